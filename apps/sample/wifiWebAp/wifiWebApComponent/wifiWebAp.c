@@ -22,7 +22,7 @@
 #define HTTP_SYS_CMD           "/usr/sbin/httpd -v -p " HTTP_PORT_NUMBER \
     " -u root -h /legato/systems/current/apps/wifiWebAp/read-only/var/www/ 2>&1"
 #define HTTP_CONNECTION_REPORT "<font color=\"black\" >%s:</font>" \
-    " Total clients connected: %d</br>\r\n"
+    " Client %s %s, total clients connected: %u</br>\r\n"
 
 static FILE *HttpdCmdPipePtr = NULL;
 static FILE *LogFilePipePtr  = NULL;
@@ -32,14 +32,7 @@ static FILE *LogFilePipePtr  = NULL;
  * Event handler reference.
  */
 //--------------------------------------------------------------------------------------------------
-static le_wifiAp_NewEventHandlerRef_t HdlrRef = NULL;
-
-//--------------------------------------------------------------------------------------------------
-/**
- * The number of clients connected to the WiFi Access point (based on Connect/Disconnect events)
- */
-//--------------------------------------------------------------------------------------------------
-static uint32_t NumberClients = 0;
+static le_wifiApExt_StationHandlerRef_t HdlrRef = NULL;
 
 //--------------------------------------------------------------------------------------------------
 /**
@@ -82,7 +75,7 @@ static le_result_t WifiEventLog
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Handler for WiFi events
+ * Handler for WiFi station events
  */
 //--------------------------------------------------------------------------------------------------
 static void WifiEventHandler
@@ -90,6 +83,12 @@ static void WifiEventHandler
     le_wifiAp_Event_t event,
         ///< [IN]
         ///< WiFi event to process
+    const char *macPtr,
+        ///< [IN]
+        ///< MAC address of the station
+    uint32_t stationCount,
+        ///< [IN]
+        ///< Number of clients connected, as counted by the WiFi service
     void *contextPtr
         ///< [IN]
         ///< Associated WiFi event context
@@ -102,6 +101,13 @@ static void WifiEventHandler
 
     LE_INFO("WiFi Ap event received");
 
+    if ((LE_WIFIAP_EVENT_CLIENT_CONNECTED != event) &&
+        (LE_WIFIAP_EVENT_CLIENT_DISCONNECTED != event))
+    {
+        LE_ERROR("ERROR Unknown event %d", event);
+        return;
+    }
+
     LogFilePipePtr = fopen(LOGFILE, "a");
 
     if (LogFilePipePtr == NULL)
@@ -117,48 +123,14 @@ static void WifiEventHandler
 
     strftime(timebuf, sizeof(timebuf), "%H:%M:%S", &tmp);
 
-    switch (event)
-    {
-        case LE_WIFIAP_EVENT_CLIENT_CONNECTED:
-        {
-            NumberClients++;
-            if (LogFilePipePtr != NULL)
-            {
-                ///< A client connect to AP
-                snprintf(str, BUF_SIZE, HTTP_CONNECTION_REPORT, timebuf, NumberClients);
-                LE_INFO("%s", str);
-                WifiEventLog(str, LogFilePipePtr);
-            }
-        }
-        break;
-
-        case LE_WIFIAP_EVENT_CLIENT_DISCONNECTED:
-        {
-            ///< A client disconnect from AP
-            // Check the number of clients because sometimes
-            // a spurious disconnection event may occur.
-            if (NumberClients > 0)
-            {
-                NumberClients--;
-            }
-            if (LogFilePipePtr != NULL)
-            {
-                snprintf(str, BUF_SIZE, HTTP_CONNECTION_REPORT, timebuf, NumberClients);
-                LE_INFO("%s", str);
-                WifiEventLog(str, LogFilePipePtr);
-            }
-        }
-        break;
+    ///< A client connects to or disconnects from the AP
+    snprintf(str, BUF_SIZE, HTTP_CONNECTION_REPORT, timebuf, macPtr,
+             (LE_WIFIAP_EVENT_CLIENT_CONNECTED == event) ? "connected" : "disconnected",
+             stationCount);
+    LE_INFO("%s", str);
+    WifiEventLog(str, LogFilePipePtr);
 
-        default:
-            LE_ERROR("ERROR Unknown event %d", event);
-        break;
-    }
-
-    if (LogFilePipePtr != NULL)
-    {
-        fclose(LogFilePipePtr);
-    }
+    fclose(LogFilePipePtr);
 }
 
 
@@ -178,7 +150,7 @@ static void SubscribeApEvents
     // todo: Clear log file at startup?
 
     // Add an handler function to handle message reception
-    HdlrRef = le_wifiAp_AddNewEventHandler(WifiEventHandler, NULL);
+    HdlrRef = le_wifiApExt_AddStationHandler(WifiEventHandler, NULL);
     LE_ASSERT(HdlrRef != NULL);
 }
 
@@ -0,0 +1,226 @@
+/**
+ * This module implements the unit tests of the WiFi access point configuration diff
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#include "legato.h"
+#include "pa_wifi_apconf.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * hostapd.conf content of the running hostapd, as generated by the access point PA.
+ */
+//--------------------------------------------------------------------------------------------------
+#define RUNNING_CONF    "interface=wlan0\n"                                                        \
+                        "driver=nl80211\n"                                                         \
+                        "ssid=ExampleAP\n"                                                         \
+                        "channel=6\n"                                                              \
+                        "max_num_sta=10\n"                                                         \
+                        "country_code=US\n"                                                        \
+                        "ignore_broadcast_ssid=0\n"                                                \
+                        "wpa=2\n"                                                                  \
+                        "wpa_passphrase=ThisIsAPassword\n"                                         \
+                        "hw_mode=g\n"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check the diff of a new hostapd.conf content against RUNNING_CONF.
+ */
+//--------------------------------------------------------------------------------------------------
+static void AssertDiff
+(
+    const char *newPtr,
+    uint8_t     expectedApply
+)
+{
+    uint8_t apply = pa_wifiApConf_Diff(RUNNING_CONF, newPtr);
+
+    LE_INFO("Diff 0x%02x, expected 0x%02x", apply, expectedApply);
+    LE_ASSERT(expectedApply == apply);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check the parsing of the hostapd.conf lines
+ *
+ * API tested:
+ * - pa_wifiApConf_ParseLine
+ * - pa_wifiApConf_FindValue
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestWifiApConf_ParseLine
+(
+    void
+)
+{
+    static const char config[] = "ssid=ExampleAP\n# comment\nchannel=\nwpa_psk=a=b";
+    const char       *linePtr;
+    const char       *valuePtr;
+    size_t            keyLen;
+    size_t            valueLen;
+
+    linePtr = pa_wifiApConf_ParseLine(config, &keyLen, &valuePtr, &valueLen);
+    LE_ASSERT(linePtr == config + strlen("ssid=ExampleAP\n"));
+    LE_ASSERT(strlen("ssid") == keyLen);
+    LE_ASSERT((strlen("ExampleAP") == valueLen) && (0 == memcmp(valuePtr, "ExampleAP", valueLen)));
+
+    // A line without '=' is not a parameter
+    linePtr = pa_wifiApConf_ParseLine(linePtr, &keyLen, &valuePtr, &valueLen);
+    LE_ASSERT(NULL != linePtr);
+    LE_ASSERT(0 == keyLen);
+
+    // Empty value
+    linePtr = pa_wifiApConf_ParseLine(linePtr, &keyLen, &valuePtr, &valueLen);
+    LE_ASSERT(strlen("channel") == keyLen);
+    LE_ASSERT(0 == valueLen);
+
+    // Last line without a newline, the value holding a '='
+    linePtr = pa_wifiApConf_ParseLine(linePtr, &keyLen, &valuePtr, &valueLen);
+    LE_ASSERT(linePtr == config + strlen(config));
+    LE_ASSERT(strlen("wpa_psk") == keyLen);
+    LE_ASSERT((strlen("a=b") == valueLen) && (0 == memcmp(valuePtr, "a=b", valueLen)));
+
+    // End of the content
+    LE_ASSERT(NULL == pa_wifiApConf_ParseLine(linePtr, &keyLen, &valuePtr, &valueLen));
+
+    valuePtr = pa_wifiApConf_FindValue(RUNNING_CONF, "channel", strlen("channel"), &valueLen);
+    LE_ASSERT((NULL != valuePtr) && (1 == valueLen) && ('6' == valuePtr[0]));
+
+    // A key prefix does not match
+    LE_ASSERT(NULL == pa_wifiApConf_FindValue(RUNNING_CONF, "chan", strlen("chan"), &valueLen));
+    LE_ASSERT(NULL == pa_wifiApConf_FindValue(RUNNING_CONF, "wpa_psk", strlen("wpa_psk"),
+                                              &valueLen));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check the action applying each parameter change
+ *
+ * API tested:
+ * - pa_wifiApConf_GetParamApply
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestWifiApConf_GetParamApply
+(
+    void
+)
+{
+    LE_ASSERT(PA_WIFIAPCONF_APPLY_SET == pa_wifiApConf_GetParamApply("max_num_sta", 11));
+    LE_ASSERT(PA_WIFIAPCONF_APPLY_RELOAD == pa_wifiApConf_GetParamApply("wpa_passphrase", 14));
+    LE_ASSERT(PA_WIFIAPCONF_APPLY_RELOAD == pa_wifiApConf_GetParamApply("wpa_psk", 7));
+    LE_ASSERT(PA_WIFIAPCONF_APPLY_BEACON ==
+              pa_wifiApConf_GetParamApply("ignore_broadcast_ssid", 21));
+    LE_ASSERT(PA_WIFIAPCONF_APPLY_CSA == pa_wifiApConf_GetParamApply("channel", 7));
+    LE_ASSERT(PA_WIFIAPCONF_APPLY_BSS == pa_wifiApConf_GetParamApply("ssid", 4));
+    LE_ASSERT(PA_WIFIAPCONF_APPLY_RESTART == pa_wifiApConf_GetParamApply("hw_mode", 7));
+    LE_ASSERT(PA_WIFIAPCONF_APPLY_RESTART == pa_wifiApConf_GetParamApply("country_code", 12));
+
+    // The key length is used, not the null termination
+    LE_ASSERT(PA_WIFIAPCONF_APPLY_BSS == pa_wifiApConf_GetParamApply("ssid=ExampleAP", 4));
+    LE_ASSERT(PA_WIFIAPCONF_APPLY_RESTART == pa_wifiApConf_GetParamApply("ssid", 3));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check the diff of new hostapd.conf contents against the running one
+ *
+ * API tested:
+ * - pa_wifiApConf_Diff
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestWifiApConf_Diff
+(
+    void
+)
+{
+    // Unchanged
+    AssertDiff(RUNNING_CONF, 0);
+
+    // max_num_sta: SET only
+    AssertDiff("interface=wlan0\ndriver=nl80211\nssid=ExampleAP\nchannel=6\nmax_num_sta=5\n"
+               "country_code=US\nignore_broadcast_ssid=0\nwpa=2\n"
+               "wpa_passphrase=ThisIsAPassword\nhw_mode=g\n",
+               PA_WIFIAPCONF_APPLY_SET);
+
+    // ignore_broadcast_ssid: beacon update, the stations stay associated
+    AssertDiff("interface=wlan0\ndriver=nl80211\nssid=ExampleAP\nchannel=6\nmax_num_sta=10\n"
+               "country_code=US\nignore_broadcast_ssid=1\nwpa=2\n"
+               "wpa_passphrase=ThisIsAPassword\nhw_mode=g\n",
+               PA_WIFIAPCONF_APPLY_BEACON);
+
+    // New passphrase: RELOAD, the stations are disconnected
+    AssertDiff("interface=wlan0\ndriver=nl80211\nssid=ExampleAP\nchannel=6\nmax_num_sta=10\n"
+               "country_code=US\nignore_broadcast_ssid=0\nwpa=2\n"
+               "wpa_passphrase=AnotherPassword\nhw_mode=g\n",
+               PA_WIFIAPCONF_APPLY_RELOAD);
+
+    // Passphrase replaced by a PSK: RELOAD, the removed passphrase does not restart hostapd
+    AssertDiff("interface=wlan0\ndriver=nl80211\nssid=ExampleAP\nchannel=6\nmax_num_sta=10\n"
+               "country_code=US\nignore_broadcast_ssid=0\nwpa=2\n"
+               "wpa_psk=0dc0d6eb90555ed6419756b9a15ec3e3209b63df707dd508d14581f8982721af\n"
+               "hw_mode=g\n",
+               PA_WIFIAPCONF_APPLY_RELOAD);
+
+    // PSK replaced by a passphrase: RELOAD
+    LE_ASSERT(PA_WIFIAPCONF_APPLY_RELOAD ==
+              pa_wifiApConf_Diff("ssid=ExampleAP\nwpa=2\nwpa_psk=0dc0d6eb\n",
+                                 "ssid=ExampleAP\nwpa=2\nwpa_passphrase=ThisIsAPassword\n"));
+
+    // channel: channel switch announcement
+    AssertDiff("interface=wlan0\ndriver=nl80211\nssid=ExampleAP\nchannel=11\nmax_num_sta=10\n"
+               "country_code=US\nignore_broadcast_ssid=0\nwpa=2\n"
+               "wpa_passphrase=ThisIsAPassword\nhw_mode=g\n",
+               PA_WIFIAPCONF_APPLY_CSA);
+
+    // ssid: BSS restart
+    AssertDiff("interface=wlan0\ndriver=nl80211\nssid=OtherAP\nchannel=6\nmax_num_sta=10\n"
+               "country_code=US\nignore_broadcast_ssid=0\nwpa=2\n"
+               "wpa_passphrase=ThisIsAPassword\nhw_mode=g\n",
+               PA_WIFIAPCONF_APPLY_BSS);
+
+    // Changes needing different actions are all reported
+    AssertDiff("interface=wlan0\ndriver=nl80211\nssid=ExampleAP\nchannel=11\nmax_num_sta=5\n"
+               "country_code=US\nignore_broadcast_ssid=0\nwpa=2\n"
+               "wpa_passphrase=ThisIsAPassword\nhw_mode=g\n",
+               PA_WIFIAPCONF_APPLY_SET | PA_WIFIAPCONF_APPLY_CSA);
+
+    // hw_mode: hostapd restart
+    AssertDiff("interface=wlan0\ndriver=nl80211\nssid=ExampleAP\nchannel=6\nmax_num_sta=10\n"
+               "country_code=US\nignore_broadcast_ssid=0\nwpa=2\n"
+               "wpa_passphrase=ThisIsAPassword\nhw_mode=a\n",
+               PA_WIFIAPCONF_APPLY_RESTART);
+
+    // New key: hostapd restart
+    AssertDiff(RUNNING_CONF "ieee80211n=1\n", PA_WIFIAPCONF_APPLY_RESTART);
+
+    // Removed key, e.g. security switched off: hostapd restart
+    AssertDiff("interface=wlan0\ndriver=nl80211\nssid=ExampleAP\nchannel=6\nmax_num_sta=10\n"
+               "country_code=US\nignore_broadcast_ssid=0\nhw_mode=g\n",
+               PA_WIFIAPCONF_APPLY_RESTART);
+
+    // Nothing running yet
+    LE_ASSERT(PA_WIFIAPCONF_APPLY_RESTART & pa_wifiApConf_Diff("", RUNNING_CONF));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * main of the test
+ *
+ */
+//--------------------------------------------------------------------------------------------------
+COMPONENT_INIT
+{
+    LE_INFO ("======== Start UnitTest of WiFi AP configuration diff ========");
+
+    TestWifiApConf_ParseLine();
+
+    TestWifiApConf_GetParamApply();
+
+    TestWifiApConf_Diff();
+
+    LE_INFO ("======== UnitTest of WiFi AP configuration diff SUCCESS ========");
+
+    exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,13 @@
+/**
+ * This module contains the interfaces used by the WiFi access point unit test.
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#include "le_wifiAp_interface.h"
+#include "le_wifiApExt_interface.h"
+#include "le_cfg_interface.h"
+
+#undef LE_KILL_CLIENT
+#define LE_KILL_CLIENT LE_WARN
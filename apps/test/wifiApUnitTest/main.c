@@ -0,0 +1,324 @@
+/**
+ * This module implements the unit tests for WiFi access point API
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#include "legato.h"
+#include "interfaces.h"
+#include "wifiService.h"
+#include "stubs.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Interval of the station dumps (ms).
+ */
+//--------------------------------------------------------------------------------------------------
+#define STUB_POLL_MS        100
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stations of the test.
+ */
+//--------------------------------------------------------------------------------------------------
+#define STATION_MAC         "02:00:00:00:00:01"
+#define OTHER_STATION_MAC   "02:00:00:00:00:02"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Weight of the last interval in the averaged rates of the service, in percent.
+ */
+//--------------------------------------------------------------------------------------------------
+#define RATE_WEIGHT_PERCENT 25
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Station dumps of the test, as numbered by the stubs.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef enum
+{
+    DUMP_FIRST = 1,         ///< First counters of the station: no rate yet
+    DUMP_FIRST_INTERVAL,    ///< Rate of the first interval
+    DUMP_AVERAGED,          ///< Rate averaged with the previous one
+    DUMP_BACKWARDS,         ///< Counters reset by the driver: rates kept
+    DUMP_RESTARTED,         ///< Rate from the reset counters
+    DUMP_TRUNCATED,         ///< Dump missing a station, truncated: no eviction
+    DUMP_COMPLETE           ///< Dump missing a station, complete: eviction
+}
+Dump_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Counters of the station, its averaged rates as expected, and the time of the last dump.
+ */
+//--------------------------------------------------------------------------------------------------
+static pa_wifiAp_StationStats_t StationStats;
+static uint32_t                 ExpectedRxRate;
+static uint32_t                 ExpectedTxRate;
+static le_clk_Time_t            LastDumpTime;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the time elapsed since the last dump, in milliseconds, and restart it.
+ */
+//--------------------------------------------------------------------------------------------------
+static uint64_t GetDumpIntervalMs
+(
+    void
+)
+{
+    le_clk_Time_t now = le_clk_GetRelativeTime();
+    le_clk_Time_t interval = le_clk_Sub(now, LastDumpTime);
+
+    LastDumpTime = now;
+    return (uint64_t)interval.sec * 1000 + interval.usec / 1000;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Fold the traffic of an interval into an expected rate, as the service does.
+ *
+ * @return The expected rate, in bytes per second.
+ */
+//--------------------------------------------------------------------------------------------------
+static uint32_t FoldRate
+(
+    uint32_t rate,
+    uint64_t bytes,
+    uint64_t intervalMs,
+    bool     isFirst
+)
+{
+    uint64_t sample = bytes * 1000 / intervalMs;
+
+    if (isFirst)
+    {
+        return (uint32_t)sample;
+    }
+    return (uint32_t)(((uint64_t)rate * (100 - RATE_WEIGHT_PERCENT) +
+                       sample * RATE_WEIGHT_PERCENT) / 100);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check a rate of the service against the expected one, allowing for the scheduling of the timer.
+ */
+//--------------------------------------------------------------------------------------------------
+static void AssertRate
+(
+    uint32_t rate,
+    uint32_t expectedRate
+)
+{
+    uint32_t margin = expectedRate / 20 + 1;
+
+    LE_INFO("Rate %u B/s, expected %u B/s", rate, expectedRate);
+    LE_ASSERT((rate + margin >= expectedRate) && (rate <= expectedRate + margin));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add traffic to the station for its next dump.
+ */
+//--------------------------------------------------------------------------------------------------
+static void AddTraffic
+(
+    uint64_t rxBytes,
+    uint64_t txBytes,
+    le_result_t result
+)
+{
+    StationStats.rxBytes += rxBytes;
+    StationStats.txBytes += txBytes;
+    StationStats.rxPackets++;
+    StationStats.txPackets++;
+    StubSetStationDump(&StationStats, 1, result);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check the counters and the rates of the station against the last dump.
+ */
+//--------------------------------------------------------------------------------------------------
+static void AssertStationStats
+(
+    void
+)
+{
+    int16_t  signalStrength;
+    uint32_t rxRate;
+    uint32_t txRate;
+    uint32_t txBitrate;
+    uint64_t rxBytes;
+    uint64_t txBytes;
+
+    LE_ASSERT_OK(le_wifiApExt_GetStationStats(STATION_MAC, &signalStrength, &rxRate, &txRate,
+                                              &txBitrate, &rxBytes, &txBytes));
+    LE_ASSERT(StationStats.signalStrength == signalStrength);
+    LE_ASSERT(StationStats.txBitrate == txBitrate);
+    LE_ASSERT(StationStats.rxBytes == rxBytes);
+    LE_ASSERT(StationStats.txBytes == txBytes);
+    AssertRate(rxRate, ExpectedRxRate);
+    AssertRate(txRate, ExpectedTxRate);
+
+    // The averaged rates are the ones used by the service from now on
+    ExpectedRxRate = rxRate;
+    ExpectedTxRate = txRate;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check the service after each station dump, and set the next one.
+ *
+ * API tested:
+ * - le_wifiApExt_GetStationStats
+ * - le_wifiApExt_GetStation
+ */
+//--------------------------------------------------------------------------------------------------
+static void StationDumpHandler
+(
+    uint32_t dumpCount
+)
+{
+    uint64_t intervalMs = GetDumpIntervalMs();
+    uint32_t connectedSec;
+    uint32_t inactiveMs;
+
+    LE_INFO("Station dump %u, %"PRIu64" ms", dumpCount, intervalMs);
+
+    switch (dumpCount)
+    {
+        case DUMP_FIRST:
+            // One dump gives the counters, not a rate
+            AssertStationStats();
+            LE_ASSERT((0 == ExpectedRxRate) && (0 == ExpectedTxRate));
+            AddTraffic(1000, 500, LE_OK);
+            break;
+
+        case DUMP_FIRST_INTERVAL:
+            // The first interval gives the rate as is, not weighted with a rate of 0
+            ExpectedRxRate = FoldRate(0, 1000, intervalMs, true);
+            ExpectedTxRate = FoldRate(0, 500, intervalMs, true);
+            AssertStationStats();
+            AddTraffic(5000, 1500, LE_OK);
+            break;
+
+        case DUMP_AVERAGED:
+            // The last interval weighs 25%
+            ExpectedRxRate = FoldRate(ExpectedRxRate, 5000, intervalMs, false);
+            ExpectedTxRate = FoldRate(ExpectedTxRate, 1500, intervalMs, false);
+            AssertStationStats();
+
+            // Counters reset by the driver
+            StationStats.rxBytes = 100;
+            StationStats.txBytes = 100;
+            StubSetStationDump(&StationStats, 1, LE_OK);
+            break;
+
+        case DUMP_BACKWARDS:
+            // The rates are kept, and the reset counters are the base of the next interval
+            AssertStationStats();
+            AddTraffic(1000, 500, LE_OK);
+            break;
+
+        case DUMP_RESTARTED:
+            ExpectedRxRate = FoldRate(ExpectedRxRate, StationStats.rxBytes - 100, intervalMs,
+                                      false);
+            ExpectedTxRate = FoldRate(ExpectedTxRate, StationStats.txBytes - 100, intervalMs,
+                                      false);
+            AssertStationStats();
+
+            // Another station, missing from the next dumps
+            StubReportStation(LE_WIFIAP_EVENT_CLIENT_CONNECTED, OTHER_STATION_MAC);
+            AddTraffic(0, 0, LE_OVERFLOW);
+            break;
+
+        case DUMP_TRUNCATED:
+            // A truncated dump still updates the stations it lists, but does not tell the
+            // stations that disassociated
+            ExpectedRxRate = FoldRate(ExpectedRxRate, 0, intervalMs, false);
+            ExpectedTxRate = FoldRate(ExpectedTxRate, 0, intervalMs, false);
+            AssertStationStats();
+            LE_ASSERT_OK(le_wifiApExt_GetStation(OTHER_STATION_MAC, &connectedSec,
+                                                 &inactiveMs));
+            AddTraffic(0, 0, LE_OK);
+            break;
+
+        case DUMP_COMPLETE:
+            // A complete dump evicts the stations it misses
+            LE_ASSERT(LE_NOT_FOUND == le_wifiApExt_GetStation(OTHER_STATION_MAC, &connectedSec,
+                                                              &inactiveMs));
+            LE_ASSERT_OK(le_wifiApExt_GetStation(STATION_MAC, &connectedSec, &inactiveMs));
+
+            LE_ASSERT_OK(le_wifiAp_Stop());
+            LE_ASSERT(LE_NOT_FOUND == le_wifiApExt_GetStation(STATION_MAC, &connectedSec,
+                                                              &inactiveMs));
+
+            LE_INFO("======== UnitTest of WiFi access point SUCCESS ========");
+            exit(EXIT_SUCCESS);
+            break;
+
+        default:
+            LE_FATAL("Unexpected station dump %u", dumpCount);
+            break;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Follow the traffic of a station through the station dumps
+ *
+ * API tested:
+ * - le_wifiAp_Start
+ * - le_wifiApExt_GetStationStats
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestWifiAp_StationStats
+(
+    void
+)
+{
+    int16_t  signalStrength;
+    uint32_t rxRate;
+    uint32_t txRate;
+    uint32_t txBitrate;
+    uint64_t rxBytes;
+    uint64_t txBytes;
+
+    memset(&StationStats, 0, sizeof(StationStats));
+    le_utf8_Copy(StationStats.mac, STATION_MAC, sizeof(StationStats.mac), NULL);
+    StationStats.rxBytes = 1000;
+    StationStats.txBytes = 2000;
+    StationStats.signalStrength = -50;
+    StationStats.txBitrate = 65000;
+    StubSetStationDump(&StationStats, 1, LE_OK);
+    StubSetStationDumpHandler(StationDumpHandler);
+
+    LE_ASSERT_OK(le_wifiAp_Start());
+    StubReportStation(LE_WIFIAP_EVENT_CLIENT_CONNECTED, STATION_MAC);
+
+    // Not dumped yet
+    LE_ASSERT(LE_UNAVAILABLE == le_wifiApExt_GetStationStats(STATION_MAC, &signalStrength,
+                                                             &rxRate, &txRate, &txBitrate,
+                                                             &rxBytes, &txBytes));
+    LastDumpTime = le_clk_GetRelativeTime();
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * main of the test
+ *
+ */
+//--------------------------------------------------------------------------------------------------
+COMPONENT_INIT
+{
+    le_cfg_QuickSetInt("wifiService:/wifi/ap/stationPollMs", STUB_POLL_MS);
+
+    le_wifiAp_Init();
+
+    LE_INFO ("======== Start UnitTest of WiFi access point ========");
+
+    TestWifiAp_StationStats();
+}
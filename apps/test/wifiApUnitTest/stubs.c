@@ -0,0 +1,481 @@
+/**
+ * @file stubs.c
+ *
+ * Stub functions required for WiFi access point unit test
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ */
+
+#include "legato.h"
+#include "interfaces.h"
+#include "pa_wifi_ap.h"
+#include "pa_wifi_dhcp.h"
+#include "stubs.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Event indication handler of the service.
+ */
+//--------------------------------------------------------------------------------------------------
+static pa_wifiAp_EventIndHandlerFunc_t StubEventIndHandlerPtr = NULL;
+static void                           *StubEventIndContextPtr = NULL;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Result of the station dumps, and the number of dumps so far.
+ */
+//--------------------------------------------------------------------------------------------------
+static pa_wifiAp_StationStats_t StubStationStats[PA_WIFIAP_MAX_STATIONS];
+static size_t                   StubStationCount = 0;
+static le_result_t              StubStationResult = LE_NOT_FOUND;
+static uint32_t                 StubStationDumpCount = 0;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Handler called after each station dump.
+ */
+//--------------------------------------------------------------------------------------------------
+static StubStationDumpHandlerFunc_t StubStationDumpHandlerPtr = NULL;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Report the association or the disassociation of a station, as the PA does.
+ */
+//--------------------------------------------------------------------------------------------------
+void StubReportStation
+(
+    le_wifiAp_Event_t  event,
+        ///< [IN]
+        ///< Association or disassociation
+    const char        *macPtr
+        ///< [IN]
+        ///< MAC address of the station
+)
+{
+    pa_wifiAp_EventInd_t eventInd;
+
+    LE_ASSERT(NULL != StubEventIndHandlerPtr);
+
+    memset(&eventInd, 0, sizeof(eventInd));
+    eventInd.event = event;
+    le_utf8_Copy(eventInd.stationMac, macPtr, sizeof(eventInd.stationMac), NULL);
+    StubEventIndHandlerPtr(&eventInd, StubEventIndContextPtr);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the result of the next station dumps.
+ */
+//--------------------------------------------------------------------------------------------------
+void StubSetStationDump
+(
+    const pa_wifiAp_StationStats_t *statsPtr,
+        ///< [IN]
+        ///< Stations
+    size_t                          count,
+        ///< [IN]
+        ///< Number of stations
+    le_result_t                     result
+        ///< [IN]
+        ///< Result of the dumps
+)
+{
+    LE_ASSERT(count <= PA_WIFIAP_MAX_STATIONS);
+
+    memcpy(StubStationStats, statsPtr, count * sizeof(pa_wifiAp_StationStats_t));
+    StubStationCount = count;
+    StubStationResult = result;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the handler called after each station dump.
+ */
+//--------------------------------------------------------------------------------------------------
+void StubSetStationDumpHandler
+(
+    StubStationDumpHandlerFunc_t handlerPtr
+        ///< [IN]
+        ///< Handler
+)
+{
+    StubStationDumpHandlerPtr = handlerPtr;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Call the station dump handler, once the service has processed the dump.
+ */
+//--------------------------------------------------------------------------------------------------
+static void CallStationDumpHandler
+(
+    void *param1Ptr,
+    void *param2Ptr
+)
+{
+    if (NULL != StubStationDumpHandlerPtr)
+    {
+        StubStationDumpHandlerPtr(StubStationDumpCount);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * This function must be called to initialize the PA WiFi Access Point.
+ *
+ * @return LE_OK     The function succeeded.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiAp_Init
+(
+    void
+)
+{
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add handler function for WiFi related event indications, which also give the station.
+ *
+ * @return LE_OK            Function succeeded.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiAp_AddEventIndHandler
+(
+    pa_wifiAp_EventIndHandlerFunc_t handlerPtr,
+        ///< [IN]
+        ///< Event indication handler function pointer
+
+    void *contextPtr
+        ///< [IN]
+        ///< Associated event context
+)
+{
+    StubEventIndHandlerPtr = handlerPtr;
+    StubEventIndContextPtr = contextPtr;
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * This function starts the WiFi access point.
+ *
+ * @return LE_OK            The function succeeded.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiAp_Start
+(
+    void
+)
+{
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * This function stops the WiFi access point.
+ *
+ * @return LE_OK            The function succeeded.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiAp_Stop
+(
+    void
+)
+{
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the traffic and signal of all the stations associated to the access point, as set by
+ * StubSetStationDump().
+ *
+ * @return LE_OK            The function succeeded.
+ * @return LE_OVERFLOW      More stations than returned are associated.
+ * @return LE_NOT_FOUND     The access point is not started.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiAp_GetStationStats
+(
+    pa_wifiAp_StationStats_t *statsPtr,
+        ///< [OUT]
+        ///< Stations
+    size_t                    maxCount,
+        ///< [IN]
+        ///< Number of entries of statsPtr
+    size_t                   *countPtr
+        ///< [OUT]
+        ///< Number of stations returned
+)
+{
+    LE_ASSERT(StubStationCount <= maxCount);
+
+    StubStationDumpCount++;
+    le_event_QueueFunction(CallStationDumpHandler, NULL, NULL);
+
+    if ((LE_OK != StubStationResult) && (LE_OVERFLOW != StubStationResult))
+    {
+        return StubStationResult;
+    }
+
+    memcpy(statsPtr, StubStationStats, StubStationCount * sizeof(pa_wifiAp_StationStats_t));
+    *countPtr = StubStationCount;
+    return StubStationResult;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the time taken by the last start of the access point.
+ *
+ * @return LE_UNAVAILABLE   The access point was not started yet.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiAp_GetStartLatency
+(
+    uint32_t *interfaceUpMsPtr,
+        ///< [OUT]
+        ///< Time from the start of the WiFi hardware until the WLAN interface was up (ms)
+    uint32_t *hostapdMsPtr
+        ///< [OUT]
+        ///< Time taken by the last hostapd (re)start (ms), 0 if unknown
+)
+{
+    return LE_UNAVAILABLE;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the security protocol to use.
+ *
+ * @return LE_OK            Function succeeded.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiAp_SetSecurityProtocol
+(
+    le_wifiAp_SecurityProtocol_t securityProtocol
+        ///< [IN]
+        ///< The security protocol to use.
+)
+{
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the Service Set IDentification (SSID) of the access point.
+ *
+ * @return LE_OK            Function succeeded.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiAp_SetSsid
+(
+    const uint8_t *ssidPtr,
+        ///< [IN]
+        ///< The SSID to set as an octet array.
+
+    size_t ssidNumElements
+        ///< [IN]
+        ///< The length of the SSID in octets.
+)
+{
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the passphrase used to generate the PSK.
+ *
+ * @return LE_OK            Function succeeded.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiAp_SetPassPhrase
+(
+    const char *passphrasePtr
+        ///< [IN]
+        ///< Passphrase to authenticate against the access point.
+)
+{
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the pre-shared key (PSK).
+ *
+ * @return LE_OK            Function succeeded.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiAp_SetPreSharedKey
+(
+    const char *preSharedKeyPtr
+        ///< [IN]
+        ///< Pre-shared key used to authenticate against the access point.
+)
+{
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set if the access point should announce its presence.
+ *
+ * @return LE_OK            Function succeeded.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiAp_SetDiscoverable
+(
+    bool isDiscoverable
+        ///< [IN]
+        ///< If TRUE, the access point SSID is visible by the clients otherwise it is hidden.
+)
+{
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set which WiFi channel to use.
+ *
+ * @return LE_OK            Function succeeded.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiAp_SetChannel
+(
+    uint16_t channelNumber
+        ///< [IN]
+        ///< the channel number.
+)
+{
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set which IEEE standard to use.
+ *
+ * @return LE_OK            Function succeeded.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiAp_SetIeeeStandard
+(
+    le_wifiAp_IeeeStdBitMask_t stdMask
+        ///< [IN]
+        ///< Bit mask for the IEEE standard.
+)
+{
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get which IEEE standard was set.
+ *
+ * @return LE_OK            Function succeeded.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiAp_GetIeeeStandard
+(
+    le_wifiAp_IeeeStdBitMask_t *stdMaskPtr
+        ///< [OUT]
+        ///< Bit mask for the IEEE standard.
+)
+{
+    *stdMaskPtr = LE_WIFIAP_BITMASK_IEEE_STD_G;
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set what country code to use for regulatory domain.
+ *
+ * @return LE_OK            Function succeeded.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiAp_SetCountryCode
+(
+    const char *countryCodePtr
+        ///< [IN]
+        ///< the country code.
+)
+{
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the maximum number of clients allowed to be connected to WiFi access point at the same time.
+ *
+ * @return LE_OK            Function succeeded.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiAp_SetMaxNumberClients
+(
+    int maxNumberClients
+        ///< [IN]
+        ///< The maximum number of clients.
+)
+{
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Define the access point IP address and the client IP addresses range.
+ *
+ * @return LE_OK            Function succeeded.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiAp_SetIpRange
+(
+    const char *ipApPtr,
+        ///< [IN]
+        ///< the IP address of the access point.
+    const char *ipStartPtr,
+        ///< [IN]
+        ///< the start IP address of the access point.
+    const char *ipStopPtr
+        ///< [IN]
+        ///< the stop IP address of the access point.
+)
+{
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the lease handler of the DHCP server.
+ */
+//--------------------------------------------------------------------------------------------------
+void pa_wifiDhcp_SetLeaseHandler
+(
+    pa_wifiDhcp_LeaseHandlerFunc_t handlerPtr,
+        ///< [IN]
+        ///< Lease handler
+    void                          *contextPtr
+        ///< [IN]
+        ///< Context given to the handler
+)
+{
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the active lease of a client.
+ *
+ * @return LE_NOT_FOUND     The client has no active lease.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiDhcp_GetLease
+(
+    const char          *macPtr,
+        ///< [IN]
+        ///< MAC address of the client
+    pa_wifiDhcp_Lease_t *leasePtr
+        ///< [OUT]
+        ///< Lease of the client
+)
+{
+    return LE_NOT_FOUND;
+}
@@ -0,0 +1,74 @@
+/**
+ * @file stubs.h
+ *
+ * Functions of the stubs driving the WiFi access point unit test
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ */
+
+#ifndef STUBS_H
+#define STUBS_H
+
+#include "legato.h"
+#include "interfaces.h"
+#include "pa_wifi_ap.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Station dump handler of the stubs, called after each station dump has been handed to the
+ * service.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef void (*StubStationDumpHandlerFunc_t)
+(
+    uint32_t dumpCount
+        ///< [IN]
+        ///< Number of station dumps so far
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Report the association or the disassociation of a station, as the PA does. (STUBBED FUNCTION)
+ */
+//--------------------------------------------------------------------------------------------------
+void StubReportStation
+(
+    le_wifiAp_Event_t  event,
+        ///< [IN]
+        ///< Association or disassociation
+    const char        *macPtr
+        ///< [IN]
+        ///< MAC address of the station
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the result of the next station dumps. (STUBBED FUNCTION)
+ */
+//--------------------------------------------------------------------------------------------------
+void StubSetStationDump
+(
+    const pa_wifiAp_StationStats_t *statsPtr,
+        ///< [IN]
+        ///< Stations
+    size_t                          count,
+        ///< [IN]
+        ///< Number of stations
+    le_result_t                     result
+        ///< [IN]
+        ///< Result of the dumps
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the handler called after each station dump. (STUBBED FUNCTION)
+ */
+//--------------------------------------------------------------------------------------------------
+void StubSetStationDumpHandler
+(
+    StubStationDumpHandlerFunc_t handlerPtr
+        ///< [IN]
+        ///< Handler
+);
+
+#endif // STUBS_H
@@ -6,6 +6,7 @@
  */
 
 #include "le_wifiClient_interface.h"
+#include "le_wifiClientExt_interface.h"
 #include "le_cfg_interface.h"
 #include "le_secStore_interface.h"
 
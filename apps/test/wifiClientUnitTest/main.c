@@ -8,6 +8,67 @@
 #include "legato.h"
 #include "interfaces.h"
 #include "wifiService.h"
+#include "stubs.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Size of the access point table: the number of access points found by one stub scan.
+ */
+//--------------------------------------------------------------------------------------------------
+#define STUB_AP_TABLE_MAX   30
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum age of the scan results requested to the scan scheduler (ms).
+ */
+//--------------------------------------------------------------------------------------------------
+#define STUB_SCAN_MAX_AGE_MS    100
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Time given to the scan scheduler to start a scan on the stopped WiFi device (ms).
+ */
+//--------------------------------------------------------------------------------------------------
+#define STUB_STOPPED_WAIT_MS    (3 * STUB_SCAN_MAX_AGE_MS)
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Saved network of the PMK test, with the PSK derived from its passphrase: test vector of
+ * IEEE 802.11i-2004, H.4.
+ */
+//--------------------------------------------------------------------------------------------------
+#define PMK_TEST_SSID           "IEEE"
+#define PMK_TEST_PASSPHRASE     "password"
+#define PMK_TEST_PSK            "f42c6fc52df0ebef9ebb4b90b38a5f902e83fe1b135a70e23aed762e9710a12e"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Interval and maximum number of the checks for the PMK derived by the scan worker.
+ */
+//--------------------------------------------------------------------------------------------------
+#define PMK_POLL_MS             10
+#define PMK_POLL_MAX            500
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Age of the access points returned by a cached scan of the stub (ms).
+ */
+//--------------------------------------------------------------------------------------------------
+#define STUB_CACHED_AGE_MS      5000
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Dwell time of the roaming engine (ms), longer than its check interval.
+ */
+//--------------------------------------------------------------------------------------------------
+#define STUB_ROAM_DWELL_MS      3000
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Time taken by a reassociation of the stub (ms).
+ */
+//--------------------------------------------------------------------------------------------------
+#define STUB_ROAM_DELAY_MS      50
 
 //--------------------------------------------------------------------------------------------------
 /**
@@ -123,6 +184,391 @@ static void TestWifiClient_ConnectDisconnect
 }
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the link state from the cache
+ *
+ * API tested:
+ * - le_wifiClientExt_GetLinkInfo
+ * - le_wifiClient_GetRxData
+ * - le_wifiClient_GetCurrentSignalStrength
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestWifiClient_GetLinkInfo
+(
+    void
+)
+{
+    int16_t  signalStrength;
+    uint64_t rxBytes;
+    uint64_t txBytes;
+    uint64_t rxData;
+    uint32_t rxBitrate;
+    uint32_t txBitrate;
+    uint32_t frequency;
+    char     bssid[LE_WIFIDEFS_MAX_BSSID_BYTES];
+    uint8_t  ssid[LE_WIFIDEFS_MAX_SSID_LENGTH];
+    size_t   ssidSize = sizeof(ssid);
+
+    LE_ASSERT_OK(le_wifiClientExt_GetLinkInfo(&signalStrength, &rxBytes, &txBytes, &rxBitrate,
+                                              &txBitrate, &frequency, bssid, sizeof(bssid),
+                                              ssid, &ssidSize));
+    LE_ASSERT(-50 == signalStrength);
+    LE_ASSERT(500 == txBytes);
+    LE_ASSERT(72200 == rxBitrate);
+    LE_ASSERT(65000 == txBitrate);
+    LE_ASSERT(2437 == frequency);
+    LE_ASSERT(0 == strcmp(bssid, "00:11:22:33:44:55"));
+    LE_ASSERT((7 == ssidSize) && (0 == memcmp(ssid, "Example", 7)));
+
+    // Polled again within the freshness window: the same sample is returned
+    LE_ASSERT_OK(le_wifiClient_GetRxData(&rxData));
+    LE_ASSERT(rxBytes == rxData);
+    LE_ASSERT_OK(le_wifiClient_GetCurrentSignalStrength(&signalStrength));
+    LE_ASSERT(-50 == signalStrength);
+
+    // A disconnection invalidates the cache
+    LE_ASSERT_OK(le_wifiClient_Disconnect());
+    LE_ASSERT_OK(le_wifiClient_GetRxData(&rxData));
+    LE_ASSERT(rxBytes != rxData);
+
+    // Buffers too small
+    ssidSize = 1;
+    LE_ASSERT(LE_OVERFLOW == le_wifiClientExt_GetLinkInfo(&signalStrength, &rxBytes, &txBytes,
+                                                          &rxBitrate, &txBitrate, &frequency,
+                                                          bssid, sizeof(bssid), ssid, &ssidSize));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Identifier of the first scan.
+ */
+//--------------------------------------------------------------------------------------------------
+static uint32_t FirstScanId;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of scans completed.
+ */
+//--------------------------------------------------------------------------------------------------
+static uint32_t ScanDoneCount = 0;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Scan request to the scan scheduler.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_wifiClientExt_ScanRequestRef_t ScanRequestRef = NULL;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Last changes reported by the ScanChanges event.
+ */
+//--------------------------------------------------------------------------------------------------
+static struct
+{
+    uint32_t scanId;
+    uint32_t addedCount;
+    uint32_t removedCount;
+    uint32_t updatedCount;
+}
+LastScanChanges;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Roaming test: once started, the scan and connection events belong to it.
+ */
+//--------------------------------------------------------------------------------------------------
+static struct
+{
+    bool          isStarted;    ///< Started by TestWifiClient_Roam
+    uint32_t      scanCount;    ///< Number of roam scans done
+    le_clk_Time_t scanTime;     ///< End of the first roam scan
+}
+RoamTest;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read the results of the first scan as packed pages
+ *
+ * API tested:
+ * - le_wifiClientExt_GetScanResults
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestWifiClient_GetScanResults
+(
+    void
+)
+{
+    uint8_t     page[LE_WIFICLIENTEXT_SCAN_PAGE_MAX_BYTES];
+    size_t      pageSize;
+    uint32_t    start = 0;
+    uint32_t    scanId;
+    uint32_t    total = 0;
+    uint32_t    pageCount = 0;
+
+    pageSize = sizeof(page);
+    LE_ASSERT_OK(le_wifiClientExt_GetScanResults(0, &FirstScanId, &total, page, &pageSize));
+    LE_ASSERT(30 == total);
+
+    do
+    {
+        pageSize = sizeof(page);
+        LE_ASSERT_OK(le_wifiClientExt_GetScanResults(start, &scanId, &total, page, &pageSize));
+        LE_ASSERT(scanId == FirstScanId);
+        LE_ASSERT(0 == pageSize % LE_WIFICLIENTEXT_SCAN_ENTRY_BYTES);
+        LE_ASSERT(pageSize > 0);
+
+        for (size_t offset = 0; offset < pageSize; offset += LE_WIFICLIENTEXT_SCAN_ENTRY_BYTES)
+        {
+            const uint8_t *entryPtr = &page[offset];
+            const uint8_t *signalPtr = &entryPtr[LE_WIFICLIENTEXT_SCAN_ENTRY_SIGNAL_OFFSET];
+            const uint8_t *frequencyPtr = &entryPtr[LE_WIFICLIENTEXT_SCAN_ENTRY_FREQUENCY_OFFSET];
+            uint8_t        index = entryPtr[LE_WIFICLIENTEXT_SCAN_ENTRY_BSSID_OFFSET + 5];
+            int16_t        signal = signalPtr[0] | (signalPtr[1] << 8);
+            uint16_t       frequency = frequencyPtr[0] | (frequencyPtr[1] << 8);
+            uint8_t        security = entryPtr[LE_WIFICLIENTEXT_SCAN_ENTRY_SECURITY_OFFSET];
+            char           ssid[LE_WIFIDEFS_MAX_SSID_BYTES];
+
+            snprintf(ssid, sizeof(ssid), "Scan%u", index);
+            LE_ASSERT(0x02 == entryPtr[LE_WIFICLIENTEXT_SCAN_ENTRY_BSSID_OFFSET]);
+            LE_ASSERT(-40 - index == signal);
+            LE_ASSERT(2412 + 5 * (index % 13) == frequency);
+            LE_ASSERT(((0 == index % 2) ? (LE_WIFICLIENTEXT_SCAN_SECURITY_PRIVACY |
+                                           LE_WIFICLIENTEXT_SCAN_SECURITY_WPA2) : 0) == security);
+            LE_ASSERT(strlen(ssid) == entryPtr[LE_WIFICLIENTEXT_SCAN_ENTRY_SSID_LENGTH_OFFSET]);
+            LE_ASSERT(0 == memcmp(ssid, &entryPtr[LE_WIFICLIENTEXT_SCAN_ENTRY_SSID_OFFSET],
+                                  strlen(ssid)));
+        }
+
+        start += pageSize / LE_WIFICLIENTEXT_SCAN_ENTRY_BYTES;
+        pageCount++;
+    }
+    while (start < total);
+    LE_ASSERT(2 == pageCount);
+
+    // End of the results, then past the end
+    pageSize = sizeof(page);
+    LE_ASSERT_OK(le_wifiClientExt_GetScanResults(total, &scanId, &total, page, &pageSize));
+    LE_ASSERT(0 == pageSize);
+    pageSize = sizeof(page);
+    LE_ASSERT(LE_OUT_OF_RANGE == le_wifiClientExt_GetScanResults(total + 1, &scanId, &total,
+                                                                 page, &pageSize));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Look up the access points found by the second scan
+ *
+ * API tested:
+ * - le_wifiClient_Create on a scanned SSID
+ * - le_wifiClient_GetFirstAccessPoint/le_wifiClient_GetNextAccessPoint
+ * - le_wifiClient_Delete of a scanned access point
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestWifiClient_ScanIndex
+(
+    void
+)
+{
+    const uint8_t                  ssid[] = "Scan3";
+    le_wifiClient_AccessPointRef_t ref;
+    le_wifiClient_AccessPointRef_t iterRef;
+    char                           bssid[LE_WIFIDEFS_MAX_BSSID_BYTES];
+    uint8_t                        page[LE_WIFICLIENTEXT_SCAN_PAGE_MAX_BYTES];
+    size_t                         pageSize = sizeof(page);
+    uint32_t                       scanId;
+    uint32_t                       total;
+    uint32_t                       count = 0;
+
+    // The access points found again are updated, not added
+    LE_ASSERT_OK(le_wifiClientExt_GetScanResults(0, &scanId, &total, page, &pageSize));
+    LE_ASSERT(FirstScanId + 1 == scanId);
+    LE_ASSERT(30 == total);
+
+    // Creating a scanned SSID returns the scanned access point
+    ref = le_wifiClient_Create(ssid, sizeof(ssid) - 1);
+    LE_ASSERT(NULL != ref);
+    LE_ASSERT_OK(le_wifiClient_GetBssid(ref, bssid, sizeof(bssid)));
+    LE_ASSERT(0 == strcmp(bssid, "02:00:00:00:00:03"));
+
+    // Deleting an access point while iterating does not break the iteration
+    for (iterRef = le_wifiClient_GetFirstAccessPoint();
+         NULL != iterRef;
+         iterRef = le_wifiClient_GetNextAccessPoint())
+    {
+        if (0 == count)
+        {
+            LE_ASSERT_OK(le_wifiClient_Delete(ref));
+        }
+        count++;
+    }
+    LE_ASSERT(29 == count);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check the changes found by each scan
+ *
+ * API tested:
+ * - le_wifiClientExt_AddScanChangesHandler
+ * - le_wifiClientExt_GetScanChanges
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestWifiClient_ScanChanges
+(
+    void
+)
+{
+    uint8_t  changes[LE_WIFICLIENTEXT_SCAN_PAGE_MAX_ENTRIES];
+    size_t   changesSize = NUM_ARRAY_MEMBERS(changes);
+    uint8_t  page[LE_WIFICLIENTEXT_SCAN_PAGE_MAX_BYTES];
+    size_t   pageSize = sizeof(page);
+    uint32_t scanId;
+    uint32_t total;
+
+    LE_ASSERT(FirstScanId + ScanDoneCount - 1 == LastScanChanges.scanId);
+
+    switch (ScanDoneCount)
+    {
+        case 1:
+            // Everything is new, read in two pages
+            LE_ASSERT(30 == LastScanChanges.addedCount);
+            LE_ASSERT(0 == LastScanChanges.removedCount);
+            LE_ASSERT(0 == LastScanChanges.updatedCount);
+            LE_ASSERT_OK(le_wifiClientExt_GetScanChanges(0, &scanId, &total, changes,
+                                                         &changesSize, page, &pageSize));
+            LE_ASSERT(30 == total);
+            LE_ASSERT(LE_WIFICLIENTEXT_SCAN_PAGE_MAX_ENTRIES == changesSize);
+            LE_ASSERT(changesSize * LE_WIFICLIENTEXT_SCAN_ENTRY_BYTES == pageSize);
+            LE_ASSERT(LE_WIFICLIENTEXT_SCAN_CHANGE_ADDED == changes[0]);
+            changesSize = NUM_ARRAY_MEMBERS(changes);
+            pageSize = sizeof(page);
+            LE_ASSERT_OK(le_wifiClientExt_GetScanChanges(changesSize, &scanId, &total, changes,
+                                                         &changesSize, page, &pageSize));
+            LE_ASSERT(30 - LE_WIFICLIENTEXT_SCAN_PAGE_MAX_ENTRIES == changesSize);
+            break;
+
+        case 3:
+            // Scan1 updated, Scan3 (deleted by TestWifiClient_ScanIndex) and Scan30 added,
+            // Scan0 removed, in this order
+            LE_ASSERT(2 == LastScanChanges.addedCount);
+            LE_ASSERT(1 == LastScanChanges.removedCount);
+            LE_ASSERT(1 == LastScanChanges.updatedCount);
+            LE_ASSERT_OK(le_wifiClientExt_GetScanChanges(0, &scanId, &total, changes,
+                                                         &changesSize, page, &pageSize));
+            LE_ASSERT(LastScanChanges.scanId == scanId);
+            LE_ASSERT(4 == total);
+            LE_ASSERT(4 == changesSize);
+            LE_ASSERT(LE_WIFICLIENTEXT_SCAN_CHANGE_UPDATED == changes[0]);
+            LE_ASSERT(1 == page[LE_WIFICLIENTEXT_SCAN_ENTRY_BSSID_OFFSET + 5]);
+            LE_ASSERT(LE_WIFICLIENTEXT_SCAN_CHANGE_ADDED == changes[1]);
+            LE_ASSERT(3 == page[LE_WIFICLIENTEXT_SCAN_ENTRY_BYTES +
+                                LE_WIFICLIENTEXT_SCAN_ENTRY_BSSID_OFFSET + 5]);
+            LE_ASSERT(LE_WIFICLIENTEXT_SCAN_CHANGE_ADDED == changes[2]);
+            LE_ASSERT(30 == page[2 * LE_WIFICLIENTEXT_SCAN_ENTRY_BYTES +
+                                 LE_WIFICLIENTEXT_SCAN_ENTRY_BSSID_OFFSET + 5]);
+            LE_ASSERT(LE_WIFICLIENTEXT_SCAN_CHANGE_REMOVED == changes[3]);
+            LE_ASSERT(0 == page[3 * LE_WIFICLIENTEXT_SCAN_ENTRY_BYTES +
+                                LE_WIFICLIENTEXT_SCAN_ENTRY_BSSID_OFFSET + 5]);
+            // The last seen signal of the removed access point
+            LE_ASSERT(-40 == (int8_t)page[3 * LE_WIFICLIENTEXT_SCAN_ENTRY_BYTES +
+                                          LE_WIFICLIENTEXT_SCAN_ENTRY_SIGNAL_OFFSET]);
+            break;
+
+        case 5:
+            // Directed scan on 2412 MHz: Scan13 removed, Scan26 and the access points on the
+            // other frequencies kept
+            LE_ASSERT(0 == LastScanChanges.addedCount);
+            LE_ASSERT(1 == LastScanChanges.removedCount);
+            LE_ASSERT(0 == LastScanChanges.updatedCount);
+            LE_ASSERT_OK(le_wifiClientExt_GetScanChanges(0, &scanId, &total, changes,
+                                                         &changesSize, page, &pageSize));
+            LE_ASSERT(1 == changesSize);
+            LE_ASSERT(LE_WIFICLIENTEXT_SCAN_CHANGE_REMOVED == changes[0]);
+            LE_ASSERT(13 == page[LE_WIFICLIENTEXT_SCAN_ENTRY_BSSID_OFFSET + 5]);
+            pageSize = sizeof(page);
+            LE_ASSERT_OK(le_wifiClientExt_GetScanResults(0, &scanId, &total, page, &pageSize));
+            LE_ASSERT(29 == total);
+            break;
+
+        case 6:
+            // Cached scan: Scan13 found again, STUB_CACHED_AGE_MS old
+            LE_ASSERT(1 == LastScanChanges.addedCount);
+            LE_ASSERT(0 == LastScanChanges.removedCount);
+            LE_ASSERT(0 == LastScanChanges.updatedCount);
+            LE_ASSERT_OK(le_wifiClientExt_GetScanChanges(0, &scanId, &total, changes,
+                                                         &changesSize, page, &pageSize));
+            LE_ASSERT(1 == changesSize);
+            LE_ASSERT(LE_WIFICLIENTEXT_SCAN_CHANGE_ADDED == changes[0]);
+            LE_ASSERT(13 == page[LE_WIFICLIENTEXT_SCAN_ENTRY_BSSID_OFFSET + 5]);
+            LE_ASSERT(STUB_CACHED_AGE_MS <=
+                      (page[LE_WIFICLIENTEXT_SCAN_ENTRY_AGE_OFFSET] |
+                       page[LE_WIFICLIENTEXT_SCAN_ENTRY_AGE_OFFSET + 1] << 8 |
+                       page[LE_WIFICLIENTEXT_SCAN_ENTRY_AGE_OFFSET + 2] << 16 |
+                       (uint32_t)page[LE_WIFICLIENTEXT_SCAN_ENTRY_AGE_OFFSET + 3] << 24));
+            pageSize = sizeof(page);
+            LE_ASSERT_OK(le_wifiClientExt_GetScanResults(0, &scanId, &total, page, &pageSize));
+            LE_ASSERT(30 == total);
+            break;
+
+        default:
+            // Same access points
+            LE_ASSERT(0 == LastScanChanges.addedCount);
+            LE_ASSERT(0 == LastScanChanges.removedCount);
+            LE_ASSERT(0 == LastScanChanges.updatedCount);
+            LE_ASSERT_OK(le_wifiClientExt_GetScanChanges(0, &scanId, &total, changes,
+                                                         &changesSize, page, &pageSize));
+            LE_ASSERT(0 == total);
+            LE_ASSERT(0 == changesSize);
+            LE_ASSERT(LE_OUT_OF_RANGE == le_wifiClientExt_GetScanChanges(1, &scanId, &total,
+                                                                         changes, &changesSize,
+                                                                         page, &pageSize));
+            break;
+
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check the eviction of the access points of the third scan, with the table limited to the size
+ * of one scan
+ *
+ * API tested:
+ * - le_wifiClientExt_GetApTableStats
+ * - le_wifiClient_Create on an evicted SSID
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestWifiClient_ApTable
+(
+    void
+)
+{
+    const uint8_t                  ssid[] = "Scan0";
+    le_wifiClient_AccessPointRef_t ref;
+    char                           bssid[LE_WIFIDEFS_MAX_BSSID_BYTES];
+    uint32_t                       count;
+    uint32_t                       maxCount;
+    uint32_t                       agedOutCount;
+    uint32_t                       evictedCount;
+
+    LE_ASSERT_OK(le_wifiClientExt_GetApTableStats(&count, &maxCount, &agedOutCount,
+                                                  &evictedCount));
+    LE_ASSERT(STUB_AP_TABLE_MAX == maxCount);
+    LE_ASSERT(0 == agedOutCount);
+
+    // Scan0, not found by the third scan, is the only one which can be evicted
+    LE_ASSERT(1 == evictedCount);
+    LE_ASSERT(count >= maxCount);
+
+    // Its SSID is now unknown: a new access point without BSSID is created
+    ref = le_wifiClient_Create(ssid, sizeof(ssid) - 1);
+    LE_ASSERT(NULL != ref);
+    LE_ASSERT_OK(le_wifiClient_GetBssid(ref, bssid, sizeof(bssid)));
+    LE_ASSERT('\0' == bssid[0]);
+    LE_ASSERT_OK(le_wifiClient_Delete(ref));
+}
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Configure a WIFI client reference
@@ -422,6 +868,497 @@ static void TestWifiClient_ConfigureSecurity_NegTests
 }
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check the scan run by the scan scheduler, then remove the scan request
+ *
+ * API tested:
+ * - le_wifiClientExt_AddScanRequest
+ * - le_wifiClientExt_RemoveScanRequest
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestWifiClient_ScanScheduler
+(
+    void
+)
+{
+    LE_ASSERT(4 == ScanDoneCount);
+    LE_ASSERT(NULL == le_wifiClientExt_AddScanRequest(0));
+
+    LE_ASSERT_OK(le_wifiClientExt_RemoveScanRequest(ScanRequestRef));
+    LE_ASSERT(LE_BAD_PARAMETER == le_wifiClientExt_RemoveScanRequest(ScanRequestRef));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Start a scan and attach a second request to it
+ *
+ * API tested:
+ * - le_wifiClient_Scan while a scan is running
+ * - le_wifiClient_GetFirstAccessPoint while a scan is running
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestWifiClient_ScanCoalescing
+(
+    void
+)
+{
+    LE_ASSERT_OK(le_wifiClient_Scan());
+
+    // Attached to the running scan: a single scan and SCAN_DONE event serve both calls
+    LE_ASSERT_OK(le_wifiClient_Scan());
+
+    // The results of the previous scan remain readable
+    LE_ASSERT(NULL != le_wifiClient_GetFirstAccessPoint());
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Start a scan directed to the first channel, after checking the invalid parameters
+ *
+ * API tested:
+ * - le_wifiClientExt_DirectedScan
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestWifiClient_DirectedScan
+(
+    void
+)
+{
+    const uint16_t frequencies[] = { 2412 };
+    const uint16_t badFrequencies[] = { 2412, 0 };
+    const uint8_t  badSsids[] = { 5, 'S', 'c', 'a', 'n' };
+
+    LE_ASSERT(LE_BAD_PARAMETER == le_wifiClientExt_DirectedScan(frequencies, 0, NULL, 0));
+    LE_ASSERT(LE_BAD_PARAMETER ==
+              le_wifiClientExt_DirectedScan(badFrequencies, NUM_ARRAY_MEMBERS(badFrequencies),
+                                            NULL, 0));
+    LE_ASSERT(LE_BAD_PARAMETER ==
+              le_wifiClientExt_DirectedScan(NULL, 0, badSsids, sizeof(badSsids)));
+
+    LE_ASSERT_OK(le_wifiClientExt_DirectedScan(frequencies, NUM_ARRAY_MEMBERS(frequencies),
+                                               NULL, 0));
+    LE_ASSERT(LE_BUSY == le_wifiClientExt_DirectedScan(frequencies,
+                                                       NUM_ARRAY_MEMBERS(frequencies), NULL, 0));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Auto-connect to the saved networks found by the latest scan, continued by
+ * TestWifiClient_AutoConnected: wpa_supplicant is given all of them, the connection to the network
+ * of highest priority fails in the stub, which fails over to the stronger of the two next ones
+ *
+ * API tested:
+ * - le_wifiClientExt_SetProfilePriority
+ * - le_wifiClientExt_SetAutoConnect
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestWifiClient_AutoConnect
+(
+    void
+)
+{
+    const uint8_t                  failingSsid[] = "Scan20";
+    const uint8_t                  strongSsid[] = "Scan2";
+    const uint8_t                  weakSsid[] = "Scan4";
+    le_wifiClient_AccessPointRef_t ref = NULL;
+
+    LE_ASSERT(LE_BAD_PARAMETER == le_wifiClientExt_SetProfilePriority(NULL, 0, 1));
+    LE_ASSERT_OK(le_wifiClientExt_SetProfilePriority(failingSsid, sizeof(failingSsid), 5));
+    LE_ASSERT_OK(le_wifiClientExt_SetProfilePriority(strongSsid, sizeof(strongSsid), 1));
+    LE_ASSERT_OK(le_wifiClientExt_SetProfilePriority(weakSsid, sizeof(weakSsid), 1));
+
+    // The latest scan results are recent: the connection is started at once, the network chosen
+    // by wpa_supplicant is known from the connection event
+    LE_ASSERT_OK(le_wifiClientExt_SetAutoConnect(true));
+    le_wifiClient_GetCurrentConnection(&ref);
+    LE_ASSERT(NULL == ref);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check the roam attempt, then end the test: the link moved to the access point found by the second
+ * roam scan.
+ *
+ * API tested:
+ * - le_wifiClientExt_AddRoamHandler
+ */
+//--------------------------------------------------------------------------------------------------
+static void RoamHandler
+(
+    const char  *fromBssid,
+    const char  *toBssid,
+    le_result_t  result,
+    uint32_t     timeToRoamMs,
+    void        *contextPtr
+)
+{
+    LE_ASSERT(2 == RoamTest.scanCount);
+    LE_ASSERT(0 == strcmp(fromBssid, "02:00:00:00:01:00"));
+    LE_ASSERT(0 == strcmp(toBssid, "02:00:00:00:01:01"));
+    LE_ASSERT_OK(result);
+
+    // From the weak link detection to the reassociation completed by the stub
+    LE_ASSERT(timeToRoamMs >= STUB_ROAM_DELAY_MS);
+    LE_ASSERT(timeToRoamMs < STUB_ROAM_DWELL_MS);
+
+    LE_ASSERT_OK(le_wifiClient_Disconnect());
+
+    LE_INFO ("======== UnitTest of WiFi client SUCCESS ========");
+
+    exit(EXIT_SUCCESS);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check the roam scans: the first one finds the second access point of the SSID 4 dB stronger,
+ * below the hysteresis, so that the link stays. The second one, run once the dwell time is over,
+ * finds it 20 dB stronger and the link moves to it.
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestWifiClient_RoamScanDone
+(
+    void
+)
+{
+    le_clk_Time_t elapsed;
+
+    RoamTest.scanCount++;
+    if (1 == RoamTest.scanCount)
+    {
+        RoamTest.scanTime = le_clk_GetRelativeTime();
+        return;
+    }
+
+    LE_ASSERT(2 == RoamTest.scanCount);
+    elapsed = le_clk_Sub(le_clk_GetRelativeTime(), RoamTest.scanTime);
+    LE_ASSERT(elapsed.sec * 1000 + elapsed.usec / 1000 >= STUB_ROAM_DWELL_MS);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Connect to the SSID of two access points with a weak link to the first one, continued by
+ * TestWifiClient_RoamScanDone and RoamHandler
+ *
+ * API tested:
+ * - le_wifiClient_Connect, watched by the roaming engine
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestWifiClient_Roam
+(
+    void
+)
+{
+    const uint8_t                  ssid[] = "Roam";
+    le_wifiClient_AccessPointRef_t ref;
+
+    LE_ASSERT(NULL != le_wifiClientExt_AddRoamHandler(RoamHandler, NULL));
+    RoamTest.isStarted = true;
+
+    ref = le_wifiClient_Create(ssid, sizeof(ssid) - 1);
+    LE_ASSERT(NULL != ref);
+    LE_ASSERT_OK(le_wifiClient_Connect(ref));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check the network connected by the auto-connect, then start the roaming test. Queued by the
+ * connection event so that the auto-connect handled the event first.
+ *
+ * API tested:
+ * - le_wifiClient_GetCurrentConnection, bound to the network chosen by wpa_supplicant
+ * - le_wifiClient_Disconnect, suspending the auto-connect
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestWifiClient_AutoConnected
+(
+    void *param1Ptr,
+    void *param2Ptr
+)
+{
+    const uint8_t                  strongSsid[] = "Scan2";
+    uint8_t                        ssid[LE_WIFIDEFS_MAX_SSID_BYTES];
+    size_t                         ssidLen = sizeof(ssid);
+    le_wifiClient_AccessPointRef_t ref = NULL;
+
+    le_wifiClient_GetCurrentConnection(&ref);
+    LE_ASSERT(NULL != ref);
+    LE_ASSERT_OK(le_wifiClient_GetSsid(ref, ssid, &ssidLen));
+    LE_ASSERT((sizeof(strongSsid) - 1 == ssidLen) && (0 == memcmp(ssid, strongSsid, ssidLen)));
+
+    LE_ASSERT_OK(le_wifiClient_Disconnect());
+    le_wifiClient_GetCurrentConnection(&ref);
+    LE_ASSERT(NULL == ref);
+
+    // The auto-connect released its start of the WiFi device, the test holds the other one
+    LE_ASSERT_OK(le_wifiClientExt_SetAutoConnect(false));
+    LE_ASSERT_OK(le_wifiClient_Stop());
+    LE_ASSERT(LE_DUPLICATE == le_wifiClient_Stop());
+    LE_ASSERT_OK(le_wifiClient_Start());
+
+    TestWifiClient_Roam();
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Handler of the ScanChanges event, reported before LE_WIFICLIENT_EVENT_SCAN_DONE.
+ */
+//--------------------------------------------------------------------------------------------------
+static void ScanChangesHandler
+(
+    uint32_t  scanId,
+    uint32_t  addedCount,
+    uint32_t  removedCount,
+    uint32_t  updatedCount,
+    void     *contextPtr
+)
+{
+    LastScanChanges.scanId = scanId;
+    LastScanChanges.addedCount = addedCount;
+    LastScanChanges.removedCount = removedCount;
+    LastScanChanges.updatedCount = updatedCount;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Handler of the scan events: the scan results are committed by the main thread, the scan tests
+ * run from its event loop. The connection event ends the auto-connect test, the roaming test
+ * follows.
+ */
+//--------------------------------------------------------------------------------------------------
+static void ScanEventHandler
+(
+    const le_wifiClient_EventInd_t *wifiEventIndPtr,
+    void                           *contextPtr
+)
+{
+    if (LE_WIFICLIENT_EVENT_SCAN_FAILED == wifiEventIndPtr->event)
+    {
+        LE_FATAL("Scan failed");
+    }
+    if (RoamTest.isStarted)
+    {
+        if (LE_WIFICLIENT_EVENT_SCAN_DONE == wifiEventIndPtr->event)
+        {
+            TestWifiClient_RoamScanDone();
+        }
+        return;
+    }
+    if (LE_WIFICLIENT_EVENT_CONNECTED == wifiEventIndPtr->event)
+    {
+        le_event_QueueFunction(TestWifiClient_AutoConnected, NULL, NULL);
+        return;
+    }
+    if (LE_WIFICLIENT_EVENT_SCAN_DONE != wifiEventIndPtr->event)
+    {
+        return;
+    }
+
+    ScanDoneCount++;
+    if (1 == ScanDoneCount)
+    {
+        TestWifiClient_GetScanResults();
+        TestWifiClient_ScanChanges();
+        TestWifiClient_ScanCoalescing();
+        return;
+    }
+    if (2 == ScanDoneCount)
+    {
+        TestWifiClient_ScanChanges();
+        TestWifiClient_ScanIndex();
+        LE_ASSERT_OK(le_wifiClient_Scan());
+        return;
+    }
+
+    TestWifiClient_ScanChanges();
+    if (3 == ScanDoneCount)
+    {
+        TestWifiClient_ApTable();
+
+        // The next scan is run by the scan scheduler
+        ScanRequestRef = le_wifiClientExt_AddScanRequest(STUB_SCAN_MAX_AGE_MS);
+        LE_ASSERT(NULL != ScanRequestRef);
+        return;
+    }
+
+    if (4 == ScanDoneCount)
+    {
+        TestWifiClient_ScanScheduler();
+        TestWifiClient_DirectedScan();
+        return;
+    }
+    if (5 == ScanDoneCount)
+    {
+        // Publish the access points cached by the stub
+        LE_ASSERT_OK(le_wifiClientExt_CachedScan());
+        return;
+    }
+
+    TestWifiClient_AutoConnect();
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Start the scan tests, continued by ScanEventHandler
+ *
+ * API tested:
+ * - le_wifiClient_Scan, attached to the running scan
+ * - le_wifiClientExt_GetScanResults while scanning
+ * - le_wifiClientExt_AddScanChangesHandler
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestWifiClient_Scan
+(
+    void
+)
+{
+    uint8_t  page[LE_WIFICLIENTEXT_SCAN_PAGE_MAX_BYTES];
+    size_t   pageSize = sizeof(page);
+    uint32_t scanId;
+    uint32_t total;
+
+    LE_ASSERT(NULL != le_wifiClient_AddConnectionEventHandler(ScanEventHandler, NULL));
+    LE_ASSERT(NULL != le_wifiClientExt_AddScanChangesHandler(ScanChangesHandler, NULL));
+
+    LE_ASSERT_OK(le_wifiClient_Scan());
+    LE_ASSERT_OK(le_wifiClient_Scan());
+    // No scan committed yet
+    LE_ASSERT_OK(le_wifiClientExt_GetScanResults(0, &scanId, &total, page, &pageSize));
+    LE_ASSERT(0 == total);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check that the scan request made while the WiFi device was stopped started no scan, then start
+ * the device and the scan tests.
+ *
+ * API tested:
+ * - le_wifiClientExt_RemoveScanRequest
+ * - le_wifiClient_Start, with no scan request left
+ */
+//--------------------------------------------------------------------------------------------------
+static void StoppedScanTimerHandler
+(
+    le_timer_Ref_t timerRef
+)
+{
+    le_timer_Delete(timerRef);
+
+    // The stub fails the test if a scan is started on the stopped device
+    LE_ASSERT_OK(le_wifiClientExt_RemoveScanRequest(ScanRequestRef));
+    ScanRequestRef = NULL;
+
+    LE_ASSERT_OK(le_wifiClient_Start());
+    TestWifiClient_Scan();
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Make a scan request while the WiFi device is stopped, continued by StoppedScanTimerHandler
+ *
+ * API tested:
+ * - le_wifiClientExt_AddScanRequest, on the stopped device
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestWifiClient_StoppedScanRequest
+(
+    void
+)
+{
+    le_timer_Ref_t timerRef = le_timer_Create("StoppedScanTimer");
+
+    ScanRequestRef = le_wifiClientExt_AddScanRequest(STUB_SCAN_MAX_AGE_MS);
+    LE_ASSERT(NULL != ScanRequestRef);
+
+    le_timer_SetMsInterval(timerRef, STUB_STOPPED_WAIT_MS);
+    le_timer_SetHandler(timerRef, StoppedScanTimerHandler);
+    le_timer_Start(timerRef);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Wait for the PMK of the saved network derived by the scan worker: once cached, it is handed to
+ * wpa_supplicant in place of the passphrase, and used by le_wifiClient_SetPassphrase(). Then start
+ * the scan tests.
+ *
+ * API tested:
+ * - le_wifiClient_SetPassphrase, with the PMK cached
+ */
+//--------------------------------------------------------------------------------------------------
+static void PmkTimerHandler
+(
+    le_timer_Ref_t timerRef
+)
+{
+    const uint8_t                  ssid[] = PMK_TEST_SSID;
+    const char                    *passphrasePtr;
+    const char                    *pskPtr;
+    le_wifiClient_AccessPointRef_t ref;
+
+    LE_ASSERT_OK(StubGetNetworkCredentials(PMK_TEST_SSID, &passphrasePtr, &pskPtr));
+    if ('\0' == pskPtr[0])
+    {
+        LE_ASSERT(le_timer_GetExpiryCount(timerRef) < PMK_POLL_MAX);
+        return;
+    }
+    le_timer_Delete(timerRef);
+
+    LE_ASSERT('\0' == passphrasePtr[0]);
+    LE_ASSERT(0 == strcmp(pskPtr, PMK_TEST_PSK));
+
+    ref = le_wifiClient_Create(ssid, sizeof(ssid) - 1);
+    LE_ASSERT(NULL != ref);
+    LE_ASSERT_OK(le_wifiClient_SetPassphrase(ref, PMK_TEST_PASSPHRASE));
+    LE_ASSERT(0 == strcmp(StubGetPreSharedKey(), PMK_TEST_PSK));
+    LE_ASSERT_OK(le_wifiClient_Delete(ref));
+
+    TestWifiClient_StoppedScanRequest();
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Save a network with a passphrase: its PMK is derived by the scan worker, continued by
+ * PmkTimerHandler
+ *
+ * API tested:
+ * - le_wifiClient_ConfigurePsk, with a passphrase
+ * - le_wifiClient_SetPassphrase, with no PMK cached yet
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestWifiClient_Pmk
+(
+    void
+)
+{
+    const uint8_t                  ssid[] = PMK_TEST_SSID;
+    const uint8_t                  passphrase[] = PMK_TEST_PASSPHRASE;
+    const char                    *passphrasePtr;
+    const char                    *pskPtr;
+    le_wifiClient_AccessPointRef_t ref;
+    le_timer_Ref_t                 timerRef;
+
+    LE_ASSERT_OK(le_wifiClient_ConfigurePsk(ssid, sizeof(ssid) - 1,
+                                            LE_WIFICLIENT_SECURITY_WPA2_PSK_PERSONAL,
+                                            passphrase, sizeof(passphrase) - 1, NULL, 0));
+
+    // Not derived yet: wpa_supplicant is given the passphrase
+    LE_ASSERT_OK(StubGetNetworkCredentials(PMK_TEST_SSID, &passphrasePtr, &pskPtr));
+    LE_ASSERT(0 == strcmp(passphrasePtr, PMK_TEST_PASSPHRASE));
+    LE_ASSERT('\0' == pskPtr[0]);
+
+    ref = le_wifiClient_Create(ssid, sizeof(ssid) - 1);
+    LE_ASSERT(NULL != ref);
+    LE_ASSERT_OK(le_wifiClient_SetPassphrase(ref, PMK_TEST_PASSPHRASE));
+    LE_ASSERT('\0' == StubGetPreSharedKey()[0]);
+    LE_ASSERT_OK(le_wifiClient_Delete(ref));
+
+    timerRef = le_timer_Create("PmkTimer");
+    le_timer_SetMsInterval(timerRef, PMK_POLL_MS);
+    le_timer_SetRepeat(timerRef, 0);
+    le_timer_SetHandler(timerRef, PmkTimerHandler);
+    le_timer_Start(timerRef);
+}
+
 //--------------------------------------------------------------------------------------------------
 /**
  * main of the test
@@ -430,6 +1367,14 @@ static void TestWifiClient_ConfigureSecurity_NegTests
 //--------------------------------------------------------------------------------------------------
 COMPONENT_INIT
 {
+    // Limit the access point table to the size of one scan
+    le_cfg_QuickSetInt("wifiService:/wifi/client/apTableMax", STUB_AP_TABLE_MAX);
+    // Every scan of the test must reach the stub
+    le_cfg_QuickSetInt("wifiService:/wifi/client/scanReuseWindowMs", 0);
+    // The link of the roaming test is below the default roam threshold
+    le_cfg_QuickSetBool("wifiService:/wifi/client/roamEnable", true);
+    le_cfg_QuickSetInt("wifiService:/wifi/client/roamDwellMs", STUB_ROAM_DWELL_MS);
+
     le_wifiClient_Init();
 
     LE_INFO ("======== Start UnitTest of WiFi client ========");
@@ -440,13 +1385,15 @@ COMPONENT_INIT
 
     TestWifiClient_ConnectDisconnect();
 
+    TestWifiClient_GetLinkInfo();
+
     TestWifiClient_Configure();
 
     TestWifiClient_LoadSsid();
 
     TestWifiClient_ConfigureSecurity_NegTests();
 
-    LE_INFO ("======== UnitTest of WiFi client SUCCESS ========");
-
-    exit(EXIT_SUCCESS);
+    // The PMK and the scan results are committed by the event loop: the test ends in
+    // ScanEventHandler
+    TestWifiClient_Pmk();
 }
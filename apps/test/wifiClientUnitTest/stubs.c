@@ -8,6 +8,7 @@
 
 #include "legato.h"
 #include "interfaces.h"
+#include "stubs.h"
 
 //--------------------------------------------------------------------------------------------------
 /**
@@ -43,6 +44,202 @@ typedef void (*pa_wifiClient_EventIndHandlerFunc_t)
         ///< Associated WiFi event context
 );
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Security flags of an access point found during a scan.
+ */
+//--------------------------------------------------------------------------------------------------
+#define PA_WIFICLIENT_SCAN_SECURITY_PRIVACY 0x01
+#define PA_WIFICLIENT_SCAN_SECURITY_WPA2    0x04
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of access points found by a scan.
+ */
+//--------------------------------------------------------------------------------------------------
+#define STUB_SCAN_AP_COUNT  30
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Age of the access points returned by a cached scan (ms).
+ */
+//--------------------------------------------------------------------------------------------------
+#define STUB_CACHED_AGE_MS  5000
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * SSID to which pa_wifiClient_Connect() fails.
+ */
+//--------------------------------------------------------------------------------------------------
+#define STUB_CONNECT_FAIL_SSID  "Scan20"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * SSID of the roaming test, served by two access points: STUB_ROAM_AP_COUNT access points, the
+ * first one is connected with a weak link.
+ */
+//--------------------------------------------------------------------------------------------------
+#define STUB_ROAM_SSID      "Roam"
+#define STUB_ROAM_AP_COUNT  2
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Index of the first access point of STUB_ROAM_SSID, given to ReportStubConnected(): its BSSID is
+ * 02:00:00:00:01:00.
+ */
+//--------------------------------------------------------------------------------------------------
+#define STUB_ROAM_AP_INDEX  0x100
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Time taken by a reassociation started by pa_wifiClient_Roam() (ms).
+ */
+//--------------------------------------------------------------------------------------------------
+#define STUB_ROAM_DELAY_MS  50
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum number of saved networks handed to wpa_supplicant.
+ */
+//--------------------------------------------------------------------------------------------------
+#define PA_WIFICLIENT_MAX_NETWORKS  16
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Saved network handed to wpa_supplicant.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    uint8_t  ssidLength;                                    ///< SSID length.
+    uint8_t  ssidBytes[LE_WIFIDEFS_MAX_SSID_BYTES];         ///< SSID bytes.
+    bool     isHidden;                                      ///< The SSID must be probed.
+    int32_t  priority;                                      ///< Higher priorities are chosen
+                                                            ///< first.
+    le_wifiClient_SecurityProtocol_t securityProtocol;      ///< Security protocol.
+    char     wepKey[LE_WIFIDEFS_MAX_WEPKEY_BYTES];          ///< WEP key.
+    char     passphrase[LE_WIFIDEFS_MAX_PASSPHRASE_BYTES];  ///< WPA passphrase, or
+    char     preSharedKey[LE_WIFIDEFS_MAX_PSK_BYTES];       ///< WPA pre-shared key (hex).
+    char     username[LE_WIFIDEFS_MAX_USERNAME_BYTES];      ///< EAP username.
+    char     password[LE_WIFIDEFS_MAX_PASSWORD_BYTES];      ///< EAP password.
+}
+pa_wifiClient_Network_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Saved networks set by pa_wifiClient_SetNetworks().
+ */
+//--------------------------------------------------------------------------------------------------
+static pa_wifiClient_Network_t StubNetworks[PA_WIFICLIENT_MAX_NETWORKS];
+static size_t                  StubNetworkCount = 0;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Connection event handler registered by pa_wifiClient_AddEventIndHandler(), and the pool of its
+ * events.
+ */
+//--------------------------------------------------------------------------------------------------
+static pa_wifiClient_EventIndHandlerFunc_t StubEventIndHandlerPtr = NULL;
+static void                               *StubEventIndContextPtr = NULL;
+static le_mem_PoolRef_t                    StubEventPool = NULL;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set by pa_wifiClient_Start(), cleared by pa_wifiClient_Stop(): no scan can run on a stopped
+ * WiFi device.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool StubIsStarted = false;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Pre-shared key set by pa_wifiClient_SetPreSharedKey(), cleared by pa_wifiClient_SetPassphrase().
+ */
+//--------------------------------------------------------------------------------------------------
+static char StubPreSharedKey[LE_WIFIDEFS_MAX_PSK_BYTES] = {0};
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum number and size of the items written to the secure storage stub.
+ */
+//--------------------------------------------------------------------------------------------------
+#define STUB_SECSTORE_ITEM_MAX      16
+#define STUB_SECSTORE_ITEM_BYTES    128
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Item written to the secure storage stub.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    char    name[LE_CFG_STR_LEN_BYTES];         ///< Name of the item, empty if unused.
+    uint8_t data[STUB_SECSTORE_ITEM_BYTES];     ///< Data of the item.
+    size_t  size;                               ///< Size of the data.
+}
+StubSecStoreItem_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Items written to the secure storage stub.
+ */
+//--------------------------------------------------------------------------------------------------
+static StubSecStoreItem_t StubSecStoreItems[STUB_SECSTORE_ITEM_MAX];
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Index of the next access point returned by pa_wifiClient_GetScanResult().
+ */
+//--------------------------------------------------------------------------------------------------
+static uint32_t StubScanIndex = STUB_SCAN_AP_COUNT;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of scans started. From the third scan on, access point 0 is no longer found, access
+ * point 1 is 10 dB weaker and access point STUB_SCAN_AP_COUNT is found.
+ */
+//--------------------------------------------------------------------------------------------------
+static uint32_t StubScanCount = 0;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set by pa_wifiClient_DirectedScan(): access point 13 is then no longer found.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool StubIsDirectedScan = false;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set by pa_wifiClient_CachedScan(): the access points are then STUB_CACHED_AGE_MS old.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool StubIsCachedScan = false;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set by a directed scan probing STUB_ROAM_SSID: only its access points are then found.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool StubIsRoamScan = false;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of directed scans probing STUB_ROAM_SSID. The second access point of STUB_ROAM_SSID is
+ * 4 dB stronger than the first one for the first scan, then 20 dB stronger.
+ */
+//--------------------------------------------------------------------------------------------------
+static uint32_t StubRoamScanCount = 0;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Access point of STUB_ROAM_SSID to which the link is established, STUB_ROAM_AP_COUNT when not
+ * connected to STUB_ROAM_SSID, and the timer of the reassociations started by
+ * pa_wifiClient_Roam().
+ */
+//--------------------------------------------------------------------------------------------------
+static uint32_t       StubRoamLinkIndex = STUB_ROAM_AP_COUNT;
+static le_timer_Ref_t StubRoamTimer = NULL;
+
 //--------------------------------------------------------------------------------------------------
 /**
  * AccessPoint structure.
@@ -57,8 +254,58 @@ typedef struct
     char     bssid[LE_WIFIDEFS_MAX_BSSID_BYTES];    ///< Contains the bssid.
     uint64_t rx;                                    ///< Rx of access point (bytes).
     uint64_t tx;                                    ///< Tx of access point (bytes).
+    uint16_t frequency;                             ///< Frequency (MHz), 0 if unknown.
+    uint8_t  securityFlags;                         ///< PA_WIFICLIENT_SCAN_SECURITY_* flags.
+    uint32_t ageMs;                                 ///< Time since the access point was last
+                                                    ///< seen by a scan (ms), 0 if just seen.
 } pa_wifiClient_AccessPoint_t;
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * State of the current link.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    pa_wifiClient_AccessPoint_t accessPoint;    ///< Connected access point, signal and bytes.
+    uint32_t                    rxBitrate;      ///< Bitrate of the last received frame (kbit/s),
+                                                ///< 0 if unknown.
+    uint32_t                    txBitrate;      ///< Bitrate of the last sent frame (kbit/s),
+                                                ///< 0 if unknown.
+    uint32_t                    frequency;      ///< Operating frequency (MHz).
+} pa_wifiClient_LinkInfo_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Scan backends.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef enum
+{
+    PA_WIFICLIENT_SCAN_BACKEND_SCRIPT = 0,  ///< Scan through the pa_wifi script and iw.
+    PA_WIFICLIENT_SCAN_BACKEND_NL80211      ///< Scan through nl80211 generic netlink messages.
+}
+pa_wifiClient_ScanBackend_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Parameters of a directed scan.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    uint16_t frequencies[16];                           ///< Frequencies to scan (MHz).
+    size_t   frequencyCount;                            ///< Number of frequencies, 0 for all.
+    struct
+    {
+        uint8_t length;                                 ///< Number of bytes of the SSID.
+        uint8_t bytes[LE_WIFIDEFS_MAX_SSID_BYTES];      ///< SSID.
+    }
+    ssids[4];                                           ///< SSIDs to probe.
+    size_t   ssidCount;                                 ///< Number of SSIDs, 0 for none.
+}
+pa_wifiClient_ScanParams_t;
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Struct to hold the AccessPoint from the Scan's data.
@@ -87,6 +334,21 @@ le_result_t pa_wifiClient_Init
     return LE_OK;
 }
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Select the backend used by pa_wifiClient_Scan().
+ *
+ * @return LE_OK     The function succeeded.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiClient_SetScanBackend
+(
+    pa_wifiClient_ScanBackend_t backend
+)
+{
+    return LE_OK;
+}
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Start WiFi Client PA
@@ -100,6 +362,7 @@ le_result_t pa_wifiClient_Start
     void
 )
 {
+    StubIsStarted = true;
     return LE_OK;
 }
 
@@ -116,9 +379,118 @@ le_result_t pa_wifiClient_Stop
     void
 )
 {
+    StubIsStarted = false;
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the time taken by the last start of the WiFi client.
+ *
+ * @return LE_OK            The function succeeded.
+ * @return LE_UNAVAILABLE   The WiFi client was not started yet.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiClient_GetStartLatency
+(
+    uint32_t *interfaceUpMsPtr
+)
+{
+    *interfaceUpMsPtr = 1;
     return LE_OK;
 }
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the signal of the access point of a given index found by the stub scans.
+ *
+ * @return The signal (dBm), or LE_WIFICLIENT_NO_SIGNAL_STRENGTH if the access point is not found.
+ */
+//--------------------------------------------------------------------------------------------------
+static int16_t GetStubSignal
+(
+    uint32_t index
+)
+{
+    int16_t signal = -40 - (int16_t)index;
+
+    if (index >= STUB_SCAN_AP_COUNT + ((StubScanCount >= 3) ? 1 : 0))
+    {
+        return LE_WIFICLIENT_NO_SIGNAL_STRENGTH;
+    }
+    if ((StubScanCount >= 3) && (1 == index))
+    {
+        signal -= 10;
+    }
+    return signal;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Report the connection to the access point of a given index, STUB_ROAM_AP_INDEX and above for
+ * the access points of STUB_ROAM_SSID.
+ */
+//--------------------------------------------------------------------------------------------------
+static void ReportStubConnected
+(
+    void *param1Ptr,
+    void *param2Ptr
+)
+{
+    le_wifiClient_EventInd_t *eventPtr;
+
+    if (NULL == StubEventIndHandlerPtr)
+    {
+        return;
+    }
+    if (NULL == StubEventPool)
+    {
+        StubEventPool = le_mem_CreatePool("StubEventPool", sizeof(le_wifiClient_EventInd_t));
+    }
+
+    eventPtr = le_mem_ForceAlloc(StubEventPool);
+    memset(eventPtr, 0, sizeof(le_wifiClient_EventInd_t));
+    eventPtr->event = LE_WIFICLIENT_EVENT_CONNECTED;
+    le_utf8_Copy(eventPtr->ifName, "wlan0", sizeof(eventPtr->ifName), NULL);
+    snprintf(eventPtr->apBssid, sizeof(eventPtr->apBssid), "02:00:00:00:%02x:%02x",
+             (unsigned int)((uintptr_t)param1Ptr >> 8),
+             (unsigned int)((uintptr_t)param1Ptr & 0xff));
+    StubEventIndHandlerPtr(eventPtr, StubEventIndContextPtr);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the signal of the access point of a given index of STUB_ROAM_SSID: the first one is below
+ * the roam threshold of the test, see StubRoamScanCount for the second one.
+ *
+ * @return The signal (dBm).
+ */
+//--------------------------------------------------------------------------------------------------
+static int16_t GetStubRoamSignal
+(
+    uint32_t index
+)
+{
+    if (0 == index)
+    {
+        return -80;
+    }
+    return (StubRoamScanCount <= 1) ? -76 : -60;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Complete the reassociation started by pa_wifiClient_Roam().
+ */
+//--------------------------------------------------------------------------------------------------
+static void StubRoamTimerHandler
+(
+    le_timer_Ref_t timerRef
+)
+{
+    ReportStubConnected((void *)(uintptr_t)(STUB_ROAM_AP_INDEX + StubRoamLinkIndex), NULL);
+}
+
 //--------------------------------------------------------------------------------------------------
 /**
  * This function connects a wifiClient.
@@ -137,6 +509,18 @@ le_result_t pa_wifiClient_Connect
         ///< The number of Bytes in the ssidBytes
 )
 {
+    if ((strlen(STUB_CONNECT_FAIL_SSID) == ssidLength) &&
+        (0 == memcmp(ssidBytes, STUB_CONNECT_FAIL_SSID, ssidLength)))
+    {
+        return LE_FAULT;
+    }
+    if ((strlen(STUB_ROAM_SSID) == ssidLength) &&
+        (0 == memcmp(ssidBytes, STUB_ROAM_SSID, ssidLength)))
+    {
+        // Connected to the first access point of the SSID
+        StubRoamLinkIndex = 0;
+        le_event_QueueFunction(ReportStubConnected, (void *)(uintptr_t)STUB_ROAM_AP_INDEX, NULL);
+    }
     return LE_OK;
 }
 
@@ -154,6 +538,135 @@ le_result_t pa_wifiClient_Disconnect
     void
 )
 {
+    StubRoamLinkIndex = STUB_ROAM_AP_COUNT;
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * This function starts the reassociation to another BSSID of the selected network. The
+ * reassociation to an access point of STUB_ROAM_SSID is reported by an event STUB_ROAM_DELAY_MS
+ * later.
+ *
+ * @return LE_BAD_PARAMETER  Invalid BSSID.
+ * @return LE_OK             The function succeeded.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiClient_Roam
+(
+    const char *bssidPtr
+        ///< [IN]
+        ///< BSSID to reassociate to
+)
+{
+    unsigned int high;
+    unsigned int low;
+    unsigned int index;
+
+    if (NULL == bssidPtr)
+    {
+        return LE_BAD_PARAMETER;
+    }
+    if (2 != sscanf(bssidPtr, "02:00:00:00:%02x:%02x", &high, &low))
+    {
+        return LE_OK;
+    }
+    index = (high << 8) | low;
+    if ((index < STUB_ROAM_AP_INDEX) || (index >= STUB_ROAM_AP_INDEX + STUB_ROAM_AP_COUNT))
+    {
+        return LE_OK;
+    }
+
+    StubRoamLinkIndex = index - STUB_ROAM_AP_INDEX;
+    if (NULL == StubRoamTimer)
+    {
+        StubRoamTimer = le_timer_Create("StubRoamTimer");
+        le_timer_SetMsInterval(StubRoamTimer, STUB_ROAM_DELAY_MS);
+        le_timer_SetHandler(StubRoamTimer, StubRoamTimerHandler);
+    }
+    le_timer_Start(StubRoamTimer);
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * This function sets the saved networks among which wpa_supplicant chooses.
+ *
+ * @return LE_BAD_PARAMETER  Too many networks.
+ * @return LE_OK             The function succeeded.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiClient_SetNetworks
+(
+    const pa_wifiClient_Network_t *networksPtr,
+        ///< [IN]
+        ///< Saved networks
+    size_t                         networkCount
+        ///< [IN]
+        ///< Number of networks
+)
+{
+    if (networkCount > PA_WIFICLIENT_MAX_NETWORKS)
+    {
+        return LE_BAD_PARAMETER;
+    }
+
+    memset(StubNetworks, 0, sizeof(StubNetworks));
+    if (0 != networkCount)
+    {
+        memcpy(StubNetworks, networksPtr, networkCount * sizeof(pa_wifiClient_Network_t));
+    }
+    StubNetworkCount = networkCount;
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * This function connects to the saved networks. As wpa_supplicant, the stub chooses the network
+ * found by the scans by priority then signal, failing over from STUB_CONNECT_FAIL_SSID. The
+ * connection is reported by an event.
+ *
+ * @return LE_NOT_FOUND  No saved network is found.
+ * @return LE_OK         The function succeeded.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiClient_ConnectAny
+(
+    void
+)
+{
+    const pa_wifiClient_Network_t *bestPtr = NULL;
+    uint32_t                       bestIndex = 0;
+    size_t                         i;
+
+    for (i = 0; i < StubNetworkCount; i++)
+    {
+        const pa_wifiClient_Network_t *networkPtr = &StubNetworks[i];
+        char                           ssid[LE_WIFIDEFS_MAX_SSID_BYTES] = {0};
+        unsigned int                   index;
+        int                            len = 0;
+
+        memcpy(ssid, networkPtr->ssidBytes, networkPtr->ssidLength);
+        if ((1 != sscanf(ssid, "Scan%u%n", &index, &len)) || (networkPtr->ssidLength != len) ||
+            (LE_WIFICLIENT_NO_SIGNAL_STRENGTH == GetStubSignal(index)) ||
+            (0 == strcmp(ssid, STUB_CONNECT_FAIL_SSID)))
+        {
+            continue;
+        }
+        if ((NULL == bestPtr) || (networkPtr->priority > bestPtr->priority) ||
+            ((networkPtr->priority == bestPtr->priority) &&
+             (GetStubSignal(index) > GetStubSignal(bestIndex))))
+        {
+            bestPtr = networkPtr;
+            bestIndex = index;
+        }
+    }
+
+    if (NULL == bestPtr)
+    {
+        return LE_NOT_FOUND;
+    }
+    le_event_QueueFunction(ReportStubConnected, (void *)(uintptr_t)bestIndex, NULL);
     return LE_OK;
 }
 
@@ -232,6 +745,7 @@ le_result_t pa_wifiClient_SetPassphrase
     LE_INFO("Set passphrase");
     if (NULL != passphrasePtr)
     {
+        memset(StubPreSharedKey, 0, sizeof(StubPreSharedKey));
         length = strlen(passphrasePtr);
 
         LE_INFO("Set passphrase");
@@ -273,6 +787,7 @@ le_result_t pa_wifiClient_SetPreSharedKey
     LE_INFO("Set PSK");
     if (NULL != preSharedKeyPtr)
     {
+       le_utf8_Copy(StubPreSharedKey, preSharedKeyPtr, sizeof(StubPreSharedKey), NULL);
        result = LE_OK;
     }
 
@@ -332,6 +847,64 @@ le_result_t pa_wifiClient_Scan
     void
 )
 {
+    LE_ASSERT(StubIsStarted);
+    StubScanCount++;
+    StubScanIndex = (StubScanCount >= 3) ? 1 : 0;
+    StubIsDirectedScan = false;
+    StubIsCachedScan = false;
+    StubIsRoamScan = false;
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * This function will start a scan limited to some frequencies and/or SSIDs, and returns when it
+ * is done. Results are read via pa_wifiClient_GetScanResult. Probing STUB_ROAM_SSID finds its
+ * access points only.
+ *
+ * @return LE_FAULT  The function failed.
+ * @return LE_BUSY   The function is already ongoing.
+ * @return LE_OK     The function succeeded.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiClient_DirectedScan
+(
+    const pa_wifiClient_ScanParams_t *paramsPtr
+)
+{
+    if ((0 != paramsPtr->ssidCount) && (strlen(STUB_ROAM_SSID) == paramsPtr->ssids[0].length) &&
+        (0 == memcmp(paramsPtr->ssids[0].bytes, STUB_ROAM_SSID, paramsPtr->ssids[0].length)))
+    {
+        StubRoamScanCount++;
+        StubScanIndex = 0;
+        StubIsRoamScan = true;
+        return LE_OK;
+    }
+
+    pa_wifiClient_Scan();
+    StubIsDirectedScan = true;
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * This function will read the access points cached by the kernel, without scanning. Results are
+ * read via pa_wifiClient_GetScanResult: those of the last scan, STUB_CACHED_AGE_MS old.
+ *
+ * @return LE_FAULT  The function failed.
+ * @return LE_BUSY   The function is already ongoing.
+ * @return LE_OK     The function succeeded.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiClient_CachedScan
+(
+    void
+)
+{
+    StubScanIndex = (StubScanCount >= 3) ? 1 : 0;
+    StubIsDirectedScan = false;
+    StubIsCachedScan = true;
+    StubIsRoamScan = false;
     return LE_OK;
 }
 
@@ -341,6 +914,10 @@ le_result_t pa_wifiClient_Scan
  * When the reading is done, it no longer returns LE_OK,
  * pa_wifiClient_ScanDone MUST be called.
  *
+ * Access point i is "Scan<i>", BSSID 02:00:00:00:00:<i>, signal -40 - i dBm, on channel
+ * 1 + i % 13; even access points are WPA2. See StubScanCount for the changes between scans.
+ * Access point i of STUB_ROAM_SSID has BSSID 02:00:00:00:01:<i>, on channel 6.
+ *
  * @return LE_NOT_FOUND  There is no more AP:s found.
  * @return LE_OK     The function succeeded.
  * @return LE_FAULT  The function failed.
@@ -348,12 +925,66 @@ le_result_t pa_wifiClient_Scan
 //--------------------------------------------------------------------------------------------------
 le_result_t pa_wifiClient_GetScanResult
 (
-    pa_wifiClient_AccessPoint_t *accessPointPtr
+    pa_wifiClient_AccessPoint_t *accessPointPtr,
     ///< [IN][OUT]
     ///< Structure provided by calling function.
     ///< Results filled out if result was LE_OK.
+    char scanIfName[]
+    ///< [IN][OUT]
+    ///< Array provided by calling function.
+    ///< Store WLAN interface used for scan.
 )
 {
+    if (StubIsRoamScan)
+    {
+        if (StubScanIndex >= STUB_ROAM_AP_COUNT)
+        {
+            return LE_NOT_FOUND;
+        }
+
+        memset(accessPointPtr, 0, sizeof(pa_wifiClient_AccessPoint_t));
+        accessPointPtr->signalStrength = GetStubRoamSignal(StubScanIndex);
+        accessPointPtr->ssidLength = strlen(STUB_ROAM_SSID);
+        memcpy(accessPointPtr->ssidBytes, STUB_ROAM_SSID, accessPointPtr->ssidLength);
+        snprintf(accessPointPtr->bssid, sizeof(accessPointPtr->bssid), "02:00:00:00:01:%02x",
+                 StubScanIndex);
+        accessPointPtr->frequency = 2437;
+        le_utf8_Copy(scanIfName, "wlan0", LE_WIFIDEFS_MAX_IFNAME_BYTES, NULL);
+
+        StubScanIndex++;
+        return LE_OK;
+    }
+
+    if (StubScanIndex >= STUB_SCAN_AP_COUNT + ((StubScanCount >= 3) ? 1 : 0))
+    {
+        return LE_NOT_FOUND;
+    }
+
+    if ((StubIsDirectedScan) && (13 == StubScanIndex))
+    {
+        StubScanIndex++;
+    }
+
+    memset(accessPointPtr, 0, sizeof(pa_wifiClient_AccessPoint_t));
+    accessPointPtr->signalStrength = GetStubSignal(StubScanIndex);
+    accessPointPtr->ssidLength = snprintf((char *)accessPointPtr->ssidBytes,
+                                          sizeof(accessPointPtr->ssidBytes), "Scan%u",
+                                          StubScanIndex);
+    snprintf(accessPointPtr->bssid, sizeof(accessPointPtr->bssid), "02:00:00:00:00:%02x",
+             StubScanIndex);
+    accessPointPtr->frequency = 2412 + 5 * (StubScanIndex % 13);
+    if (0 == StubScanIndex % 2)
+    {
+        accessPointPtr->securityFlags = PA_WIFICLIENT_SCAN_SECURITY_PRIVACY |
+                                        PA_WIFICLIENT_SCAN_SECURITY_WPA2;
+    }
+    if (StubIsCachedScan)
+    {
+        accessPointPtr->ageMs = STUB_CACHED_AGE_MS;
+    }
+    le_utf8_Copy(scanIfName, "wlan0", LE_WIFIDEFS_MAX_IFNAME_BYTES, NULL);
+
+    StubScanIndex++;
     return LE_OK;
 }
 
@@ -380,6 +1011,49 @@ le_result_t pa_wifiClient_GetLinkResult
     return LE_OK;
 }
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the state of the current link. Each query reports 1000 more received bytes than the
+ * previous one, so that cached results can be told apart. A link to STUB_ROAM_SSID reports the
+ * signal of its access point.
+ *
+ * @return LE_OK            The function succeeded.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiClient_GetLinkInfo
+(
+    pa_wifiClient_LinkInfo_t *linkInfoPtr
+        ///< [OUT]
+        ///< State of the link, filled out if result was LE_OK.
+)
+{
+    static uint64_t rxBytes = 0;
+
+    memset(linkInfoPtr, 0, sizeof(pa_wifiClient_LinkInfo_t));
+    linkInfoPtr->accessPoint.signalStrength = -50;
+    linkInfoPtr->accessPoint.ssidLength = 7;
+    memcpy(linkInfoPtr->accessPoint.ssidBytes, "Example", 7);
+    le_utf8_Copy(linkInfoPtr->accessPoint.bssid, "00:11:22:33:44:55",
+                 sizeof(linkInfoPtr->accessPoint.bssid), NULL);
+    rxBytes += 1000;
+    linkInfoPtr->accessPoint.rx = rxBytes;
+    linkInfoPtr->accessPoint.tx = 500;
+    linkInfoPtr->rxBitrate = 72200;
+    linkInfoPtr->txBitrate = 65000;
+    linkInfoPtr->frequency = 2437;
+
+    if (StubRoamLinkIndex < STUB_ROAM_AP_COUNT)
+    {
+        linkInfoPtr->accessPoint.signalStrength = GetStubRoamSignal(StubRoamLinkIndex);
+        linkInfoPtr->accessPoint.ssidLength = strlen(STUB_ROAM_SSID);
+        memcpy(linkInfoPtr->accessPoint.ssidBytes, STUB_ROAM_SSID,
+               linkInfoPtr->accessPoint.ssidLength);
+        snprintf(linkInfoPtr->accessPoint.bssid, sizeof(linkInfoPtr->accessPoint.bssid),
+                 "02:00:00:00:01:%02x", StubRoamLinkIndex);
+    }
+    return LE_OK;
+}
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Set the WEP key (Wired Equivalent Privacy)
@@ -486,6 +1160,8 @@ LE_SHARED le_result_t pa_wifiClient_AddEventIndHandler
         ///< Associated event context.
 )
 {
+    StubEventIndHandlerPtr = handlerPtr;
+    StubEventIndContextPtr = contextPtr;
     return LE_OK;
 }
 
@@ -515,6 +1191,32 @@ le_msg_SessionRef_t le_wifiClient_GetClientSessionRef
     return (le_msg_SessionRef_t)0x1001;
 }
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the server service reference of the extension service
+ */
+//--------------------------------------------------------------------------------------------------
+le_msg_ServiceRef_t le_wifiClientExt_GetServiceRef
+(
+    void
+)
+{
+    return NULL;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the client session reference for the current message of the extension service
+ */
+//--------------------------------------------------------------------------------------------------
+le_msg_SessionRef_t le_wifiClientExt_GetClientSessionRef
+(
+    void
+)
+{
+    return (le_msg_SessionRef_t)0x1001;
+}
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Registers a function to be called whenever one of this service's sessions is closed by
@@ -532,13 +1234,89 @@ le_msg_SessionEventHandlerRef_t MyAddServiceCloseHandler
     return NULL;
 }
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the credentials of a saved network handed to wpa_supplicant. (STUBBED FUNCTION)
+ *
+ * @return LE_OK         The function succeeded.
+ * @return LE_NOT_FOUND  The network was not handed to wpa_supplicant.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t StubGetNetworkCredentials
+(
+    const char *ssidPtr,
+        ///< [IN]
+        ///< SSID
+    const char **passphrasePtrPtr,
+        ///< [OUT]
+        ///< Passphrase, empty if none
+    const char **preSharedKeyPtrPtr
+        ///< [OUT]
+        ///< Pre-shared key, empty if none
+)
+{
+    size_t i;
+
+    for (i = 0; i < StubNetworkCount; i++)
+    {
+        if ((strlen(ssidPtr) == StubNetworks[i].ssidLength) &&
+            (0 == memcmp(ssidPtr, StubNetworks[i].ssidBytes, StubNetworks[i].ssidLength)))
+        {
+            *passphrasePtrPtr = StubNetworks[i].passphrase;
+            *preSharedKeyPtrPtr = StubNetworks[i].preSharedKey;
+            return LE_OK;
+        }
+    }
+    return LE_NOT_FOUND;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the pre-shared key last set by pa_wifiClient_SetPreSharedKey(), empty if a passphrase was set
+ * since. (STUBBED FUNCTION)
+ *
+ * @return The pre-shared key.
+ */
+//--------------------------------------------------------------------------------------------------
+const char *StubGetPreSharedKey
+(
+    void
+)
+{
+    return StubPreSharedKey;
+}
+
 //--------------------------------------------------------------------------------------------------
 // Secure storage service stubbing
 //--------------------------------------------------------------------------------------------------
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Stub for reading an item from secure storage.
+ * Find an item written to the secure storage stub.
+ *
+ * @return The item, NULL if it was not written.
+ */
+//--------------------------------------------------------------------------------------------------
+static StubSecStoreItem_t *FindStubSecStoreItem
+(
+    const char *name
+)
+{
+    int i;
+
+    for (i = 0; i < STUB_SECSTORE_ITEM_MAX; i++)
+    {
+        if (0 == strcmp(StubSecStoreItems[i].name, name))
+        {
+            return &StubSecStoreItems[i];
+        }
+    }
+    return NULL;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stub for reading an item from secure storage: the item written, or "mySecret".
  */
 //--------------------------------------------------------------------------------------------------
 le_result_t le_secStore_Read
@@ -549,6 +1327,19 @@ le_result_t le_secStore_Read
 )
 {
     #define STUB_SECSTORE_ITEM_VALUE "mySecret"
+    StubSecStoreItem_t *itemPtr = FindStubSecStoreItem(name);
+
+    if (NULL != itemPtr)
+    {
+        if (itemPtr->size > *bufNumElementsPtr)
+        {
+            return LE_OVERFLOW;
+        }
+        *bufNumElementsPtr = itemPtr->size;
+        memcpy(bufPtr, itemPtr->data, itemPtr->size);
+        return LE_OK;
+    }
+
     *bufNumElementsPtr = strlen(STUB_SECSTORE_ITEM_VALUE);
     memcpy(bufPtr, STUB_SECSTORE_ITEM_VALUE, *bufNumElementsPtr);
     return LE_OK;
@@ -566,6 +1357,17 @@ le_result_t le_secStore_Write
     size_t bufNumElements           ///< [IN] Size of buffer.
 )
 {
+    StubSecStoreItem_t *itemPtr = FindStubSecStoreItem(name);
+
+    if (NULL == itemPtr)
+    {
+        itemPtr = FindStubSecStoreItem("");
+    }
+    LE_ASSERT((NULL != itemPtr) && (bufNumElements <= sizeof(itemPtr->data)));
+
+    le_utf8_Copy(itemPtr->name, name, sizeof(itemPtr->name), NULL);
+    memcpy(itemPtr->data, bufPtr, bufNumElements);
+    itemPtr->size = bufNumElements;
     return LE_OK;
 }
 
@@ -580,5 +1382,11 @@ le_result_t le_secStore_Delete
 
 )
 {
+    StubSecStoreItem_t *itemPtr = FindStubSecStoreItem(name);
+
+    if (NULL != itemPtr)
+    {
+        memset(itemPtr, 0, sizeof(StubSecStoreItem_t));
+    }
     return LE_OK;
 }
@@ -0,0 +1,49 @@
+/**
+ * @file stubs.h
+ *
+ * Functions of the stubs checked by the WiFi client unit test
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ */
+
+#ifndef STUBS_H
+#define STUBS_H
+
+#include "legato.h"
+#include "interfaces.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the credentials of a saved network handed to wpa_supplicant. (STUBBED FUNCTION)
+ *
+ * @return LE_OK         The function succeeded.
+ * @return LE_NOT_FOUND  The network was not handed to wpa_supplicant.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t StubGetNetworkCredentials
+(
+    const char *ssidPtr,
+        ///< [IN]
+        ///< SSID
+    const char **passphrasePtrPtr,
+        ///< [OUT]
+        ///< Passphrase, empty if none
+    const char **preSharedKeyPtrPtr
+        ///< [OUT]
+        ///< Pre-shared key, empty if none
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the pre-shared key last set by pa_wifiClient_SetPreSharedKey(), empty if a passphrase was set
+ * since. (STUBBED FUNCTION)
+ *
+ * @return The pre-shared key.
+ */
+//--------------------------------------------------------------------------------------------------
+const char *StubGetPreSharedKey
+(
+    void
+);
+
+#endif // STUBS_H
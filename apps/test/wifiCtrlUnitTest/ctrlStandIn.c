@@ -0,0 +1,235 @@
+/**
+ * This module implements a stand-in for the wpa_supplicant control interface.
+ *
+ * It speaks the control protocol on a local UNIX datagram socket so that the control interface
+ * client can be tested without a radio: commands are answered like wpa_supplicant does and,
+ * once a client is attached, events are sent to it.
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "legato.h"
+#include "ctrlStandIn.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum size of a message.
+ */
+//--------------------------------------------------------------------------------------------------
+#define MSG_MAX_BYTES       1024
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Event sent when a network is selected.
+ */
+//--------------------------------------------------------------------------------------------------
+#define EVENT_CONNECTED     "<3>CTRL-EVENT-CONNECTED - Connection to 00:11:22:33:44:55 completed"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Event sent before every reply to an attached client, to check that it is not taken for the
+ * reply.
+ */
+//--------------------------------------------------------------------------------------------------
+#define EVENT_SCAN_STARTED  "<3>CTRL-EVENT-SCAN-STARTED "
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stand-in socket and its path.
+ */
+//--------------------------------------------------------------------------------------------------
+static int  StandInFd = -1;
+static char StandInPath[sizeof(((struct sockaddr_un *)0)->sun_path)];
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Address of the attached client.
+ */
+//--------------------------------------------------------------------------------------------------
+static struct sockaddr_un AttachedAddr;
+static socklen_t          AttachedAddrLen = 0;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of networks added.
+ */
+//--------------------------------------------------------------------------------------------------
+static int NetworkCount = 0;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Send a message to a client.
+ */
+//--------------------------------------------------------------------------------------------------
+static void SendTo
+(
+    const char               *msgPtr,
+    const struct sockaddr_un *addrPtr,
+    socklen_t                 addrLen
+)
+{
+    LE_ASSERT(sendto(StandInFd, msgPtr, strlen(msgPtr), 0,
+                     (const struct sockaddr *)addrPtr, addrLen) >= 0);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Build the reply to a command.
+ *
+ * @return false when the stand-in must terminate.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool HandleCommand
+(
+    const char               *cmdPtr,
+    const struct sockaddr_un *addrPtr,
+    socklen_t                 addrLen,
+    char                     *replyPtr,
+    size_t                    replySize
+)
+{
+    bool isAttached = (AttachedAddrLen == addrLen) &&
+                      (0 == memcmp(&AttachedAddr, addrPtr, addrLen));
+
+    if (isAttached)
+    {
+        SendTo(EVENT_SCAN_STARTED, addrPtr, addrLen);
+    }
+
+    if (0 == strcmp(cmdPtr, "PING"))
+    {
+        le_utf8_Copy(replyPtr, "PONG\n", replySize, NULL);
+    }
+    else if (0 == strcmp(cmdPtr, "ATTACH"))
+    {
+        memcpy(&AttachedAddr, addrPtr, addrLen);
+        AttachedAddrLen = addrLen;
+        le_utf8_Copy(replyPtr, "OK\n", replySize, NULL);
+    }
+    else if (0 == strcmp(cmdPtr, "DETACH"))
+    {
+        AttachedAddrLen = 0;
+        le_utf8_Copy(replyPtr, "OK\n", replySize, NULL);
+    }
+    else if (0 == strcmp(cmdPtr, "ADD_NETWORK"))
+    {
+        snprintf(replyPtr, replySize, "%d\n", NetworkCount++);
+    }
+    else if (0 == strcmp(cmdPtr, "REMOVE_NETWORK all"))
+    {
+        NetworkCount = 0;
+        le_utf8_Copy(replyPtr, "OK\n", replySize, NULL);
+    }
+    else if (0 == strncmp(cmdPtr, "SET_NETWORK ", sizeof("SET_NETWORK ") - 1))
+    {
+        int id = atoi(cmdPtr + sizeof("SET_NETWORK ") - 1);
+
+        le_utf8_Copy(replyPtr, (id < NetworkCount) ? "OK\n" : "FAIL\n", replySize, NULL);
+    }
+    else if (0 == strncmp(cmdPtr, "SELECT_NETWORK ", sizeof("SELECT_NETWORK ") - 1))
+    {
+        int id = atoi(cmdPtr + sizeof("SELECT_NETWORK ") - 1);
+
+        le_utf8_Copy(replyPtr, (id < NetworkCount) ? "OK\n" : "FAIL\n", replySize, NULL);
+    }
+    else if (0 == strcmp(cmdPtr, "DISCONNECT"))
+    {
+        le_utf8_Copy(replyPtr, "OK\n", replySize, NULL);
+    }
+    else if (0 == strcmp(cmdPtr, "STATUS"))
+    {
+        le_utf8_Copy(replyPtr, "bssid=00:11:22:33:44:55\nssid=standIn\nwpa_state=COMPLETED\n",
+                     replySize, NULL);
+    }
+    else if (0 == strcmp(cmdPtr, "TERMINATE"))
+    {
+        le_utf8_Copy(replyPtr, "OK\n", replySize, NULL);
+        return false;
+    }
+    else
+    {
+        le_utf8_Copy(replyPtr, "UNKNOWN COMMAND\n", replySize, NULL);
+    }
+
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stand-in thread: answer the commands until TERMINATE is received.
+ */
+//--------------------------------------------------------------------------------------------------
+static void *StandInThread
+(
+    void *contextPtr
+)
+{
+    char               cmd[MSG_MAX_BYTES];
+    char               reply[MSG_MAX_BYTES];
+    struct sockaddr_un addr;
+    socklen_t          addrLen;
+    ssize_t            len;
+    bool               isRunning = true;
+
+    while (isRunning)
+    {
+        addrLen = sizeof(addr);
+        len = recvfrom(StandInFd, cmd, sizeof(cmd) - 1, 0, (struct sockaddr *)&addr, &addrLen);
+        if (len < 0)
+        {
+            continue;
+        }
+        cmd[len] = '\0';
+
+        isRunning = HandleCommand(cmd, &addr, addrLen, reply, sizeof(reply));
+        SendTo(reply, &addr, addrLen);
+
+        // A selected network connects immediately
+        if ((0 == strncmp(cmd, "SELECT_NETWORK ", sizeof("SELECT_NETWORK ") - 1)) &&
+            (0 == strcmp(reply, "OK\n")) && (0 != AttachedAddrLen))
+        {
+            SendTo(EVENT_CONNECTED, &AttachedAddr, AttachedAddrLen);
+        }
+    }
+
+    close(StandInFd);
+    unlink(StandInPath);
+    StandInFd = -1;
+    return NULL;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Start the stand-in on the given socket path.
+ *
+ * @return Reference of the stand-in thread, to be joined after TERMINATE.
+ */
+//--------------------------------------------------------------------------------------------------
+le_thread_Ref_t ctrlStandIn_Start
+(
+    const char *pathPtr
+)
+{
+    struct sockaddr_un addr;
+    le_thread_Ref_t    threadRef;
+
+    StandInFd = socket(AF_UNIX, SOCK_DGRAM, 0);
+    LE_ASSERT(StandInFd >= 0);
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    LE_ASSERT_OK(le_utf8_Copy(addr.sun_path, pathPtr, sizeof(addr.sun_path), NULL));
+    le_utf8_Copy(StandInPath, pathPtr, sizeof(StandInPath), NULL);
+    unlink(StandInPath);
+    LE_ASSERT(0 == bind(StandInFd, (struct sockaddr *)&addr, sizeof(addr)));
+
+    threadRef = le_thread_Create("CtrlStandIn", StandInThread, NULL);
+    le_thread_SetJoinable(threadRef);
+    le_thread_Start(threadRef);
+
+    return threadRef;
+}
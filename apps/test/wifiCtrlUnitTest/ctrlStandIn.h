@@ -0,0 +1,23 @@
+/**
+ * Stand-in for the wpa_supplicant control interface used by the unit tests.
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#ifndef CTRL_STAND_IN_H
+#define CTRL_STAND_IN_H
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Start the stand-in on the given socket path.
+ *
+ * @return Reference of the stand-in thread, to be joined after TERMINATE.
+ */
+//--------------------------------------------------------------------------------------------------
+le_thread_Ref_t ctrlStandIn_Start
+(
+    const char *pathPtr
+);
+
+#endif // CTRL_STAND_IN_H
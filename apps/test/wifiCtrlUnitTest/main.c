@@ -0,0 +1,163 @@
+/**
+ * This module implements the unit tests for the WiFi control interface client
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#include "legato.h"
+#include "pa_wifi_ctrl.h"
+#include "ctrlStandIn.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Path of the stand-in control interface.
+ */
+//--------------------------------------------------------------------------------------------------
+#define STAND_IN_PATH   "/tmp/wifiCtrlUnitTest"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Connection to the stand-in.
+ */
+//--------------------------------------------------------------------------------------------------
+static pa_wifiCtrl_Conn_t Conn = { .fd = -1 };
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Open a connection to a missing control interface
+ *
+ * API tested:
+ * - pa_wifiCtrl_Open
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestWifiCtrl_OpenMissing
+(
+    void
+)
+{
+    pa_wifiCtrl_Conn_t conn;
+
+    LE_ASSERT(LE_NOT_FOUND == pa_wifiCtrl_Open(&conn, "/tmp/wifiCtrlUnitTest.missing"));
+    LE_ASSERT(!pa_wifiCtrl_IsOpen(&conn));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Send requests and check the replies
+ *
+ * API tested:
+ * - pa_wifiCtrl_Open
+ * - pa_wifiCtrl_Request
+ * - pa_wifiCtrl_RequestOk
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestWifiCtrl_Request
+(
+    void
+)
+{
+    char reply[PA_WIFICTRL_MSG_MAX_BYTES];
+
+    LE_ASSERT_OK(pa_wifiCtrl_Open(&Conn, STAND_IN_PATH));
+    LE_ASSERT(pa_wifiCtrl_IsOpen(&Conn));
+
+    LE_ASSERT_OK(pa_wifiCtrl_Request(&Conn, "PING", reply, sizeof(reply),
+                                     PA_WIFICTRL_REQUEST_TIMEOUT_MS));
+    LE_ASSERT(0 == strcmp(reply, "PONG\n"));
+
+    LE_ASSERT_OK(pa_wifiCtrl_Request(&Conn, "ADD_NETWORK", reply, sizeof(reply),
+                                     PA_WIFICTRL_REQUEST_TIMEOUT_MS));
+    LE_ASSERT(0 == atoi(reply));
+    LE_ASSERT_OK(pa_wifiCtrl_RequestOk(&Conn, "SET_NETWORK 0 ssid \"standIn\""));
+
+    // Rejected commands
+    LE_ASSERT(LE_FAULT == pa_wifiCtrl_RequestOk(&Conn, "SET_NETWORK 1 ssid \"standIn\""));
+    LE_ASSERT(LE_FAULT == pa_wifiCtrl_RequestOk(&Conn, "NOT_A_COMMAND"));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Attach to the events and select a network
+ *
+ * API tested:
+ * - pa_wifiCtrl_Attach
+ * - pa_wifiCtrl_RequestOk with interleaved events
+ * - pa_wifiCtrl_Recv
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestWifiCtrl_Events
+(
+    void
+)
+{
+    char event[PA_WIFICTRL_MSG_MAX_BYTES];
+    bool isConnected = false;
+
+    LE_ASSERT_OK(pa_wifiCtrl_Attach(&Conn));
+
+    // The stand-in sends an event before every reply: it must not be taken for the reply.
+    LE_ASSERT_OK(pa_wifiCtrl_RequestOk(&Conn, "SELECT_NETWORK 0"));
+
+    while (LE_OK == pa_wifiCtrl_Recv(&Conn, event, sizeof(event), 1000))
+    {
+        LE_ASSERT('<' != event[0]);
+        if (0 == strncmp(event, "CTRL-EVENT-CONNECTED", sizeof("CTRL-EVENT-CONNECTED") - 1))
+        {
+            isConnected = true;
+            break;
+        }
+    }
+    LE_ASSERT(isConnected);
+
+    LE_ASSERT_OK(pa_wifiCtrl_RequestOk(&Conn, "DETACH"));
+    LE_ASSERT(LE_TIMEOUT == pa_wifiCtrl_Recv(&Conn, event, sizeof(event), 100));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Terminate the stand-in and close the connection
+ *
+ * API tested:
+ * - pa_wifiCtrl_Close
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestWifiCtrl_Close
+(
+    le_thread_Ref_t standInRef
+)
+{
+    LE_ASSERT_OK(pa_wifiCtrl_RequestOk(&Conn, "TERMINATE"));
+    LE_ASSERT_OK(le_thread_Join(standInRef, NULL));
+
+    pa_wifiCtrl_Close(&Conn);
+    LE_ASSERT(!pa_wifiCtrl_IsOpen(&Conn));
+    LE_ASSERT(LE_FAULT == pa_wifiCtrl_RequestOk(&Conn, "PING"));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * main of the test
+ *
+ */
+//--------------------------------------------------------------------------------------------------
+COMPONENT_INIT
+{
+    le_thread_Ref_t standInRef;
+
+    LE_INFO ("======== Start UnitTest of WiFi control interface ========");
+
+    TestWifiCtrl_OpenMissing();
+
+    standInRef = ctrlStandIn_Start(STAND_IN_PATH);
+
+    TestWifiCtrl_Request();
+
+    TestWifiCtrl_Events();
+
+    TestWifiCtrl_Close(standInRef);
+
+    LE_INFO ("======== UnitTest of WiFi control interface SUCCESS ========");
+
+    exit(EXIT_SUCCESS);
+}
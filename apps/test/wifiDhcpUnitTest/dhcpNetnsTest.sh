@@ -0,0 +1,75 @@
+#!/bin/sh
+#*******************************************************************************
+# Copyright (C) Sierra Wireless Inc.
+#
+# Run the WiFi access point DHCP server against a DHCP client in a network namespace, over a veth
+# pair, and report the time taken to get an address.
+#
+# Usage: dhcpNetnsTest.sh [wifiDhcpUnitTest executable]
+#
+# Needs root, ip, and udhcpc (busybox) or dhclient.
+#*******************************************************************************
+
+TEST_EXEC=${1:-./wifiDhcpUnitTest}
+NS=wifiDhcpTest
+SERVER_IF=wdhcp0
+CLIENT_IF=wdhcp1
+SERVER_IP=192.168.43.1
+RANGE_START=192.168.43.10
+RANGE_STOP=192.168.43.20
+SERVER_PID=
+
+cleanup()
+{
+    [ -n "${SERVER_PID}" ] && kill "${SERVER_PID}" 2> /dev/null
+    ip link del ${SERVER_IF} 2> /dev/null
+    ip netns del ${NS} 2> /dev/null
+}
+
+fail()
+{
+    echo "FAILED: $*"
+    cleanup
+    exit 1
+}
+
+now_ms()
+{
+    echo $(( $(date +%s%N) / 1000000 ))
+}
+
+cleanup
+ip netns add ${NS} || fail "unable to create the network namespace"
+ip link add ${SERVER_IF} type veth peer name ${CLIENT_IF} || fail "unable to create veth pair"
+ip link set ${CLIENT_IF} netns ${NS}
+ip addr add ${SERVER_IP}/24 dev ${SERVER_IF}
+ip link set ${SERVER_IF} up
+ip netns exec ${NS} ip link set ${CLIENT_IF} up
+
+${TEST_EXEC} ${SERVER_IF} ${SERVER_IP} ${RANGE_START} ${RANGE_STOP} &
+SERVER_PID=$!
+sleep 1
+kill -0 ${SERVER_PID} 2> /dev/null || fail "DHCP server not running"
+
+START_MS=$(now_ms)
+if command -v udhcpc > /dev/null 2>&1; then
+    ip netns exec ${NS} udhcpc -i ${CLIENT_IF} -f -q -n -t 3 -T 1 || fail "no lease"
+elif command -v dhclient > /dev/null 2>&1; then
+    ip netns exec ${NS} dhclient -1 -pf /tmp/${NS}.pid -lf /tmp/${NS}.leases ${CLIENT_IF} \
+        || fail "no lease"
+    ip netns exec ${NS} dhclient -x -pf /tmp/${NS}.pid ${CLIENT_IF}
+    rm -f /tmp/${NS}.pid /tmp/${NS}.leases
+else
+    fail "no DHCP client (udhcpc or dhclient)"
+fi
+END_MS=$(now_ms)
+
+# dhclient configures the interface, udhcpc only does it through its script
+ip netns exec ${NS} ip -4 addr show ${CLIENT_IF}
+grep -q " 192\.168\.43\.[0-9]* " /tmp/wifiDhcpUnitTest.leases \
+    || fail "lease not saved"
+
+echo "Address obtained in $((END_MS - START_MS)) ms"
+cleanup
+echo "SUCCESS"
+exit 0
@@ -0,0 +1,477 @@
+/**
+ * This module implements the unit tests of the WiFi access point DHCP server
+ *
+ * Run without arguments, it checks the lease engine. Run with an interface and an address range,
+ * it serves the interface, as used by dhcpNetnsTest.sh against a DHCP client in a network
+ * namespace:
+ *
+ *     wifiDhcpUnitTest <interface> <server address> <start address> <stop address>
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#include <arpa/inet.h>
+
+#include "legato.h"
+#include "pa_wifi_dhcp.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Lease file of the tests.
+ */
+//--------------------------------------------------------------------------------------------------
+#define LEASE_FILE      "/tmp/wifiDhcpUnitTest.leases"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * DHCP message types and options used by the tests.
+ */
+//--------------------------------------------------------------------------------------------------
+#define DHCP_DISCOVER   1
+#define DHCP_OFFER      2
+#define DHCP_REQUEST    3
+#define DHCP_ACK        5
+#define DHCP_NAK        6
+#define DHCP_RELEASE    7
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Addresses of the tests, in host byte order.
+ */
+//--------------------------------------------------------------------------------------------------
+#define SERVER_ADDR     0xC0A82B01  // 192.168.43.1
+#define OTHER_SERVER    0xC0A82B02  // 192.168.43.2
+#define NETMASK         0xFFFFFF00
+#define RANGE_START     0xC0A82B0A  // 192.168.43.10
+#define RANGE_STOP      0xC0A82B0C  // 192.168.43.12
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * MAC addresses of the test clients.
+ */
+//--------------------------------------------------------------------------------------------------
+static const uint8_t Mac1[6] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x01 };
+static const uint8_t Mac2[6] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x02 };
+static const uint8_t Mac3[6] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x03 };
+static const uint8_t Mac4[6] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x04 };
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Write a 32 bits value in network byte order.
+ */
+//--------------------------------------------------------------------------------------------------
+static void PutU32
+(
+    uint8_t  *bytePtr,
+    uint32_t  value
+)
+{
+    bytePtr[0] = value >> 24;
+    bytePtr[1] = (value >> 16) & 0xFF;
+    bytePtr[2] = (value >> 8) & 0xFF;
+    bytePtr[3] = value & 0xFF;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read a 32 bits value in network byte order.
+ */
+//--------------------------------------------------------------------------------------------------
+static uint32_t GetU32
+(
+    const uint8_t *bytePtr
+)
+{
+    return ((uint32_t)bytePtr[0] << 24) | ((uint32_t)bytePtr[1] << 16) |
+           ((uint32_t)bytePtr[2] << 8) | bytePtr[3];
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Last lease reported to the lease handler, and number of leases reported.
+ */
+//--------------------------------------------------------------------------------------------------
+static pa_wifiDhcp_Lease_t LastLease;
+static int                 LeaseCount;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Lease handler of the test.
+ */
+//--------------------------------------------------------------------------------------------------
+static void LeaseHandler
+(
+    const pa_wifiDhcp_Lease_t *leasePtr,
+    void                      *contextPtr
+)
+{
+    LE_ASSERT(&LastLease == contextPtr);
+    LastLease = *leasePtr;
+    LeaseCount++;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Send a client message to the lease engine.
+ *
+ * @return The type of the reply, or 0 if there is none.
+ */
+//--------------------------------------------------------------------------------------------------
+static uint8_t SendMessage
+(
+    uint8_t        type,
+    const uint8_t *macPtr,
+    uint32_t       ciaddr,
+    uint32_t       requestedAddr,
+    uint32_t       serverId,
+    const char    *hostnamePtr,
+    uint32_t      *yiaddrPtr
+)
+{
+    uint8_t msg[PA_WIFIDHCP_MSG_MAX_BYTES];
+    uint8_t reply[PA_WIFIDHCP_MSG_MAX_BYTES];
+    size_t  replyLen;
+    size_t  offset = 240;
+    size_t  i;
+
+    memset(msg, 0, sizeof(msg));
+    msg[0] = 1;                     // BOOTREQUEST
+    msg[1] = 1;                     // Ethernet
+    msg[2] = 6;
+    PutU32(&msg[4], 0x12345678);    // xid
+    PutU32(&msg[12], ciaddr);
+    memcpy(&msg[28], macPtr, 6);
+    PutU32(&msg[236], 0x63825363);  // Magic cookie
+
+    msg[offset++] = 53;
+    msg[offset++] = 1;
+    msg[offset++] = type;
+    if (0 != requestedAddr)
+    {
+        msg[offset++] = 50;
+        msg[offset++] = 4;
+        PutU32(&msg[offset], requestedAddr);
+        offset += 4;
+    }
+    if (0 != serverId)
+    {
+        msg[offset++] = 54;
+        msg[offset++] = 4;
+        PutU32(&msg[offset], serverId);
+        offset += 4;
+    }
+    if (NULL != hostnamePtr)
+    {
+        msg[offset++] = 12;
+        msg[offset++] = strlen(hostnamePtr);
+        memcpy(&msg[offset], hostnamePtr, strlen(hostnamePtr));
+        offset += strlen(hostnamePtr);
+    }
+    msg[offset++] = 255;
+
+    if (LE_OK != pa_wifiDhcp_ProcessMessage(msg, offset, reply, &replyLen))
+    {
+        return 0;
+    }
+
+    // Reply to the same transaction and client
+    LE_ASSERT(replyLen >= 300);
+    LE_ASSERT(2 == reply[0]);
+    LE_ASSERT(0x12345678 == GetU32(&reply[4]));
+    LE_ASSERT(0 == memcmp(&reply[28], macPtr, 6));
+    LE_ASSERT(0x63825363 == GetU32(&reply[236]));
+    if (NULL != yiaddrPtr)
+    {
+        *yiaddrPtr = GetU32(&reply[16]);
+    }
+
+    // The message type comes first, followed by the server identifier
+    LE_ASSERT((53 == reply[240]) && (1 == reply[241]));
+    LE_ASSERT((54 == reply[243]) && (SERVER_ADDR == GetU32(&reply[245])));
+    for (i = 249; (i < replyLen) && (255 != reply[i]); i += 2 + reply[i + 1])
+    {
+        if (1 == reply[i])
+        {
+            LE_ASSERT(NETMASK == GetU32(&reply[i + 2]));
+        }
+        else if (3 == reply[i])
+        {
+            LE_ASSERT(SERVER_ADDR == GetU32(&reply[i + 2]));
+        }
+    }
+    LE_ASSERT(i < replyLen);
+    return reply[242];
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get an address for a client: DHCPDISCOVER then DHCPREQUEST of the offered address.
+ *
+ * @return The address given.
+ */
+//--------------------------------------------------------------------------------------------------
+static uint32_t GetAddress
+(
+    const uint8_t *macPtr,
+    const char    *hostnamePtr
+)
+{
+    uint32_t offered = 0;
+    uint32_t acked = 0;
+
+    LE_ASSERT(DHCP_OFFER == SendMessage(DHCP_DISCOVER, macPtr, 0, 0, 0, hostnamePtr, &offered));
+    LE_ASSERT(DHCP_ACK == SendMessage(DHCP_REQUEST, macPtr, 0, offered, SERVER_ADDR, hostnamePtr,
+                                      &acked));
+    LE_ASSERT(offered == acked);
+    return acked;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check the messages before a range is set and the invalid messages
+ *
+ * API tested:
+ * - pa_wifiDhcp_Start
+ * - pa_wifiDhcp_ProcessMessage
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestWifiDhcp_NoRange
+(
+    void
+)
+{
+    uint8_t msg[PA_WIFIDHCP_MSG_MAX_BYTES];
+    uint8_t reply[PA_WIFIDHCP_MSG_MAX_BYTES];
+    size_t  replyLen;
+
+    remove(LEASE_FILE);
+    LE_ASSERT_OK(pa_wifiDhcp_Start(NULL, LEASE_FILE));
+    LE_ASSERT(LE_DUPLICATE == pa_wifiDhcp_Start(NULL, LEASE_FILE));
+
+    LE_ASSERT(0 == SendMessage(DHCP_DISCOVER, Mac1, 0, 0, 0, NULL, NULL));
+
+    // Too short, then without the message type
+    memset(msg, 0, sizeof(msg));
+    LE_ASSERT(LE_FORMAT_ERROR == pa_wifiDhcp_ProcessMessage(msg, 100, reply, &replyLen));
+    msg[0] = 1;
+    msg[1] = 1;
+    msg[2] = 6;
+    PutU32(&msg[236], 0x63825363);
+    msg[240] = 255;
+    LE_ASSERT(LE_FORMAT_ERROR == pa_wifiDhcp_ProcessMessage(msg, 241, reply, &replyLen));
+
+    // Invalid ranges
+    LE_ASSERT(LE_BAD_PARAMETER == pa_wifiDhcp_SetRange(SERVER_ADDR, NETMASK, RANGE_STOP,
+                                                       RANGE_START));
+    LE_ASSERT(LE_BAD_PARAMETER == pa_wifiDhcp_SetRange(RANGE_START, NETMASK, RANGE_START,
+                                                       RANGE_STOP));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Give, renew, release and refuse addresses
+ *
+ * API tested:
+ * - pa_wifiDhcp_SetRange
+ * - pa_wifiDhcp_ProcessMessage
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestWifiDhcp_Lease
+(
+    void
+)
+{
+    uint32_t addr;
+
+    LE_ASSERT_OK(pa_wifiDhcp_SetRange(SERVER_ADDR, NETMASK, RANGE_START, RANGE_STOP));
+
+    LE_ASSERT(RANGE_START == GetAddress(Mac1, "client1"));
+    LE_ASSERT(RANGE_START + 1 == GetAddress(Mac2, NULL));
+
+    // Same address for a client coming back, and renewal with ciaddr
+    LE_ASSERT(RANGE_START == GetAddress(Mac1, NULL));
+    LE_ASSERT(DHCP_ACK == SendMessage(DHCP_REQUEST, Mac1, RANGE_START, 0, 0, NULL, &addr));
+    LE_ASSERT(RANGE_START == addr);
+
+    // Address of another client, or out of the range
+    LE_ASSERT(DHCP_NAK == SendMessage(DHCP_REQUEST, Mac3, 0, RANGE_START, 0, NULL, NULL));
+    LE_ASSERT(DHCP_NAK == SendMessage(DHCP_REQUEST, Mac3, 0, SERVER_ADDR, 0, NULL, NULL));
+
+    // Client choosing another server
+    LE_ASSERT(DHCP_OFFER == SendMessage(DHCP_DISCOVER, Mac3, 0, 0, 0, NULL, &addr));
+    LE_ASSERT(RANGE_START + 2 == addr);
+    LE_ASSERT(0 == SendMessage(DHCP_REQUEST, Mac3, 0, addr, OTHER_SERVER, NULL, NULL));
+
+    // Range exhausted, until a client releases its address
+    LE_ASSERT(RANGE_START + 2 == GetAddress(Mac3, NULL));
+    LE_ASSERT(0 == SendMessage(DHCP_DISCOVER, Mac4, 0, 0, 0, NULL, NULL));
+    LE_ASSERT(0 == SendMessage(DHCP_RELEASE, Mac2, RANGE_START + 1, 0, SERVER_ADDR, NULL, NULL));
+    LE_ASSERT(RANGE_START + 1 == GetAddress(Mac4, NULL));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Restore the leases from the lease file after a restart, and drop the leases out of a new range
+ *
+ * API tested:
+ * - pa_wifiDhcp_Stop
+ * - pa_wifiDhcp_Start
+ * - pa_wifiDhcp_SetRange
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestWifiDhcp_Restart
+(
+    void
+)
+{
+    char  line[128];
+    FILE *filePtr;
+    bool  isFound = false;
+    uint32_t addr;
+
+    pa_wifiDhcp_Stop();
+
+    filePtr = fopen(LEASE_FILE, "r");
+    LE_ASSERT(NULL != filePtr);
+    while (NULL != fgets(line, sizeof(line), filePtr))
+    {
+        if (NULL != strstr(line, " 02:00:00:00:00:01 192.168.43.10 client1"))
+        {
+            isFound = true;
+        }
+    }
+    fclose(filePtr);
+    LE_ASSERT(isFound);
+
+    LE_ASSERT_OK(pa_wifiDhcp_Start(NULL, LEASE_FILE));
+    LE_ASSERT_OK(pa_wifiDhcp_SetRange(SERVER_ADDR, NETMASK, RANGE_START, RANGE_STOP));
+
+    // Rebooting client keeping its address, other clients still holding theirs
+    LE_ASSERT(DHCP_ACK == SendMessage(DHCP_REQUEST, Mac1, 0, RANGE_START, 0, NULL, &addr));
+    LE_ASSERT(RANGE_START == addr);
+    LE_ASSERT(0 == SendMessage(DHCP_DISCOVER, Mac2, 0, 0, 0, NULL, NULL));
+
+    // New range
+    LE_ASSERT_OK(pa_wifiDhcp_SetRange(SERVER_ADDR, NETMASK, RANGE_START + 10, RANGE_STOP + 10));
+    LE_ASSERT(DHCP_NAK == SendMessage(DHCP_REQUEST, Mac1, 0, RANGE_START, 0, NULL, NULL));
+    LE_ASSERT(RANGE_START + 10 == GetAddress(Mac1, NULL));
+
+    pa_wifiDhcp_Stop();
+    remove(LEASE_FILE);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Report the leases given and released, and look them up
+ *
+ * API tested:
+ * - pa_wifiDhcp_SetLeaseHandler
+ * - pa_wifiDhcp_GetLease
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestWifiDhcp_LeaseHandler
+(
+    void
+)
+{
+    pa_wifiDhcp_Lease_t lease;
+
+    LE_ASSERT_OK(pa_wifiDhcp_Start(NULL, NULL));
+    LE_ASSERT_OK(pa_wifiDhcp_SetRange(SERVER_ADDR, NETMASK, RANGE_START, RANGE_STOP));
+    pa_wifiDhcp_SetLeaseHandler(LeaseHandler, &LastLease);
+
+    // Offers are not reported
+    LE_ASSERT(DHCP_OFFER == SendMessage(DHCP_DISCOVER, Mac1, 0, 0, 0, NULL, NULL));
+    LE_ASSERT(0 == LeaseCount);
+
+    LE_ASSERT(RANGE_START == GetAddress(Mac1, "client1"));
+    LE_ASSERT(1 == LeaseCount);
+    LE_ASSERT(0 == strcmp("02:00:00:00:00:01", LastLease.mac));
+    LE_ASSERT(RANGE_START == LastLease.addr);
+    LE_ASSERT(0 == strcmp("client1", LastLease.hostname));
+
+    LE_ASSERT_OK(pa_wifiDhcp_GetLease("02:00:00:00:00:01", &lease));
+    LE_ASSERT(RANGE_START == lease.addr);
+    LE_ASSERT(0 == strcmp("client1", lease.hostname));
+    LE_ASSERT(lease.expiry == LastLease.expiry);
+    LE_ASSERT(LE_NOT_FOUND == pa_wifiDhcp_GetLease("02:00:00:00:00:02", &lease));
+    LE_ASSERT(LE_BAD_PARAMETER == pa_wifiDhcp_GetLease("02:00:00", &lease));
+
+    // Release, then lease dropped by a new range
+    LE_ASSERT(0 == SendMessage(DHCP_RELEASE, Mac1, RANGE_START, 0, SERVER_ADDR, NULL, NULL));
+    LE_ASSERT(2 == LeaseCount);
+    LE_ASSERT(0 == LastLease.addr);
+    LE_ASSERT(LE_NOT_FOUND == pa_wifiDhcp_GetLease("02:00:00:00:00:01", &lease));
+
+    LE_ASSERT(RANGE_START == GetAddress(Mac2, NULL));
+    LE_ASSERT(3 == LeaseCount);
+    LE_ASSERT_OK(pa_wifiDhcp_SetRange(SERVER_ADDR, NETMASK, RANGE_START + 10, RANGE_STOP + 10));
+    LE_ASSERT(4 == LeaseCount);
+    LE_ASSERT(0 == strcmp("02:00:00:00:00:02", LastLease.mac));
+    LE_ASSERT(0 == LastLease.addr);
+
+    pa_wifiDhcp_SetLeaseHandler(NULL, NULL);
+    pa_wifiDhcp_Stop();
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Serve an interface until the process is killed.
+ */
+//--------------------------------------------------------------------------------------------------
+static void Serve
+(
+    void
+)
+{
+    const char     *argPtr[4];
+    struct in_addr  addr[3];
+    size_t          i;
+
+    LE_ASSERT(4 == le_arg_NumArgs());
+    for (i = 0; i < 4; i++)
+    {
+        argPtr[i] = le_arg_GetArg(i);
+        LE_ASSERT(NULL != argPtr[i]);
+    }
+    for (i = 0; i < 3; i++)
+    {
+        LE_ASSERT(1 == inet_pton(AF_INET, argPtr[i + 1], &addr[i]));
+    }
+
+    remove(LEASE_FILE);
+    LE_ASSERT_OK(pa_wifiDhcp_Start(argPtr[0], LEASE_FILE));
+    LE_ASSERT_OK(pa_wifiDhcp_SetRange(ntohl(addr[0].s_addr), NETMASK, ntohl(addr[1].s_addr),
+                                      ntohl(addr[2].s_addr)));
+    LE_INFO("Serving %s", argPtr[0]);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * main of the test
+ *
+ */
+//--------------------------------------------------------------------------------------------------
+COMPONENT_INIT
+{
+    if (le_arg_NumArgs() > 0)
+    {
+        Serve();
+        return;
+    }
+
+    LE_INFO ("======== Start UnitTest of WiFi DHCP server ========");
+
+    TestWifiDhcp_NoRange();
+
+    TestWifiDhcp_Lease();
+
+    TestWifiDhcp_Restart();
+
+    TestWifiDhcp_LeaseHandler();
+
+    LE_INFO ("======== UnitTest of WiFi DHCP server SUCCESS ========");
+
+    exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,217 @@
+/**
+ * This module implements the unit tests and the benchmark of the WiFi PMK derivation
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#include "legato.h"
+#include "pa_wifi_pmk.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of runs averaged by the benchmark, for the derivation and for the cache check.
+ */
+//--------------------------------------------------------------------------------------------------
+#define BENCH_DERIVE_RUNS   10
+#define BENCH_CACHED_RUNS   1000
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check a binary result against its expected hexadecimal form.
+ */
+//--------------------------------------------------------------------------------------------------
+static void AssertHex
+(
+    const uint8_t *bytesPtr,
+    size_t         len,
+    const char    *expectedPtr
+)
+{
+    char   hex[2 * PA_WIFIPMK_BYTES + 1];
+    size_t i;
+
+    LE_ASSERT(2 * len < sizeof(hex));
+    for (i = 0; i < len; i++)
+    {
+        snprintf(&hex[2 * i], 3, "%02x", bytesPtr[i]);
+    }
+    LE_ASSERT(0 == strcmp(hex, expectedPtr));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the time elapsed since a relative time, in microseconds.
+ */
+//--------------------------------------------------------------------------------------------------
+static uint64_t GetElapsedUs
+(
+    le_clk_Time_t startTime
+)
+{
+    le_clk_Time_t elapsed = le_clk_Sub(le_clk_GetRelativeTime(), startTime);
+
+    return (uint64_t)elapsed.sec * 1000000 + elapsed.usec;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check SHA-1 and HMAC-SHA1 against the FIPS 180 and RFC 2202 test vectors
+ *
+ * API tested:
+ * - pa_wifiPmk_Sha1
+ * - pa_wifiPmk_HmacSha1
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestWifiPmk_Sha1
+(
+    void
+)
+{
+    static const char longMsg[] = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+    static const char hmacMsg[] = "what do ya want for nothing?";
+    uint8_t           digest[PA_WIFIPMK_SHA1_BYTES];
+    uint8_t           longKey[80];
+
+    pa_wifiPmk_Sha1((const uint8_t *)"abc", 3, digest);
+    AssertHex(digest, sizeof(digest), "a9993e364706816aba3e25717850c26c9cd0d89d");
+
+    // Two blocks of padding
+    pa_wifiPmk_Sha1((const uint8_t *)longMsg, sizeof(longMsg) - 1, digest);
+    AssertHex(digest, sizeof(digest), "84983e441c3bd26ebaae4aa1f95129e5e54670f1");
+
+    pa_wifiPmk_HmacSha1((const uint8_t *)"Jefe", 4, (const uint8_t *)hmacMsg,
+                        sizeof(hmacMsg) - 1, digest);
+    AssertHex(digest, sizeof(digest), "effcdf6ae5eb2fa2d27416d5f184df9c259a7c79");
+
+    // Key longer than a block
+    memset(longKey, 0xaa, sizeof(longKey));
+    pa_wifiPmk_HmacSha1(longKey, sizeof(longKey),
+                        (const uint8_t *)"Test Using Larger Than Block-Size Key - Hash Key First",
+                        54, digest);
+    AssertHex(digest, sizeof(digest), "aa4ae5e15272d00e95705637ce8a3b55ed402112");
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check PBKDF2-HMAC-SHA1 against the RFC 6070 test vectors, and the PMK against the IEEE 802.11i
+ * annex H.4 test vectors
+ *
+ * API tested:
+ * - pa_wifiPmk_Pbkdf2Sha1
+ * - pa_wifiPmk_Derive
+ * - pa_wifiPmk_ToHex
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestWifiPmk_Derive
+(
+    void
+)
+{
+    uint8_t key[25];
+    uint8_t pmk[PA_WIFIPMK_BYTES];
+    char    hex[PA_WIFIPMK_HEX_BYTES];
+
+    pa_wifiPmk_Pbkdf2Sha1((const uint8_t *)"password", 8, (const uint8_t *)"salt", 4, 1,
+                          key, 20);
+    AssertHex(key, 20, "0c60c80f961f0e71f3a9b524af6012062fe037a6");
+    pa_wifiPmk_Pbkdf2Sha1((const uint8_t *)"password", 8, (const uint8_t *)"salt", 4, 2,
+                          key, 20);
+    AssertHex(key, 20, "ea6c014dc72d6f8ccd1ed92ace1d41f0d8de8957");
+    pa_wifiPmk_Pbkdf2Sha1((const uint8_t *)"password", 8, (const uint8_t *)"salt", 4, 4096,
+                          key, 20);
+    AssertHex(key, 20, "4b007901b765489abead49d926f721d065a429c1");
+
+    // Output spanning two blocks
+    pa_wifiPmk_Pbkdf2Sha1((const uint8_t *)"passwordPASSWORDpassword", 24,
+                          (const uint8_t *)"saltSALTsaltSALTsaltSALTsaltSALTsalt", 36, 4096,
+                          key, 25);
+    AssertHex(key, 25, "3d2eec4fe41c849b80c8d83662c0e44a8b291a964cf2f07038");
+
+    LE_ASSERT_OK(pa_wifiPmk_Derive("password", (const uint8_t *)"IEEE", 4, pmk));
+    pa_wifiPmk_ToHex(pmk, hex);
+    LE_ASSERT(0 == strcmp(hex,
+                          "f42c6fc52df0ebef9ebb4b90b38a5f902e83fe1b135a70e23aed762e9710a12e"));
+
+    LE_ASSERT_OK(pa_wifiPmk_Derive("ThisIsAPassword", (const uint8_t *)"ThisIsASSID", 11, pmk));
+    pa_wifiPmk_ToHex(pmk, hex);
+    LE_ASSERT(0 == strcmp(hex,
+                          "0dc0d6eb90555ed6419756b9a15ec3e3209b63df707dd508d14581f8982721af"));
+
+    // Invalid passphrase and SSID lengths
+    LE_ASSERT(LE_BAD_PARAMETER == pa_wifiPmk_Derive("short", (const uint8_t *)"IEEE", 4, pmk));
+    LE_ASSERT(LE_BAD_PARAMETER ==
+              pa_wifiPmk_Derive("1234567890123456789012345678901234567890123456789012345678901234",
+                                (const uint8_t *)"IEEE", 4, pmk));
+    LE_ASSERT(LE_BAD_PARAMETER == pa_wifiPmk_Derive("password", (const uint8_t *)"IEEE", 0, pmk));
+    LE_ASSERT(LE_BAD_PARAMETER == pa_wifiPmk_Derive("password",
+                                                    (const uint8_t *)"IEEE", 33, pmk));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Benchmark the key setup of a connection: deriving the PSK from the passphrase, as
+ * wpa_supplicant does for each connection given a passphrase, against checking the PMK cached by
+ * the WiFi client service, which costs one HMAC.
+ *
+ * API tested:
+ * - pa_wifiPmk_Derive
+ * - pa_wifiPmk_HmacSha1
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestWifiPmk_Benchmark
+(
+    void
+)
+{
+    static const char passphrase[] = "ThisIsAPassword";
+    static const char ssid[] = "ThisIsASSID";
+    uint8_t           pmk[PA_WIFIPMK_BYTES];
+    uint8_t           tag[PA_WIFIPMK_SHA1_BYTES];
+    char              hex[PA_WIFIPMK_HEX_BYTES];
+    le_clk_Time_t     startTime;
+    uint64_t          deriveUs;
+    uint64_t          cachedUs;
+    int               i;
+
+    startTime = le_clk_GetRelativeTime();
+    for (i = 0; i < BENCH_DERIVE_RUNS; i++)
+    {
+        LE_ASSERT_OK(pa_wifiPmk_Derive(passphrase, (const uint8_t *)ssid, sizeof(ssid) - 1, pmk));
+    }
+    deriveUs = GetElapsedUs(startTime) / BENCH_DERIVE_RUNS;
+
+    startTime = le_clk_GetRelativeTime();
+    for (i = 0; i < BENCH_CACHED_RUNS; i++)
+    {
+        pa_wifiPmk_HmacSha1(pmk, sizeof(pmk), (const uint8_t *)passphrase,
+                            sizeof(passphrase) - 1, tag);
+        pa_wifiPmk_ToHex(pmk, hex);
+    }
+    cachedUs = GetElapsedUs(startTime) / BENCH_CACHED_RUNS;
+
+    LE_INFO("PSK setup per connection: derived %"PRIu64" us, cached %"PRIu64" us, "
+            "saving %"PRIu64" us", deriveUs, cachedUs, deriveUs - cachedUs);
+    LE_ASSERT(cachedUs < deriveUs);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * main of the test
+ *
+ */
+//--------------------------------------------------------------------------------------------------
+COMPONENT_INIT
+{
+    LE_INFO ("======== Start UnitTest of WiFi PMK derivation ========");
+
+    TestWifiPmk_Sha1();
+
+    TestWifiPmk_Derive();
+
+    TestWifiPmk_Benchmark();
+
+    LE_INFO ("======== UnitTest of WiFi PMK derivation SUCCESS ========");
+
+    exit(EXIT_SUCCESS);
+}
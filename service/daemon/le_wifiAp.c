@@ -11,6 +11,7 @@
 #include "interfaces.h"
 
 #include "pa_wifi_ap.h"
+#include "pa_wifi_dhcp.h"
 
 
 //--------------------------------------------------------------------------------------------------
@@ -23,415 +24,1522 @@ static le_event_Id_t NewWifiApEventId;
 
 //--------------------------------------------------------------------------------------------------
 /**
- * CallBack for PA Access Point Events.
+ * Initial number of stations of the station table.
  */
 //--------------------------------------------------------------------------------------------------
+#define INIT_STATION_COUNT  16
 
-static void PaEventApHandler
+//--------------------------------------------------------------------------------------------------
+/**
+ * Access point configuration tree.
+ */
+//--------------------------------------------------------------------------------------------------
+#define CFG_TREE_ROOT_DIR           "wifiService:"
+#define CFG_PATH_WIFI_AP            "wifi/ap"
+#define CFG_NODE_STATION_POLL       "stationPollMs"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Default interval of the station dumps, in ms.
+ */
+//--------------------------------------------------------------------------------------------------
+#define STATION_POLL_DEFAULT_MS     2000
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Weight of the last interval in the traffic rates (exponentially weighted moving average), in
+ * percent.
+ */
+//--------------------------------------------------------------------------------------------------
+#define STATION_RATE_WEIGHT_PERCENT 25
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Station associated to the access point.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    char          mac[LE_WIFIDEFS_MAX_BSSID_BYTES]; ///< MAC address, lowercase, key of StationTable
+    le_clk_Time_t associationTime;                  ///< Relative time of the association
+    le_clk_Time_t lastSeen;                         ///< Relative time the station was last seen
+    bool          hasStats;                         ///< stats is valid
+    bool          hasRates;                         ///< rxRate and txRate are valid
+    pa_wifiAp_StationStats_t stats;                 ///< Counters of the last station dump
+    le_clk_Time_t statsTime;                        ///< Relative time of the last station dump
+    uint32_t      rxRate;                           ///< Received bytes per second, averaged
+    uint32_t      txRate;                           ///< Transmitted bytes per second, averaged
+    uint32_t      pollId;                           ///< Last station dump listing the station
+    uint32_t      ipAddr;                           ///< Leased address, host byte order, or 0
+    time_t        leaseExpiry;                      ///< Absolute expiry time of the lease (s)
+    char          hostname[LE_WIFIAPEXT_HOSTNAME_MAX_BYTES]; ///< Host name of the lease
+    le_dls_Link_t link;                             ///< Link in StationList
+}
+Station_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Station event, as reported to the le_wifiApExt_Station handlers.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    le_wifiAp_Event_t event;                            ///< Association or disassociation
+    char              mac[LE_WIFIDEFS_MAX_BSSID_BYTES]; ///< MAC address of the station
+    uint32_t          stationCount;                     ///< Number of stations afterwards
+}
+StationReport_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Lease event, as reported to the le_wifiApExt_Lease handlers.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    char mac[LE_WIFIDEFS_MAX_BSSID_BYTES];                  ///< MAC address of the station
+    char ipAddr[LE_WIFIAPEXT_IP_ADDR_MAX_LENGTH + 1];       ///< Address leased to the station
+    char hostname[LE_WIFIAPEXT_HOSTNAME_MAX_BYTES];         ///< Host name, or empty
+}
+LeaseReport_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Pool from which Station_t objects are allocated.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_mem_PoolRef_t StationPool;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stations associated to the access point, indexed by MAC address.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_hashmap_Ref_t StationTable;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stations associated to the access point, by association time.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_dls_List_t    StationList = LE_DLS_LIST_INIT;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Event ID of the le_wifiApExt_Station event.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_event_Id_t    StationEventId;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Event ID of the le_wifiApExt_Lease event.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_event_Id_t    LeaseEventId;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Timer of the station dumps, running while the access point is started, its interval in ms
+ * (0 to disable the dumps), and the ID of the last dump.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_timer_Ref_t   StationPollTimerRef;
+static int32_t          StationPollMs = STATION_POLL_DEFAULT_MS;
+static uint32_t         StationPollId;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Result of the last station dump.
+ */
+//--------------------------------------------------------------------------------------------------
+static pa_wifiAp_StationStats_t StationStats[PA_WIFIAP_MAX_STATIONS];
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Compute the time elapsed since a relative time, in milliseconds.
+ */
+//--------------------------------------------------------------------------------------------------
+static uint64_t GetElapsedMs
 (
-    le_wifiAp_Event_t event,
-    void *ctxPtr
+    le_clk_Time_t time
+        ///< [IN]
+        ///< Relative time, in the past
+)
+{
+    le_clk_Time_t elapsed = le_clk_Sub(le_clk_GetRelativeTime(), time);
+
+    return (uint64_t)elapsed.sec * 1000 + elapsed.usec / 1000;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Report a station association or disassociation to the le_wifiApExt_Station handlers.
+ */
+//--------------------------------------------------------------------------------------------------
+static void ReportStation
+(
+    le_wifiAp_Event_t  event,
+        ///< [IN]
+        ///< Association or disassociation
+    const char        *macPtr
+        ///< [IN]
+        ///< MAC address of the station
 )
 {
+    StationReport_t report;
 
-    LE_DEBUG("Event: %d", event);
+    report.event = event;
+    le_utf8_Copy(report.mac, macPtr, sizeof(report.mac), NULL);
+    report.stationCount = le_hashmap_Size(StationTable);
 
-    le_event_Report(NewWifiApEventId, (void *)&event, sizeof(le_wifiAp_Event_t));
+    LE_INFO("Station %s %s, %u connected", report.mac,
+            (LE_WIFIAP_EVENT_CLIENT_CONNECTED == event) ? "associated" : "disassociated",
+            report.stationCount);
+    le_event_Report(StationEventId, &report, sizeof(report));
 }
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Join a lease of the DHCP server to a station.
+ */
+//--------------------------------------------------------------------------------------------------
+static void SetStationLease
+(
+    Station_t                 *stationPtr,
+        ///< [IN]
+        ///< Station
+    const pa_wifiDhcp_Lease_t *leasePtr
+        ///< [IN]
+        ///< Lease of the station, address 0 if released
+)
+{
+    stationPtr->ipAddr = leasePtr->addr;
+    stationPtr->leaseExpiry = leasePtr->expiry;
+    le_utf8_Copy(stationPtr->hostname, leasePtr->hostname, sizeof(stationPtr->hostname), NULL);
+}
 
 //--------------------------------------------------------------------------------------------------
 /**
- * The first-layer WiFi Ap Event Handler.
+ * Get the time until the lease of a station expires.
  *
+ * @return The remaining time in seconds, 0 if the station has no active lease.
  */
 //--------------------------------------------------------------------------------------------------
-static void FirstLayerWifiApEventHandler
+static uint32_t GetLeaseRemainingSec
 (
-    void *reportPtr,
-    void *secondLayerHandlerFunc
+    const Station_t *stationPtr
+        ///< [IN]
+        ///< Station
 )
 {
-    le_wifiAp_EventHandlerFunc_t  clientHandlerFunc = secondLayerHandlerFunc;
-    le_wifiAp_Event_t            *wifiEventPtr      = (le_wifiAp_Event_t *)reportPtr;
+    time_t now = le_clk_GetAbsoluteTime().sec;
 
-    if (NULL != wifiEventPtr)
-    {
-        LE_DEBUG("Event: %d", *wifiEventPtr);
-        clientHandlerFunc(*wifiEventPtr, le_event_GetContextPtr());
-    }
-    else
+    if ((0 == stationPtr->ipAddr) || (stationPtr->leaseExpiry <= now))
     {
-        LE_ERROR("Event is NULL");
+        return 0;
     }
+    return (uint32_t)(stationPtr->leaseExpiry - now);
 }
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Add handler function for EVENT 'le_wifiAp_NewEvent'
- *
- * These events provide information on WiFi Access Point
+ * Format an address in host byte order.
  */
 //--------------------------------------------------------------------------------------------------
-le_wifiAp_NewEventHandlerRef_t le_wifiAp_AddNewEventHandler
+static void FormatIpAddr
 (
-    le_wifiAp_EventHandlerFunc_t handlerFuncPtr,
+    uint32_t  addr,
         ///< [IN]
-        ///< Event handler function
-
-    void *contextPtr
+        ///< Address
+    char     *bufPtr,
+        ///< [OUT]
+        ///< Dotted decimal address
+    size_t    bufSize
         ///< [IN]
-        ///< Associated event context
+        ///< Size of the buffer
 )
 {
-    le_event_HandlerRef_t handlerRef;
+    snprintf(bufPtr, bufSize, "%u.%u.%u.%u", (addr >> 24) & 0xFF, (addr >> 16) & 0xFF,
+             (addr >> 8) & 0xFF, addr & 0xFF);
+}
 
-    LE_DEBUG("Add new event handler");
-    if (handlerFuncPtr == NULL)
+//--------------------------------------------------------------------------------------------------
+/**
+ * CallBack for the leases of the DHCP server: join the lease to its station and report the
+ * addresses and host names given.
+ */
+//--------------------------------------------------------------------------------------------------
+static void PaDhcpLeaseHandler
+(
+    const pa_wifiDhcp_Lease_t *leasePtr,
+    void                      *ctxPtr
+)
+{
+    Station_t    *stationPtr = le_hashmap_Get(StationTable, leasePtr->mac);
+    LeaseReport_t report;
+
+    LE_DEBUG("Lease of %s: %08x", leasePtr->mac, leasePtr->addr);
+
+    // Renewals only update the expiry time of the lease
+    if ((0 != leasePtr->addr) &&
+        ((NULL == stationPtr) || (stationPtr->ipAddr != leasePtr->addr) ||
+         (0 != strcmp(stationPtr->hostname, leasePtr->hostname))))
     {
-        LE_KILL_CLIENT("handlerFuncPtr is NULL !");
-        return NULL;
+        le_utf8_Copy(report.mac, leasePtr->mac, sizeof(report.mac), NULL);
+        FormatIpAddr(leasePtr->addr, report.ipAddr, sizeof(report.ipAddr));
+        le_utf8_Copy(report.hostname, leasePtr->hostname, sizeof(report.hostname), NULL);
+        LE_INFO("Station %s given %s (%s)", report.mac, report.ipAddr,
+                ('\0' != report.hostname[0]) ? report.hostname : "no host name");
+        le_event_Report(LeaseEventId, &report, sizeof(report));
     }
 
-    handlerRef = le_event_AddLayeredHandler("NewWiFiApEventHandler",
-        NewWifiApEventId,
-        FirstLayerWifiApEventHandler,
-        (le_event_HandlerFunc_t)handlerFuncPtr);
+    if (NULL != stationPtr)
+    {
+        SetStationLease(stationPtr, leasePtr);
+    }
+}
 
-    le_event_SetContextPtr(handlerRef, contextPtr);
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add a station to the station table, or refresh it when it reassociates.
+ */
+//--------------------------------------------------------------------------------------------------
+static void AddStation
+(
+    const char *macPtr
+        ///< [IN]
+        ///< MAC address of the station
+)
+{
+    Station_t          *stationPtr = le_hashmap_Get(StationTable, macPtr);
+    pa_wifiDhcp_Lease_t lease;
 
-    return (le_wifiAp_NewEventHandlerRef_t)(handlerRef);
+    if (NULL == stationPtr)
+    {
+        stationPtr = le_mem_ForceAlloc(StationPool);
+        memset(stationPtr, 0, sizeof(Station_t));
+        le_utf8_Copy(stationPtr->mac, macPtr, sizeof(stationPtr->mac), NULL);
+        stationPtr->link = LE_DLS_LINK_INIT;
+        le_hashmap_Put(StationTable, stationPtr->mac, stationPtr);
+
+        // The station may keep a lease granted before it associated, e.g. before a restart
+        if (LE_OK == pa_wifiDhcp_GetLease(stationPtr->mac, &lease))
+        {
+            SetStationLease(stationPtr, &lease);
+        }
+    }
+    else
+    {
+        // Keep the list ordered by association time
+        le_dls_Remove(&StationList, &stationPtr->link);
+    }
+    le_dls_Queue(&StationList, &stationPtr->link);
+
+    stationPtr->associationTime = le_clk_GetRelativeTime();
+    stationPtr->lastSeen = stationPtr->associationTime;
+    // The counters of the driver restart at the association
+    stationPtr->hasStats = false;
+    stationPtr->hasRates = false;
+    stationPtr->rxRate = 0;
+    stationPtr->txRate = 0;
+
+    ReportStation(LE_WIFIAP_EVENT_CLIENT_CONNECTED, stationPtr->mac);
 }
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Remove handler function for EVENT 'le_wifiAp_NewEvent'
+ * Remove a station from the station table.
  */
 //--------------------------------------------------------------------------------------------------
-void le_wifiAp_RemoveNewEventHandler
+static void RemoveStation
 (
-    le_wifiAp_NewEventHandlerRef_t handlerRef
+    Station_t *stationPtr
         ///< [IN]
-        ///< Event handler function to remove.
+        ///< Station to remove
 )
 {
-    le_event_RemoveHandler((le_event_HandlerRef_t)handlerRef);
+    char mac[LE_WIFIDEFS_MAX_BSSID_BYTES];
+
+    le_utf8_Copy(mac, stationPtr->mac, sizeof(mac), NULL);
+    le_hashmap_Remove(StationTable, stationPtr->mac);
+    le_dls_Remove(&StationList, &stationPtr->link);
+    le_mem_Release(stationPtr);
+
+    ReportStation(LE_WIFIAP_EVENT_CLIENT_DISCONNECTED, mac);
 }
 
 //--------------------------------------------------------------------------------------------------
 /**
- * This function starts the WiFi Access Point.
- * Note that all settings, if to be used, such as security, username, password must set prior to
- * starting the Access Point.
- *
- * @return LE_FAULT         The function failed.
- * @return LE_OK            The function succeeded.
- * @return LE_NOT_FOUND     The WiFi card is absent.
- * @return LE_UNAVAILABLE   The WiFi card may not work.
- *
+ * Remove all the stations from the station table, once the access point is stopped.
  */
 //--------------------------------------------------------------------------------------------------
-le_result_t le_wifiAp_Start
+static void FlushStations
 (
     void
 )
 {
-    return pa_wifiAp_Start();
+    le_dls_Link_t *linkPtr;
+
+    while (NULL != (linkPtr = le_dls_Peek(&StationList)))
+    {
+        RemoveStation(CONTAINER_OF(linkPtr, Station_t, link));
+    }
 }
 
 //--------------------------------------------------------------------------------------------------
 /**
- * This function stops the WiFi Access Point.
+ * Fold the traffic of the last interval into an averaged rate.
  *
- * @return LE_FAULT         The function failed.
- * @return LE_OK            The function succeeded.
+ * @return The new rate, in bytes per second.
  */
 //--------------------------------------------------------------------------------------------------
-le_result_t le_wifiAp_Stop
+static uint32_t UpdateRate
 (
-    void
+    uint32_t rate,
+        ///< [IN]
+        ///< Averaged rate, in bytes per second
+    uint64_t bytes,
+        ///< [IN]
+        ///< Bytes of the interval
+    uint64_t intervalMs,
+        ///< [IN]
+        ///< Interval, not 0
+    bool     isFirst
+        ///< [IN]
+        ///< First interval of the station
 )
 {
-    return pa_wifiAp_Stop();
+    uint64_t sample = bytes * 1000 / intervalMs;
+
+    if (sample > UINT32_MAX)
+    {
+        sample = UINT32_MAX;
+    }
+    if (isFirst)
+    {
+        return (uint32_t)sample;
+    }
+    return (uint32_t)(((uint64_t)rate * (100 - STATION_RATE_WEIGHT_PERCENT) +
+                       sample * STATION_RATE_WEIGHT_PERCENT) / 100);
 }
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Update a station with its counters from a station dump.
+ */
+//--------------------------------------------------------------------------------------------------
+static void UpdateStation
+(
+    Station_t                      *stationPtr,
+        ///< [IN]
+        ///< Station
+    const pa_wifiAp_StationStats_t *statsPtr,
+        ///< [IN]
+        ///< Counters of the station
+    le_clk_Time_t                   now
+        ///< [IN]
+        ///< Relative time of the station dump
+)
+{
+    le_clk_Time_t inactive = { statsPtr->inactiveMs / 1000, (statsPtr->inactiveMs % 1000) * 1000 };
+    le_clk_Time_t interval = le_clk_Sub(now, stationPtr->statsTime);
+    uint64_t      intervalMs = (uint64_t)interval.sec * 1000 + interval.usec / 1000;
+
+    // Counters going backwards were reset by the driver: restart the rates on the next dump
+    if (stationPtr->hasStats && (intervalMs > 0) &&
+        (statsPtr->rxBytes >= stationPtr->stats.rxBytes) &&
+        (statsPtr->txBytes >= stationPtr->stats.txBytes))
+    {
+        stationPtr->rxRate = UpdateRate(stationPtr->rxRate,
+                                        statsPtr->rxBytes - stationPtr->stats.rxBytes,
+                                        intervalMs, !stationPtr->hasRates);
+        stationPtr->txRate = UpdateRate(stationPtr->txRate,
+                                        statsPtr->txBytes - stationPtr->stats.txBytes,
+                                        intervalMs, !stationPtr->hasRates);
+        stationPtr->hasRates = true;
+    }
+
+    stationPtr->stats = *statsPtr;
+    stationPtr->statsTime = now;
+    stationPtr->hasStats = true;
+    stationPtr->pollId = StationPollId;
 
+    // The driver sees the station frames that hostapd does not report
+    if (le_clk_GreaterThan(now, inactive))
+    {
+        inactive = le_clk_Sub(now, inactive);
+        if (le_clk_GreaterThan(inactive, stationPtr->lastSeen))
+        {
+            stationPtr->lastSeen = inactive;
+        }
+    }
+}
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Set the Service Set IDentification (SSID) of the access point
- *
- * @note The SSID does not have to be human readable ASCII values, but often is.
+ * Station dump timer handler: one nl80211 station dump updates all the stations of the table.
+ */
+//--------------------------------------------------------------------------------------------------
+static void StationPollTimerHandler
+(
+    le_timer_Ref_t timerRef
+)
+{
+    le_clk_Time_t  now = le_clk_GetRelativeTime();
+    le_dls_Link_t *linkPtr;
+    size_t         count;
+    size_t         i;
+    le_result_t    result;
+
+    result = pa_wifiAp_GetStationStats(StationStats, PA_WIFIAP_MAX_STATIONS, &count);
+    if ((LE_OK != result) && (LE_OVERFLOW != result))
+    {
+        LE_DEBUG("No station dump (%d)", result);
+        return;
+    }
+
+    StationPollId++;
+    for (i = 0; i < count; i++)
+    {
+        Station_t *stationPtr = le_hashmap_Get(StationTable, StationStats[i].mac);
+
+        if (NULL != stationPtr)
+        {
+            UpdateStation(stationPtr, &StationStats[i], now);
+        }
+    }
+
+    // A complete dump tells the stations whose disassociation was missed
+    linkPtr = le_dls_Peek(&StationList);
+    while ((LE_OK == result) && (NULL != linkPtr))
+    {
+        Station_t *stationPtr = CONTAINER_OF(linkPtr, Station_t, link);
+
+        linkPtr = le_dls_PeekNext(&StationList, linkPtr);
+        if (stationPtr->pollId != StationPollId)
+        {
+            LE_WARN("Station %s is not associated anymore", stationPtr->mac);
+            RemoveStation(stationPtr);
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * CallBack for PA Access Point Events.
+ */
+//--------------------------------------------------------------------------------------------------
+
+static void PaEventApHandler
+(
+    const pa_wifiAp_EventInd_t *eventIndPtr,
+    void *ctxPtr
+)
+{
+    le_wifiAp_Event_t event = eventIndPtr->event;
+
+    LE_DEBUG("Event: %d, station: %s", event, eventIndPtr->stationMac);
+
+    if ('\0' != eventIndPtr->stationMac[0])
+    {
+        Station_t *stationPtr = le_hashmap_Get(StationTable, eventIndPtr->stationMac);
+
+        if (LE_WIFIAP_EVENT_CLIENT_CONNECTED == event)
+        {
+            AddStation(eventIndPtr->stationMac);
+        }
+        else if ((LE_WIFIAP_EVENT_CLIENT_DISCONNECTED == event) && (NULL != stationPtr))
+        {
+            RemoveStation(stationPtr);
+        }
+    }
+
+    le_event_Report(NewWifiApEventId, (void *)&event, sizeof(le_wifiAp_Event_t));
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * The first-layer WiFi Ap Event Handler.
+ *
+ */
+//--------------------------------------------------------------------------------------------------
+static void FirstLayerWifiApEventHandler
+(
+    void *reportPtr,
+    void *secondLayerHandlerFunc
+)
+{
+    le_wifiAp_EventHandlerFunc_t  clientHandlerFunc = secondLayerHandlerFunc;
+    le_wifiAp_Event_t            *wifiEventPtr      = (le_wifiAp_Event_t *)reportPtr;
+
+    if (NULL != wifiEventPtr)
+    {
+        LE_DEBUG("Event: %d", *wifiEventPtr);
+        clientHandlerFunc(*wifiEventPtr, le_event_GetContextPtr());
+    }
+    else
+    {
+        LE_ERROR("Event is NULL");
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add handler function for EVENT 'le_wifiAp_NewEvent'
+ *
+ * These events provide information on WiFi Access Point
+ */
+//--------------------------------------------------------------------------------------------------
+le_wifiAp_NewEventHandlerRef_t le_wifiAp_AddNewEventHandler
+(
+    le_wifiAp_EventHandlerFunc_t handlerFuncPtr,
+        ///< [IN]
+        ///< Event handler function
+
+    void *contextPtr
+        ///< [IN]
+        ///< Associated event context
+)
+{
+    le_event_HandlerRef_t handlerRef;
+
+    LE_DEBUG("Add new event handler");
+    if (handlerFuncPtr == NULL)
+    {
+        LE_KILL_CLIENT("handlerFuncPtr is NULL !");
+        return NULL;
+    }
+
+    handlerRef = le_event_AddLayeredHandler("NewWiFiApEventHandler",
+        NewWifiApEventId,
+        FirstLayerWifiApEventHandler,
+        (le_event_HandlerFunc_t)handlerFuncPtr);
+
+    le_event_SetContextPtr(handlerRef, contextPtr);
+
+    return (le_wifiAp_NewEventHandlerRef_t)(handlerRef);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Remove handler function for EVENT 'le_wifiAp_NewEvent'
+ */
+//--------------------------------------------------------------------------------------------------
+void le_wifiAp_RemoveNewEventHandler
+(
+    le_wifiAp_NewEventHandlerRef_t handlerRef
+        ///< [IN]
+        ///< Event handler function to remove.
+)
+{
+    le_event_RemoveHandler((le_event_HandlerRef_t)handlerRef);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * This function starts the WiFi Access Point.
+ * Note that all settings, if to be used, such as security, username, password must set prior to
+ * starting the Access Point.
+ *
+ * @return LE_FAULT         The function failed.
+ * @return LE_OK            The function succeeded.
+ * @return LE_NOT_FOUND     The WiFi card is absent.
+ * @return LE_UNAVAILABLE   The WiFi card may not work.
+ *
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t le_wifiAp_Start
+(
+    void
+)
+{
+    le_result_t result = pa_wifiAp_Start();
+
+    if ((LE_OK == result) && (StationPollMs > 0) && (!le_timer_IsRunning(StationPollTimerRef)))
+    {
+        le_timer_Start(StationPollTimerRef);
+    }
+    return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * This function stops the WiFi Access Point.
+ *
+ * @return LE_FAULT         The function failed.
+ * @return LE_OK            The function succeeded.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t le_wifiAp_Stop
+(
+    void
+)
+{
+    le_result_t result = pa_wifiAp_Stop();
+
+    if (LE_OK == result)
+    {
+        if (le_timer_IsRunning(StationPollTimerRef))
+        {
+            le_timer_Stop(StationPollTimerRef);
+        }
+        // The disassociations are not notified once the access point is stopped
+        FlushStations();
+    }
+    return result;
+}
+
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the Service Set IDentification (SSID) of the access point
+ *
+ * @note The SSID does not have to be human readable ASCII values, but often is.
+ *
+ * @return LE_BAD_PARAMETER Some parameter is invalid.
+ * @return LE_OK            Function succeeded.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t le_wifiAp_SetSsid
+(
+    const uint8_t *ssidPtr,
+        ///< [IN]
+        ///< The SSID to set as a octet array.
+
+    size_t ssidNumElements
+        ///< [IN]
+        ///< The length of the SSID in octets.
+)
+{
+    return pa_wifiAp_SetSsid(ssidPtr, ssidNumElements);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the security protocol to use.
+ *
+ * @note that the SSID does not have to be human readable ASCII values, but often has.
+ *
+ * @return LE_BAD_PARAMETER Some parameter is invalid.
+ * @return LE_OK            Function succeeded.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t le_wifiAp_SetSecurityProtocol
+(
+    le_wifiAp_SecurityProtocol_t securityProtocol
+        ///< [IN]
+        ///< The security protocol used to communicate with the access point.
+)
+{
+    return pa_wifiAp_SetSecurityProtocol(securityProtocol);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the passphrase used to generate the PSK.
+ *
+ * @note This is one way to authenticate against the access point. The other one is provided by the
+ * le_wifiAp_SetPreSharedKey() function. Both ways are exclusive and are effective only when used
+ * with WPA-personal authentication.
+ *
+ * @return LE_BAD_PARAMETER Parameter is invalid.
+ * @return LE_OK            Function succeeded.
+ *
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t le_wifiAp_SetPassPhrase
+(
+    const char *passphrasePtr
+        ///< [IN]
+        ///< Passphrase to authenticate against the access point.
+)
+{
+    return pa_wifiAp_SetPassPhrase(passphrasePtr);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the pre-shared key (PSK).
+ *
+ * @note This is one way to authenticate against the access point. The other one is provided by the
+ * le_wifiAp_SetPassPhrase() function. Both ways are exclusive and are effective only when used
+ * with WPA-personal authentication.
+ *
+ * @return LE_BAD_PARAMETER Parameter is invalid.
+ * @return LE_OK            Function succeeded.
+ *
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t le_wifiAp_SetPreSharedKey
+(
+    const char *preSharedKeyPtr
+        ///< [IN]
+        ///< Pre-shared key used to authenticate against the access point.
+)
+{
+    return pa_wifiAp_SetPreSharedKey(preSharedKeyPtr);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set if the Access Point should announce its presence.
+ * Default value is TRUE.
+ * If the value is set to FALSE, the Access Point will be hidden.
+ *
+ * @return LE_OK            Function succeeded.
+ *
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t le_wifiAp_SetDiscoverable
+(
+    bool isDiscoverable
+        ///< [IN]
+        ///< If TRUE the Access Point shows up on scans, else it is hidden.
+)
+{
+    return pa_wifiAp_SetDiscoverable(isDiscoverable);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set which WiFi channel to use.
+ * Default number is 7.
+ * Some legal restrictions might apply for your region.
+ * The channel number must be between 1 and 14 for IEEE 802.11b/g.
+ * The channel number must be between 7 and 196 for IEEE 802.11a.
+ * The channel number must be between 1 and 6 for IEEE 802.11ad.
+ * @return
+ *      - LE_OUT_OF_RANGE if requested channel number is out of range.
+ *      - LE_OK if the function succeeded.
+ *
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t le_wifiAp_SetChannel
+(
+    uint16_t channelNumber
+        ///< [IN]
+        ///< the channel number.
+)
+{
+    return pa_wifiAp_SetChannel(channelNumber);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set which IEEE standard to use.
+ * Default hardware mode is IEEE 802.11g.
+ *
+ * @return
+ *      - LE_BAD_PARAMETER if invalid IEEE standard is set.
+ *      - LE_OK if the function succeeded.
+ *
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t le_wifiAp_SetIeeeStandard
+(
+    le_wifiAp_IeeeStdBitMask_t stdMask
+        ///< [IN]
+        ///< Bit mask for the IEEE standard.
+)
+{
+    return pa_wifiAp_SetIeeeStandard(stdMask);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get which IEEE standard was set.
+ * Default hardware mode is IEEE 802.11g.
+ *
+ * @return
+ *      - LE_FAULT if the function failed.
+ *      - LE_OK if the function succeeded.
+ *
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t le_wifiAp_GetIeeeStandard
+(
+    le_wifiAp_IeeeStdBitMask_t *stdMaskPtr
+        ///< [OUT]
+        ///< Bit mask for the IEEE standard.
+)
+{
+    if ( NULL == stdMaskPtr )
+    {
+        LE_WARN("stdMaskPtr is NULL.");
+        return LE_FAULT;
+    }
+    return pa_wifiAp_GetIeeeStandard(stdMaskPtr);
+}
+
+/**
+ * Set what country code to use for regulatory domain.
+ * ISO/IEC 3166-1 Alpha-2 code is used.
+ * Default country code is US.
+ * @return
+ *      - LE_FAULT if the function failed.
+ *      - LE_OK if the function succeeded.
+ *
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t le_wifiAp_SetCountryCode
+(
+    const char *countryCodePtr
+        ///< [IN]
+        ///< the country code.
+)
+{
+    return pa_wifiAp_SetCountryCode(countryCodePtr);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Load the access point settings of the configuration tree.
+ *
+ * wifiService:/wifi/ap/stationPollMs sets the interval of the station dumps updating the traffic
+ * and the signal of the stations, 0 to disable them.
+ */
+//--------------------------------------------------------------------------------------------------
+static void LoadApConfig
+(
+    void
+)
+{
+    char                 configPath[LE_CFG_STR_LEN_BYTES] = {0};
+    le_cfg_IteratorRef_t cfg;
+    int32_t              pollMs;
+
+    snprintf(configPath, sizeof(configPath), "%s/%s", CFG_TREE_ROOT_DIR, CFG_PATH_WIFI_AP);
+    cfg = le_cfg_CreateReadTxn(configPath);
+
+    pollMs = le_cfg_GetInt(cfg, CFG_NODE_STATION_POLL, STATION_POLL_DEFAULT_MS);
+    if (pollMs < 0)
+    {
+        LE_WARN("Invalid station poll interval %d ms, using %d ms", pollMs,
+                STATION_POLL_DEFAULT_MS);
+        pollMs = STATION_POLL_DEFAULT_MS;
+    }
+    StationPollMs = pollMs;
+
+    le_cfg_CancelTxn(cfg);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ *  WiFi access point component initialization.
+ */
+//--------------------------------------------------------------------------------------------------
+void le_wifiAp_Init
+(
+    void
+)
+{
+    LE_DEBUG("WiFi Access Point Service is ready");
+
+    pa_wifiAp_Init();
+
+    // Create an event Id for new WiFi Events
+    NewWifiApEventId = le_event_CreateId("WiFiApEventId", sizeof(le_wifiAp_Event_t));
+
+    StationPool = le_mem_CreatePool("WifiApStation", sizeof(Station_t));
+    le_mem_ExpandPool(StationPool, INIT_STATION_COUNT);
+    StationTable = le_hashmap_Create("le_wifiAp_StationTable", INIT_STATION_COUNT,
+                                     le_hashmap_HashString, le_hashmap_EqualsString);
+    StationEventId = le_event_CreateId("WifiApStation", sizeof(StationReport_t));
+    LeaseEventId = le_event_CreateId("WifiApLease", sizeof(LeaseReport_t));
+
+    LoadApConfig();
+    StationPollTimerRef = le_timer_Create("WifiApStationPoll");
+    le_timer_SetMsInterval(StationPollTimerRef, (StationPollMs > 0) ? StationPollMs : 1);
+    le_timer_SetRepeat(StationPollTimerRef, 0);
+    le_timer_SetHandler(StationPollTimerRef, StationPollTimerHandler);
+
+    // register for events from PA.
+    pa_wifiAp_AddEventIndHandler(PaEventApHandler, NULL);
+    pa_wifiDhcp_SetLeaseHandler(PaDhcpLeaseHandler, NULL);
+
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set number of maximally allowed clients to connect to the Access Point at the same time.
+ *
+ * @return LE_OUT_OF_RANGE  Requested number of users exceeds the capabilities of the Access Point.
+ * @return LE_OK            Function succeeded.
+ *
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t le_wifiAp_SetMaxNumberOfClients
+(
+    int8_t maxNumberOfClients
+        ///< [IN]
+        ///< the maximum number of clients
+)
+{
+    if (0 == maxNumberOfClients)
+    {
+        return LE_OUT_OF_RANGE;
+    }
+    return pa_wifiAp_SetMaxNumberClients(maxNumberOfClients);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Defines the IP adresses range for the host AP.
+ *
+ * @return LE_BAD_PARAMETER At least, one of the given IP addresses is invalid.
+ * @return LE_FAULT         A system call has failed.
+ * @return LE_OK            Function succeeded.
+ *
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t le_wifiAp_SetIpRange
+(
+    const char *ip_ap,
+        ///< [IN]
+        ///< the IP address of the Access Point.
+    const char *ip_start,
+        ///< [IN]
+        ///< the start IP address of the Access Point.
+    const char *ip_stop
+        ///< [IN]
+        ///< the stop IP address of the Access Point.
+)
+{
+    return pa_wifiAp_SetIpRange(ip_ap, ip_start, ip_stop);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Write an unsigned integer of a packed entry, little endian.
+ */
+//--------------------------------------------------------------------------------------------------
+static void PackUint
+(
+    uint8_t  *bytePtr,
+        ///< [OUT]
+        ///< First byte of the field
+    uint64_t  value,
+        ///< [IN]
+        ///< Value of the field
+    size_t    size
+        ///< [IN]
+        ///< Size of the field in bytes
+)
+{
+    size_t i;
+
+    for (i = 0; i < size; i++)
+    {
+        bytePtr[i] = (value >> (8 * i)) & 0xFF;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Write a station as a packed station entry (see le_wifiApExt_GetStations()).
+ */
+//--------------------------------------------------------------------------------------------------
+static void PackStationEntry
+(
+    const Station_t *stationPtr,
+        ///< [IN]
+        ///< Station
+    uint8_t         *entryPtr
+        ///< [OUT]
+        ///< Entry of LE_WIFIAPEXT_STATION_ENTRY_BYTES bytes
+)
+{
+    uint8_t *macPtr = &entryPtr[LE_WIFIAPEXT_STATION_ENTRY_MAC_OFFSET];
+    uint64_t connectedSec = GetElapsedMs(stationPtr->associationTime) / 1000;
+    uint64_t inactiveMs = GetElapsedMs(stationPtr->lastSeen);
+    int16_t  signal = LE_WIFIAPEXT_NO_SIGNAL_STRENGTH;
+    uint32_t leaseSec;
+
+    memset(entryPtr, 0, LE_WIFIAPEXT_STATION_ENTRY_BYTES);
+
+    if (6 != sscanf(stationPtr->mac, "%hhx:%hhx:%hhx:%hhx:%hhx:%hhx", &macPtr[0], &macPtr[1],
+                    &macPtr[2], &macPtr[3], &macPtr[4], &macPtr[5]))
+    {
+        memset(macPtr, 0, 6);
+    }
+
+    if (inactiveMs > UINT32_MAX)
+    {
+        inactiveMs = UINT32_MAX;
+    }
+    PackUint(&entryPtr[LE_WIFIAPEXT_STATION_ENTRY_CONNECTED_OFFSET], connectedSec, 4);
+    PackUint(&entryPtr[LE_WIFIAPEXT_STATION_ENTRY_INACTIVE_OFFSET], inactiveMs, 4);
+
+    if (stationPtr->hasStats)
+    {
+        signal = stationPtr->stats.signalStrength;
+        PackUint(&entryPtr[LE_WIFIAPEXT_STATION_ENTRY_RX_RATE_OFFSET], stationPtr->rxRate, 4);
+        PackUint(&entryPtr[LE_WIFIAPEXT_STATION_ENTRY_TX_RATE_OFFSET], stationPtr->txRate, 4);
+        PackUint(&entryPtr[LE_WIFIAPEXT_STATION_ENTRY_TX_BITRATE_OFFSET],
+                 stationPtr->stats.txBitrate, 4);
+        PackUint(&entryPtr[LE_WIFIAPEXT_STATION_ENTRY_RX_PACKETS_OFFSET],
+                 stationPtr->stats.rxPackets, 4);
+        PackUint(&entryPtr[LE_WIFIAPEXT_STATION_ENTRY_TX_PACKETS_OFFSET],
+                 stationPtr->stats.txPackets, 4);
+        PackUint(&entryPtr[LE_WIFIAPEXT_STATION_ENTRY_RX_BYTES_OFFSET],
+                 stationPtr->stats.rxBytes, 8);
+        PackUint(&entryPtr[LE_WIFIAPEXT_STATION_ENTRY_TX_BYTES_OFFSET],
+                 stationPtr->stats.txBytes, 8);
+    }
+    PackUint(&entryPtr[LE_WIFIAPEXT_STATION_ENTRY_SIGNAL_OFFSET], (uint16_t)signal, 2);
+
+    leaseSec = GetLeaseRemainingSec(stationPtr);
+    if (leaseSec > 0)
+    {
+        // Network byte order, as the MAC address
+        entryPtr[LE_WIFIAPEXT_STATION_ENTRY_IP_ADDR_OFFSET] = (stationPtr->ipAddr >> 24) & 0xFF;
+        entryPtr[LE_WIFIAPEXT_STATION_ENTRY_IP_ADDR_OFFSET + 1] = (stationPtr->ipAddr >> 16) & 0xFF;
+        entryPtr[LE_WIFIAPEXT_STATION_ENTRY_IP_ADDR_OFFSET + 2] = (stationPtr->ipAddr >> 8) & 0xFF;
+        entryPtr[LE_WIFIAPEXT_STATION_ENTRY_IP_ADDR_OFFSET + 3] = stationPtr->ipAddr & 0xFF;
+        PackUint(&entryPtr[LE_WIFIAPEXT_STATION_ENTRY_LEASE_OFFSET], leaseSec, 4);
+        le_utf8_Copy((char *)&entryPtr[LE_WIFIAPEXT_STATION_ENTRY_HOSTNAME_OFFSET],
+                     stationPtr->hostname, LE_WIFIAPEXT_HOSTNAME_MAX_BYTES, NULL);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get a page of the stations connected to the access point, as packed entries.
  *
- * @return LE_BAD_PARAMETER Some parameter is invalid.
- * @return LE_OK            Function succeeded.
+ * @return
+ *      - LE_OK             Function succeeded.
+ *      - LE_OUT_OF_RANGE   startIndex is greater than totalCount.
+ *      - LE_FAULT          Function failed.
  */
 //--------------------------------------------------------------------------------------------------
-le_result_t le_wifiAp_SetSsid
+le_result_t le_wifiApExt_GetStations
 (
-    const uint8_t *ssidPtr,
-        ///< [IN]
-        ///< The SSID to set as a octet array.
-
-    size_t ssidNumElements
+    uint32_t startIndex,
         ///< [IN]
-        ///< The length of the SSID in octets.
+        ///< Index of the first entry to return.
+    uint32_t *totalCountPtr,
+        ///< [OUT]
+        ///< Number of stations connected.
+    uint8_t *entriesPtr,
+        ///< [OUT]
+        ///< Packed entries.
+    size_t *entriesSizePtr
+        ///< [INOUT]
 )
 {
-    return pa_wifiAp_SetSsid(ssidPtr, ssidNumElements);
-}
+    le_dls_Link_t *linkPtr;
+    uint32_t       index = 0;
+    size_t         pageSize = 0;
 
+    if ((!totalCountPtr) || (!entriesPtr) || (!entriesSizePtr))
+    {
+        LE_KILL_CLIENT("Invalid parameter !");
+        return LE_FAULT;
+    }
+
+    for (linkPtr = le_dls_Peek(&StationList);
+         NULL != linkPtr;
+         linkPtr = le_dls_PeekNext(&StationList, linkPtr))
+    {
+        if ((index >= startIndex) &&
+            (pageSize + LE_WIFIAPEXT_STATION_ENTRY_BYTES <= *entriesSizePtr))
+        {
+            PackStationEntry(CONTAINER_OF(linkPtr, Station_t, link), &entriesPtr[pageSize]);
+            pageSize += LE_WIFIAPEXT_STATION_ENTRY_BYTES;
+        }
+        index++;
+    }
+
+    if (startIndex > index)
+    {
+        return LE_OUT_OF_RANGE;
+    }
+
+    *totalCountPtr = index;
+    *entriesSizePtr = pageSize;
+    return LE_OK;
+}
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Set the security protocol to use.
- *
- * @note that the SSID does not have to be human readable ASCII values, but often has.
+ * Look a station of the station table up by its MAC address, in any case.
  *
- * @return LE_BAD_PARAMETER Some parameter is invalid.
- * @return LE_OK            Function succeeded.
+ * @return
+ *      - LE_OK             Function succeeded.
+ *      - LE_NOT_FOUND      The station is not connected.
+ *      - LE_BAD_PARAMETER  The MAC address is invalid.
  */
 //--------------------------------------------------------------------------------------------------
-le_result_t le_wifiAp_SetSecurityProtocol
+static le_result_t FindStation
 (
-    le_wifiAp_SecurityProtocol_t securityProtocol
+    const char       *macPtr,
         ///< [IN]
-        ///< The security protocol used to communicate with the access point.
+        ///< MAC address
+    const Station_t **stationPtrPtr
+        ///< [OUT]
+        ///< Station
 )
 {
-    return pa_wifiAp_SetSecurityProtocol(securityProtocol);
-}
+    char    mac[LE_WIFIDEFS_MAX_BSSID_BYTES];
+    uint8_t bytes[6];
 
+    // The table is keyed by the lowercase form reported by the PA
+    if (6 != sscanf(macPtr, "%hhx:%hhx:%hhx:%hhx:%hhx:%hhx",
+                    &bytes[0], &bytes[1], &bytes[2], &bytes[3], &bytes[4], &bytes[5]))
+    {
+        return LE_BAD_PARAMETER;
+    }
+    snprintf(mac, sizeof(mac), "%02x:%02x:%02x:%02x:%02x:%02x",
+             bytes[0], bytes[1], bytes[2], bytes[3], bytes[4], bytes[5]);
+
+    *stationPtrPtr = le_hashmap_Get(StationTable, mac);
+    return (NULL == *stationPtrPtr) ? LE_NOT_FOUND : LE_OK;
+}
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Set the passphrase used to generate the PSK.
- *
- * @note This is one way to authenticate against the access point. The other one is provided by the
- * le_wifiAp_SetPreSharedKey() function. Both ways are exclusive and are effective only when used
- * with WPA-personal authentication.
- *
- * @return LE_BAD_PARAMETER Parameter is invalid.
- * @return LE_OK            Function succeeded.
+ * Look a station connected to the access point up.
  *
+ * @return
+ *      - LE_OK             Function succeeded.
+ *      - LE_NOT_FOUND      The station is not connected.
+ *      - LE_BAD_PARAMETER  The MAC address is invalid.
+ *      - LE_FAULT          Function failed.
  */
 //--------------------------------------------------------------------------------------------------
-le_result_t le_wifiAp_SetPassPhrase
+le_result_t le_wifiApExt_GetStation
 (
-    const char *passphrasePtr
+    const char *macPtr,
         ///< [IN]
-        ///< Passphrase to authenticate against the access point.
+        ///< MAC address, e.g. 02:00:00:00:00:01.
+    uint32_t *connectedSecPtr,
+        ///< [OUT]
+        ///< Time since the association (s).
+    uint32_t *inactiveMsPtr
+        ///< [OUT]
+        ///< Time since last seen (ms).
 )
 {
-    return pa_wifiAp_SetPassPhrase(passphrasePtr);
-}
+    uint64_t         inactiveMs;
+    const Station_t *stationPtr;
+    le_result_t      result;
+
+    if ((!macPtr) || (!connectedSecPtr) || (!inactiveMsPtr))
+    {
+        LE_KILL_CLIENT("Invalid parameter !");
+        return LE_FAULT;
+    }
 
+    result = FindStation(macPtr, &stationPtr);
+    if (LE_OK != result)
+    {
+        return result;
+    }
+
+    inactiveMs = GetElapsedMs(stationPtr->lastSeen);
+    *connectedSecPtr = GetElapsedMs(stationPtr->associationTime) / 1000;
+    *inactiveMsPtr = (inactiveMs > UINT32_MAX) ? UINT32_MAX : (uint32_t)inactiveMs;
+    return LE_OK;
+}
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Set the pre-shared key (PSK).
- *
- * @note This is one way to authenticate against the access point. The other one is provided by the
- * le_wifiAp_SetPassPhrase() function. Both ways are exclusive and are effective only when used
- * with WPA-personal authentication.
- *
- * @return LE_BAD_PARAMETER Parameter is invalid.
- * @return LE_OK            Function succeeded.
+ * Get the traffic and the signal of a station connected to the access point, as of the last
+ * station dump.
  *
+ * @return
+ *      - LE_OK             Function succeeded.
+ *      - LE_NOT_FOUND      The station is not connected.
+ *      - LE_UNAVAILABLE    The station was not dumped yet.
+ *      - LE_BAD_PARAMETER  The MAC address is invalid.
+ *      - LE_FAULT          Function failed.
  */
 //--------------------------------------------------------------------------------------------------
-le_result_t le_wifiAp_SetPreSharedKey
+le_result_t le_wifiApExt_GetStationStats
 (
-    const char *preSharedKeyPtr
+    const char *macPtr,
         ///< [IN]
-        ///< Pre-shared key used to authenticate against the access point.
+        ///< MAC address, e.g. 02:00:00:00:00:01.
+    int16_t *signalStrengthPtr,
+        ///< [OUT]
+        ///< Signal strength (dBm), NO_SIGNAL_STRENGTH if unknown.
+    uint32_t *rxRatePtr,
+        ///< [OUT]
+        ///< Bytes received per second, averaged.
+    uint32_t *txRatePtr,
+        ///< [OUT]
+        ///< Bytes transmitted per second, averaged.
+    uint32_t *txBitratePtr,
+        ///< [OUT]
+        ///< Transmit bitrate (kbit/s), 0 if unknown.
+    uint64_t *rxBytesPtr,
+        ///< [OUT]
+        ///< Bytes received since the association.
+    uint64_t *txBytesPtr
+        ///< [OUT]
+        ///< Bytes transmitted since the association.
 )
 {
-    return pa_wifiAp_SetPreSharedKey(preSharedKeyPtr);
-}
+    const Station_t *stationPtr;
+    le_result_t      result;
+
+    if ((!macPtr) || (!signalStrengthPtr) || (!rxRatePtr) || (!txRatePtr) || (!txBitratePtr) ||
+        (!rxBytesPtr) || (!txBytesPtr))
+    {
+        LE_KILL_CLIENT("Invalid parameter !");
+        return LE_FAULT;
+    }
+
+    result = FindStation(macPtr, &stationPtr);
+    if (LE_OK != result)
+    {
+        return result;
+    }
+    if (!stationPtr->hasStats)
+    {
+        return LE_UNAVAILABLE;
+    }
 
+    *signalStrengthPtr = stationPtr->stats.signalStrength;
+    *rxRatePtr = stationPtr->rxRate;
+    *txRatePtr = stationPtr->txRate;
+    *txBitratePtr = stationPtr->stats.txBitrate;
+    *rxBytesPtr = stationPtr->stats.rxBytes;
+    *txBytesPtr = stationPtr->stats.txBytes;
+    return LE_OK;
+}
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Set if the Access Point should announce its presence.
- * Default value is TRUE.
- * If the value is set to FALSE, the Access Point will be hidden.
- *
- * @return LE_OK            Function succeeded.
+ * Get the time taken by the last start of the access point.
  *
+ * @return
+ *      - LE_OK             Function succeeded.
+ *      - LE_UNAVAILABLE    The access point was not started yet.
+ *      - LE_FAULT          Function failed.
  */
 //--------------------------------------------------------------------------------------------------
-le_result_t le_wifiAp_SetDiscoverable
+le_result_t le_wifiApExt_GetStartStats
 (
-    bool isDiscoverable
-        ///< [IN]
-        ///< If TRUE the Access Point shows up on scans, else it is hidden.
+    uint32_t *interfaceUpMsPtr,
+        ///< [OUT]
+        ///< Time until the WLAN interface was up (ms).
+    uint32_t *hostapdMsPtr
+        ///< [OUT]
+        ///< Time taken by the last hostapd start or restart (ms), 0 if unknown.
 )
 {
-    return pa_wifiAp_SetDiscoverable(isDiscoverable);
-}
+    if ((!interfaceUpMsPtr) || (!hostapdMsPtr))
+    {
+        LE_KILL_CLIENT("Invalid parameter !");
+        return LE_FAULT;
+    }
 
+    return pa_wifiAp_GetStartLatency(interfaceUpMsPtr, hostapdMsPtr);
+}
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Set which WiFi channel to use.
- * Default number is 7.
- * Some legal restrictions might apply for your region.
- * The channel number must be between 1 and 14 for IEEE 802.11b/g.
- * The channel number must be between 7 and 196 for IEEE 802.11a.
- * The channel number must be between 1 and 6 for IEEE 802.11ad.
- * @return
- *      - LE_OUT_OF_RANGE if requested channel number is out of range.
- *      - LE_OK if the function succeeded.
+ * Get the address lease of a station connected to the access point.
  *
+ * @return
+ *      - LE_OK             Function succeeded.
+ *      - LE_NOT_FOUND      The station is not connected.
+ *      - LE_UNAVAILABLE    The station has no active lease.
+ *      - LE_BAD_PARAMETER  The MAC address is invalid.
+ *      - LE_FAULT          Function failed.
  */
 //--------------------------------------------------------------------------------------------------
-le_result_t le_wifiAp_SetChannel
+le_result_t le_wifiApExt_GetLease
 (
-    uint16_t channelNumber
+    const char *macPtr,
         ///< [IN]
-        ///< the channel number.
+        ///< MAC address, e.g. 02:00:00:00:00:01.
+    char *ipAddrPtr,
+        ///< [OUT]
+        ///< IPv4 address leased to the station.
+    size_t ipAddrSize,
+        ///< [IN]
+    char *hostnamePtr,
+        ///< [OUT]
+        ///< Host name, empty if none.
+    size_t hostnameSize,
+        ///< [IN]
+    uint32_t *expirySecPtr
+        ///< [OUT]
+        ///< Time until the lease expires (s).
 )
 {
-    return pa_wifiAp_SetChannel(channelNumber);
-}
+    const Station_t *stationPtr;
+    le_result_t      result;
+    uint32_t         leaseSec;
+
+    if ((!macPtr) || (!ipAddrPtr) || (!hostnamePtr) || (!expirySecPtr))
+    {
+        LE_KILL_CLIENT("Invalid parameter !");
+        return LE_FAULT;
+    }
+
+    result = FindStation(macPtr, &stationPtr);
+    if (LE_OK != result)
+    {
+        return result;
+    }
+    leaseSec = GetLeaseRemainingSec(stationPtr);
+    if (0 == leaseSec)
+    {
+        return LE_UNAVAILABLE;
+    }
 
+    FormatIpAddr(stationPtr->ipAddr, ipAddrPtr, ipAddrSize);
+    le_utf8_Copy(hostnamePtr, stationPtr->hostname, hostnameSize, NULL);
+    *expirySecPtr = leaseSec;
+    return LE_OK;
+}
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Set which IEEE standard to use.
- * Default hardware mode is IEEE 802.11g.
- *
- * @return
- *      - LE_BAD_PARAMETER if invalid IEEE standard is set.
- *      - LE_OK if the function succeeded.
- *
+ * The first-layer Station event handler.
  */
 //--------------------------------------------------------------------------------------------------
-le_result_t le_wifiAp_SetIeeeStandard
+static void FirstLayerStationHandler
 (
-    le_wifiAp_IeeeStdBitMask_t stdMask
-        ///< [IN]
-        ///< Bit mask for the IEEE standard.
+    void *reportPtr,
+    void *secondLayerHandlerFunc
 )
 {
-    return pa_wifiAp_SetIeeeStandard(stdMask);
+    const StationReport_t              *stationPtr = reportPtr;
+    le_wifiApExt_StationHandlerFunc_t   clientHandlerFunc = secondLayerHandlerFunc;
+
+    clientHandlerFunc(stationPtr->event, stationPtr->mac, stationPtr->stationCount,
+                      le_event_GetContextPtr());
 }
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Get which IEEE standard was set.
- * Default hardware mode is IEEE 802.11g.
- *
- * @return
- *      - LE_FAULT if the function failed.
- *      - LE_OK if the function succeeded.
+ * Add handler function for EVENT 'le_wifiApExt_Station'
  *
+ * This event reports each station association and disassociation.
  */
 //--------------------------------------------------------------------------------------------------
-le_result_t le_wifiAp_GetIeeeStandard
+le_wifiApExt_StationHandlerRef_t le_wifiApExt_AddStationHandler
 (
-    le_wifiAp_IeeeStdBitMask_t *stdMaskPtr
-        ///< [OUT]
-        ///< Bit mask for the IEEE standard.
+    le_wifiApExt_StationHandlerFunc_t handlerFuncPtr,
+        ///< [IN]
+        ///< Event handling function
+
+    void *contextPtr
+        ///< [IN]
+        ///< Associated event context
 )
 {
-    if ( NULL == stdMaskPtr )
+    le_event_HandlerRef_t handlerRef;
+
+    if (handlerFuncPtr == NULL)
     {
-        LE_WARN("stdMaskPtr is NULL.");
-        return LE_FAULT;
+        LE_KILL_CLIENT("handlerFuncPtr is NULL !");
+        return NULL;
     }
-    return pa_wifiAp_GetIeeeStandard(stdMaskPtr);
+
+    handlerRef = le_event_AddLayeredHandler("WiFiApStationHandler",
+                                            StationEventId,
+                                            FirstLayerStationHandler,
+                                            (le_event_HandlerFunc_t)handlerFuncPtr);
+
+    le_event_SetContextPtr(handlerRef, contextPtr);
+
+    return (le_wifiApExt_StationHandlerRef_t)(handlerRef);
 }
 
+//--------------------------------------------------------------------------------------------------
 /**
- * Set what country code to use for regulatory domain.
- * ISO/IEC 3166-1 Alpha-2 code is used.
- * Default country code is US.
- * @return
- *      - LE_FAULT if the function failed.
- *      - LE_OK if the function succeeded.
- *
+ * Remove handler function for EVENT 'le_wifiApExt_Station'
  */
 //--------------------------------------------------------------------------------------------------
-le_result_t le_wifiAp_SetCountryCode
+void le_wifiApExt_RemoveStationHandler
 (
-    const char *countryCodePtr
+    le_wifiApExt_StationHandlerRef_t handlerRef
         ///< [IN]
-        ///< the country code.
+        ///< Reference of the event handler to remove
 )
 {
-    return pa_wifiAp_SetCountryCode(countryCodePtr);
+    le_event_RemoveHandler((le_event_HandlerRef_t)handlerRef);
 }
 
 //--------------------------------------------------------------------------------------------------
 /**
- *  WiFi access point component initialization.
+ * The first-layer Lease event handler.
  */
 //--------------------------------------------------------------------------------------------------
-void le_wifiAp_Init
+static void FirstLayerLeaseHandler
 (
-    void
+    void *reportPtr,
+    void *secondLayerHandlerFunc
 )
 {
-    LE_DEBUG("WiFi Access Point Service is ready");
-
-    pa_wifiAp_Init();
-
-    // Create an event Id for new WiFi Events
-    NewWifiApEventId = le_event_CreateId("WiFiApEventId", sizeof(le_wifiAp_Event_t));
-
-    // register for events from PA.
-    pa_wifiAp_AddEventHandler(PaEventApHandler, NULL);
+    const LeaseReport_t              *leasePtr = reportPtr;
+    le_wifiApExt_LeaseHandlerFunc_t   clientHandlerFunc = secondLayerHandlerFunc;
 
+    clientHandlerFunc(leasePtr->mac, leasePtr->ipAddr, leasePtr->hostname,
+                      le_event_GetContextPtr());
 }
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Set number of maximally allowed clients to connect to the Access Point at the same time.
- *
- * @return LE_OUT_OF_RANGE  Requested number of users exceeds the capabilities of the Access Point.
- * @return LE_OK            Function succeeded.
+ * Add handler function for EVENT 'le_wifiApExt_Lease'
  *
+ * This event reports each station given a new address or host name.
  */
 //--------------------------------------------------------------------------------------------------
-le_result_t le_wifiAp_SetMaxNumberOfClients
+le_wifiApExt_LeaseHandlerRef_t le_wifiApExt_AddLeaseHandler
 (
-    int8_t maxNumberOfClients
+    le_wifiApExt_LeaseHandlerFunc_t handlerFuncPtr,
         ///< [IN]
-        ///< the maximum number of clients
+        ///< Event handling function
+
+    void *contextPtr
+        ///< [IN]
+        ///< Associated event context
 )
 {
-    if (0 == maxNumberOfClients)
+    le_event_HandlerRef_t handlerRef;
+
+    if (handlerFuncPtr == NULL)
     {
-        return LE_OUT_OF_RANGE;
+        LE_KILL_CLIENT("handlerFuncPtr is NULL !");
+        return NULL;
     }
-    return pa_wifiAp_SetMaxNumberClients(maxNumberOfClients);
+
+    handlerRef = le_event_AddLayeredHandler("WiFiApLeaseHandler",
+                                            LeaseEventId,
+                                            FirstLayerLeaseHandler,
+                                            (le_event_HandlerFunc_t)handlerFuncPtr);
+
+    le_event_SetContextPtr(handlerRef, contextPtr);
+
+    return (le_wifiApExt_LeaseHandlerRef_t)(handlerRef);
 }
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Defines the IP adresses range for the host AP.
- *
- * @return LE_BAD_PARAMETER At least, one of the given IP addresses is invalid.
- * @return LE_FAULT         A system call has failed.
- * @return LE_OK            Function succeeded.
- *
+ * Remove handler function for EVENT 'le_wifiApExt_Lease'
  */
 //--------------------------------------------------------------------------------------------------
-le_result_t le_wifiAp_SetIpRange
+void le_wifiApExt_RemoveLeaseHandler
 (
-    const char *ip_ap,
-        ///< [IN]
-        ///< the IP address of the Access Point.
-    const char *ip_start,
-        ///< [IN]
-        ///< the start IP address of the Access Point.
-    const char *ip_stop
+    le_wifiApExt_LeaseHandlerRef_t handlerRef
         ///< [IN]
-        ///< the stop IP address of the Access Point.
+        ///< Reference of the event handler to remove
 )
 {
-    return pa_wifiAp_SetIpRange(ip_ap, ip_start, ip_stop);
+    le_event_RemoveHandler((le_event_HandlerRef_t)handlerRef);
 }
-
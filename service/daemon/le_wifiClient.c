@@ -11,6 +11,7 @@
 #include "interfaces.h"
 
 #include "pa_wifi.h"
+#include "pa_wifi_pmk.h"
 
 
 //--------------------------------------------------------------------------------------------------
@@ -22,6 +23,109 @@
 #define CFG_PATH_WIFI               "wifi/channel"
 #define CFG_NODE_HIDDEN_SSID        "hidden"
 #define CFG_NODE_SECPROTOCOL        "secProtocol"
+#define CFG_NODE_PRIORITY           "priority"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * The following are Wifi client's service settings config tree path and node definitions
+ */
+//-------------------------------------------------------------------------------------------------
+#define CFG_PATH_WIFI_CLIENT        "wifi/client"
+#define CFG_NODE_SCAN_BACKEND       "scanBackend"
+#define CFG_SCAN_BACKEND_SCRIPT     "script"
+#define CFG_SCAN_BACKEND_NL80211    "nl80211"
+#define CFG_SCAN_BACKEND_MAX_BYTES  16
+#define CFG_NODE_LINK_INFO_TTL      "linkInfoTtlMs"
+#define CFG_NODE_SCAN_RSSI_DELTA    "scanRssiDeltaDb"
+#define CFG_NODE_AP_TABLE_MAX       "apTableMax"
+#define CFG_NODE_AP_MAX_AGE         "apMaxAgeSec"
+#define CFG_NODE_SCAN_INTERVAL_MIN  "scanIntervalMinMs"
+#define CFG_NODE_SCAN_STABLE        "scanStableChanges"
+#define CFG_NODE_SCAN_REUSE_WINDOW  "scanReuseWindowMs"
+#define CFG_NODE_ROAM_ENABLE        "roamEnable"
+#define CFG_NODE_ROAM_THRESHOLD     "roamRssiThresholdDbm"
+#define CFG_NODE_ROAM_HYSTERESIS    "roamHysteresisDb"
+#define CFG_NODE_ROAM_DWELL         "roamDwellMs"
+#define CFG_NODE_AUTO_CONNECT       "autoConnect"
+#define CFG_NODE_AUTO_CONNECT_SCAN  "autoConnectScanMs"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Default freshness window of the link state cache (ms).
+ */
+//--------------------------------------------------------------------------------------------------
+#define LINK_INFO_TTL_DEFAULT_MS    1000
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Default signal strength change (dB) from which an access point found by two consecutive scans
+ * is reported as updated.
+ */
+//--------------------------------------------------------------------------------------------------
+#define SCAN_RSSI_DELTA_DEFAULT_DB  5
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Default maximum number of access points kept in the table, and default time (s) after which a
+ * scanned access point not found again is removed.
+ */
+//--------------------------------------------------------------------------------------------------
+#define AP_TABLE_MAX_DEFAULT        256
+#define AP_MAX_AGE_DEFAULT_SEC      600
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Default shortest interval between two scheduled scans (ms), and default number of changes up to
+ * which a scan is considered stable.
+ */
+//--------------------------------------------------------------------------------------------------
+#define SCAN_INTERVAL_MIN_DEFAULT_MS    10000
+#define SCAN_STABLE_CHANGES_DEFAULT     2
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Default time (ms) after a full scan during which le_wifiClient_Scan() is answered from its
+ * results.
+ */
+//--------------------------------------------------------------------------------------------------
+#define SCAN_REUSE_WINDOW_DEFAULT_MS    1000
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Default settings of the roaming engine: link signal (dBm) below which a better access point is
+ * looked for, signal margin (dB) a candidate must have over the current access point, and time
+ * (ms) to stay on an access point before roaming again.
+ */
+//--------------------------------------------------------------------------------------------------
+#define ROAM_ENABLE_DEFAULT             false
+#define ROAM_RSSI_THRESHOLD_DEFAULT_DBM (-70)
+#define ROAM_HYSTERESIS_DEFAULT_DB      8
+#define ROAM_DWELL_DEFAULT_MS           10000
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Interval (ms) at which the roaming engine checks the link, and time (ms) given to a
+ * reassociation to complete.
+ */
+//--------------------------------------------------------------------------------------------------
+#define ROAM_CHECK_INTERVAL_MS          2000
+#define ROAM_TIMEOUT_MS                 5000
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Auto-connect defaults: mode at start-up, and maximum age of the scan results (ms) while there
+ * is no link.
+ */
+//--------------------------------------------------------------------------------------------------
+#define AUTO_CONNECT_DEFAULT            false
+#define AUTO_CONNECT_SCAN_DEFAULT_MS    30000
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum number of saved networks tried, in order, after a scan.
+ */
+//--------------------------------------------------------------------------------------------------
+#define AUTO_CONNECT_MAX_CANDIDATES     16
 
 //--------------------------------------------------------------------------------------------------
 /**
@@ -31,6 +135,7 @@
 #define SECSTORE_WIFI_ITEM_ROOT     "wifiService/channel"
 #define SECSTORE_NODE_PASSPHRASE    "passphrase"
 #define SECSTORE_NODE_PSK           "preSharedKey"
+#define SECSTORE_NODE_PMK           "pmk"
 #define SECSTORE_NODE_WEP_KEY       "wepKey"
 #define SECSTORE_NODE_USERNAME      "userName"
 #define SECSTORE_NODE_USERPWD       "userPassword"
@@ -43,6 +148,75 @@
 //-------------------------------------------------------------------------------------------------
 #define INIT_AP_COUNT 32
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * SSID, key of the SSID index.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    uint8_t length;                             ///< Number of bytes of the SSID.
+    uint8_t bytes[LE_WIFIDEFS_MAX_SSID_BYTES];  ///< SSID bytes.
+}
+Ssid_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Entry of the SSID index: the access points sharing one SSID.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    Ssid_t        ssid;                         ///< Key of the entry in SsidIndex.
+    le_dls_List_t apList;                       ///< Access points with this SSID.
+}
+SsidEntry_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Pairwise master key cached in secStore next to the passphrase of an SSID. The tag binds it to
+ * the passphrase it was derived from: checking it costs one HMAC instead of a derivation.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    uint8_t pmk[PA_WIFIPMK_BYTES];              ///< Pairwise master key.
+    uint8_t tag[PA_WIFIPMK_SHA1_BYTES];         ///< HMAC-SHA1 of the passphrase keyed by the PMK.
+}
+PmkRecord_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * PMK derivation run by the scan worker, and handed back to the main thread to be cached in
+ * secStore.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    uint8_t       ssidBytes[LE_WIFIDEFS_MAX_SSID_BYTES];        ///< SSID
+    size_t        ssidLength;                                   ///< Length of the SSID
+    char          passphrase[LE_WIFIDEFS_MAX_PASSPHRASE_BYTES]; ///< Passphrase
+    le_result_t   result;                                       ///< Result of the derivation
+    PmkRecord_t   record;                                       ///< Derived PMK and its tag
+    le_dls_Link_t link;                                         ///< Link in PmkJobList
+}
+PmkJob_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Pool of the PMK derivations, and list of those queued to the scan worker.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_mem_PoolRef_t PmkJobPool;
+static le_dls_List_t    PmkJobList = LE_DLS_LIST_INIT;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Event handing the PMK derivations completed by the scan worker to the main thread.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_event_Id_t PmkEventId;
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Struct to hold the AccessPoint from the Scan's data.
@@ -51,8 +225,21 @@
 //-------------------------------------------------------------------------------------------------
 typedef struct
 {
-    pa_wifiClient_AccessPoint_t accessPoint;
-    bool                        foundInLatestScan;
+    pa_wifiClient_AccessPoint_t    accessPoint;
+    bool                           foundInLatestScan;
+    le_wifiClient_AccessPointRef_t ref;         ///< Safe reference of the access point.
+    SsidEntry_t                   *ssidEntryPtr;///< Entry of the SSID index holding ssidLink.
+    le_dls_Link_t                  ssidLink;    ///< Link in the list of the SSID index entry.
+    le_dls_Link_t                  latestLink;  ///< Link in LatestScanList.
+    bool                           inPreviousScan;      ///< Set while in PreviousScanList.
+    bool                           isSsidChanged;       ///< SSID changed by the latest scan.
+    int16_t                        previousSignal;      ///< Signal in the previous scan.
+    uint16_t                       previousFrequency;   ///< Frequency in the previous scan.
+    uint8_t                        previousSecurityFlags;///< Security in the previous scan.
+    le_dls_Link_t                  previousLink;        ///< Link in PreviousScanList.
+    bool                           isPinned;    ///< Owned by a client, never evicted.
+    le_clk_Time_t                  lastSeen;    ///< Time of the last scan which found it.
+    le_dls_Link_t                  lruLink;     ///< Link in LruList, if scanned.
 }
 FoundAccessPoint_t;
 
@@ -66,662 +253,3587 @@ static le_ref_MapRef_t ScanApRefMap;
 //--------------------------------------------------------------------------------------------------
 /**
  * Pool from which FoundAccessPoint_t objects are allocated.
- * After each Scan pool is first emptied then populated with the result.
+ * The scanned access points are kept within the budget set by ApTableMax and ApMaxAgeSec.
  */
 //--------------------------------------------------------------------------------------------------
 static le_mem_PoolRef_t AccessPointPool;
 
 //--------------------------------------------------------------------------------------------------
 /**
- * The number of found AP:s from the scan used for informative traces.
- *
+ * Index of the access points by BSSID string. Access points created with le_wifiClient_Create()
+ * have no BSSID and are not indexed.
  */
 //--------------------------------------------------------------------------------------------------
-static uint32_t FoundWifiApCount = 0;
+static le_hashmap_Ref_t BssidIndex;
 
 //--------------------------------------------------------------------------------------------------
 /**
- * iteration reference used by GetFirst & GetNext
- * @see variable GetFirstSessionRef
+ * Index of the access points by SSID: one SsidEntry_t per SSID.
  */
 //--------------------------------------------------------------------------------------------------
-static le_ref_IterRef_t IterRef = NULL;
+static le_hashmap_Ref_t SsidIndex;
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Saves reference at call of GetFirst to check that GetNext is being called by same caller.
- * This to protect varible IterRef.
+ * Pool from which SsidEntry_t objects are allocated.
  */
 //--------------------------------------------------------------------------------------------------
-static le_msg_SessionRef_t GetFirstSessionRef = NULL;
+static le_mem_PoolRef_t SsidEntryPool;
 
 //--------------------------------------------------------------------------------------------------
 /**
- * If the Scan is running in a seperate thread, this variable will have a value != NULL.
- * The thread destructor will clear the
+ * Access points found by the latest scan, in the order they were found.
  */
 //--------------------------------------------------------------------------------------------------
-static le_thread_Ref_t ScanThreadRef = NULL;
+static le_dls_List_t LatestScanList = LE_DLS_LIST_INIT;
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Result of completed scan
+ * Scanned access points, least recently seen first. Access points created with
+ * le_wifiClient_Create() are not in this list.
  */
 //--------------------------------------------------------------------------------------------------
-static le_result_t ScanResult = LE_OK;
+static le_dls_List_t LruList = LE_DLS_LIST_INIT;
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Event ID for WiFi Event notification.
- *
+ * Number of access points in the table.
  */
 //--------------------------------------------------------------------------------------------------
-static le_event_Id_t WifiEventId;
+static uint32_t AccessPointCount = 0;
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Event ID for WiFi Event indication notification.
- *
+ * Budget of the access point table: maximum number of access points and maximum age (s) of a
+ * scanned access point not found again, 0 for no limit.
  */
 //--------------------------------------------------------------------------------------------------
-static le_event_Id_t WifiEventIndicationId;
+static uint32_t ApTableMax = AP_TABLE_MAX_DEFAULT;
+static uint32_t ApMaxAgeSec = AP_MAX_AGE_DEFAULT_SEC;
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Pool for WifiClient state events reporting.
+ * Number of access points removed from the table for their age and for the table size.
  */
 //--------------------------------------------------------------------------------------------------
-static le_mem_PoolRef_t WifiEventPool;
+static uint32_t AgedOutCount = 0;
+static uint32_t EvictedCount = 0;
 
 //--------------------------------------------------------------------------------------------------
 /**
- * The number of calls to le_wifiClient_Start().
- * This is used to call stop the WiFi hardware, when the last client calls stop.
+ * Access points found by the previous scan, only filled while a scan is being committed.
  */
 //--------------------------------------------------------------------------------------------------
-static uint32_t ClientStartCount = 0;
+static le_dls_List_t PreviousScanList = LE_DLS_LIST_INIT;
 
 //--------------------------------------------------------------------------------------------------
 /**
- * This CurrentConnection records the selected connection to get established via an API call to
- * le_wifiClient_Connect().  But note that it doesn't necessarily mean that this connection has
- * been successfully established, since the attempt to connect might fail, take time to finish, etc.
- * Its value will be reset after an API call to le_wifiClient_Disconnect() or le_wifiClient_Stop().
- * Thus, this CurrentConnection variable refers more to the selected SSID to get connected instead.
+ * Change of an access point between the previous and the latest scan.
  */
 //--------------------------------------------------------------------------------------------------
-static le_wifiClient_AccessPointRef_t CurrentConnection = NULL;
+typedef struct
+{
+    le_wifiClientExt_ScanChange_t change;       ///< Kind of change
+    pa_wifiClient_AccessPoint_t   accessPoint;  ///< Access point, as last seen if removed
+    le_clk_Time_t                 lastSeen;     ///< Time at which it was last seen
+    le_dls_Link_t                 link;         ///< Link in ScanChangeList
+}
+ScanChangeEntry_t;
 
 //--------------------------------------------------------------------------------------------------
 /**
- * WLAN interface being used to do WiFi scan.
+ * Summary of the changes found by a scan, reported by the ScanChanges event.
  */
 //--------------------------------------------------------------------------------------------------
-static char scanIfName[LE_WIFIDEFS_MAX_IFNAME_BYTES] = {0};
+typedef struct
+{
+    uint32_t scanId;                            ///< Identifier of the scan
+    uint32_t addedCount;                        ///< Number of access points added
+    uint32_t removedCount;                      ///< Number of access points removed
+    uint32_t updatedCount;                      ///< Number of access points updated
+}
+ScanChangesReport_t;
 
 //--------------------------------------------------------------------------------------------------
 /**
- * CallBack for PA WiFi Event Indications.
+ * Changes found by the latest scan: added and updated access points in the scan order, then the
+ * removed ones.
  */
 //--------------------------------------------------------------------------------------------------
-static void PaEventIndicationHandler
-(
-    le_wifiClient_EventInd_t* wifiEventIndicationPtr,
-    void *contextPtr
-)
-{
-    LE_DEBUG("WiFi event: %d, interface: %s, bssid: %s",
-            wifiEventIndicationPtr->event,
-            wifiEventIndicationPtr->ifName,
-            wifiEventIndicationPtr->apBssid);
+static le_dls_List_t       ScanChangeList = LE_DLS_LIST_INIT;
+static ScanChangesReport_t ScanChanges;
 
-    if (LE_WIFICLIENT_EVENT_DISCONNECTED == wifiEventIndicationPtr->event)
-    {
-        LE_DEBUG("disconnectCause: %d", wifiEventIndicationPtr->disconnectionCause);
-    }
+//--------------------------------------------------------------------------------------------------
+/**
+ * Pool from which ScanChangeEntry_t objects are allocated.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_mem_PoolRef_t ScanChangePool;
 
-    le_event_ReportWithRefCounting(WifiEventIndicationId, wifiEventIndicationPtr);
-}
+//--------------------------------------------------------------------------------------------------
+/**
+ * Event ID of the ScanChanges event.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_event_Id_t ScanChangesEventId;
 
 //--------------------------------------------------------------------------------------------------
 /**
- * CallBack for PA Events.
- * @deprecated pa_wifiClient_AddEventHandler() should not be used anymore.
- * It has been replaced by pa_wifiClient_AddEventIndHandler().
+ * Signal strength change (dB) from which an access point is reported as updated.
  */
 //--------------------------------------------------------------------------------------------------
-static void PaEventHandler
-(
-    le_wifiClient_Event_t event,
-    void *contextPtr
-)
-{
-    LE_DEBUG("Event: %d ", event);
+static uint32_t ScanRssiDeltaDb = SCAN_RSSI_DELTA_DEFAULT_DB;
 
-    le_event_Report(WifiEventId, (void *)&event, sizeof(le_wifiClient_Event_t));
-}
+//--------------------------------------------------------------------------------------------------
+/**
+ * The number of found AP:s from the scan used for informative traces.
+ *
+ */
+//--------------------------------------------------------------------------------------------------
+static uint32_t FoundWifiApCount = 0;
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Local function to find an access point reference based on BSSID among the AP found in scan.
- * If not found will return NULL.
+ * Next link of LatestScanList returned by GetNext, NULL at the end of the list.
+ * @see variable GetFirstSessionRef
  */
 //--------------------------------------------------------------------------------------------------
-static le_wifiClient_AccessPointRef_t FindAccessPointRefFromBssid
-(
-    const char* bssidPtr
-        ///< [OUT]
-        ///< The BSSID returned as a byte array.
-)
-{
-    le_wifiClient_AccessPointRef_t apRef = NULL;
-    le_ref_IterRef_t               iter  = le_ref_GetIterator(ScanApRefMap);
+static le_dls_Link_t *IterNextLinkPtr = NULL;
 
-    LE_DEBUG("Find AP from BSSID");
+//--------------------------------------------------------------------------------------------------
+/**
+ * Saves reference at call of GetFirst to check that GetNext is being called by same caller.
+ * This to protect varible IterNextLinkPtr.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_msg_SessionRef_t GetFirstSessionRef = NULL;
 
-    while (le_ref_NextNode(iter) == LE_OK)
-    {
-        apRef = (le_wifiClient_AccessPointRef_t)le_ref_GetSafeRef(iter);
-        if (NULL != apRef)
-        {
-            FoundAccessPoint_t *apPtr = (FoundAccessPoint_t *)le_ref_Lookup(ScanApRefMap, apRef);
-            if (NULL != apPtr)
-            {
-                if (0 == strncmp(apPtr->accessPoint.bssid, bssidPtr, LE_WIFIDEFS_MAX_BSSID_BYTES))
-                {
-                    LE_DEBUG("Found apRef %p", apRef);
-                    return apRef;
-                }
-            }
-        }
-        else
-        {
-            LE_ERROR("ERROR le_ref_GetSafeRef returned NULL iter:%p", iter);
-        }
-    }
-    return NULL;
+//--------------------------------------------------------------------------------------------------
+/**
+ * Access point found by the scan worker, waiting to be committed to the access point table.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    pa_wifiClient_AccessPoint_t accessPoint;    ///< Access point
+    le_dls_Link_t               link;           ///< Link in the batch
 }
+ScanBatchEntry_t;
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Local function to find an access point reference based on SSID among the AP found in scan.
- * If not found will return NULL.
+ * Kinds of scan.
  */
 //--------------------------------------------------------------------------------------------------
-static le_wifiClient_AccessPointRef_t FindAccessPointRefFromSsid
-(
-    const uint8_t* ssidPtr,
-        ///< [OUT]
-        ///< The SSID returned as a byte array.
-
-    size_t ssidNumElements
-        ///< [INOUT]
-        ///< SSID length in bytes.
-)
+typedef enum
 {
-    le_wifiClient_AccessPointRef_t apRef = NULL;
-    le_ref_IterRef_t               iter  = le_ref_GetIterator(ScanApRefMap);
-
-    LE_DEBUG("Find AP from SSID");
-
-    while (le_ref_NextNode(iter) == LE_OK)
-    {
-        apRef = (le_wifiClient_AccessPointRef_t)le_ref_GetSafeRef(iter);
-        if (NULL != apRef)
-        {
-            FoundAccessPoint_t *apPtr = (FoundAccessPoint_t *)le_ref_Lookup(ScanApRefMap, apRef);
-            if (NULL != apPtr)
-            {
-                if (apPtr->accessPoint.ssidLength == ssidNumElements)
-                {
-                    if (0 == memcmp(apPtr->accessPoint.ssidBytes, ssidPtr, ssidNumElements))
-                    {
-                        LE_DEBUG("Found apRef %p", apRef);
-                        return apRef;
-                    }
-                }
-            }
-        }
-        else
-        {
-            LE_ERROR("ERROR le_ref_GetSafeRef returned NULL iter:%p", iter);
-        }
-    }
-    return NULL;
+    SCAN_KIND_FULL,         ///< Scan of all the channels
+    SCAN_KIND_DIRECTED,     ///< Scan limited to some frequencies and/or SSIDs
+    SCAN_KIND_CACHED        ///< Read of the results cached by the kernel, without scanning
 }
-
+ScanKind_t;
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Local function to add AP:s found during scan to AddRef point interface
+ * Results of one scan, handed from the scan worker to the main thread.
  */
 //--------------------------------------------------------------------------------------------------
-
-static le_wifiClient_AccessPointRef_t AddAccessPointToApRefMap
-(
-    pa_wifiClient_AccessPoint_t *apPtr
-)
+typedef struct
 {
-    // first see if it alreay exists in our list of reference.
-    le_wifiClient_AccessPointRef_t returnedRef = FindAccessPointRefFromBssid(apPtr->bssid);
-
-    if (NULL != returnedRef)
-    {
-        FoundAccessPoint_t *oldAccessPointPtr =
-            (FoundAccessPoint_t *)le_ref_Lookup(ScanApRefMap, returnedRef);
+    ScanKind_t                 kind;                        ///< Kind of scan
+    pa_wifiClient_ScanParams_t params;                      ///< Parameters of a directed scan
+    le_result_t                result;                      ///< Result of the scan
+    char                       ifName[LE_WIFIDEFS_MAX_IFNAME_BYTES];///< Interface of the scan
+    le_dls_List_t              apList;                      ///< ScanBatchEntry_t list
+}
+ScanBatch_t;
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Pools of the scan batches and their entries.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_mem_PoolRef_t ScanBatchPool;
+static le_mem_PoolRef_t ScanBatchEntryPool;
 
-        if (NULL != oldAccessPointPtr)
-        {
-            LE_DEBUG("Already exists %p. Update SignalStrength %d, SSID '%s'",
-                     returnedRef, apPtr->signalStrength, &apPtr->ssidBytes[0]);
+//--------------------------------------------------------------------------------------------------
+/**
+ * Persistent scan worker thread, and the thread owning the access point table to which it hands
+ * back the results.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_thread_Ref_t ScanWorkerThreadRef = NULL;
+static le_thread_Ref_t MainThreadRef = NULL;
 
-            oldAccessPointPtr->accessPoint.signalStrength = apPtr->signalStrength;
-            oldAccessPointPtr->accessPoint.ssidLength = apPtr->ssidLength;
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set from the scan request until its results are committed.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsScanPending = false;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set when the last client stops the WiFi device while a scan is pending: the results of this
+ * scan are dropped when they reach the main thread.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsScanCancelled = false;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Kind of the pending scan.
+ */
+//--------------------------------------------------------------------------------------------------
+static ScanKind_t PendingScanKind = SCAN_KIND_FULL;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Identifier of the last completed scan, reported with the packed scan results so that a client
+ * reading them page by page can detect a new scan.
+ */
+//--------------------------------------------------------------------------------------------------
+static uint32_t ScanId = 0;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Scan request of a client, served by the scan scheduler.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    uint32_t                          maxAgeMs;     ///< Maximum age of the scan results (ms)
+    le_msg_SessionRef_t               sessionRef;   ///< Session of the client
+    le_wifiClientExt_ScanRequestRef_t ref;          ///< Safe reference of the request
+    le_dls_Link_t                     link;         ///< Link in ScanRequestList
+}
+ScanRequest_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Scan requests of the clients, their pool and their safe references.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_dls_List_t    ScanRequestList = LE_DLS_LIST_INIT;
+static le_mem_PoolRef_t ScanRequestPool;
+static le_ref_MapRef_t  ScanRequestRefMap;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Timer of the scan scheduler, and time of the last completed scan, forgotten when the WiFi
+ * device is stopped.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_timer_Ref_t ScanTimerRef;
+static bool           HasScanTime = false;
+static le_clk_Time_t  LastScanTime;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Current interval of the scan scheduler (ms), and its upper bound: the smallest maxAgeMs of the
+ * scan requests, 0 when there is no request.
+ */
+//--------------------------------------------------------------------------------------------------
+static uint32_t ScanIntervalMs = 0;
+static uint32_t ScanMaxIntervalMs = 0;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Shortest interval of the scan scheduler (ms), and number of changes up to which a scan is
+ * considered stable and the interval is doubled.
+ */
+//--------------------------------------------------------------------------------------------------
+static uint32_t ScanIntervalMinMs = SCAN_INTERVAL_MIN_DEFAULT_MS;
+static uint32_t ScanStableChanges = SCAN_STABLE_CHANGES_DEFAULT;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Time (ms) after a full scan during which le_wifiClient_Scan() is answered from its results,
+ * 0 to always scan.
+ */
+//--------------------------------------------------------------------------------------------------
+static uint32_t ScanReuseWindowMs = SCAN_REUSE_WINDOW_DEFAULT_MS;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set when le_wifiClient_Scan() is called during a directed or cached scan: a full scan is
+ * started once that scan is committed.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsFullScanQueued = false;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Event ID for WiFi Event notification.
+ *
+ */
+//--------------------------------------------------------------------------------------------------
+static le_event_Id_t WifiEventId;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Event ID for WiFi Event indication notification.
+ *
+ */
+//--------------------------------------------------------------------------------------------------
+static le_event_Id_t WifiEventIndicationId;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Pool for WifiClient state events reporting.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_mem_PoolRef_t WifiEventPool;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * The number of calls to le_wifiClient_Start().
+ * This is used to call stop the WiFi hardware, when the last client calls stop.
+ */
+//--------------------------------------------------------------------------------------------------
+static uint32_t ClientStartCount = 0;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * This CurrentConnection records the selected connection to get established via an API call to
+ * le_wifiClient_Connect().  But note that it doesn't necessarily mean that this connection has
+ * been successfully established, since the attempt to connect might fail, take time to finish, etc.
+ * Its value will be reset after an API call to le_wifiClient_Disconnect() or le_wifiClient_Stop().
+ * Thus, this CurrentConnection variable refers more to the selected SSID to get connected instead.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_wifiClient_AccessPointRef_t CurrentConnection = NULL;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * WLAN interface being used to do WiFi scan.
+ */
+//--------------------------------------------------------------------------------------------------
+static char scanIfName[LE_WIFIDEFS_MAX_IFNAME_BYTES] = {0};
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Freshness window of the link state cache (ms), 0 disables the cache.
+ */
+//--------------------------------------------------------------------------------------------------
+static uint32_t LinkInfoTtlMs = LINK_INFO_TTL_DEFAULT_MS;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Link state cache: the last link query and its result, shared by all the clients polling the
+ * link within LinkInfoTtlMs.
+ */
+//--------------------------------------------------------------------------------------------------
+static struct
+{
+    bool                     isValid;       ///< A query was done since the last link change
+    le_clk_Time_t            timestamp;     ///< Time of the query
+    le_result_t              result;        ///< Result of the query
+    pa_wifiClient_LinkInfo_t info;          ///< Link state, valid if result is LE_OK
+}
+LinkInfoCache;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Settings of the roaming engine.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool    RoamEnabled = ROAM_ENABLE_DEFAULT;
+static int32_t RoamRssiThresholdDbm = ROAM_RSSI_THRESHOLD_DEFAULT_DBM;
+static int32_t RoamHysteresisDb = ROAM_HYSTERESIS_DEFAULT_DB;
+static int32_t RoamDwellMs = ROAM_DWELL_DEFAULT_MS;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * States of the roaming engine.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef enum
+{
+    ROAM_STATE_IDLE,            ///< Watching the link signal
+    ROAM_STATE_SCANNING,        ///< Waiting for the scan looking for a better access point
+    ROAM_STATE_REASSOCIATING    ///< Waiting for the reassociation to the chosen access point
+}
+RoamState_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Roam attempt, reported by the Roam event.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    char        fromBssid[LE_WIFIDEFS_MAX_BSSID_BYTES];    ///< Access point left
+    char        toBssid[LE_WIFIDEFS_MAX_BSSID_BYTES];      ///< Access point chosen
+    le_result_t result;                                     ///< Result of the attempt
+    uint32_t    timeToRoamMs;                               ///< Time from the weak link detection
+}
+RoamReport_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Roaming engine: it starts a scan for the SSID of the link when the link signal drops below
+ * RoamRssiThresholdDbm, and reassociates to the strongest access point of this SSID found by the
+ * scan if it beats the current one by RoamHysteresisDb.
+ */
+//--------------------------------------------------------------------------------------------------
+static struct
+{
+    RoamState_t   state;                                    ///< State of the engine
+    le_clk_Time_t holdTime;                                 ///< Start of the dwell time, or
+                                                            ///< of the reassociation
+    le_clk_Time_t startTime;                                ///< Weak link detection
+    Ssid_t        ssid;                                     ///< SSID of the link
+    int16_t       signal;                                   ///< Link signal at the detection
+    bool          isFullScanNeeded;                         ///< Directed scans fail, e.g. with
+                                                            ///< the script scan backend
+    RoamReport_t  report;                                   ///< Current attempt
+}
+Roam;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Timer of the roaming engine, running while connected, and event ID of the Roam event.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_timer_Ref_t RoamTimerRef;
+static le_event_Id_t  RoamEventId;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum age of the scan results (ms) requested by the auto-connect while there is no link.
+ */
+//--------------------------------------------------------------------------------------------------
+static uint32_t AutoConnectScanMs = AUTO_CONNECT_SCAN_DEFAULT_MS;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Saved network found by a scan, candidate of the auto-connect.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    Ssid_t  ssid;                                   ///< SSID, name of the config tree node
+    int32_t priority;                               ///< Priority of the saved network
+    int16_t signal;                                 ///< Signal of its strongest access point
+}
+AutoConnectCandidate_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Auto-connect: while there is no link, the saved networks found by each scan are ranked by
+ * priority then signal. wpa_supplicant is given all of them and chooses in the same order, failing
+ * over from one to the next by itself; otherwise they are tried in this order until a connection
+ * succeeds.
+ */
+//--------------------------------------------------------------------------------------------------
+static struct
+{
+    bool                           isEnabled;       ///< Auto-connect mode
+    bool                           isStarted;       ///< Holds a start of the WiFi device
+    bool                           isSuspended;     ///< Suspended by le_wifiClient_Disconnect()
+    bool                           isLinkUp;        ///< Connected, as reported by the events
+    bool                           isReleasingLink; ///< Waiting for the end of the link
+                                                    ///< released by le_wifiClient_Disconnect()
+    bool                           isConnecting;    ///< Waiting for the result of an attempt
+    bool                           hasNetworkList;  ///< wpa_supplicant has the saved networks
+    bool                           isSupplicantChoice; ///< wpa_supplicant chooses the network
+    le_wifiClient_AccessPointRef_t apRef;           ///< Access point of the last attempt
+    bool                           isApOwned;       ///< apRef was created for the attempt
+    bool                           isScanRequested; ///< scanRequest is in ScanRequestList
+    ScanRequest_t                  scanRequest;     ///< Scans while there is no link
+    AutoConnectCandidate_t         candidates[AUTO_CONNECT_MAX_CANDIDATES]; ///< Ranked networks
+    uint32_t                       candidateCount;  ///< Number of candidates
+    uint32_t                       candidateIndex;  ///< Next candidate to try
+}
+AutoConnect;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Report the end of a roam attempt and start the dwell time.
+ */
+//--------------------------------------------------------------------------------------------------
+static void ReportRoam
+(
+    le_result_t result
+        ///< [IN]
+        ///< Result of the attempt
+)
+{
+    le_clk_Time_t now = le_clk_GetRelativeTime();
+    le_clk_Time_t elapsed = le_clk_Sub(now, Roam.startTime);
+
+    Roam.report.result = result;
+    Roam.report.timeToRoamMs = elapsed.sec * 1000 + elapsed.usec / 1000;
+    if (LE_OK == result)
+    {
+        LE_INFO("Roamed from %s to %s in %u ms", Roam.report.fromBssid, Roam.report.toBssid,
+                Roam.report.timeToRoamMs);
+    }
+    else
+    {
+        LE_WARN("Roaming from %s to %s failed (%d)", Roam.report.fromBssid, Roam.report.toBssid,
+                result);
+    }
+
+    Roam.state = ROAM_STATE_IDLE;
+    Roam.holdTime = now;
+    le_event_Report(RoamEventId, &Roam.report, sizeof(RoamReport_t));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Update the roaming engine on a connection change: a connection completes the reassociation in
+ * progress and (re)starts the dwell time, a disconnection stops the engine unless it happens
+ * during a reassociation.
+ */
+//--------------------------------------------------------------------------------------------------
+static void UpdateRoamOnLinkEvent
+(
+    const le_wifiClient_EventInd_t *eventPtr
+        ///< [IN]
+        ///< Connection event
+)
+{
+    if (LE_WIFICLIENT_EVENT_CONNECTED == eventPtr->event)
+    {
+        if (ROAM_STATE_REASSOCIATING == Roam.state)
+        {
+            ReportRoam((0 == strcasecmp(eventPtr->apBssid, Roam.report.toBssid)) ?
+                       LE_OK : LE_FAULT);
+        }
+        Roam.state = ROAM_STATE_IDLE;
+        Roam.holdTime = le_clk_GetRelativeTime();
+
+        if (RoamEnabled && (NULL != CurrentConnection) && (!le_timer_IsRunning(RoamTimerRef)))
+        {
+            le_timer_Start(RoamTimerRef);
+        }
+    }
+    else if (LE_WIFICLIENT_EVENT_DISCONNECTED == eventPtr->event)
+    {
+        if ((ROAM_STATE_REASSOCIATING == Roam.state) && (NULL != CurrentConnection))
+        {
+            // The link to the previous access point is released first
+            return;
+        }
+        Roam.state = ROAM_STATE_IDLE;
+
+        if (le_timer_IsRunning(RoamTimerRef))
+        {
+            le_timer_Stop(RoamTimerRef);
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * CallBack for PA WiFi Event Indications.
+ */
+//--------------------------------------------------------------------------------------------------
+static void PaEventIndicationHandler
+(
+    le_wifiClient_EventInd_t* wifiEventIndicationPtr,
+    void *contextPtr
+)
+{
+    LE_DEBUG("WiFi event: %d, interface: %s, bssid: %s",
+            wifiEventIndicationPtr->event,
+            wifiEventIndicationPtr->ifName,
+            wifiEventIndicationPtr->apBssid);
+
+    if (LE_WIFICLIENT_EVENT_DISCONNECTED == wifiEventIndicationPtr->event)
+    {
+        LE_DEBUG("disconnectCause: %d", wifiEventIndicationPtr->disconnectionCause);
+    }
+
+    // The link changed: the cached link state is outdated
+    if ((LE_WIFICLIENT_EVENT_CONNECTED == wifiEventIndicationPtr->event) ||
+        (LE_WIFICLIENT_EVENT_DISCONNECTED == wifiEventIndicationPtr->event))
+    {
+        LinkInfoCache.isValid = false;
+        UpdateRoamOnLinkEvent(wifiEventIndicationPtr);
+    }
+
+    le_event_ReportWithRefCounting(WifiEventIndicationId, wifiEventIndicationPtr);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * CallBack for PA Events.
+ * @deprecated pa_wifiClient_AddEventHandler() should not be used anymore.
+ * It has been replaced by pa_wifiClient_AddEventIndHandler().
+ */
+//--------------------------------------------------------------------------------------------------
+static void PaEventHandler
+(
+    le_wifiClient_Event_t event,
+    void *contextPtr
+)
+{
+    LE_DEBUG("Event: %d ", event);
+
+    le_event_Report(WifiEventId, (void *)&event, sizeof(le_wifiClient_Event_t));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Hash an SSID of the SSID index (FNV-1a).
+ */
+//--------------------------------------------------------------------------------------------------
+static size_t HashSsid
+(
+    const void *keyPtr
+)
+{
+    const Ssid_t *ssidPtr = keyPtr;
+    uint32_t      hash = 2166136261u;
+    uint8_t       i;
+
+    for (i = 0; i < ssidPtr->length; i++)
+    {
+        hash = (hash ^ ssidPtr->bytes[i]) * 16777619u;
+    }
+
+    return hash;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Compare two SSIDs of the SSID index.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool EqualsSsid
+(
+    const void *firstKeyPtr,
+    const void *secondKeyPtr
+)
+{
+    const Ssid_t *firstPtr = firstKeyPtr;
+    const Ssid_t *secondPtr = secondKeyPtr;
+
+    return (firstPtr->length == secondPtr->length) &&
+           (0 == memcmp(firstPtr->bytes, secondPtr->bytes, firstPtr->length));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add an access point to the SSID index.
+ */
+//--------------------------------------------------------------------------------------------------
+static void IndexSsid
+(
+    FoundAccessPoint_t *apPtr
+)
+{
+    Ssid_t       ssid;
+    SsidEntry_t *entryPtr;
+
+    ssid.length = apPtr->accessPoint.ssidLength;
+    memcpy(ssid.bytes, apPtr->accessPoint.ssidBytes, ssid.length);
+
+    entryPtr = le_hashmap_Get(SsidIndex, &ssid);
+    if (NULL == entryPtr)
+    {
+        entryPtr = le_mem_ForceAlloc(SsidEntryPool);
+        entryPtr->ssid = ssid;
+        entryPtr->apList = LE_DLS_LIST_INIT;
+        le_hashmap_Put(SsidIndex, &entryPtr->ssid, entryPtr);
+    }
+
+    apPtr->ssidLink = LE_DLS_LINK_INIT;
+    le_dls_Queue(&entryPtr->apList, &apPtr->ssidLink);
+    apPtr->ssidEntryPtr = entryPtr;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Remove an access point from the SSID index.
+ */
+//--------------------------------------------------------------------------------------------------
+static void UnindexSsid
+(
+    FoundAccessPoint_t *apPtr
+)
+{
+    SsidEntry_t *entryPtr = apPtr->ssidEntryPtr;
+
+    if (NULL == entryPtr)
+    {
+        return;
+    }
+
+    le_dls_Remove(&entryPtr->apList, &apPtr->ssidLink);
+    apPtr->ssidEntryPtr = NULL;
+
+    if (le_dls_IsEmpty(&entryPtr->apList))
+    {
+        le_hashmap_Remove(SsidIndex, &entryPtr->ssid);
+        le_mem_Release(entryPtr);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add an access point to LatestScanList if it is not in it yet.
+ */
+//--------------------------------------------------------------------------------------------------
+static void MarkAccessPointFound
+(
+    FoundAccessPoint_t *apPtr
+)
+{
+    if (!apPtr->foundInLatestScan)
+    {
+        apPtr->foundInLatestScan = true;
+        apPtr->latestLink = LE_DLS_LINK_INIT;
+        le_dls_Queue(&LatestScanList, &apPtr->latestLink);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Local function to find an access point reference based on BSSID among the AP found in scan.
+ * If not found will return NULL.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_wifiClient_AccessPointRef_t FindAccessPointRefFromBssid
+(
+    const char* bssidPtr
+        ///< [IN]
+        ///< The BSSID as a null terminated string.
+)
+{
+    FoundAccessPoint_t *apPtr = le_hashmap_Get(BssidIndex, bssidPtr);
+
+    return (NULL != apPtr) ? apPtr->ref : NULL;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Local function to find an access point reference based on SSID among the AP found in scan.
+ * If not found will return NULL.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_wifiClient_AccessPointRef_t FindAccessPointRefFromSsid
+(
+    const uint8_t* ssidPtr,
+        ///< [IN]
+        ///< The SSID as a byte array.
+
+    size_t ssidNumElements
+        ///< [IN]
+        ///< SSID length in bytes.
+)
+{
+    Ssid_t       ssid;
+    SsidEntry_t *entryPtr;
+
+    if (ssidNumElements > LE_WIFIDEFS_MAX_SSID_BYTES)
+    {
+        return NULL;
+    }
+
+    ssid.length = ssidNumElements;
+    memcpy(ssid.bytes, ssidPtr, ssidNumElements);
+
+    entryPtr = le_hashmap_Get(SsidIndex, &ssid);
+    if (NULL == entryPtr)
+    {
+        return NULL;
+    }
+
+    return CONTAINER_OF(le_dls_Peek(&entryPtr->apList), FoundAccessPoint_t, ssidLink)->ref;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the time elapsed since a relative time.
+ *
+ * @return Elapsed time in ms.
+ */
+//--------------------------------------------------------------------------------------------------
+static uint64_t GetElapsedMs
+(
+    le_clk_Time_t time
+        ///< [IN]
+        ///< Relative time, in the past
+)
+{
+    le_clk_Time_t elapsed = le_clk_Sub(le_clk_GetRelativeTime(), time);
+
+    return (uint64_t)elapsed.sec * 1000 + elapsed.usec / 1000;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the relative time at which a scanned access point was last seen, from its age.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_clk_Time_t GetSeenTime
+(
+    const pa_wifiClient_AccessPoint_t *apPtr
+)
+{
+    le_clk_Time_t now = le_clk_GetRelativeTime();
+    le_clk_Time_t age = { .sec = apPtr->ageMs / 1000, .usec = (apPtr->ageMs % 1000) * 1000 };
+
+    if ((age.sec > now.sec) || ((age.sec == now.sec) && (age.usec > now.usec)))
+    {
+        return (le_clk_Time_t){ 0, 0 };
+    }
+
+    return le_clk_Sub(now, age);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Local function to add AP:s found during scan to AddRef point interface
+ */
+//--------------------------------------------------------------------------------------------------
+
+static le_wifiClient_AccessPointRef_t AddAccessPointToApRefMap
+(
+    pa_wifiClient_AccessPoint_t *apPtr
+)
+{
+    // first see if it alreay exists in our list of reference.
+    FoundAccessPoint_t *oldAccessPointPtr = le_hashmap_Get(BssidIndex, apPtr->bssid);
+
+    if (NULL != oldAccessPointPtr)
+    {
+        LE_DEBUG("Already exists %p. Update SignalStrength %d, SSID '%.*s'",
+                 oldAccessPointPtr->ref, apPtr->signalStrength,
+                 apPtr->ssidLength, (char *)apPtr->ssidBytes);
+
+        // A hidden SSID may be revealed by a later scan
+        if ((oldAccessPointPtr->accessPoint.ssidLength != apPtr->ssidLength) ||
+            (0 != memcmp(oldAccessPointPtr->accessPoint.ssidBytes, apPtr->ssidBytes,
+                         apPtr->ssidLength)))
+        {
+            UnindexSsid(oldAccessPointPtr);
+            oldAccessPointPtr->accessPoint.ssidLength = apPtr->ssidLength;
             memcpy(&oldAccessPointPtr->accessPoint.ssidBytes, &apPtr->ssidBytes,
                    apPtr->ssidLength);
-            oldAccessPointPtr->foundInLatestScan = true;
+            IndexSsid(oldAccessPointPtr);
+            oldAccessPointPtr->isSsidChanged = true;
+        }
+
+        oldAccessPointPtr->accessPoint.signalStrength = apPtr->signalStrength;
+        oldAccessPointPtr->accessPoint.frequency = apPtr->frequency;
+        oldAccessPointPtr->accessPoint.securityFlags = apPtr->securityFlags;
+        MarkAccessPointFound(oldAccessPointPtr);
+
+        // Now the most recently seen
+        oldAccessPointPtr->lastSeen = GetSeenTime(apPtr);
+        le_dls_Remove(&LruList, &oldAccessPointPtr->lruLink);
+        le_dls_Queue(&LruList, &oldAccessPointPtr->lruLink);
+
+        return oldAccessPointPtr->ref;
+    }
+    else
+    {
+        FoundAccessPoint_t *foundAccessPointPtr = le_mem_ForceAlloc(AccessPointPool);
+
+        if (foundAccessPointPtr)
+        {
+            FoundWifiApCount++;
+            LE_DEBUG("New AP[%d] SignalStrength %d | SSID length %d | SSID: \"%.*s\"",
+                FoundWifiApCount,
+                apPtr->signalStrength,
+                apPtr->ssidLength,
+                apPtr->ssidLength,
+                (char *)apPtr->ssidBytes
+               );
+
+            memset(foundAccessPointPtr, 0, sizeof(FoundAccessPoint_t));
+            // struct member value copy
+            foundAccessPointPtr->accessPoint = *apPtr;
+
+            // Create a Safe Reference for this object.
+            foundAccessPointPtr->ref = le_ref_CreateRef(ScanApRefMap, foundAccessPointPtr);
+
+            le_hashmap_Put(BssidIndex, foundAccessPointPtr->accessPoint.bssid,
+                           foundAccessPointPtr);
+            IndexSsid(foundAccessPointPtr);
+            MarkAccessPointFound(foundAccessPointPtr);
+            foundAccessPointPtr->lastSeen = GetSeenTime(apPtr);
+            foundAccessPointPtr->lruLink = LE_DLS_LINK_INIT;
+            le_dls_Queue(&LruList, &foundAccessPointPtr->lruLink);
+            AccessPointCount++;
+
+            LE_DEBUG("le_ref_CreateRef foundAccessPointPtr %p; Ref%p ",
+                foundAccessPointPtr, foundAccessPointPtr->ref);
+
+            return foundAccessPointPtr->ref;
+        }
+        else
+        {
+            LE_ERROR("le_mem_ForceAlloc failed. Count %d", FoundWifiApCount);
+        }
+    }
+
+    return NULL;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ *  Frees one members of the access point and the corresponding access points memory
+ */
+//--------------------------------------------------------------------------------------------------
+static void RemoveAccessPoint
+(
+    le_wifiClient_AccessPointRef_t apRef
+)
+{
+    FoundAccessPoint_t *apPtr = (FoundAccessPoint_t *)le_ref_Lookup(ScanApRefMap, apRef);
+
+    if (apPtr == NULL)
+    {
+        LE_ERROR("Bad reference");
+        return;
+    }
+
+    // Only scanned access points are indexed by BSSID and in LruList
+    if (('\0' != apPtr->accessPoint.bssid[0]) &&
+        (apPtr == le_hashmap_Get(BssidIndex, apPtr->accessPoint.bssid)))
+    {
+        le_hashmap_Remove(BssidIndex, apPtr->accessPoint.bssid);
+        le_dls_Remove(&LruList, &apPtr->lruLink);
+    }
+    UnindexSsid(apPtr);
+
+    if (apPtr->foundInLatestScan)
+    {
+        // Keep an ongoing GetFirst/GetNext iteration valid
+        if (IterNextLinkPtr == &apPtr->latestLink)
+        {
+            IterNextLinkPtr = le_dls_PeekNext(&LatestScanList, IterNextLinkPtr);
+        }
+        le_dls_Remove(&LatestScanList, &apPtr->latestLink);
+    }
+    if (apPtr->inPreviousScan)
+    {
+        le_dls_Remove(&PreviousScanList, &apPtr->previousLink);
+    }
+
+    le_ref_DeleteRef(ScanApRefMap, apRef);
+    le_mem_Release(apPtr);
+    AccessPointCount--;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ *  Frees all members of the AddRef and the corresponding AccessPoints added during Scan and
+ *  le_wifiClient_Create()
+ */
+//--------------------------------------------------------------------------------------------------
+static void ReleaseAllAccessPoints
+(
+    void
+)
+{
+    le_wifiClient_AccessPointRef_t apRef = NULL;
+    le_ref_IterRef_t               iter  = le_ref_GetIterator(ScanApRefMap);
+
+    LE_DEBUG("Release all AP");
+
+    while (le_ref_NextNode(iter) == LE_OK)
+    {
+        apRef = (le_wifiClient_AccessPointRef_t)le_ref_GetSafeRef(iter);
+        if (NULL != apRef)
+        {
+            RemoveAccessPoint(apRef);
+        }
+        else
+        {
+            LE_ERROR("ERROR le_ref_GetSafeRef returned NULL iter:%p", iter);
+            return;
+        }
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check whether an access point is within the frequencies and SSIDs of a directed scan.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsInScanScope
+(
+    const pa_wifiClient_AccessPoint_t *apPtr,
+    const pa_wifiClient_ScanParams_t  *paramsPtr
+        ///< [IN]
+        ///< Parameters of the directed scan, NULL for a full scan
+)
+{
+    size_t i;
+
+    if (NULL == paramsPtr)
+    {
+        return true;
+    }
+
+    if (paramsPtr->frequencyCount > 0)
+    {
+        for (i = 0; (i < paramsPtr->frequencyCount) &&
+                    (paramsPtr->frequencies[i] != apPtr->frequency); i++)
+        {
+        }
+        if (i == paramsPtr->frequencyCount)
+        {
+            return false;
+        }
+    }
+
+    if (paramsPtr->ssidCount > 0)
+    {
+        for (i = 0; i < paramsPtr->ssidCount; i++)
+        {
+            if ((paramsPtr->ssids[i].length == apPtr->ssidLength) &&
+                (0 == memcmp(paramsPtr->ssids[i].bytes, apPtr->ssidBytes, apPtr->ssidLength)))
+            {
+                break;
+            }
+        }
+        if (i == paramsPtr->ssidCount)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Marks the current access points as old by changing the values for foundInLatestScan
+ * and signalStrength, and moves them from LatestScanList to PreviousScanList.
+ * These values will be updated later, if the same AP is still found.
+ * This way the new and old AccessPoints can be separated.
+ * The access points outside the scope of a directed scan are left found.
+ *
+ */
+//--------------------------------------------------------------------------------------------------
+static void MarkAllAccessPointsOld
+(
+    const pa_wifiClient_ScanParams_t *paramsPtr
+        ///< [IN]
+        ///< Parameters of a directed scan, NULL for a full scan
+)
+{
+    le_dls_List_t  keptList = LE_DLS_LIST_INIT;
+    le_dls_Link_t *linkPtr;
+    uint32_t       counter = 0;
+
+    LE_DEBUG("Mark all AP as old");
+
+    while (NULL != (linkPtr = le_dls_Pop(&LatestScanList)))
+    {
+        FoundAccessPoint_t *apPtr = CONTAINER_OF(linkPtr, FoundAccessPoint_t, latestLink);
+
+        apPtr->previousSignal = apPtr->accessPoint.signalStrength;
+        apPtr->previousFrequency = apPtr->accessPoint.frequency;
+        apPtr->previousSecurityFlags = apPtr->accessPoint.securityFlags;
+        apPtr->isSsidChanged = false;
+        apPtr->inPreviousScan = true;
+        apPtr->previousLink = LE_DLS_LINK_INIT;
+        le_dls_Queue(&PreviousScanList, &apPtr->previousLink);
+
+        if (!IsInScanScope(&apPtr->accessPoint, paramsPtr))
+        {
+            apPtr->latestLink = LE_DLS_LINK_INIT;
+            le_dls_Queue(&keptList, &apPtr->latestLink);
+            continue;
+        }
+
+        apPtr->accessPoint.signalStrength = LE_WIFICLIENT_NO_SIGNAL_STRENGTH;
+        apPtr->foundInLatestScan = false;
+        counter++;
+    }
+    while (NULL != (linkPtr = le_dls_Pop(&keptList)))
+    {
+        le_dls_Queue(&LatestScanList, linkPtr);
+    }
+    IterNextLinkPtr = NULL;
+
+    LE_DEBUG("Marked: %d", counter);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check whether an access point found by the previous and the latest scans changed enough to be
+ * reported as updated.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsAccessPointUpdated
+(
+    const FoundAccessPoint_t *apPtr
+)
+{
+    int signalDelta = abs(apPtr->accessPoint.signalStrength - apPtr->previousSignal);
+
+    return ((0 != signalDelta) && ((uint32_t)signalDelta >= ScanRssiDeltaDb)) ||
+           (apPtr->accessPoint.frequency != apPtr->previousFrequency) ||
+           (apPtr->accessPoint.securityFlags != apPtr->previousSecurityFlags) ||
+           apPtr->isSsidChanged;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Record a change of an access point in ScanChangeList.
+ */
+//--------------------------------------------------------------------------------------------------
+static void AddScanChange
+(
+    le_wifiClientExt_ScanChange_t  change,
+    const FoundAccessPoint_t      *apPtr
+)
+{
+    ScanChangeEntry_t *entryPtr = le_mem_ForceAlloc(ScanChangePool);
+
+    entryPtr->change = change;
+    entryPtr->accessPoint = apPtr->accessPoint;
+    entryPtr->lastSeen = apPtr->lastSeen;
+    entryPtr->link = LE_DLS_LINK_INIT;
+    le_dls_Queue(&ScanChangeList, &entryPtr->link);
+
+    switch (change)
+    {
+        case LE_WIFICLIENTEXT_SCAN_CHANGE_ADDED:
+            ScanChanges.addedCount++;
+            break;
+        case LE_WIFICLIENTEXT_SCAN_CHANGE_REMOVED:
+            // Report the signal last seen rather than LE_WIFICLIENT_NO_SIGNAL_STRENGTH
+            entryPtr->accessPoint.signalStrength = apPtr->previousSignal;
+            ScanChanges.removedCount++;
+            break;
+        default:
+            ScanChanges.updatedCount++;
+            break;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Replace ScanChangeList by the changes between PreviousScanList and LatestScanList, and empty
+ * PreviousScanList.
+ */
+//--------------------------------------------------------------------------------------------------
+static void BuildScanChanges
+(
+    bool isScanCommitted
+        ///< [IN]
+        ///< false if the scan failed: only PreviousScanList is emptied
+)
+{
+    le_dls_Link_t *linkPtr;
+
+    if (isScanCommitted)
+    {
+        while (NULL != (linkPtr = le_dls_Pop(&ScanChangeList)))
+        {
+            le_mem_Release(CONTAINER_OF(linkPtr, ScanChangeEntry_t, link));
+        }
+        memset(&ScanChanges, 0, sizeof(ScanChanges));
+        ScanChanges.scanId = ScanId;
+
+        for (linkPtr = le_dls_Peek(&LatestScanList);
+             NULL != linkPtr;
+             linkPtr = le_dls_PeekNext(&LatestScanList, linkPtr))
+        {
+            FoundAccessPoint_t *apPtr = CONTAINER_OF(linkPtr, FoundAccessPoint_t, latestLink);
+
+            if (!apPtr->inPreviousScan)
+            {
+                AddScanChange(LE_WIFICLIENTEXT_SCAN_CHANGE_ADDED, apPtr);
+            }
+            else if (IsAccessPointUpdated(apPtr))
+            {
+                AddScanChange(LE_WIFICLIENTEXT_SCAN_CHANGE_UPDATED, apPtr);
+            }
+        }
+    }
+
+    while (NULL != (linkPtr = le_dls_Pop(&PreviousScanList)))
+    {
+        FoundAccessPoint_t *apPtr = CONTAINER_OF(linkPtr, FoundAccessPoint_t, previousLink);
+
+        apPtr->inPreviousScan = false;
+        if (isScanCommitted && !apPtr->foundInLatestScan)
+        {
+            AddScanChange(LE_WIFICLIENTEXT_SCAN_CHANGE_REMOVED, apPtr);
+        }
+    }
+
+    if (isScanCommitted)
+    {
+        LE_DEBUG("Scan %u: %u added, %u removed, %u updated", ScanChanges.scanId,
+                 ScanChanges.addedCount, ScanChanges.removedCount, ScanChanges.updatedCount);
+        le_event_Report(ScanChangesEventId, &ScanChanges, sizeof(ScanChanges));
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Remove the scanned access points older than ApMaxAgeSec, then the least recently seen ones
+ * while the table holds more than ApTableMax access points. The access points found by the
+ * latest scan, pinned by a client or selected for connection are kept.
+ */
+//--------------------------------------------------------------------------------------------------
+static void EvictAccessPoints
+(
+    void
+)
+{
+    le_clk_Time_t  now = le_clk_GetRelativeTime();
+    le_dls_Link_t *linkPtr = le_dls_Peek(&LruList);
+
+    while (NULL != linkPtr)
+    {
+        FoundAccessPoint_t *apPtr = CONTAINER_OF(linkPtr, FoundAccessPoint_t, lruLink);
+        bool                isAged = (0 != ApMaxAgeSec) &&
+                                     (now.sec - apPtr->lastSeen.sec >= ApMaxAgeSec);
+        bool                isOverBudget = (0 != ApTableMax) && (AccessPointCount > ApTableMax);
+
+        if ((!isAged) && (!isOverBudget))
+        {
+            // The next access points were seen more recently
+            break;
+        }
+
+        linkPtr = le_dls_PeekNext(&LruList, linkPtr);
+
+        if ((!apPtr->foundInLatestScan) && (!apPtr->isPinned) &&
+            (apPtr->ref != CurrentConnection))
+        {
+            LE_DEBUG("Evict AP %s (%s)", apPtr->accessPoint.bssid, isAged ? "aged" : "LRU");
+            if (isAged)
+            {
+                AgedOutCount++;
+            }
+            else
+            {
+                EvictedCount++;
+            }
+            RemoveAccessPoint(apPtr->ref);
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Shortest interval of the scan scheduler (ms), never above the smallest requested age.
+ */
+//--------------------------------------------------------------------------------------------------
+static uint32_t GetShortestScanInterval
+(
+    void
+)
+{
+    return (ScanIntervalMinMs < ScanMaxIntervalMs) ? ScanIntervalMinMs : ScanMaxIntervalMs;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Start the scan scheduler timer so that it expires delayMs from now, or stop it when the WiFi
+ * device is stopped or when there is no scan request.
+ */
+//--------------------------------------------------------------------------------------------------
+static void ArmScanTimer
+(
+    uint32_t delayMs
+)
+{
+    if (le_timer_IsRunning(ScanTimerRef))
+    {
+        le_timer_Stop(ScanTimerRef);
+    }
+
+    // le_wifiClient_Start() arms the timer again for the scan requests
+    if ((0 == ClientStartCount) || ((0 == ScanMaxIntervalMs) && (!IsFullScanQueued)))
+    {
+        return;
+    }
+
+    le_timer_SetMsInterval(ScanTimerRef, (0 == delayMs) ? 1 : delayMs);
+    le_timer_Start(ScanTimerRef);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the age of the results of the last full scan.
+ *
+ * @return Age in ms, UINT64_MAX if no full scan succeeded yet.
+ */
+//--------------------------------------------------------------------------------------------------
+static uint64_t GetLastScanAgeMs
+(
+    void
+)
+{
+    return HasScanTime ? GetElapsedMs(LastScanTime) : UINT64_MAX;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Start the scan scheduler timer so that it expires ScanIntervalMs after the last full scan.
+ */
+//--------------------------------------------------------------------------------------------------
+static void ArmScanTimerFromLastScan
+(
+    void
+)
+{
+    uint64_t ageMs = GetLastScanAgeMs();
+
+    // Scan at once if the last results are already too old
+    ArmScanTimer((ageMs >= ScanIntervalMs) ? 0 : ScanIntervalMs - ageMs);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Adapt the scan interval to the changes found by the scan just committed, whoever requested it,
+ * and schedule the next scan: the interval is reset to its shortest value when the environment
+ * changes, and doubled up to ScanMaxIntervalMs while it is stable.
+ */
+//--------------------------------------------------------------------------------------------------
+static void ScheduleNextScan
+(
+    le_result_t result
+        ///< [IN]
+        ///< Result of the scan
+)
+{
+    if (LE_OK == result)
+    {
+        uint32_t changeCount = ScanChanges.addedCount + ScanChanges.removedCount +
+                               ScanChanges.updatedCount;
+
+        LastScanTime = le_clk_GetRelativeTime();
+        HasScanTime = true;
+
+        if (changeCount > ScanStableChanges)
+        {
+            ScanIntervalMs = GetShortestScanInterval();
+        }
+        else if (ScanIntervalMs < ScanMaxIntervalMs / 2)
+        {
+            ScanIntervalMs *= 2;
+        }
+        else
+        {
+            ScanIntervalMs = ScanMaxIntervalMs;
+        }
+        LE_DEBUG("%u changes, next scan in %u ms", changeCount, ScanIntervalMs);
+    }
+
+    ArmScanTimer(ScanIntervalMs);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Update the scan scheduler after a scan request was added or removed.
+ */
+//--------------------------------------------------------------------------------------------------
+static void UpdateScanSchedule
+(
+    void
+)
+{
+    le_dls_Link_t *linkPtr;
+
+    ScanMaxIntervalMs = 0;
+    for (linkPtr = le_dls_Peek(&ScanRequestList);
+         NULL != linkPtr;
+         linkPtr = le_dls_PeekNext(&ScanRequestList, linkPtr))
+    {
+        const ScanRequest_t *requestPtr = CONTAINER_OF(linkPtr, ScanRequest_t, link);
+
+        if ((0 == ScanMaxIntervalMs) || (requestPtr->maxAgeMs < ScanMaxIntervalMs))
+        {
+            ScanMaxIntervalMs = requestPtr->maxAgeMs;
+        }
+    }
+
+    if ((0 == ScanIntervalMs) || (ScanIntervalMs > ScanMaxIntervalMs))
+    {
+        ScanIntervalMs = GetShortestScanInterval();
+    }
+
+    if (IsScanPending)
+    {
+        // The next scan is scheduled when the running one is committed
+        return;
+    }
+
+    ArmScanTimerFromLastScan();
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Report the end of a scan to the clients, with the interface of the last scan.
+ */
+//--------------------------------------------------------------------------------------------------
+static void ReportScanEvent
+(
+    le_result_t result
+        ///< [IN]
+        ///< Result of the scan
+)
+{
+    le_wifiClient_EventInd_t* wifiEventIndicationPtr = le_mem_ForceAlloc(WifiEventPool);
+
+    if (result == LE_OK)
+    {
+        wifiEventIndicationPtr->event = LE_WIFICLIENT_EVENT_SCAN_DONE;
+    }
+    else
+    {
+        LE_WARN("Scan failed");
+        wifiEventIndicationPtr->event = LE_WIFICLIENT_EVENT_SCAN_FAILED;
+    }
+
+    wifiEventIndicationPtr->disconnectionCause = LE_WIFICLIENT_UNKNOWN_CAUSE;
+    strncpy(wifiEventIndicationPtr->ifName, scanIfName, LE_WIFIDEFS_MAX_IFNAME_LENGTH);
+    wifiEventIndicationPtr->ifName[LE_WIFIDEFS_MAX_IFNAME_LENGTH] = '\0';
+    wifiEventIndicationPtr->apBssid[0] = '\0';
+    PaEventIndicationHandler(wifiEventIndicationPtr, NULL);
+
+    PaEventHandler(wifiEventIndicationPtr->event, NULL);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Choose among the results of the roam scan the strongest access point of the link SSID, and
+ * reassociate to it if it beats the current access point by RoamHysteresisDb. Only the access
+ * points seen since the weak link detection are candidates.
+ */
+//--------------------------------------------------------------------------------------------------
+static void SelectRoamTarget
+(
+    ScanKind_t  kind,
+        ///< [IN]
+        ///< Kind of the scan just committed
+    le_result_t result
+        ///< [IN]
+        ///< Result of the scan
+)
+{
+    const FoundAccessPoint_t *currentPtr;
+    const FoundAccessPoint_t *bestPtr = NULL;
+    const SsidEntry_t        *entryPtr;
+    le_dls_Link_t            *linkPtr;
+    int32_t                   currentSignal = Roam.signal;
+
+    if (ROAM_STATE_SCANNING != Roam.state)
+    {
+        return;
+    }
+    Roam.state = ROAM_STATE_IDLE;
+    Roam.holdTime = le_clk_GetRelativeTime();
+
+    if (LE_OK != result)
+    {
+        if (SCAN_KIND_DIRECTED == kind)
+        {
+            LE_WARN("Roam scan failed, using full scans");
+            Roam.isFullScanNeeded = true;
+        }
+        return;
+    }
+
+    // The current access point measured by the same scan is the fairest reference
+    currentPtr = le_hashmap_Get(BssidIndex, Roam.report.fromBssid);
+    if ((NULL != currentPtr) && currentPtr->foundInLatestScan &&
+        (LE_WIFICLIENT_NO_SIGNAL_STRENGTH != currentPtr->accessPoint.signalStrength) &&
+        (!le_clk_GreaterThan(Roam.startTime, currentPtr->lastSeen)))
+    {
+        currentSignal = currentPtr->accessPoint.signalStrength;
+    }
+
+    entryPtr = le_hashmap_Get(SsidIndex, &Roam.ssid);
+    if (NULL == entryPtr)
+    {
+        return;
+    }
+
+    for (linkPtr = le_dls_Peek(&entryPtr->apList);
+         NULL != linkPtr;
+         linkPtr = le_dls_PeekNext(&entryPtr->apList, linkPtr))
+    {
+        const FoundAccessPoint_t *apPtr = CONTAINER_OF(linkPtr, FoundAccessPoint_t, ssidLink);
+        int16_t                   signal = apPtr->accessPoint.signalStrength;
+
+        if ((!apPtr->foundInLatestScan) || (LE_WIFICLIENT_NO_SIGNAL_STRENGTH == signal) ||
+            le_clk_GreaterThan(Roam.startTime, apPtr->lastSeen) ||
+            (0 == strcasecmp(apPtr->accessPoint.bssid, Roam.report.fromBssid)) ||
+            (signal < currentSignal + RoamHysteresisDb) ||
+            ((NULL != bestPtr) && (signal <= bestPtr->accessPoint.signalStrength)))
+        {
+            continue;
+        }
+        bestPtr = apPtr;
+    }
+
+    if (NULL == bestPtr)
+    {
+        LE_DEBUG("No access point stronger than %s (%d dBm) by %d dB", Roam.report.fromBssid,
+                 currentSignal, RoamHysteresisDb);
+        return;
+    }
+
+    le_utf8_Copy(Roam.report.toBssid, bestPtr->accessPoint.bssid, sizeof(Roam.report.toBssid),
+                 NULL);
+    LE_INFO("Roaming from %s (%d dBm) to %s (%d dBm)", Roam.report.fromBssid, currentSignal,
+            Roam.report.toBssid, bestPtr->accessPoint.signalStrength);
+    if (LE_OK != pa_wifiClient_Roam(Roam.report.toBssid))
+    {
+        ReportRoam(LE_FAULT);
+        return;
+    }
+    // The reassociation times out ROAM_TIMEOUT_MS after holdTime
+    Roam.state = ROAM_STATE_REASSOCIATING;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Keep the scan request of the auto-connect while it waits for a link, so that the saved
+ * networks are looked for by the scan scheduler.
+ */
+//--------------------------------------------------------------------------------------------------
+static void UpdateAutoConnectScanRequest
+(
+    void
+)
+{
+    bool isNeeded = AutoConnect.isEnabled && AutoConnect.isStarted &&
+                    (!AutoConnect.isSuspended) && (!AutoConnect.isLinkUp);
+
+    if (isNeeded == AutoConnect.isScanRequested)
+    {
+        return;
+    }
+
+    if (isNeeded)
+    {
+        AutoConnect.scanRequest.maxAgeMs = AutoConnectScanMs;
+        AutoConnect.scanRequest.link = LE_DLS_LINK_INIT;
+        le_dls_Queue(&ScanRequestList, &AutoConnect.scanRequest.link);
+    }
+    else
+    {
+        le_dls_Remove(&ScanRequestList, &AutoConnect.scanRequest.link);
+    }
+    AutoConnect.isScanRequested = isNeeded;
+    UpdateScanSchedule();
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Release the access point of the last auto-connect attempt. An access point created for the
+ * attempt goes back to the scan results, or is removed if the latest scan did not find it.
+ */
+//--------------------------------------------------------------------------------------------------
+static void ReleaseAutoConnectAp
+(
+    void
+)
+{
+    FoundAccessPoint_t *apPtr;
+
+    if (NULL == AutoConnect.apRef)
+    {
+        return;
+    }
+
+    if (CurrentConnection == AutoConnect.apRef)
+    {
+        CurrentConnection = NULL;
+    }
+
+    apPtr = le_ref_Lookup(ScanApRefMap, AutoConnect.apRef);
+    if ((NULL != apPtr) && AutoConnect.isApOwned)
+    {
+        if (apPtr->foundInLatestScan)
+        {
+            apPtr->isPinned = false;
+        }
+        else
+        {
+            RemoveAccessPoint(AutoConnect.apRef);
+        }
+    }
+    AutoConnect.apRef = NULL;
+    AutoConnect.isApOwned = false;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Rank the saved networks of wifiService:/wifi/channel found by the latest scan: by decreasing
+ * priority, then by decreasing signal of their strongest access point. Only the first
+ * AUTO_CONNECT_MAX_CANDIDATES are kept.
+ */
+//--------------------------------------------------------------------------------------------------
+static void RankAutoConnectCandidates
+(
+    void
+)
+{
+    char                 configPath[LE_CFG_STR_LEN_BYTES] = {0};
+    char                 name[LE_WIFIDEFS_MAX_SSID_BYTES];
+    le_cfg_IteratorRef_t cfg;
+
+    AutoConnect.candidateCount = 0;
+    AutoConnect.candidateIndex = 0;
+
+    snprintf(configPath, sizeof(configPath), "%s/%s", CFG_TREE_ROOT_DIR, CFG_PATH_WIFI);
+    cfg = le_cfg_CreateReadTxn(configPath);
+    if (LE_OK != le_cfg_GoToFirstChild(cfg))
+    {
+        le_cfg_CancelTxn(cfg);
+        return;
+    }
+
+    do
+    {
+        AutoConnectCandidate_t candidate;
+        const SsidEntry_t     *entryPtr;
+        le_dls_Link_t         *linkPtr;
+        uint32_t               i;
+
+        if ((LE_OK != le_cfg_GetNodeName(cfg, "", name, sizeof(name))) || ('\0' == name[0]))
+        {
+            continue;
+        }
+
+        memset(&candidate, 0, sizeof(candidate));
+        candidate.ssid.length = strlen(name);
+        memcpy(candidate.ssid.bytes, name, candidate.ssid.length);
+        entryPtr = le_hashmap_Get(SsidIndex, &candidate.ssid);
+        if (NULL == entryPtr)
+        {
+            continue;
+        }
+
+        candidate.signal = LE_WIFICLIENT_NO_SIGNAL_STRENGTH;
+        for (linkPtr = le_dls_Peek(&entryPtr->apList);
+             NULL != linkPtr;
+             linkPtr = le_dls_PeekNext(&entryPtr->apList, linkPtr))
+        {
+            const FoundAccessPoint_t *apPtr = CONTAINER_OF(linkPtr, FoundAccessPoint_t, ssidLink);
+            int16_t                   signal = apPtr->accessPoint.signalStrength;
+
+            if (apPtr->foundInLatestScan && (LE_WIFICLIENT_NO_SIGNAL_STRENGTH != signal) &&
+                ((LE_WIFICLIENT_NO_SIGNAL_STRENGTH == candidate.signal) ||
+                 (signal > candidate.signal)))
+            {
+                candidate.signal = signal;
+            }
+        }
+        if (LE_WIFICLIENT_NO_SIGNAL_STRENGTH == candidate.signal)
+        {
+            continue;
+        }
+        candidate.priority = le_cfg_GetInt(cfg, CFG_NODE_PRIORITY, 0);
+
+        // Insertion sort, the last candidate is dropped when the list is full
+        for (i = AutoConnect.candidateCount; i > 0; i--)
+        {
+            const AutoConnectCandidate_t *previousPtr = &AutoConnect.candidates[i - 1];
+
+            if ((previousPtr->priority > candidate.priority) ||
+                ((previousPtr->priority == candidate.priority) &&
+                 (previousPtr->signal >= candidate.signal)))
+            {
+                break;
+            }
+            if (i < AUTO_CONNECT_MAX_CANDIDATES)
+            {
+                AutoConnect.candidates[i] = *previousPtr;
+            }
+        }
+        if (i < AUTO_CONNECT_MAX_CANDIDATES)
+        {
+            AutoConnect.candidates[i] = candidate;
+            if (AutoConnect.candidateCount < AUTO_CONNECT_MAX_CANDIDATES)
+            {
+                AutoConnect.candidateCount++;
+            }
+        }
+    }
+    while (LE_OK == le_cfg_GoToNextSibling(cfg));
+
+    le_cfg_CancelTxn(cfg);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Start a connection to the next ranked saved network, skipping those whose configuration cannot
+ * be loaded or whose connection cannot be started.
+ */
+//--------------------------------------------------------------------------------------------------
+static void TryNextAutoConnectCandidate
+(
+    void
+)
+{
+    while (AutoConnect.candidateIndex < AutoConnect.candidateCount)
+    {
+        const AutoConnectCandidate_t  *candidatePtr;
+        le_wifiClient_AccessPointRef_t existingRef;
+        const FoundAccessPoint_t      *existingPtr;
+        le_result_t                    result;
+
+        if (IsScanPending)
+        {
+            // No access point can be created during a scan: resumed once it is committed
+            return;
+        }
+
+        candidatePtr = &AutoConnect.candidates[AutoConnect.candidateIndex++];
+        ReleaseAutoConnectAp();
+
+        // Do not release an access point held by a client
+        existingRef = FindAccessPointRefFromSsid(candidatePtr->ssid.bytes,
+                                                 candidatePtr->ssid.length);
+        existingPtr = le_ref_Lookup(ScanApRefMap, existingRef);
+        AutoConnect.isApOwned = (NULL == existingPtr) || (!existingPtr->isPinned);
+
+        result = le_wifiClient_LoadSsid(candidatePtr->ssid.bytes, candidatePtr->ssid.length,
+                                        &AutoConnect.apRef);
+        if (LE_OK == result)
+        {
+            AutoConnect.isConnecting = true;
+            result = le_wifiClient_Connect(AutoConnect.apRef);
+        }
+        if (LE_OK == result)
+        {
+            LE_INFO("Auto-connecting to %.*s, priority %d, %d dBm", candidatePtr->ssid.length,
+                    (const char *)candidatePtr->ssid.bytes, candidatePtr->priority,
+                    candidatePtr->signal);
+            return;
+        }
+
+        LE_WARN("Unable to connect to %.*s (%d)", candidatePtr->ssid.length,
+                (const char *)candidatePtr->ssid.bytes, result);
+        AutoConnect.isConnecting = false;
+        ReleaseAutoConnectAp();
+    }
+
+    LE_DEBUG("No saved network left to try");
+    AutoConnect.candidateCount = 0;
+    AutoConnect.candidateIndex = 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Let wpa_supplicant choose among the saved networks, and fail over from one to the next.
+ *
+ * @return
+ *      - LE_OK             The connection attempt is started.
+ *      - Otherwise the error of pa_wifiClient_ConnectAny().
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t ConnectAnySavedNetwork
+(
+    void
+)
+{
+    const AutoConnectCandidate_t *bestPtr = &AutoConnect.candidates[0];
+    le_result_t                   result;
+
+    ReleaseAutoConnectAp();
+    result = pa_wifiClient_ConnectAny();
+    if (LE_OK != result)
+    {
+        LE_WARN("wpa_supplicant cannot choose among the saved networks (%d)", result);
+        return result;
+    }
+
+    LE_INFO("Auto-connecting to the saved networks, %.*s first, priority %d, %d dBm",
+            bestPtr->ssid.length, (const char *)bestPtr->ssid.bytes, bestPtr->priority,
+            bestPtr->signal);
+    AutoConnect.isConnecting = true;
+    AutoConnect.isSupplicantChoice = true;
+    AutoConnect.candidateCount = 0;
+    AutoConnect.candidateIndex = 0;
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Bind a connection chosen by wpa_supplicant to the access point of its BSSID, as if it had been
+ * started by le_wifiClient_Connect(). A reassociation within the same network keeps the binding.
+ */
+//--------------------------------------------------------------------------------------------------
+static void BindAutoConnectAp
+(
+    const char *bssidPtr
+        ///< [IN]
+        ///< BSSID of the connected access point
+)
+{
+    le_wifiClient_AccessPointRef_t apRef = FindAccessPointRefFromBssid(bssidPtr);
+    FoundAccessPoint_t            *apPtr = le_ref_Lookup(ScanApRefMap, apRef);
+    const FoundAccessPoint_t      *currentPtr = le_ref_Lookup(ScanApRefMap, CurrentConnection);
+
+    if (NULL == apPtr)
+    {
+        LE_WARN("Connected to %s, not found by the scans", bssidPtr);
+        return;
+    }
+
+    if ((NULL != currentPtr) &&
+        (currentPtr->accessPoint.ssidLength == apPtr->accessPoint.ssidLength) &&
+        (0 == memcmp(currentPtr->accessPoint.ssidBytes, apPtr->accessPoint.ssidBytes,
+                     apPtr->accessPoint.ssidLength)))
+    {
+        return;
+    }
+
+    ReleaseAutoConnectAp();
+    AutoConnect.apRef = apRef;
+    AutoConnect.isApOwned = !apPtr->isPinned;
+    apPtr->isPinned = true;
+    CurrentConnection = apRef;
+    LE_INFO("wpa_supplicant connected to %.*s", apPtr->accessPoint.ssidLength,
+            (const char *)apPtr->accessPoint.ssidBytes);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Connect to the best saved network found by the latest scan when there is no link, or resume
+ * the attempts delayed by a scan.
+ */
+//--------------------------------------------------------------------------------------------------
+static void RunAutoConnect
+(
+    le_result_t result
+        ///< [IN]
+        ///< Result of the latest scan
+)
+{
+    if ((!AutoConnect.isEnabled) || (!AutoConnect.isStarted) || AutoConnect.isSuspended ||
+        AutoConnect.isLinkUp || AutoConnect.isConnecting)
+    {
+        return;
+    }
+
+    if (AutoConnect.candidateIndex >= AutoConnect.candidateCount)
+    {
+        if (LE_OK != result)
+        {
+            return;
+        }
+
+        RankAutoConnectCandidates();
+        if (0 == AutoConnect.candidateCount)
+        {
+            LE_DEBUG("No saved network found");
+            return;
+        }
+
+        if ((NULL != CurrentConnection) || AutoConnect.isSupplicantChoice)
+        {
+            // wpa_supplicant did not restore the link: select the best network instead
+            ReleaseAutoConnectAp();
+            CurrentConnection = NULL;
+            AutoConnect.isSupplicantChoice = false;
+            LinkInfoCache.isValid = false;
+            (void)pa_wifiClient_Disconnect();
+        }
+
+        if (AutoConnect.hasNetworkList && (LE_OK == ConnectAnySavedNetwork()))
+        {
+            return;
+        }
+    }
+
+    TryNextAutoConnectCandidate();
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Follow a connection started by le_wifiClient_Connect(): a client connection replaces the
+ * attempts of the auto-connect, which falls back to the saved networks if it fails.
+ */
+//--------------------------------------------------------------------------------------------------
+static void UpdateAutoConnectOnConnect
+(
+    le_wifiClient_AccessPointRef_t apRef
+        ///< [IN]
+        ///< Access point to connect to
+)
+{
+    AutoConnect.isConnecting = true;
+    AutoConnect.isSuspended = false;
+    AutoConnect.isSupplicantChoice = false;
+    if (apRef == AutoConnect.apRef)
+    {
+        return;
+    }
+
+    ReleaseAutoConnectAp();
+    AutoConnect.apRef = apRef;
+    AutoConnect.isApOwned = false;
+    AutoConnect.candidateCount = 0;
+    AutoConnect.candidateIndex = 0;
+    UpdateAutoConnectScanRequest();
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Suspend the auto-connect after le_wifiClient_Disconnect(), until the next
+ * le_wifiClient_Connect() or le_wifiClientExt_SetAutoConnect().
+ */
+//--------------------------------------------------------------------------------------------------
+static void SuspendAutoConnect
+(
+    void
+)
+{
+    AutoConnect.isSuspended = true;
+    AutoConnect.isConnecting = false;
+    AutoConnect.isSupplicantChoice = false;
+    AutoConnect.isReleasingLink = AutoConnect.isLinkUp;
+    AutoConnect.candidateCount = 0;
+    AutoConnect.candidateIndex = 0;
+    ReleaseAutoConnectAp();
+    UpdateAutoConnectScanRequest();
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Reset the auto-connect state when the WiFi device is stopped, the access points being
+ * released.
+ */
+//--------------------------------------------------------------------------------------------------
+static void ResetAutoConnect
+(
+    void
+)
+{
+    AutoConnect.isStarted = false;
+    AutoConnect.isLinkUp = false;
+    AutoConnect.isReleasingLink = false;
+    AutoConnect.isConnecting = false;
+    AutoConnect.isSupplicantChoice = false;
+    AutoConnect.apRef = NULL;
+    AutoConnect.isApOwned = false;
+    AutoConnect.candidateCount = 0;
+    AutoConnect.candidateIndex = 0;
+    UpdateAutoConnectScanRequest();
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Enable or disable the auto-connect. Enabled, it holds a start of the WiFi device and uses the
+ * latest scan results at once if they are recent enough, otherwise its scan request starts a
+ * scan.
+ *
+ * @return
+ *      - LE_OK             Function succeeded.
+ *      - Otherwise the error of le_wifiClient_Start().
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t EnableAutoConnect
+(
+    bool isEnabled
+        ///< [IN]
+        ///< True to enable the auto-connect
+)
+{
+    le_result_t result;
+
+    if (!isEnabled)
+    {
+        // An attempt in progress goes on, without fallback
+        AutoConnect.isEnabled = false;
+        AutoConnect.candidateCount = 0;
+        AutoConnect.candidateIndex = 0;
+        UpdateAutoConnectScanRequest();
+        if (AutoConnect.isStarted)
+        {
+            AutoConnect.isStarted = false;
+            (void)le_wifiClient_Stop();
+        }
+        return LE_OK;
+    }
+
+    if (!AutoConnect.isStarted)
+    {
+        result = le_wifiClient_Start();
+        if ((LE_OK != result) && (LE_BUSY != result))
+        {
+            LE_ERROR("Unable to start the WiFi device for the auto-connect (%d)", result);
+            return result;
+        }
+        AutoConnect.isStarted = true;
+    }
+
+    AutoConnect.isEnabled = true;
+    AutoConnect.isSuspended = false;
+    UpdateAutoConnectScanRequest();
+
+    if ((!IsScanPending) && (GetLastScanAgeMs() < AutoConnectScanMs))
+    {
+        RunAutoConnect(LE_OK);
+    }
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Handler of the connection events for the auto-connect: it tracks the link and the network
+ * chosen by wpa_supplicant, and tries the next saved network when an attempt fails.
+ */
+//--------------------------------------------------------------------------------------------------
+static void AutoConnectEventHandler
+(
+    const le_wifiClient_EventInd_t *eventPtr,
+        ///< [IN]
+        ///< Connection event
+    void                           *contextPtr
+)
+{
+    if (LE_WIFICLIENT_EVENT_CONNECTED == eventPtr->event)
+    {
+        AutoConnect.isLinkUp = true;
+        AutoConnect.isReleasingLink = false;
+        AutoConnect.isConnecting = false;
+        if (AutoConnect.isSupplicantChoice)
+        {
+            BindAutoConnectAp(eventPtr->apBssid);
+        }
+        AutoConnect.candidateCount = 0;
+        AutoConnect.candidateIndex = 0;
+        UpdateAutoConnectScanRequest();
+    }
+    else if (LE_WIFICLIENT_EVENT_DISCONNECTED == eventPtr->event)
+    {
+        AutoConnect.isLinkUp = false;
+        if (AutoConnect.isReleasingLink)
+        {
+            // End of the link released by le_wifiClient_Disconnect()
+            AutoConnect.isReleasingLink = false;
+            return;
+        }
+        if ((ROAM_STATE_REASSOCIATING == Roam.state) && (NULL != CurrentConnection))
+        {
+            // The link to the previous access point is released first
+            return;
+        }
+
+        if (AutoConnect.isConnecting)
+        {
+            LE_WARN("Connection attempt failed, cause %d", eventPtr->disconnectionCause);
+            AutoConnect.isConnecting = false;
+            if (AutoConnect.isEnabled && AutoConnect.isStarted && (!AutoConnect.isSuspended))
+            {
+                TryNextAutoConnectCandidate();
+            }
+        }
+        UpdateAutoConnectScanRequest();
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Commit the results of a scan to the access point table and report the end of the scan.
+ * Runs in the main thread, which owns the table.
+ */
+//--------------------------------------------------------------------------------------------------
+static void CommitScanBatch
+(
+    void *param1Ptr,
+        ///< [IN]
+        ///< Scan batch
+    void *param2Ptr
+)
+{
+    ScanBatch_t   *batchPtr = param1Ptr;
+    le_result_t    result = batchPtr->result;
+    ScanKind_t     kind = batchPtr->kind;
+    le_dls_Link_t *linkPtr;
+
+    if (IsScanCancelled)
+    {
+        // The WiFi device was stopped during the scan: its access point table was emptied
+        while (NULL != (linkPtr = le_dls_Pop(&batchPtr->apList)))
+        {
+            le_mem_Release(CONTAINER_OF(linkPtr, ScanBatchEntry_t, link));
+        }
+        le_mem_Release(batchPtr);
+
+        LE_DEBUG("Cancelled scan dropped");
+        IsScanCancelled = false;
+        IsScanPending = false;
+        if (0 == ClientStartCount)
+        {
+            return;
+        }
+
+        // The device was started again during the scan: resume the scan scheduler
+        if (IsFullScanQueued)
+        {
+            ArmScanTimer(0);
+        }
+        else
+        {
+            ArmScanTimerFromLastScan();
+        }
+        return;
+    }
+
+    if (LE_OK == result)
+    {
+        FoundWifiApCount = 0;
+        MarkAllAccessPointsOld((SCAN_KIND_DIRECTED == kind) ? &batchPtr->params : NULL);
+    }
+
+    while (NULL != (linkPtr = le_dls_Pop(&batchPtr->apList)))
+    {
+        ScanBatchEntry_t *entryPtr = CONTAINER_OF(linkPtr, ScanBatchEntry_t, link);
+
+        if ((LE_OK == result) && (NULL == AddAccessPointToApRefMap(&entryPtr->accessPoint)))
+        {
+            result = LE_FAULT;
+        }
+        le_mem_Release(entryPtr);
+    }
+
+    if (LE_OK == result)
+    {
+        ScanId++;
+    }
+    le_utf8_Copy(scanIfName, batchPtr->ifName, sizeof(scanIfName), NULL);
+    le_mem_Release(batchPtr);
+
+    IsScanPending = false;
+
+    BuildScanChanges(LE_OK == result);
+    EvictAccessPoints();
+    if (SCAN_KIND_FULL != kind)
+    {
+        // A directed or cached scan does not refresh all the results
+        ArmScanTimerFromLastScan();
+    }
+    else
+    {
+        ScheduleNextScan(result);
+    }
+
+    if (IsFullScanQueued)
+    {
+        // The clients which called le_wifiClient_Scan() during a directed or cached scan expect
+        // a full scan: run it from the scan timer
+        ArmScanTimer(0);
+    }
+
+    SelectRoamTarget(kind, result);
+    RunAutoConnect(result);
+    ReportScanEvent(result);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Run a scan in the scan worker thread and hand its results to the main thread. The access
+ * point table is not accessed here.
+ */
+//--------------------------------------------------------------------------------------------------
+static void RunScan
+(
+    void *param1Ptr,
+        ///< [IN]
+        ///< Scan batch, holding the parameters of a directed scan
+    void *param2Ptr
+)
+{
+    ScanBatch_t *batchPtr = param1Ptr;
+    le_result_t  paResult;
+
+    switch (batchPtr->kind)
+    {
+        case SCAN_KIND_DIRECTED:
+            paResult = pa_wifiClient_DirectedScan(&batchPtr->params);
+            break;
+        case SCAN_KIND_CACHED:
+            paResult = pa_wifiClient_CachedScan();
+            break;
+        default:
+            paResult = pa_wifiClient_Scan();
+            break;
+    }
+    if (LE_OK != paResult)
+    {
+        LE_ERROR("Scan failed (%d)", paResult);
+        batchPtr->result = LE_FAULT;
+        le_event_QueueFunctionToThread(MainThreadRef, CommitScanBatch, batchPtr, NULL);
+        return;
+    }
+
+    for (;;)
+    {
+        ScanBatchEntry_t *entryPtr = le_mem_ForceAlloc(ScanBatchEntryPool);
+
+        paResult = pa_wifiClient_GetScanResult(&entryPtr->accessPoint, batchPtr->ifName);
+        if (LE_OK != paResult)
+        {
+            le_mem_Release(entryPtr);
+            break;
+        }
+
+        // The results of a directed scan may include access points found on other frequencies
+        // by earlier scans.
+        if ((SCAN_KIND_DIRECTED == batchPtr->kind) && (batchPtr->params.frequencyCount > 0) &&
+            (0 != entryPtr->accessPoint.frequency))
+        {
+            pa_wifiClient_ScanParams_t frequencies = batchPtr->params;
+
+            frequencies.ssidCount = 0;
+            if (!IsInScanScope(&entryPtr->accessPoint, &frequencies))
+            {
+                le_mem_Release(entryPtr);
+                continue;
+            }
+        }
+
+        entryPtr->link = LE_DLS_LINK_INIT;
+        le_dls_Queue(&batchPtr->apList, &entryPtr->link);
+    }
+
+    batchPtr->result = (LE_NOT_FOUND == paResult) ? LE_OK : paResult;
+
+    paResult = pa_wifiClient_ScanDone();
+    if (LE_OK != paResult)
+    {
+        LE_ERROR("pa_wifiClient_ScanDone() failed (%d)", paResult);
+        batchPtr->result = paResult;
+    }
+
+    le_event_QueueFunctionToThread(MainThreadRef, CommitScanBatch, batchPtr, NULL);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Queue a scan to the scan worker thread.
+ */
+//--------------------------------------------------------------------------------------------------
+static void StartScan
+(
+    ScanKind_t                        kind,
+        ///< [IN]
+        ///< Kind of scan
+    const pa_wifiClient_ScanParams_t *paramsPtr
+        ///< [IN]
+        ///< Parameters of a directed scan, NULL otherwise
+)
+{
+    ScanBatch_t *batchPtr = le_mem_ForceAlloc(ScanBatchPool);
+
+    memset(batchPtr, 0, sizeof(ScanBatch_t));
+    batchPtr->apList = LE_DLS_LIST_INIT;
+    batchPtr->kind = kind;
+    if (NULL != paramsPtr)
+    {
+        batchPtr->params = *paramsPtr;
+    }
+    if (SCAN_KIND_FULL == kind)
+    {
+        IsFullScanQueued = false;
+    }
+
+    IsScanPending = true;
+    PendingScanKind = kind;
+    le_event_QueueFunctionToThread(ScanWorkerThreadRef, RunScan, batchPtr, NULL);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Scan scheduler timer handler.
+ */
+//--------------------------------------------------------------------------------------------------
+static void ScanTimerHandler
+(
+    le_timer_Ref_t timerRef
+)
+{
+    if (IsScanPending)
+    {
+        // A client scan is running, its results serve the scan requests as well
+        return;
+    }
+
+    LE_DEBUG("Scheduled scan, interval %u ms", ScanIntervalMs);
+    StartScan(SCAN_KIND_FULL, NULL);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Scan worker thread: runs the scans queued by le_wifiClient_Scan() and the scan scheduler.
+ */
+//--------------------------------------------------------------------------------------------------
+static void *ScanWorkerThread
+(
+    void *contextPtr
+)
+{
+    le_event_RunLoop();
+    return NULL;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Handler function to the close session service to detect if the application crashed.
+ *
+ */
+//--------------------------------------------------------------------------------------------------
+static void CloseSessionEventHandler
+(
+    le_msg_SessionRef_t  sessionRef,
+    void                *contextPtr
+)
+{
+    if (sessionRef == GetFirstSessionRef)
+    {
+        GetFirstSessionRef = NULL;
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Handler function to the close session of the extension service: removes the scan requests of
+ * the client.
+ */
+//--------------------------------------------------------------------------------------------------
+static void CloseExtSessionEventHandler
+(
+    le_msg_SessionRef_t  sessionRef,
+    void                *contextPtr
+)
+{
+    le_dls_Link_t *linkPtr = le_dls_Peek(&ScanRequestList);
+    bool           isUpdated = false;
+
+    while (NULL != linkPtr)
+    {
+        ScanRequest_t *requestPtr = CONTAINER_OF(linkPtr, ScanRequest_t, link);
+
+        linkPtr = le_dls_PeekNext(&ScanRequestList, linkPtr);
+        if (requestPtr->sessionRef == sessionRef)
+        {
+            le_dls_Remove(&ScanRequestList, &requestPtr->link);
+            le_ref_DeleteRef(ScanRequestRefMap, requestPtr->ref);
+            le_mem_Release(requestPtr);
+            isUpdated = true;
+        }
+    }
+
+    if (isUpdated)
+    {
+        UpdateScanSchedule();
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Load the WiFi client service settings from the config tree.
+ *
+ * wifiService:/wifi/client/scanBackend selects the scan backend, "nl80211" (default) or
+ * "script".
+ * wifiService:/wifi/client/linkInfoTtlMs sets the freshness window of the link state cache,
+ * 0 disables the cache.
+ * wifiService:/wifi/client/scanRssiDeltaDb sets the signal strength change from which an access
+ * point is reported as updated by the ScanChanges event.
+ * wifiService:/wifi/client/apTableMax and apMaxAgeSec set the budget of the access point table,
+ * 0 for no limit.
+ * wifiService:/wifi/client/scanIntervalMinMs and scanStableChanges tune the scan scheduler.
+ * wifiService:/wifi/client/scanReuseWindowMs sets the time after a full scan during which
+ * le_wifiClient_Scan() reuses its results, 0 to always scan.
+ * wifiService:/wifi/client/roamEnable enables the roaming engine, tuned by roamRssiThresholdDbm,
+ * roamHysteresisDb and roamDwellMs.
+ * wifiService:/wifi/client/autoConnect enables the auto-connect at start-up, and
+ * autoConnectScanMs sets the maximum age of the scan results while it waits for a link.
+ */
+//--------------------------------------------------------------------------------------------------
+static void LoadClientConfig
+(
+    void
+)
+{
+    char                        configPath[LE_CFG_STR_LEN_BYTES] = {0};
+    char                        backendStr[CFG_SCAN_BACKEND_MAX_BYTES] = {0};
+    pa_wifiClient_ScanBackend_t backend = PA_WIFICLIENT_SCAN_BACKEND_NL80211;
+    le_cfg_IteratorRef_t        cfg;
+    int32_t                     ttlMs;
+    int32_t                     rssiDeltaDb;
+    int32_t                     apTableMax;
+    int32_t                     apMaxAgeSec;
+    int32_t                     intervalMinMs;
+    int32_t                     stableChanges;
+    int32_t                     reuseWindowMs;
+    int32_t                     roamThresholdDbm;
+    int32_t                     roamHysteresisDb;
+    int32_t                     roamDwellMs;
+    int32_t                     autoConnectScanMs;
+
+    snprintf(configPath, sizeof(configPath), "%s/%s", CFG_TREE_ROOT_DIR, CFG_PATH_WIFI_CLIENT);
+    cfg = le_cfg_CreateReadTxn(configPath);
+
+    if (LE_OK == le_cfg_GetString(cfg, CFG_NODE_SCAN_BACKEND, backendStr, sizeof(backendStr),
+                                  CFG_SCAN_BACKEND_NL80211))
+    {
+        if (0 == strcmp(backendStr, CFG_SCAN_BACKEND_SCRIPT))
+        {
+            backend = PA_WIFICLIENT_SCAN_BACKEND_SCRIPT;
+        }
+        else if (0 != strcmp(backendStr, CFG_SCAN_BACKEND_NL80211))
+        {
+            LE_WARN("Unknown scan backend '%s', using %s", backendStr, CFG_SCAN_BACKEND_NL80211);
         }
+    }
+
+    ttlMs = le_cfg_GetInt(cfg, CFG_NODE_LINK_INFO_TTL, LINK_INFO_TTL_DEFAULT_MS);
+    if (ttlMs < 0)
+    {
+        LE_WARN("Invalid link info TTL %d ms, using %d ms", ttlMs, LINK_INFO_TTL_DEFAULT_MS);
+        ttlMs = LINK_INFO_TTL_DEFAULT_MS;
+    }
+    LinkInfoTtlMs = ttlMs;
+
+    rssiDeltaDb = le_cfg_GetInt(cfg, CFG_NODE_SCAN_RSSI_DELTA, SCAN_RSSI_DELTA_DEFAULT_DB);
+    if (rssiDeltaDb < 0)
+    {
+        LE_WARN("Invalid scan RSSI delta %d dB, using %d dB", rssiDeltaDb,
+                SCAN_RSSI_DELTA_DEFAULT_DB);
+        rssiDeltaDb = SCAN_RSSI_DELTA_DEFAULT_DB;
+    }
+    ScanRssiDeltaDb = rssiDeltaDb;
+
+    apTableMax = le_cfg_GetInt(cfg, CFG_NODE_AP_TABLE_MAX, AP_TABLE_MAX_DEFAULT);
+    if (apTableMax < 0)
+    {
+        LE_WARN("Invalid AP table size %d, using %d", apTableMax, AP_TABLE_MAX_DEFAULT);
+        apTableMax = AP_TABLE_MAX_DEFAULT;
+    }
+    ApTableMax = apTableMax;
+
+    apMaxAgeSec = le_cfg_GetInt(cfg, CFG_NODE_AP_MAX_AGE, AP_MAX_AGE_DEFAULT_SEC);
+    if (apMaxAgeSec < 0)
+    {
+        LE_WARN("Invalid AP age %d s, using %d s", apMaxAgeSec, AP_MAX_AGE_DEFAULT_SEC);
+        apMaxAgeSec = AP_MAX_AGE_DEFAULT_SEC;
+    }
+    ApMaxAgeSec = apMaxAgeSec;
+
+    intervalMinMs = le_cfg_GetInt(cfg, CFG_NODE_SCAN_INTERVAL_MIN, SCAN_INTERVAL_MIN_DEFAULT_MS);
+    if (intervalMinMs <= 0)
+    {
+        LE_WARN("Invalid scan interval %d ms, using %d ms", intervalMinMs,
+                SCAN_INTERVAL_MIN_DEFAULT_MS);
+        intervalMinMs = SCAN_INTERVAL_MIN_DEFAULT_MS;
+    }
+    ScanIntervalMinMs = intervalMinMs;
+
+    stableChanges = le_cfg_GetInt(cfg, CFG_NODE_SCAN_STABLE, SCAN_STABLE_CHANGES_DEFAULT);
+    if (stableChanges < 0)
+    {
+        LE_WARN("Invalid stable changes %d, using %d", stableChanges,
+                SCAN_STABLE_CHANGES_DEFAULT);
+        stableChanges = SCAN_STABLE_CHANGES_DEFAULT;
+    }
+    ScanStableChanges = stableChanges;
+
+    reuseWindowMs = le_cfg_GetInt(cfg, CFG_NODE_SCAN_REUSE_WINDOW, SCAN_REUSE_WINDOW_DEFAULT_MS);
+    if (reuseWindowMs < 0)
+    {
+        LE_WARN("Invalid scan reuse window %d ms, using %d ms", reuseWindowMs,
+                SCAN_REUSE_WINDOW_DEFAULT_MS);
+        reuseWindowMs = SCAN_REUSE_WINDOW_DEFAULT_MS;
+    }
+    ScanReuseWindowMs = reuseWindowMs;
+
+    RoamEnabled = le_cfg_GetBool(cfg, CFG_NODE_ROAM_ENABLE, ROAM_ENABLE_DEFAULT);
+
+    roamThresholdDbm = le_cfg_GetInt(cfg, CFG_NODE_ROAM_THRESHOLD,
+                                     ROAM_RSSI_THRESHOLD_DEFAULT_DBM);
+    if ((roamThresholdDbm > 0) || (roamThresholdDbm < INT16_MIN))
+    {
+        LE_WARN("Invalid roam threshold %d dBm, using %d dBm", roamThresholdDbm,
+                ROAM_RSSI_THRESHOLD_DEFAULT_DBM);
+        roamThresholdDbm = ROAM_RSSI_THRESHOLD_DEFAULT_DBM;
+    }
+    RoamRssiThresholdDbm = roamThresholdDbm;
+
+    roamHysteresisDb = le_cfg_GetInt(cfg, CFG_NODE_ROAM_HYSTERESIS, ROAM_HYSTERESIS_DEFAULT_DB);
+    if ((roamHysteresisDb < 0) || (roamHysteresisDb > INT16_MAX))
+    {
+        LE_WARN("Invalid roam hysteresis %d dB, using %d dB", roamHysteresisDb,
+                ROAM_HYSTERESIS_DEFAULT_DB);
+        roamHysteresisDb = ROAM_HYSTERESIS_DEFAULT_DB;
+    }
+    RoamHysteresisDb = roamHysteresisDb;
+
+    roamDwellMs = le_cfg_GetInt(cfg, CFG_NODE_ROAM_DWELL, ROAM_DWELL_DEFAULT_MS);
+    if (roamDwellMs < 0)
+    {
+        LE_WARN("Invalid roam dwell time %d ms, using %d ms", roamDwellMs,
+                ROAM_DWELL_DEFAULT_MS);
+        roamDwellMs = ROAM_DWELL_DEFAULT_MS;
+    }
+    RoamDwellMs = roamDwellMs;
+
+    autoConnectScanMs = le_cfg_GetInt(cfg, CFG_NODE_AUTO_CONNECT_SCAN,
+                                      AUTO_CONNECT_SCAN_DEFAULT_MS);
+    if (autoConnectScanMs <= 0)
+    {
+        LE_WARN("Invalid auto-connect scan age %d ms, using %d ms", autoConnectScanMs,
+                AUTO_CONNECT_SCAN_DEFAULT_MS);
+        autoConnectScanMs = AUTO_CONNECT_SCAN_DEFAULT_MS;
+    }
+    AutoConnectScanMs = autoConnectScanMs;
+
+    // Started by le_wifiClient_Init()
+    AutoConnect.isEnabled = le_cfg_GetBool(cfg, CFG_NODE_AUTO_CONNECT, AUTO_CONNECT_DEFAULT);
+
+    le_cfg_CancelTxn(cfg);
+
+    pa_wifiClient_SetScanBackend(backend);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Is Scan running. Checks if a scan was requested and its results are not committed yet
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsScanRunning(void)
+{
+    LE_DEBUG("IsScanRunning .%d", IsScanPending);
+    return IsScanPending;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * The first-layer WiFi Client Event Handler.
+ *
+ * @deprecated le_wifiClient_AddNewEventHandler() should not be used anymore.
+ *
+ * It has been replaced by le_wifiClient_AddConnectionEventHandler().
+ */
+//--------------------------------------------------------------------------------------------------
+static void FirstLayerWifiClientEventHandler
+(
+    void *reportPtr,
+    void *secondLayerHandlerFunc
+)
+{
+    le_wifiClient_NewEventHandlerFunc_t  clientHandlerFunc = secondLayerHandlerFunc;
+    le_wifiClient_Event_t               *wifiEventPtr      = (le_wifiClient_Event_t *)reportPtr;
 
-        return returnedRef;
+    if (NULL != wifiEventPtr)
+    {
+        LE_DEBUG("Event: %d", *wifiEventPtr);
+        clientHandlerFunc(*wifiEventPtr, le_event_GetContextPtr());
     }
     else
     {
-        FoundAccessPoint_t *foundAccessPointPtr = le_mem_ForceAlloc(AccessPointPool);
+        LE_ERROR("Event is NULL");
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * The first-layer WiFi Client Connection Event Handler.
+ *
+ */
+//--------------------------------------------------------------------------------------------------
+static void FirstLayerWifiClientConnectionEventHandler
+(
+    void *reportPtr,
+    void *secondLayerHandlerFunc
+)
+{
+    le_wifiClient_EventInd_t*  wifiEventPtr = reportPtr;
+    le_wifiClient_ConnectionEventHandlerFunc_t  clientHandlerFunc = secondLayerHandlerFunc;
+
+
+    if (NULL != wifiEventPtr)
+    {
+        clientHandlerFunc(wifiEventPtr, le_event_GetContextPtr());
+    }
+    else
+    {
+        LE_WARN("wifiEventPtr is NULL");
+    }
+    // The reportPtr is a reference counted object, so need to release it
+    le_mem_Release(reportPtr);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add handler function for EVENT 'le_wifiClient_NewEvent'
+ *
+ * This event provide information on Wifi Client event changes.
+ *
+ * @deprecated le_wifiClient_AddNewEventHandler() should not be used anymore.
+ *
+ * It has been replaced by le_wifiClient_AddConnectionEventHandler().
+ */
+//--------------------------------------------------------------------------------------------------
+le_wifiClient_NewEventHandlerRef_t le_wifiClient_AddNewEventHandler
+(
+    le_wifiClient_NewEventHandlerFunc_t handlerFuncPtr,
+        ///< [IN]
+        ///< Event handling function
+
+    void *contextPtr
+        ///< [IN]
+        ///< Associated event context
+)
+{
+    le_event_HandlerRef_t handlerRef;
+
+    // Note: THIS ONE REGISTERS THE CB function..
+    LE_DEBUG("Add new event handler");
+
+    if (handlerFuncPtr == NULL)
+    {
+        LE_KILL_CLIENT("handlerFuncPtr is NULL !");
+        return NULL;
+    }
+
+    handlerRef = le_event_AddLayeredHandler("NewWiFiClientMsgHandler",
+                                            WifiEventId,
+                                            FirstLayerWifiClientEventHandler,
+                                            (le_event_HandlerFunc_t)handlerFuncPtr);
+
+    le_event_SetContextPtr(handlerRef, contextPtr);
+
+    return (le_wifiClient_NewEventHandlerRef_t)(handlerRef);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * This function must be called to register an handler for WiFi connection state change.
+ *
+ * @return A handler reference, which is only needed for later removal of the handler.
+ *
+ * @note Doesn't return on failure, so there's no need to check the return value for errors.
+ */
+//--------------------------------------------------------------------------------------------------
+le_wifiClient_ConnectionEventHandlerRef_t le_wifiClient_AddConnectionEventHandler
+(
+    le_wifiClient_ConnectionEventHandlerFunc_t handlerFuncPtr,
+        ///< [IN]
+        ///< Event handling function
+
+    void *contextPtr
+        ///< [IN]
+        ///< Associated event context
+)
+{
+    le_event_HandlerRef_t handlerRef;
+
+    // Note: THIS ONE REGISTERS THE CB function..
+    LE_DEBUG("Add wifi connection event handler");
+
+    if (handlerFuncPtr == NULL)
+    {
+        LE_KILL_CLIENT("handlerFuncPtr is NULL !");
+        return NULL;
+    }
+
+    handlerRef = le_event_AddLayeredHandler("WiFiClientMsgHandler",
+                                            WifiEventIndicationId,
+                                            FirstLayerWifiClientConnectionEventHandler,
+                                            (le_event_HandlerFunc_t)handlerFuncPtr);
+
+    le_event_SetContextPtr(handlerRef, contextPtr);
+
+    return (le_wifiClient_ConnectionEventHandlerRef_t)(handlerRef);
+}
 
-        if (foundAccessPointPtr)
-        {
-            FoundWifiApCount++;
-            LE_DEBUG("New AP[%d] SignalStrength %d | SSID length %d | SSID: \"%.*s\"",
-                FoundWifiApCount,
-                apPtr->signalStrength,
-                apPtr->ssidLength,
-                apPtr->ssidLength,
-                (char *)apPtr->ssidBytes
-               );
+//--------------------------------------------------------------------------------------------------
+/**
+ * Remove handler function for EVENT 'le_wifiClient_NewEvent'
+ *
+ * @deprecated le_wifiClient_AddNewEventHandler() should not be used anymore.
+ *
+ * It has been replaced by le_wifiClient_AddConnectionEventHandler().
+ */
+//--------------------------------------------------------------------------------------------------
+void le_wifiClient_RemoveNewEventHandler
+(
+    le_wifiClient_NewEventHandlerRef_t handlerRef
+        ///< [IN]
+        ///< Reference of the event handler to remove
+)
+{
+    LE_DEBUG("Remove event handler");
+    le_event_RemoveHandler((le_event_HandlerRef_t)handlerRef);
+}
 
-            // struct member value copy
-            foundAccessPointPtr->accessPoint = *apPtr;
-            foundAccessPointPtr->foundInLatestScan = true;
+//--------------------------------------------------------------------------------------------------
+/**
+ * Remove handler function for EVENT 'le_wifiClient_ConnectionEvent'
+ */
+//--------------------------------------------------------------------------------------------------
+void le_wifiClient_RemoveConnectionEventHandler
+(
+    le_wifiClient_ConnectionEventHandlerRef_t handlerRef
+        ///< [IN]
+        ///< Reference of the event handler to remove
+)
+{
+    LE_DEBUG("Remove event handler");
+    le_event_RemoveHandler((le_event_HandlerRef_t)handlerRef);
+}
 
-            // Create a Safe Reference for this object.
-            returnedRef = le_ref_CreateRef(ScanApRefMap, foundAccessPointPtr);
+//--------------------------------------------------------------------------------------------------
+/**
+ * Starts the WIFI device.
+ *
+ * @return
+ *      - LE_OK             Function succeeded.
+ *      - LE_FAULT          Function failed.
+ *      - LE_BUSY           The WiFi device is already started.
+ *      - LE_NOT_FOUND      The WiFi device is absent.
+ *      - LE_UNAVAILABLE    The WiFi device may not work.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t le_wifiClient_Start
+(
+    void
+)
+{
+    le_result_t result;
 
-            LE_DEBUG("le_ref_CreateRef foundAccessPointPtr %p; Ref%p ",
-                foundAccessPointPtr, returnedRef);
+    // Only the first client starts the WIFI module
+    if (!ClientStartCount)
+    {
+        result = pa_wifiClient_Start();
+        if (LE_OK == result)
+        {
+            LE_DEBUG("WIFI client started successfully");
+            // Increment the number of clients calling this start function
+            ClientStartCount++;
+            // Resume the scans of the scan requests, stopped with the device
+            UpdateScanSchedule();
         }
         else
         {
-            LE_ERROR("le_mem_ForceAlloc failed. Count %d", FoundWifiApCount);
+            LE_WARN("Unable to start WIFI client; return code: %d", result);
         }
     }
+    else
+    {
+        LE_WARN("WIFI client already started");
+        // Increment the number of clients calling this start function
+        ClientStartCount++;
+        result = LE_BUSY;
+    }
 
-    return returnedRef;
+    return result;
 }
 
-
 //--------------------------------------------------------------------------------------------------
 /**
- *  Frees one members of the access point and the corresponding access points memory
+ * Stops the WIFI device.
+ *
+ * @return
+ *      - LE_OK        Function succeeded.
+ *      - LE_FAULT     Function failed.
+ *      - LE_DUPLICATE The WIFI device is already stopped.
+ *
  */
 //--------------------------------------------------------------------------------------------------
-static void RemoveAccessPoint
+le_result_t le_wifiClient_Stop
 (
-    le_wifiClient_AccessPointRef_t apRef
+    void
 )
 {
-    FoundAccessPoint_t *apPtr = (FoundAccessPoint_t *)le_ref_Lookup(ScanApRefMap, apRef);
+    le_result_t result = LE_OK;
 
-    if (apPtr == NULL)
+    if (0 == ClientStartCount)
     {
-        LE_ERROR("Bad reference");
-        return;
+        LE_WARN("The WIFI device is already stopped");
+        return LE_DUPLICATE;
     }
 
-    le_ref_DeleteRef(ScanApRefMap, apRef);
-    le_mem_Release(apPtr);
-}
+    // Only the last client closes the WIFI module
+    if (1 == ClientStartCount)
+    {
+        pa_wifiClient_ClearAllCredentials();
+        CurrentConnection = NULL;
+        LinkInfoCache.isValid = false;
+
+        // The results of the pending scan must not refill the access point table
+        if (IsScanPending)
+        {
+            IsScanCancelled = true;
+        }
+        IsFullScanQueued = false;
+
+        result = pa_wifiClient_Stop();
+        if (LE_OK != result)
+        {
+            LE_ERROR("Unable to stop WIFI client. Err: %d", result);
+        }
+
+        // The access point table is empty: no scan result is recent anymore
+        ReleaseAllAccessPoints();
+        HasScanTime = false;
+        ResetAutoConnect();
+
+        // After ResetAutoConnect(), which updates the scan schedule
+        if (le_timer_IsRunning(ScanTimerRef))
+        {
+            le_timer_Stop(ScanTimerRef);
+        }
+        LE_DEBUG("WIFI client stopped successfully");
+    }
+
+    // Decrement the number of clients calling this stop function
+    if ((LE_OK == result) && (ClientStartCount))
+    {
+        ClientStartCount--;
+    }
 
+    return result;
+}
 
 //--------------------------------------------------------------------------------------------------
 /**
- *  Frees all members of the AddRef and the corresponding AccessPoints added during Scan and
- *  le_wifiClient_Create()
+ * Start a scan limited to some frequencies and/or probing some SSIDs.
+ * Will result in event LE_WIFICLIENT_EVENT_SCAN_DONE when the scan results are available.
+ *
+ * @return
+ *      - LE_OK             Function succeeded.
+ *      - LE_BAD_PARAMETER  No frequency and no SSID, or invalid SSID list.
+ *      - LE_BUSY           Scan already running, including a scan started by le_wifiClient_Scan().
+ *      - LE_FAULT          Function failed.
  */
 //--------------------------------------------------------------------------------------------------
-static void ReleaseAllAccessPoints
+le_result_t le_wifiClientExt_DirectedScan
 (
-    void
+    const uint16_t *frequenciesPtr,
+        ///< [IN]
+        ///< Frequencies to scan (MHz).
+    size_t frequenciesSize,
+        ///< [IN]
+    const uint8_t *ssidsPtr,
+        ///< [IN]
+        ///< SSIDs to probe, each one preceded by its length.
+    size_t ssidsSize
+        ///< [IN]
 )
 {
-    le_wifiClient_AccessPointRef_t apRef = NULL;
-    le_ref_IterRef_t               iter  = le_ref_GetIterator(ScanApRefMap);
+    pa_wifiClient_ScanParams_t params;
+    size_t                     offset = 0;
 
-    LE_DEBUG("Release all AP");
+    if (((frequenciesSize > 0) && (!frequenciesPtr)) || ((ssidsSize > 0) && (!ssidsPtr)))
+    {
+        LE_KILL_CLIENT("Invalid parameter !");
+        return LE_FAULT;
+    }
 
-    while (le_ref_NextNode(iter) == LE_OK)
+    if (((0 == frequenciesSize) && (0 == ssidsSize)) ||
+        (frequenciesSize > PA_WIFICLIENT_SCAN_MAX_FREQUENCIES))
     {
-        apRef = (le_wifiClient_AccessPointRef_t)le_ref_GetSafeRef(iter);
-        if (NULL != apRef)
+        return LE_BAD_PARAMETER;
+    }
+
+    memset(&params, 0, sizeof(params));
+    for (params.frequencyCount = 0; params.frequencyCount < frequenciesSize;
+         params.frequencyCount++)
+    {
+        if (0 == frequenciesPtr[params.frequencyCount])
         {
-            RemoveAccessPoint(apRef);
+            return LE_BAD_PARAMETER;
         }
-        else
+        params.frequencies[params.frequencyCount] = frequenciesPtr[params.frequencyCount];
+    }
+
+    while (offset < ssidsSize)
+    {
+        uint8_t length = ssidsPtr[offset];
+
+        if ((PA_WIFICLIENT_SCAN_MAX_SSIDS == params.ssidCount) ||
+            (length > LE_WIFIDEFS_MAX_SSID_LENGTH) || (offset + 1 + length > ssidsSize))
         {
-            LE_ERROR("ERROR le_ref_GetSafeRef returned NULL iter:%p", iter);
-            return;
+            LE_ERROR("Invalid SSID list");
+            return LE_BAD_PARAMETER;
         }
+        params.ssids[params.ssidCount].length = length;
+        memcpy(params.ssids[params.ssidCount].bytes, &ssidsPtr[offset + 1], length);
+        params.ssidCount++;
+        offset += 1 + length;
+    }
+
+    if (IsScanRunning())
+    {
+        LE_DEBUG("ERROR: Scan already running");
+        return LE_BUSY;
     }
-}
 
+    LE_DEBUG("Directed scan started: %zu frequencies, %zu SSIDs", params.frequencyCount,
+             params.ssidCount);
+    StartScan(SCAN_KIND_DIRECTED, &params);
+    return LE_OK;
+}
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Marks the current access points as old by changing the values for foundInLatestScan
- * and signalStrength.
- * These values will be updated later, if the same AP is still found.
- * This way the new and old AccessPoints can be separated.
+ * Publish the access points cached by the kernel as scan results, without scanning.
+ * Will result in event LE_WIFICLIENT_EVENT_SCAN_DONE when the scan results are available. If a
+ * scan is running, its results are published instead.
  *
+ * @return
+ *      - LE_OK             Function succeeded.
  */
 //--------------------------------------------------------------------------------------------------
-static void MarkAllAccessPointsOld
+le_result_t le_wifiClientExt_CachedScan
 (
     void
 )
 {
-    le_wifiClient_AccessPointRef_t apRef   = NULL;
-    le_ref_IterRef_t               iter    = le_ref_GetIterator(ScanApRefMap);
-    uint32_t                       counter = 0;
+    if (IsScanRunning())
+    {
+        LE_DEBUG("Attached to the running scan");
+        return LE_OK;
+    }
 
-    LE_DEBUG("Mark all AP as old");
+    LE_DEBUG("Cached scan started");
+    StartScan(SCAN_KIND_CACHED, NULL);
+    return LE_OK;
+}
 
-    while (le_ref_NextNode(iter) == LE_OK)
+//--------------------------------------------------------------------------------------------------
+/**
+ * Start Scanning for WiFi Access points
+ * Will result in event LE_WIFICLIENT_EVENT_SCAN_DONE when the scan results are available.
+ *
+ * A call made while a full scan is running is attached to it, and a call made during a directed
+ * or cached scan is served by a full scan started once that scan is done. A call made less than
+ * ScanReuseWindowMs after a full scan is answered from its results, without scanning again. A
+ * scan which fails is reported by the LE_WIFICLIENT_EVENT_SCAN_FAILED event.
+ *
+ * @return
+ *      - LE_OK     Function succeeded.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t le_wifiClient_Scan
+(
+    void
+)
+{
+    if (IsScanRunning())
     {
-        apRef = (le_wifiClient_AccessPointRef_t)le_ref_GetSafeRef(iter);
-        if (NULL != apRef)
+        if ((SCAN_KIND_FULL == PendingScanKind) && (!IsScanCancelled))
         {
-            FoundAccessPoint_t* apPtr = (FoundAccessPoint_t *)le_ref_Lookup(ScanApRefMap, apRef);
-
-            if (apPtr != NULL)
-            {
-                apPtr->accessPoint.signalStrength = LE_WIFICLIENT_NO_SIGNAL_STRENGTH;
-                apPtr->foundInLatestScan = false;
-                LE_DEBUG("Marking %p as old", apRef);
-                counter++;
-            }
-            else
-            {
-                LE_ERROR("Bad reference");
-                return;
-            }
-
+            LE_DEBUG("Attached to the running scan");
         }
         else
         {
-            LE_ERROR("ERROR le_ref_GetSafeRef returned NULL iter:%p", iter);
-            break;
+            LE_DEBUG("Full scan queued after the running scan");
+            IsFullScanQueued = true;
         }
+        return LE_OK;
     }
-    LE_DEBUG("Marked: %d", counter);
-}
 
+    if (GetLastScanAgeMs() < ScanReuseWindowMs)
+    {
+        LE_DEBUG("Scan results reused");
+        ReportScanEvent(LE_OK);
+        return LE_OK;
+    }
+
+    LE_DEBUG("Scan started");
+
+    StartScan(SCAN_KIND_FULL, NULL);
+    return LE_OK;
+}
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Start Scanning for WiFi Access points
- * Will result in an event LE_WIFICLIENT_EVENT_SCAN_DONE when the scan results are available or
- * an event LE_WIFICLIENT_EVENT_SCAN_FAILED if there was an error while scanning.
+ * Get the state of the current link. The driver is only queried when the cached state is older
+ * than LinkInfoTtlMs.
  *
- * @return LE_FAULT         Function failed.
- * @return LE_OK            Function succeeded.
+ * @return
+ *      - LE_OK         The function succeeded.
+ *      - LE_NOT_FOUND  The WiFi client is not connected.
+ *      - LE_FAULT      The function failed.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t GetLinkInfo
+(
+    const pa_wifiClient_LinkInfo_t **linkInfoPtrPtr
+        ///< [OUT]
+        ///< Cached link state, valid until the next call
+)
+{
+    le_clk_Time_t now = le_clk_GetRelativeTime();
+
+    if (LinkInfoCache.isValid)
+    {
+        le_clk_Time_t age = le_clk_Sub(now, LinkInfoCache.timestamp);
+
+        if ((uint64_t)age.sec * 1000 + age.usec / 1000 < LinkInfoTtlMs)
+        {
+            *linkInfoPtrPtr = &LinkInfoCache.info;
+            return LinkInfoCache.result;
+        }
+    }
+
+    LinkInfoCache.result = pa_wifiClient_GetLinkInfo(&LinkInfoCache.info);
+    LinkInfoCache.timestamp = now;
+    LinkInfoCache.isValid = true;
+    if ((LE_OK != LinkInfoCache.result) && (LE_NOT_FOUND != LinkInfoCache.result))
+    {
+        LE_ERROR("ERROR: Failed to get the link state");
+        // Retry on the next call
+        LinkInfoCache.isValid = false;
+        LinkInfoCache.result = LE_FAULT;
+    }
+
+    *linkInfoPtrPtr = &LinkInfoCache.info;
+    return LinkInfoCache.result;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Roaming engine timer handler: once the dwell time is over, start a scan for the SSID of the
+ * link when its signal is below RoamRssiThresholdDbm, and time out the reassociations.
  */
 //--------------------------------------------------------------------------------------------------
-static void *ScanThread
+static void RoamTimerHandler
 (
-    void *contextPtr
+    le_timer_Ref_t timerRef
 )
 {
-    pa_wifiClient_AccessPoint_t accessPoint;
-    le_result_t                 *scanResultPtr = contextPtr;
-    le_result_t                 paResult    = pa_wifiClient_Scan();
+    const pa_wifiClient_LinkInfo_t *linkInfoPtr;
+    pa_wifiClient_ScanParams_t      params;
+    int16_t                         signal;
 
-    if (LE_OK != paResult)
+    if ((!RoamEnabled) || (NULL == CurrentConnection))
     {
-        LE_ERROR("Scan failed (%d)", paResult);
-        *scanResultPtr = LE_FAULT;
-        return NULL;
+        Roam.state = ROAM_STATE_IDLE;
+        le_timer_Stop(timerRef);
+        return;
     }
 
-    FoundWifiApCount = 0;
-
-    MarkAllAccessPointsOld();
-    memset(scanIfName, 0, LE_WIFIDEFS_MAX_IFNAME_BYTES);
-    while (LE_OK == (paResult = pa_wifiClient_GetScanResult(&accessPoint, scanIfName)))
+    if (ROAM_STATE_REASSOCIATING == Roam.state)
     {
-        if (AddAccessPointToApRefMap(&accessPoint) == NULL)
+        if (GetElapsedMs(Roam.holdTime) >= ROAM_TIMEOUT_MS)
         {
-            LE_ERROR("pa_wifiClient_ScanDone() failed");
-            paResult = LE_FAULT;
-            break;
+            ReportRoam(LE_TIMEOUT);
         }
+        return;
     }
 
-    *scanResultPtr = ((paResult == LE_OK) || (paResult == LE_NOT_FOUND)) ? LE_OK : paResult;
+    // Another scan may hold results older than the weak link detection: check again after it
+    if ((ROAM_STATE_IDLE != Roam.state) || IsScanPending ||
+        (GetElapsedMs(Roam.holdTime) < (uint64_t)RoamDwellMs))
+    {
+        return;
+    }
 
-    paResult = pa_wifiClient_ScanDone();
-    if (LE_OK != paResult)
+    if (LE_OK != GetLinkInfo(&linkInfoPtr))
     {
-        LE_ERROR("pa_wifiClient_ScanDone() failed (%d)", paResult);
-        *scanResultPtr = paResult;
+        return;
+    }
+    signal = linkInfoPtr->accessPoint.signalStrength;
+    if ((LE_WIFICLIENT_NO_SIGNAL_STRENGTH == signal) || (signal >= RoamRssiThresholdDbm))
+    {
+        return;
     }
 
-    return NULL;
-}
+    LE_INFO("Weak link to %s (%d dBm), looking for a better access point",
+            linkInfoPtr->accessPoint.bssid, signal);
+    Roam.state = ROAM_STATE_SCANNING;
+    Roam.startTime = le_clk_GetRelativeTime();
+    Roam.signal = signal;
+    Roam.ssid.length = linkInfoPtr->accessPoint.ssidLength;
+    memcpy(Roam.ssid.bytes, linkInfoPtr->accessPoint.ssidBytes, Roam.ssid.length);
+    memset(&Roam.report, 0, sizeof(Roam.report));
+    le_utf8_Copy(Roam.report.fromBssid, linkInfoPtr->accessPoint.bssid,
+                 sizeof(Roam.report.fromBssid), NULL);
+
+    if (Roam.isFullScanNeeded)
+    {
+        StartScan(SCAN_KIND_FULL, NULL);
+        return;
+    }
 
+    // Probe the SSID on all the channels
+    memset(&params, 0, sizeof(params));
+    params.ssids[0].length = Roam.ssid.length;
+    memcpy(params.ssids[0].bytes, Roam.ssid.bytes, Roam.ssid.length);
+    params.ssidCount = 1;
+    StartScan(SCAN_KIND_DIRECTED, &params);
+}
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Thread Destructor for scan
+ * Get results of access point which is currently connecting.
+ *
+ * @return
+ *      - LE_OK     The function succeeded.
+ *      - LE_FAULT  The function failed.
  */
 //--------------------------------------------------------------------------------------------------
-static void ScanThreadDestructor
+static le_result_t GetLinkResult
 (
-    void *context
+    pa_wifiClient_AccessPoint_t *accessPoint
+        ///< [OUT]
+        ///< The data of access point
 )
 {
-    le_result_t scanResult = *((le_result_t*)context);
-
-    LE_DEBUG("Destruct scan thread");
-    ScanThreadRef = NULL;
-    le_wifiClient_EventInd_t* wifiEventIndicationPtr = le_mem_ForceAlloc(WifiEventPool);
+    const pa_wifiClient_LinkInfo_t *linkInfoPtr;
 
-    if (scanResult == LE_OK)
+    if (!accessPoint)
     {
-        wifiEventIndicationPtr->event = LE_WIFICLIENT_EVENT_SCAN_DONE;
+        LE_KILL_CLIENT("accessPoint is NULL !");
+        return LE_FAULT;
     }
-    else
+
+    if (LE_OK != GetLinkInfo(&linkInfoPtr))
     {
-        LE_WARN("Scan failed");
-        wifiEventIndicationPtr->event = LE_WIFICLIENT_EVENT_SCAN_FAILED;
+        return LE_FAULT;
     }
 
-    wifiEventIndicationPtr->disconnectionCause = LE_WIFICLIENT_UNKNOWN_CAUSE;
-    strncpy(wifiEventIndicationPtr->ifName, scanIfName, LE_WIFIDEFS_MAX_IFNAME_LENGTH);
-    wifiEventIndicationPtr->ifName[LE_WIFIDEFS_MAX_IFNAME_LENGTH] = '\0';
-    wifiEventIndicationPtr->apBssid[0] = '\0';
-    PaEventIndicationHandler(wifiEventIndicationPtr, NULL);
-
-    PaEventHandler(wifiEventIndicationPtr->event, NULL);
+    *accessPoint = linkInfoPtr->accessPoint;
+    return LE_OK;
 }
 
-
 //--------------------------------------------------------------------------------------------------
 /**
- * Handler function to the close session service to detect if the application crashed.
+ * Get signal strength of access point which is currently connecting.
  *
+ * @return
+ *      - LE_OK     The function succeeded.
+ *      - LE_FAULT  The function failed.
  */
 //--------------------------------------------------------------------------------------------------
-static void CloseSessionEventHandler
+le_result_t le_wifiClient_GetCurrentSignalStrength
 (
-    le_msg_SessionRef_t  sessionRef,
-    void                *contextPtr
+    int16_t *signalStrength
+        ///< [OUT]
+        ///< The signal strength
 )
 {
-    if (sessionRef == GetFirstSessionRef)
+    if (!signalStrength)
     {
-        GetFirstSessionRef = NULL;
+        LE_KILL_CLIENT("signalStrength is NULL !");
+        return LE_FAULT;
     }
-}
 
+    pa_wifiClient_AccessPoint_t accessPoint;
+    LE_DEBUG("Get current signal strength");
+    if (LE_OK != GetLinkResult(&accessPoint))
+    {
+        return LE_FAULT;
+    }
+    *signalStrength = accessPoint.signalStrength;
+
+    return LE_OK;
+}
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Is Scan running. Checks if the ScanThread is still running
+ * Get RX data of access point which is currently connecting.
+ *
+ * @return
+ *      - LE_OK     The function succeeded.
+ *      - LE_FAULT  The function failed.
  */
 //--------------------------------------------------------------------------------------------------
-static bool IsScanRunning(void)
+le_result_t le_wifiClient_GetRxData
+(
+    uint64_t *rxData
+        ///< [OUT]
+        ///< The rx data
+)
 {
-    LE_DEBUG("IsScanRunning .%d", (NULL != ScanThreadRef));
-    return (NULL != ScanThreadRef);
+    if (!rxData)
+    {
+        LE_KILL_CLIENT("rxBytes is NULL !");
+        return LE_FAULT;
+    }
+
+    pa_wifiClient_AccessPoint_t accessPoint;
+    LE_DEBUG("Get rx data");
+    if (LE_OK != GetLinkResult(&accessPoint))
+    {
+        return LE_FAULT;
+    }
+    *rxData = accessPoint.rx;
+
+    return LE_OK;
 }
 
 //--------------------------------------------------------------------------------------------------
 /**
- * The first-layer WiFi Client Event Handler.
- *
- * @deprecated le_wifiClient_AddNewEventHandler() should not be used anymore.
+ * Get TX data of access point which is currently connecting.
  *
- * It has been replaced by le_wifiClient_AddConnectionEventHandler().
+ * @return
+ *       - LE_OK     The function succeeded.
+ *       - LE_FAULT  The function failed.
  */
 //--------------------------------------------------------------------------------------------------
-static void FirstLayerWifiClientEventHandler
+le_result_t le_wifiClient_GetTxData
 (
-    void *reportPtr,
-    void *secondLayerHandlerFunc
+    uint64_t *txData
+        ///< [OUT]
+        ///< The tx data
 )
 {
-    le_wifiClient_NewEventHandlerFunc_t  clientHandlerFunc = secondLayerHandlerFunc;
-    le_wifiClient_Event_t               *wifiEventPtr      = (le_wifiClient_Event_t *)reportPtr;
-
-    if (NULL != wifiEventPtr)
+    if (!txData)
     {
-        LE_DEBUG("Event: %d", *wifiEventPtr);
-        clientHandlerFunc(*wifiEventPtr, le_event_GetContextPtr());
+        LE_KILL_CLIENT("txBytes is NULL !");
+        return LE_FAULT;
     }
-    else
+
+    pa_wifiClient_AccessPoint_t accessPoint;
+    LE_DEBUG("Get tx data");
+    if (LE_OK != GetLinkResult(&accessPoint))
     {
-        LE_ERROR("Event is NULL");
+        return LE_FAULT;
     }
+    *txData = accessPoint.tx;
+
+    return LE_OK;
 }
 
 //--------------------------------------------------------------------------------------------------
 /**
- * The first-layer WiFi Client Connection Event Handler.
+ * Get the state of the current connection.
  *
+ * @return
+ *      - LE_OK             Function succeeded.
+ *      - LE_NOT_FOUND      The WiFi client is not connected.
+ *      - LE_OVERFLOW       The BSSID or SSID buffer is too small.
+ *      - LE_FAULT          Function failed.
  */
 //--------------------------------------------------------------------------------------------------
-static void FirstLayerWifiClientConnectionEventHandler
+le_result_t le_wifiClientExt_GetLinkInfo
 (
-    void *reportPtr,
-    void *secondLayerHandlerFunc
+    int16_t *signalStrengthPtr,
+        ///< [OUT]
+        ///< Signal strength in dBm.
+    uint64_t *rxBytesPtr,
+        ///< [OUT]
+        ///< Received bytes.
+    uint64_t *txBytesPtr,
+        ///< [OUT]
+        ///< Sent bytes.
+    uint32_t *rxBitratePtr,
+        ///< [OUT]
+        ///< RX bitrate (kbit/s), 0 if unknown.
+    uint32_t *txBitratePtr,
+        ///< [OUT]
+        ///< TX bitrate (kbit/s), 0 if unknown.
+    uint32_t *frequencyPtr,
+        ///< [OUT]
+        ///< Frequency (MHz).
+    char *bssid,
+        ///< [OUT]
+        ///< BSSID of the access point.
+    size_t bssidSize,
+        ///< [IN]
+    uint8_t *ssidPtr,
+        ///< [OUT]
+        ///< SSID of the access point.
+    size_t *ssidSizePtr
+        ///< [INOUT]
 )
 {
-    le_wifiClient_EventInd_t*  wifiEventPtr = reportPtr;
-    le_wifiClient_ConnectionEventHandlerFunc_t  clientHandlerFunc = secondLayerHandlerFunc;
+    const pa_wifiClient_LinkInfo_t *linkInfoPtr;
+    le_result_t                     result;
 
+    if ((!signalStrengthPtr) || (!rxBytesPtr) || (!txBytesPtr) || (!rxBitratePtr) ||
+        (!txBitratePtr) || (!frequencyPtr) || (!bssid) || (!ssidPtr) || (!ssidSizePtr))
+    {
+        LE_KILL_CLIENT("Invalid parameter !");
+        return LE_FAULT;
+    }
 
-    if (NULL != wifiEventPtr)
+    LE_DEBUG("Get link info");
+    result = GetLinkInfo(&linkInfoPtr);
+    if (LE_OK != result)
     {
-        clientHandlerFunc(wifiEventPtr, le_event_GetContextPtr());
+        return result;
     }
-    else
+
+    if (*ssidSizePtr < linkInfoPtr->accessPoint.ssidLength)
     {
-        LE_WARN("wifiEventPtr is NULL");
+        return LE_OVERFLOW;
     }
-    // The reportPtr is a reference counted object, so need to release it
-    le_mem_Release(reportPtr);
+    if (LE_OK != le_utf8_Copy(bssid, linkInfoPtr->accessPoint.bssid, bssidSize, NULL))
+    {
+        return LE_OVERFLOW;
+    }
+
+    *signalStrengthPtr = linkInfoPtr->accessPoint.signalStrength;
+    *rxBytesPtr = linkInfoPtr->accessPoint.rx;
+    *txBytesPtr = linkInfoPtr->accessPoint.tx;
+    *rxBitratePtr = linkInfoPtr->rxBitrate;
+    *txBitratePtr = linkInfoPtr->txBitrate;
+    *frequencyPtr = linkInfoPtr->frequency;
+    memcpy(ssidPtr, linkInfoPtr->accessPoint.ssidBytes, linkInfoPtr->accessPoint.ssidLength);
+    *ssidSizePtr = linkInfoPtr->accessPoint.ssidLength;
+
+    return LE_OK;
 }
 
 //--------------------------------------------------------------------------------------------------
 /**
- * returns the value of the field "foundInLatestScan"
- * This is used to determine if a Ref was found in the last scan or not.
+ * Write an access point as a packed scan entry (see le_wifiClientExt_GetScanResults()).
  */
 //--------------------------------------------------------------------------------------------------
-static bool WasApFoundInLastScan
+static void PackScanEntry
 (
-    le_wifiClient_AccessPointRef_t apRef
+    const pa_wifiClient_AccessPoint_t *apPtr,
         ///< [IN]
-        ///< WiFi Access Point reference.
+        ///< Access point
+    le_clk_Time_t                      lastSeen,
+        ///< [IN]
+        ///< Time at which the access point was last seen
+    uint8_t                           *entryPtr
+        ///< [OUT]
+        ///< Entry of LE_WIFICLIENTEXT_SCAN_ENTRY_BYTES bytes
 )
 {
-    FoundAccessPoint_t *apPtr = (FoundAccessPoint_t *)le_ref_Lookup(ScanApRefMap, apRef);
+    uint8_t *bssidPtr = &entryPtr[LE_WIFICLIENTEXT_SCAN_ENTRY_BSSID_OFFSET];
+    uint8_t *signalPtr = &entryPtr[LE_WIFICLIENTEXT_SCAN_ENTRY_SIGNAL_OFFSET];
+    uint8_t *frequencyPtr = &entryPtr[LE_WIFICLIENTEXT_SCAN_ENTRY_FREQUENCY_OFFSET];
+    uint8_t *agePtr = &entryPtr[LE_WIFICLIENTEXT_SCAN_ENTRY_AGE_OFFSET];
+    uint64_t ageMs = GetElapsedMs(lastSeen);
+    uint8_t  security = 0;
 
-    if (apPtr == NULL)
+    memset(entryPtr, 0, LE_WIFICLIENTEXT_SCAN_ENTRY_BYTES);
+
+    if (6 != sscanf(apPtr->bssid, "%hhx:%hhx:%hhx:%hhx:%hhx:%hhx", &bssidPtr[0], &bssidPtr[1],
+                    &bssidPtr[2], &bssidPtr[3], &bssidPtr[4], &bssidPtr[5]))
     {
-        LE_ERROR("Bad reference");
-        return false;
+        memset(bssidPtr, 0, 6);
     }
 
-    return apPtr->foundInLatestScan;
-}
+    signalPtr[0] = (uint16_t)apPtr->signalStrength & 0xFF;
+    signalPtr[1] = (uint16_t)apPtr->signalStrength >> 8;
+    frequencyPtr[0] = apPtr->frequency & 0xFF;
+    frequencyPtr[1] = apPtr->frequency >> 8;
+
+    if (apPtr->securityFlags & PA_WIFICLIENT_SCAN_SECURITY_PRIVACY)
+    {
+        security |= LE_WIFICLIENTEXT_SCAN_SECURITY_PRIVACY;
+    }
+    if (apPtr->securityFlags & PA_WIFICLIENT_SCAN_SECURITY_WPA)
+    {
+        security |= LE_WIFICLIENTEXT_SCAN_SECURITY_WPA;
+    }
+    if (apPtr->securityFlags & PA_WIFICLIENT_SCAN_SECURITY_WPA2)
+    {
+        security |= LE_WIFICLIENTEXT_SCAN_SECURITY_WPA2;
+    }
+    if (apPtr->securityFlags & PA_WIFICLIENT_SCAN_SECURITY_EAP)
+    {
+        security |= LE_WIFICLIENTEXT_SCAN_SECURITY_EAP;
+    }
+    entryPtr[LE_WIFICLIENTEXT_SCAN_ENTRY_SECURITY_OFFSET] = security;
 
+    entryPtr[LE_WIFICLIENTEXT_SCAN_ENTRY_SSID_LENGTH_OFFSET] = apPtr->ssidLength;
+    memcpy(&entryPtr[LE_WIFICLIENTEXT_SCAN_ENTRY_SSID_OFFSET], apPtr->ssidBytes,
+           apPtr->ssidLength);
+
+    if (ageMs > UINT32_MAX)
+    {
+        ageMs = UINT32_MAX;
+    }
+    agePtr[0] = ageMs & 0xFF;
+    agePtr[1] = (ageMs >> 8) & 0xFF;
+    agePtr[2] = (ageMs >> 16) & 0xFF;
+    agePtr[3] = (ageMs >> 24) & 0xFF;
+}
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Add handler function for EVENT 'le_wifiClient_NewEvent'
- *
- * This event provide information on Wifi Client event changes.
- *
- * @deprecated le_wifiClient_AddNewEventHandler() should not be used anymore.
+ * Get a page of the access points found by the last scan, as packed entries.
  *
- * It has been replaced by le_wifiClient_AddConnectionEventHandler().
+ * @return
+ *      - LE_OK             Function succeeded.
+ *      - LE_OUT_OF_RANGE   startIndex is greater than totalCount.
+ *      - LE_FAULT          Function failed.
  */
 //--------------------------------------------------------------------------------------------------
-le_wifiClient_NewEventHandlerRef_t le_wifiClient_AddNewEventHandler
+le_result_t le_wifiClientExt_GetScanResults
 (
-    le_wifiClient_NewEventHandlerFunc_t handlerFuncPtr,
+    uint32_t startIndex,
         ///< [IN]
-        ///< Event handling function
+        ///< Index of the first entry to return.
+    uint32_t *scanIdPtr,
+        ///< [OUT]
+        ///< Identifier of the scan.
+    uint32_t *totalCountPtr,
+        ///< [OUT]
+        ///< Number of access points found.
+    uint8_t *entriesPtr,
+        ///< [OUT]
+        ///< Packed entries.
+    size_t *entriesSizePtr
+        ///< [INOUT]
+)
+{
+    le_dls_Link_t *linkPtr;
+    uint32_t       index = 0;
+    size_t         pageSize = 0;
 
-    void *contextPtr
+    if ((!scanIdPtr) || (!totalCountPtr) || (!entriesPtr) || (!entriesSizePtr))
+    {
+        LE_KILL_CLIENT("Invalid parameter !");
+        return LE_FAULT;
+    }
+
+    for (linkPtr = le_dls_Peek(&LatestScanList);
+         NULL != linkPtr;
+         linkPtr = le_dls_PeekNext(&LatestScanList, linkPtr))
+    {
+        const FoundAccessPoint_t *apPtr = CONTAINER_OF(linkPtr, FoundAccessPoint_t, latestLink);
+
+        if ((index >= startIndex) &&
+            (pageSize + LE_WIFICLIENTEXT_SCAN_ENTRY_BYTES <= *entriesSizePtr))
+        {
+            PackScanEntry(&apPtr->accessPoint, apPtr->lastSeen, &entriesPtr[pageSize]);
+            pageSize += LE_WIFICLIENTEXT_SCAN_ENTRY_BYTES;
+        }
+        index++;
+    }
+
+    if (startIndex > index)
+    {
+        return LE_OUT_OF_RANGE;
+    }
+
+    LE_DEBUG("Scan %u: %zu entries from %u of %u", ScanId,
+             pageSize / LE_WIFICLIENTEXT_SCAN_ENTRY_BYTES, startIndex, index);
+
+    *scanIdPtr = ScanId;
+    *totalCountPtr = index;
+    *entriesSizePtr = pageSize;
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get a page of the changes found by the last scan, as packed entries.
+ *
+ * @return
+ *      - LE_OK             Function succeeded.
+ *      - LE_OUT_OF_RANGE   startIndex is greater than totalCount.
+ *      - LE_FAULT          Function failed.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t le_wifiClientExt_GetScanChanges
+(
+    uint32_t startIndex,
         ///< [IN]
-        ///< Associated event context
+        ///< Index of the first change to return.
+    uint32_t *scanIdPtr,
+        ///< [OUT]
+        ///< Identifier of the scan.
+    uint32_t *totalCountPtr,
+        ///< [OUT]
+        ///< Number of changes.
+    uint8_t *changesPtr,
+        ///< [OUT]
+        ///< ScanChange of each entry.
+    size_t *changesSizePtr,
+        ///< [INOUT]
+    uint8_t *entriesPtr,
+        ///< [OUT]
+        ///< Packed entries.
+    size_t *entriesSizePtr
+        ///< [INOUT]
 )
 {
-    le_event_HandlerRef_t handlerRef;
+    le_dls_Link_t *linkPtr;
+    uint32_t       index = 0;
+    size_t         count = 0;
+
+    if ((!scanIdPtr) || (!totalCountPtr) || (!changesPtr) || (!changesSizePtr) ||
+        (!entriesPtr) || (!entriesSizePtr))
+    {
+        LE_KILL_CLIENT("Invalid parameter !");
+        return LE_FAULT;
+    }
 
-    // Note: THIS ONE REGISTERS THE CB function..
-    LE_DEBUG("Add new event handler");
+    for (linkPtr = le_dls_Peek(&ScanChangeList);
+         NULL != linkPtr;
+         linkPtr = le_dls_PeekNext(&ScanChangeList, linkPtr))
+    {
+        const ScanChangeEntry_t *entryPtr = CONTAINER_OF(linkPtr, ScanChangeEntry_t, link);
 
-    if (handlerFuncPtr == NULL)
+        if ((index >= startIndex) && (count < *changesSizePtr) &&
+            ((count + 1) * LE_WIFICLIENTEXT_SCAN_ENTRY_BYTES <= *entriesSizePtr))
+        {
+            changesPtr[count] = entryPtr->change;
+            PackScanEntry(&entryPtr->accessPoint, entryPtr->lastSeen,
+                          &entriesPtr[count * LE_WIFICLIENTEXT_SCAN_ENTRY_BYTES]);
+            count++;
+        }
+        index++;
+    }
+
+    if (startIndex > index)
     {
-        LE_KILL_CLIENT("handlerFuncPtr is NULL !");
-        return NULL;
+        return LE_OUT_OF_RANGE;
     }
 
-    handlerRef = le_event_AddLayeredHandler("NewWiFiClientMsgHandler",
-                                            WifiEventId,
-                                            FirstLayerWifiClientEventHandler,
-                                            (le_event_HandlerFunc_t)handlerFuncPtr);
+    *scanIdPtr = ScanChanges.scanId;
+    *totalCountPtr = index;
+    *changesSizePtr = count;
+    *entriesSizePtr = count * LE_WIFICLIENTEXT_SCAN_ENTRY_BYTES;
+    return LE_OK;
+}
 
-    le_event_SetContextPtr(handlerRef, contextPtr);
+//--------------------------------------------------------------------------------------------------
+/**
+ * The first-layer ScanChanges event handler.
+ */
+//--------------------------------------------------------------------------------------------------
+static void FirstLayerScanChangesHandler
+(
+    void *reportPtr,
+    void *secondLayerHandlerFunc
+)
+{
+    const ScanChangesReport_t                 *changesPtr = reportPtr;
+    le_wifiClientExt_ScanChangesHandlerFunc_t  clientHandlerFunc = secondLayerHandlerFunc;
 
-    return (le_wifiClient_NewEventHandlerRef_t)(handlerRef);
+    clientHandlerFunc(changesPtr->scanId, changesPtr->addedCount, changesPtr->removedCount,
+                      changesPtr->updatedCount, le_event_GetContextPtr());
 }
 
 //--------------------------------------------------------------------------------------------------
 /**
- * This function must be called to register an handler for WiFi connection state change.
- *
- * @return A handler reference, which is only needed for later removal of the handler.
+ * Add handler function for EVENT 'le_wifiClientExt_ScanChanges'
  *
- * @note Doesn't return on failure, so there's no need to check the return value for errors.
+ * This event reports the number of changes found by each completed scan.
  */
 //--------------------------------------------------------------------------------------------------
-le_wifiClient_ConnectionEventHandlerRef_t le_wifiClient_AddConnectionEventHandler
+le_wifiClientExt_ScanChangesHandlerRef_t le_wifiClientExt_AddScanChangesHandler
 (
-    le_wifiClient_ConnectionEventHandlerFunc_t handlerFuncPtr,
+    le_wifiClientExt_ScanChangesHandlerFunc_t handlerFuncPtr,
         ///< [IN]
         ///< Event handling function
 
@@ -732,319 +3844,259 @@ le_wifiClient_ConnectionEventHandlerRef_t le_wifiClient_AddConnectionEventHandle
 {
     le_event_HandlerRef_t handlerRef;
 
-    // Note: THIS ONE REGISTERS THE CB function..
-    LE_DEBUG("Add wifi connection event handler");
-
     if (handlerFuncPtr == NULL)
     {
         LE_KILL_CLIENT("handlerFuncPtr is NULL !");
         return NULL;
     }
 
-    handlerRef = le_event_AddLayeredHandler("WiFiClientMsgHandler",
-                                            WifiEventIndicationId,
-                                            FirstLayerWifiClientConnectionEventHandler,
+    handlerRef = le_event_AddLayeredHandler("WiFiScanChangesHandler",
+                                            ScanChangesEventId,
+                                            FirstLayerScanChangesHandler,
                                             (le_event_HandlerFunc_t)handlerFuncPtr);
 
     le_event_SetContextPtr(handlerRef, contextPtr);
 
-    return (le_wifiClient_ConnectionEventHandlerRef_t)(handlerRef);
+    return (le_wifiClientExt_ScanChangesHandlerRef_t)(handlerRef);
 }
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Remove handler function for EVENT 'le_wifiClient_NewEvent'
- *
- * @deprecated le_wifiClient_AddNewEventHandler() should not be used anymore.
- *
- * It has been replaced by le_wifiClient_AddConnectionEventHandler().
+ * Remove handler function for EVENT 'le_wifiClientExt_ScanChanges'
  */
 //--------------------------------------------------------------------------------------------------
-void le_wifiClient_RemoveNewEventHandler
+void le_wifiClientExt_RemoveScanChangesHandler
 (
-    le_wifiClient_NewEventHandlerRef_t handlerRef
+    le_wifiClientExt_ScanChangesHandlerRef_t handlerRef
         ///< [IN]
         ///< Reference of the event handler to remove
 )
 {
-    LE_DEBUG("Remove event handler");
     le_event_RemoveHandler((le_event_HandlerRef_t)handlerRef);
 }
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Remove handler function for EVENT 'le_wifiClient_ConnectionEvent'
+ * The first-layer Roam event handler.
  */
 //--------------------------------------------------------------------------------------------------
-void le_wifiClient_RemoveConnectionEventHandler
+static void FirstLayerRoamHandler
 (
-    le_wifiClient_ConnectionEventHandlerRef_t handlerRef
-        ///< [IN]
-        ///< Reference of the event handler to remove
+    void *reportPtr,
+    void *secondLayerHandlerFunc
 )
 {
-    LE_DEBUG("Remove event handler");
-    le_event_RemoveHandler((le_event_HandlerRef_t)handlerRef);
+    const RoamReport_t                 *roamPtr = reportPtr;
+    le_wifiClientExt_RoamHandlerFunc_t  clientHandlerFunc = secondLayerHandlerFunc;
+
+    clientHandlerFunc(roamPtr->fromBssid, roamPtr->toBssid, roamPtr->result,
+                      roamPtr->timeToRoamMs, le_event_GetContextPtr());
 }
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Starts the WIFI device.
+ * Add handler function for EVENT 'le_wifiClientExt_Roam'
  *
- * @return
- *      - LE_OK             Function succeeded.
- *      - LE_FAULT          Function failed.
- *      - LE_BUSY           The WiFi device is already started.
- *      - LE_NOT_FOUND      The WiFi device is absent.
- *      - LE_UNAVAILABLE    The WiFi device may not work.
+ * This event reports each roam attempt of the roaming engine.
  */
 //--------------------------------------------------------------------------------------------------
-le_result_t le_wifiClient_Start
+le_wifiClientExt_RoamHandlerRef_t le_wifiClientExt_AddRoamHandler
 (
-    void
+    le_wifiClientExt_RoamHandlerFunc_t handlerFuncPtr,
+        ///< [IN]
+        ///< Event handling function
+
+    void *contextPtr
+        ///< [IN]
+        ///< Associated event context
 )
 {
-    le_result_t result;
+    le_event_HandlerRef_t handlerRef;
 
-    // Only the first client starts the WIFI module
-    if (!ClientStartCount)
-    {
-        result = pa_wifiClient_Start();
-        if (LE_OK == result)
-        {
-            LE_DEBUG("WIFI client started successfully");
-            // Increment the number of clients calling this start function
-            ClientStartCount++;
-        }
-        else
-        {
-            LE_WARN("Unable to start WIFI client; return code: %d", result);
-        }
-    }
-    else
+    if (handlerFuncPtr == NULL)
     {
-        LE_WARN("WIFI client already started");
-        // Increment the number of clients calling this start function
-        ClientStartCount++;
-        result = LE_BUSY;
+        LE_KILL_CLIENT("handlerFuncPtr is NULL !");
+        return NULL;
     }
 
-    return result;
+    handlerRef = le_event_AddLayeredHandler("WiFiRoamHandler",
+                                            RoamEventId,
+                                            FirstLayerRoamHandler,
+                                            (le_event_HandlerFunc_t)handlerFuncPtr);
+
+    le_event_SetContextPtr(handlerRef, contextPtr);
+
+    return (le_wifiClientExt_RoamHandlerRef_t)(handlerRef);
 }
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Stops the WIFI device.
- *
- * @return
- *      - LE_OK        Function succeeded.
- *      - LE_FAULT     Function failed.
- *      - LE_DUPLICATE The WIFI device is already stopped.
- *
+ * Remove handler function for EVENT 'le_wifiClientExt_Roam'
  */
 //--------------------------------------------------------------------------------------------------
-le_result_t le_wifiClient_Stop
+void le_wifiClientExt_RemoveRoamHandler
 (
-    void
+    le_wifiClientExt_RoamHandlerRef_t handlerRef
+        ///< [IN]
+        ///< Reference of the event handler to remove
 )
 {
-    le_result_t result = LE_OK;
-
-    if (0 == ClientStartCount)
-    {
-        LE_WARN("The WIFI device is already stopped");
-        return LE_DUPLICATE;
-    }
-
-    // Only the last client closes the WIFI module
-    if (1 == ClientStartCount)
-    {
-        pa_wifiClient_ClearAllCredentials();
-        CurrentConnection = NULL;
-
-        result = pa_wifiClient_Stop();
-        if (LE_OK != result)
-        {
-            LE_ERROR("Unable to stop WIFI client. Err: %d", result);
-        }
-
-        ReleaseAllAccessPoints();
-        LE_DEBUG("WIFI client stopped successfully");
-    }
-
-    // Decrement the number of clients calling this stop function
-    if ((LE_OK == result) && (ClientStartCount))
-    {
-        ClientStartCount--;
-    }
-
-    return result;
+    le_event_RemoveHandler((le_event_HandlerRef_t)handlerRef);
 }
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Start Scanning for WiFi Access points
- * Will result in event LE_WIFICLIENT_EVENT_SCAN_DONE when the scan results are available.
+ * Get the size and the eviction counters of the access point table.
  *
  * @return
- *      - LE_OK     Function succeeded.
- *      - LE_FAULT  Function failed.
- *      - LE_BUSY   Scan already running.
+ *      - LE_OK             Function succeeded.
+ *      - LE_FAULT          Function failed.
  */
 //--------------------------------------------------------------------------------------------------
-le_result_t le_wifiClient_Scan
+le_result_t le_wifiClientExt_GetApTableStats
 (
-    void
+    uint32_t *countPtr,
+        ///< [OUT]
+        ///< Number of access points in the table.
+    uint32_t *maxCountPtr,
+        ///< [OUT]
+        ///< Configured maximum number of access points, 0 if unlimited.
+    uint32_t *agedOutCountPtr,
+        ///< [OUT]
+        ///< Number of access points removed for their age.
+    uint32_t *evictedCountPtr
+        ///< [OUT]
+        ///< Number of access points removed for the table size.
 )
 {
-    if (!IsScanRunning())
-    {
-        LE_DEBUG("Scan started");
-
-        // Start the thread
-        ScanResult = LE_OK;
-        ScanThreadRef = le_thread_Create("WiFi Client Scan Thread", ScanThread, &ScanResult);
-        le_thread_AddChildDestructor(ScanThreadRef, ScanThreadDestructor, &ScanResult);
-
-        le_thread_Start(ScanThreadRef);
-        return LE_OK;
-    }
-    else
+    if ((!countPtr) || (!maxCountPtr) || (!agedOutCountPtr) || (!evictedCountPtr))
     {
-        LE_DEBUG("ERROR: Scan already running");
-        return LE_BUSY;
+        LE_KILL_CLIENT("Invalid parameter !");
+        return LE_FAULT;
     }
+
+    *countPtr = AccessPointCount;
+    *maxCountPtr = ApTableMax;
+    *agedOutCountPtr = AgedOutCount;
+    *evictedCountPtr = EvictedCount;
+    return LE_OK;
 }
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Get results of access point which is currently connecting.
+ * Get the time taken by the last start of the WiFi device.
  *
  * @return
- *      - LE_OK     The function succeeded.
- *      - LE_FAULT  The function failed.
+ *      - LE_OK             Function succeeded.
+ *      - LE_UNAVAILABLE    The WiFi device was not started yet.
+ *      - LE_FAULT          Function failed.
  */
 //--------------------------------------------------------------------------------------------------
-static le_result_t GetLinkResult
+le_result_t le_wifiClientExt_GetStartStats
 (
-    pa_wifiClient_AccessPoint_t *accessPoint
+    uint32_t *interfaceUpMsPtr
         ///< [OUT]
-        ///< The data of access point
+        ///< Time until the WLAN interface was up (ms).
 )
 {
-    if (!accessPoint)
-    {
-        LE_KILL_CLIENT("accessPoint is NULL !");
-        return LE_FAULT;
-    }
-
-    memset(scanIfName, 0, LE_WIFIDEFS_MAX_IFNAME_BYTES);
-    if (LE_OK != pa_wifiClient_GetLinkResult(accessPoint,scanIfName))
+    if (!interfaceUpMsPtr)
     {
-        LE_ERROR("ERORR: Failed to get data from iw command");
+        LE_KILL_CLIENT("Invalid parameter !");
         return LE_FAULT;
     }
 
-    return LE_OK;
+    return pa_wifiClient_GetStartLatency(interfaceUpMsPtr);
 }
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Get signal strength of access point which is currently connecting.
+ * Request periodic scans: the scan scheduler keeps the scan results younger than maxAgeMs, with
+ * one scan serving all the requests.
  *
  * @return
- *      - LE_OK     The function succeeded.
- *      - LE_FAULT  The function failed.
+ *      - Reference of the request.
+ *      - NULL if maxAgeMs is 0.
  */
 //--------------------------------------------------------------------------------------------------
-le_result_t le_wifiClient_GetCurrentSignalStrength
+le_wifiClientExt_ScanRequestRef_t le_wifiClientExt_AddScanRequest
 (
-    int16_t *signalStrength
-        ///< [OUT]
-        ///< The signal strength
+    uint32_t maxAgeMs
+        ///< [IN]
+        ///< Maximum age of the scan results (ms).
 )
 {
-    if (!signalStrength)
-    {
-        LE_KILL_CLIENT("signalStrength is NULL !");
-        return LE_FAULT;
-    }
+    ScanRequest_t *requestPtr;
 
-    pa_wifiClient_AccessPoint_t accessPoint;
-    LE_DEBUG("Get current signal strength");
-    if (LE_OK != GetLinkResult(&accessPoint))
+    if (0 == maxAgeMs)
     {
-        return LE_FAULT;
+        LE_ERROR("Invalid maximum age");
+        return NULL;
     }
-    *signalStrength = accessPoint.signalStrength;
 
-    return LE_OK;
+    requestPtr = le_mem_ForceAlloc(ScanRequestPool);
+    requestPtr->maxAgeMs = maxAgeMs;
+    requestPtr->sessionRef = le_wifiClientExt_GetClientSessionRef();
+    requestPtr->ref = le_ref_CreateRef(ScanRequestRefMap, requestPtr);
+    requestPtr->link = LE_DLS_LINK_INIT;
+    le_dls_Queue(&ScanRequestList, &requestPtr->link);
+
+    LE_DEBUG("Scan request %p, max age %u ms", requestPtr->ref, maxAgeMs);
+    UpdateScanSchedule();
+
+    return requestPtr->ref;
 }
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Get RX data of access point which is currently connecting.
+ * Remove a scan request.
  *
  * @return
- *      - LE_OK     The function succeeded.
- *      - LE_FAULT  The function failed.
+ *      - LE_OK             Function succeeded.
+ *      - LE_BAD_PARAMETER  Invalid reference.
  */
 //--------------------------------------------------------------------------------------------------
-le_result_t le_wifiClient_GetRxData
+le_result_t le_wifiClientExt_RemoveScanRequest
 (
-    uint64_t *rxData
-        ///< [OUT]
-        ///< The rx data
+    le_wifiClientExt_ScanRequestRef_t requestRef
+        ///< [IN]
+        ///< Reference of the request.
 )
 {
-    if (!rxData)
-    {
-        LE_KILL_CLIENT("rxBytes is NULL !");
-        return LE_FAULT;
-    }
+    ScanRequest_t *requestPtr = le_ref_Lookup(ScanRequestRefMap, requestRef);
 
-    pa_wifiClient_AccessPoint_t accessPoint;
-    LE_DEBUG("Get rx data");
-    if (LE_OK != GetLinkResult(&accessPoint))
+    if (NULL == requestPtr)
     {
-        return LE_FAULT;
+        return LE_BAD_PARAMETER;
     }
-    *rxData = accessPoint.rx;
 
+    le_dls_Remove(&ScanRequestList, &requestPtr->link);
+    le_ref_DeleteRef(ScanRequestRefMap, requestRef);
+    le_mem_Release(requestPtr);
+
+    UpdateScanSchedule();
     return LE_OK;
 }
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Get TX data of access point which is currently connecting.
+ * Enable or disable the auto-connect to the saved networks.
  *
  * @return
- *       - LE_OK     The function succeeded.
- *       - LE_FAULT  The function failed.
+ *      - LE_OK             Function succeeded.
+ *      - LE_FAULT          The WiFi device could not be started.
+ *      - LE_NOT_FOUND      The WiFi device is absent.
+ *      - LE_UNAVAILABLE    The WiFi device may not work.
  */
 //--------------------------------------------------------------------------------------------------
-le_result_t le_wifiClient_GetTxData
+le_result_t le_wifiClientExt_SetAutoConnect
 (
-    uint64_t *txData
-        ///< [OUT]
-        ///< The tx data
+    bool enable
+        ///< [IN]
+        ///< True to enable the auto-connect.
 )
 {
-    if (!txData)
-    {
-        LE_KILL_CLIENT("txBytes is NULL !");
-        return LE_FAULT;
-    }
-
-    pa_wifiClient_AccessPoint_t accessPoint;
-    LE_DEBUG("Get tx data");
-    if (LE_OK != GetLinkResult(&accessPoint))
-    {
-        return LE_FAULT;
-    }
-    *txData = accessPoint.tx;
-
-    return LE_OK;
+    LE_DEBUG("Auto-connect %s", enable ? "enabled" : "disabled");
+    return EnableAutoConnect(enable);
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -1061,39 +4113,23 @@ le_wifiClient_AccessPointRef_t le_wifiClient_GetFirstAccessPoint
     void
 )
 {
-    le_wifiClient_AccessPointRef_t apRef = NULL;
-    bool                           found = false;
+    le_dls_Link_t *linkPtr;
 
-    if (IsScanRunning())
-    {
-        LE_ERROR("ERROR: Scan is running.");
-        return NULL;
-    }
-    IterRef = le_ref_GetIterator(ScanApRefMap);
     GetFirstSessionRef = le_wifiClient_GetClientSessionRef();
 
     LE_DEBUG("Get first AP");
 
-    while (le_ref_NextNode(IterRef) == LE_OK)
-    {
-        apRef = (le_wifiClient_AccessPointRef_t)le_ref_GetSafeRef(IterRef);
-        if (WasApFoundInLastScan(apRef))
-        {
-            found = true;
-            break;
-        }
-    }
-
-    if (found)
-    {
-        LE_DEBUG("AP ref = %p", apRef);
-        return apRef;
-    }
-    else
+    linkPtr = le_dls_Peek(&LatestScanList);
+    if (NULL == linkPtr)
     {
         LE_DEBUG("AP not found");
+        IterNextLinkPtr = NULL;
         return NULL;
     }
+
+    IterNextLinkPtr = le_dls_PeekNext(&LatestScanList, linkPtr);
+    LE_DEBUG("AP ref = %p", CONTAINER_OF(linkPtr, FoundAccessPoint_t, latestLink)->ref);
+    return CONTAINER_OF(linkPtr, FoundAccessPoint_t, latestLink)->ref;
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -1112,45 +4148,29 @@ le_wifiClient_AccessPointRef_t le_wifiClient_GetNextAccessPoint
     void
 )
 {
-    le_wifiClient_AccessPointRef_t apRef = NULL;
-    bool                           found = false;
+    le_dls_Link_t *linkPtr;
 
     LE_DEBUG("Get next AP");
-    if (IsScanRunning())
-    {
-        LE_ERROR("ERROR: Scan is running.");
-        return NULL;
-    }
 
-    /* This check to protect the variable IterRef that shouldn't be called from different contexts*/
+    /* This check to protect the variable IterNextLinkPtr that shouldn't be called from different
+       contexts*/
     if (le_wifiClient_GetClientSessionRef() != GetFirstSessionRef)
     {
         LE_ERROR("ERROR: Called from different context than GetFirstAccessPoint");
         return NULL;
     }
 
-    while (le_ref_NextNode(IterRef) == LE_OK)
-    {
-        apRef = (le_wifiClient_AccessPointRef_t)le_ref_GetSafeRef(IterRef);
-        LE_DEBUG("AP ref = %p", apRef);
-        if (WasApFoundInLastScan(apRef))
-        {
-            found = true;
-            break;
-        }
-    }
-
-    if (found)
-    {
-        LE_DEBUG("AP ref = %p", apRef);
-        return apRef;
-    }
-    else
+    linkPtr = IterNextLinkPtr;
+    if (NULL == linkPtr)
     {
         LE_DEBUG("AP not found");
         GetFirstSessionRef = NULL;
         return NULL;
     }
+
+    IterNextLinkPtr = le_dls_PeekNext(&LatestScanList, linkPtr);
+    LE_DEBUG("AP ref = %p", CONTAINER_OF(linkPtr, FoundAccessPoint_t, latestLink)->ref);
+    return CONTAINER_OF(linkPtr, FoundAccessPoint_t, latestLink)->ref;
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -1314,6 +4334,178 @@ void le_wifiClient_GetCurrentConnection
 }
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Build the secStore path of the PMK cached for an SSID.
+ *
+ * @return
+ *      - LE_OK             Function succeeded.
+ *      - LE_BAD_PARAMETER  The SSID cannot be part of a secStore path.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t GetPmkPath
+(
+    const uint8_t *ssidPtr,
+        ///< [IN]
+        ///< SSID
+    size_t         ssidLen,
+        ///< [IN]
+        ///< Length of the SSID
+    char          *pathPtr,
+        ///< [OUT]
+        ///< secStore path
+    size_t         pathSize
+        ///< [IN]
+        ///< Size of the path buffer
+)
+{
+    if ((0 == ssidLen) || (NULL != memchr(ssidPtr, '\0', ssidLen)))
+    {
+        return LE_BAD_PARAMETER;
+    }
+
+    snprintf(pathPtr, pathSize, "%s/%.*s/%s", SECSTORE_WIFI_ITEM_ROOT, (int)ssidLen,
+             (const char *)ssidPtr, SECSTORE_NODE_PMK);
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Derive the PMK of an SSID and passphrase in the scan worker thread, and hand it to the main
+ * thread. The derivation takes thousands of SHA-1 rounds: running it here keeps the IPC calls
+ * responsive.
+ */
+//--------------------------------------------------------------------------------------------------
+static void DerivePmk
+(
+    void *param1Ptr,
+        ///< [IN]
+        ///< PMK derivation
+    void *param2Ptr
+)
+{
+    PmkJob_t     *jobPtr = param1Ptr;
+    le_clk_Time_t startTime = le_clk_GetRelativeTime();
+
+    jobPtr->result = pa_wifiPmk_Derive(jobPtr->passphrase, jobPtr->ssidBytes, jobPtr->ssidLength,
+                                       jobPtr->record.pmk);
+    if (LE_OK == jobPtr->result)
+    {
+        pa_wifiPmk_HmacSha1(jobPtr->record.pmk, sizeof(jobPtr->record.pmk),
+                            (const uint8_t *)jobPtr->passphrase, strlen(jobPtr->passphrase),
+                            jobPtr->record.tag);
+        LE_DEBUG("PMK derived in %"PRIu64" ms", GetElapsedMs(startTime));
+    }
+
+    le_event_Report(PmkEventId, &jobPtr, sizeof(jobPtr));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Queue the derivation of the PMK of an SSID and passphrase to the scan worker, to be cached in
+ * secStore. Nothing is queued if the SSID cannot be part of a secStore path, or if the same
+ * derivation is already queued.
+ */
+//--------------------------------------------------------------------------------------------------
+static void QueuePmkDerivation
+(
+    const uint8_t *ssidPtr,
+        ///< [IN]
+        ///< SSID
+    size_t         ssidLen,
+        ///< [IN]
+        ///< Length of the SSID
+    const char    *passphrasePtr
+        ///< [IN]
+        ///< Passphrase
+)
+{
+    char           secStorePath[LE_CFG_STR_LEN_BYTES] = {0};
+    le_dls_Link_t *linkPtr;
+    PmkJob_t      *jobPtr;
+
+    if ((ssidLen > LE_WIFIDEFS_MAX_SSID_BYTES) ||
+        (LE_OK != GetPmkPath(ssidPtr, ssidLen, secStorePath, sizeof(secStorePath))))
+    {
+        return;
+    }
+
+    for (linkPtr = le_dls_Peek(&PmkJobList); NULL != linkPtr;
+         linkPtr = le_dls_PeekNext(&PmkJobList, linkPtr))
+    {
+        jobPtr = CONTAINER_OF(linkPtr, PmkJob_t, link);
+        if ((ssidLen == jobPtr->ssidLength) && (0 == memcmp(ssidPtr, jobPtr->ssidBytes, ssidLen)) &&
+            (0 == strcmp(passphrasePtr, jobPtr->passphrase)))
+        {
+            return;
+        }
+    }
+
+    jobPtr = le_mem_ForceAlloc(PmkJobPool);
+    memset(jobPtr, 0, sizeof(PmkJob_t));
+    memcpy(jobPtr->ssidBytes, ssidPtr, ssidLen);
+    jobPtr->ssidLength = ssidLen;
+    le_utf8_Copy(jobPtr->passphrase, passphrasePtr, sizeof(jobPtr->passphrase), NULL);
+    jobPtr->link = LE_DLS_LINK_INIT;
+    le_dls_Queue(&PmkJobList, &jobPtr->link);
+
+    // The worker runs the derivations and the scans in order: a later derivation for the same
+    // SSID is cached last
+    le_event_QueueFunctionToThread(ScanWorkerThreadRef, DerivePmk, jobPtr, NULL);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the PMK of an SSID and passphrase as a hexadecimal PSK, if the PMK cached in secStore was
+ * derived from this passphrase. Otherwise its derivation is queued to the scan worker, and the
+ * PMK is available once cached.
+ *
+ * @return
+ *      - LE_OK             Function succeeded.
+ *      - LE_NOT_FOUND      No PMK is cached yet for this SSID and passphrase.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t GetPmk
+(
+    const uint8_t *ssidPtr,
+        ///< [IN]
+        ///< SSID
+    size_t         ssidLen,
+        ///< [IN]
+        ///< Length of the SSID
+    const char    *passphrasePtr,
+        ///< [IN]
+        ///< Passphrase
+    char           pskHex[PA_WIFIPMK_HEX_BYTES]
+        ///< [OUT]
+        ///< PMK as 64 hexadecimal digits
+)
+{
+    char        secStorePath[LE_CFG_STR_LEN_BYTES] = {0};
+    PmkRecord_t record;
+    size_t      size = sizeof(record);
+    uint8_t     tag[PA_WIFIPMK_SHA1_BYTES];
+
+    if ((LE_OK == GetPmkPath(ssidPtr, ssidLen, secStorePath, sizeof(secStorePath))) &&
+        (LE_OK == le_secStore_Read(secStorePath, (uint8_t *)&record, &size)) &&
+        (sizeof(record) == size))
+    {
+        pa_wifiPmk_HmacSha1(record.pmk, sizeof(record.pmk), (const uint8_t *)passphrasePtr,
+                            strnlen(passphrasePtr, LE_WIFIDEFS_MAX_PASSPHRASE_BYTES), tag);
+        if (0 == memcmp(tag, record.tag, sizeof(tag)))
+        {
+            LE_DEBUG("Using the PMK cached in secStore");
+            pa_wifiPmk_ToHex(record.pmk, pskHex);
+            memset(&record, 0, sizeof(record));
+            return LE_OK;
+        }
+        memset(&record, 0, sizeof(record));
+    }
+
+    QueuePmkDerivation(ssidPtr, ssidLen, passphrasePtr);
+    return LE_NOT_FOUND;
+}
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Set the passphrase used to generate the PSK.
@@ -1337,11 +4529,13 @@ le_result_t le_wifiClient_SetPassphrase
         ///< pass-phrase for PSK
 )
 {
-    le_result_t result = LE_BAD_PARAMETER;
+    le_result_t         result = LE_BAD_PARAMETER;
+    FoundAccessPoint_t *apPtr = le_ref_Lookup(ScanApRefMap, apRef);
+    char                psk[PA_WIFIPMK_HEX_BYTES];
 
     LE_DEBUG("Set passphrase");
 
-    if (NULL == le_ref_Lookup(ScanApRefMap, apRef))
+    if (NULL == apPtr)
     {
         LE_ERROR("Invalid access point reference.");
         return LE_BAD_PARAMETER;
@@ -1349,7 +4543,18 @@ le_result_t le_wifiClient_SetPassphrase
 
     if (NULL != passPhrasePtr)
     {
-        result = pa_wifiClient_SetPassphrase(passPhrasePtr);
+        // Hand the PSK derived once to wpa_supplicant, so that it does not derive it on each
+        // connection. Until the PSK is cached, wpa_supplicant derives it from the passphrase.
+        if (LE_OK == GetPmk(apPtr->accessPoint.ssidBytes, apPtr->accessPoint.ssidLength,
+                            passPhrasePtr, psk))
+        {
+            result = pa_wifiClient_SetPreSharedKey(psk);
+            memset(psk, 0, sizeof(psk));
+        }
+        else
+        {
+            result = pa_wifiClient_SetPassphrase(passPhrasePtr);
+        }
     }
 
     return result;
@@ -1583,14 +4788,21 @@ le_wifiClient_AccessPointRef_t le_wifiClient_Create
 
     returnedRef = FindAccessPointRefFromSsid(ssidPtr, ssidNumElements);
 
+    // The access point is now owned by the client: keep it until le_wifiClient_Delete()
+    if (returnedRef != NULL)
+    {
+        ((FoundAccessPoint_t *)le_ref_Lookup(ScanApRefMap, returnedRef))->isPinned = true;
+    }
     // if the access point does not already exist, then create it.
-    if (returnedRef == NULL)
+    else
     {
         FoundAccessPoint_t* createdAccessPointPtr = le_mem_ForceAlloc(AccessPointPool);
 
         if (createdAccessPointPtr)
         {
+            memset(createdAccessPointPtr, 0, sizeof(FoundAccessPoint_t));
             createdAccessPointPtr->foundInLatestScan = false;
+            createdAccessPointPtr->isPinned = true;
 
             createdAccessPointPtr->accessPoint.signalStrength = LE_WIFICLIENT_NO_SIGNAL_STRENGTH;
             createdAccessPointPtr->accessPoint.ssidLength = ssidNumElements;
@@ -1600,6 +4812,9 @@ le_wifiClient_AccessPointRef_t le_wifiClient_Create
 
             // Create a Safe Reference for this object.
             returnedRef = le_ref_CreateRef(ScanApRefMap, createdAccessPointPtr);
+            createdAccessPointPtr->ref = returnedRef;
+            IndexSsid(createdAccessPointPtr);
+            AccessPointCount++;
 
             LE_DEBUG("AP[%p %p] signal strength %d | SSID length %d | SSID: \"%.*s\"",
                 createdAccessPointPtr,
@@ -1662,12 +4877,14 @@ le_result_t le_wifiClient_Delete
 /**
  * Connect to the WiFi Access Point.
  * All authentication must be set prior to calling this function.
+ * The function returns as soon as the connection attempt is started. Its result is reported by
+ * a LE_WIFICLIENT_EVENT_CONNECTED event, or a LE_WIFICLIENT_EVENT_DISCONNECTED event with the cause
+ * when the attempt fails or times out.
  *
  * @return
- *      - LE_OK             Function succeeded.
+ *      - LE_OK             Connection attempt started.
  *      - LE_BAD_PARAMETER  Invalid parameter.
  *      - LE_DUPLICATE      Duplicated request.
- *      - LE_TIMEOUT        Connection request time out.
  *      - LE_FAULT          The function failed.
  *
  * @note For PSK credentials see le_wifiClient_SetPassphrase() or le_wifiClient_SetPreSharedKey() .
@@ -1694,6 +4911,7 @@ le_result_t le_wifiClient_Connect
         result = pa_wifiClient_Connect(apPtr->accessPoint.ssidBytes, ssidLen);
         if (LE_OK == result)
         {
+            UpdateAutoConnectOnConnect(apRef);
             CurrentConnection = apRef;
         }
     }
@@ -1716,7 +4934,9 @@ le_result_t le_wifiClient_Disconnect
 )
 {
     LE_DEBUG("Disconnect");
+    SuspendAutoConnect();
     CurrentConnection = NULL;
+    LinkInfoCache.isValid = false;
     return pa_wifiClient_Disconnect();
 }
 
@@ -2167,6 +5387,181 @@ le_result_t le_wifiClient_LoadSsid
 }
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Load a saved network of wifiService:/wifi/channel with its credentials, to be handed to
+ * wpa_supplicant. A passphrase is replaced by its PMK once it is cached in secStore.
+ *
+ * @return
+ *      - LE_OK     Function succeeded.
+ *      - LE_FAULT  The credentials cannot be loaded.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t LoadSavedNetwork
+(
+    le_cfg_IteratorRef_t     cfg,
+        ///< [IN]
+        ///< Config tree node of the saved network
+    const char              *ssidPtr,
+        ///< [IN]
+        ///< SSID, name of the node
+    pa_wifiClient_Network_t *networkPtr
+        ///< [OUT]
+        ///< Saved network
+)
+{
+    char        pskHex[PA_WIFIPMK_HEX_BYTES];
+    size_t      size1 = 0, size2 = 0;
+    le_result_t ret;
+
+    memset(networkPtr, 0, sizeof(pa_wifiClient_Network_t));
+    networkPtr->ssidLength = strlen(ssidPtr);
+    memcpy(networkPtr->ssidBytes, ssidPtr, networkPtr->ssidLength);
+    networkPtr->isHidden = le_cfg_GetBool(cfg, CFG_NODE_HIDDEN_SSID, false);
+    networkPtr->priority = le_cfg_GetInt(cfg, CFG_NODE_PRIORITY, 0);
+    networkPtr->securityProtocol = le_cfg_NodeExists(cfg, CFG_NODE_SECPROTOCOL) ?
+                                   le_cfg_GetInt(cfg, CFG_NODE_SECPROTOCOL,
+                                                 LE_WIFICLIENT_SECURITY_WPA2_PSK_PERSONAL) :
+                                   LE_WIFICLIENT_SECURITY_NONE;
+
+    switch (networkPtr->securityProtocol)
+    {
+        case LE_WIFICLIENT_SECURITY_NONE:
+            ret = LE_OK;
+            break;
+
+        case LE_WIFICLIENT_SECURITY_WEP:
+            ret = WifiClient_LoadCfg_Wep(ssidPtr, (uint8_t *)networkPtr->wepKey, &size1);
+            break;
+
+        case LE_WIFICLIENT_SECURITY_WPA_PSK_PERSONAL:
+        case LE_WIFICLIENT_SECURITY_WPA2_PSK_PERSONAL:
+            ret = WifiClient_LoadCfg_WpaPsk(ssidPtr, networkPtr->securityProtocol,
+                                            (uint8_t *)networkPtr->passphrase, &size1,
+                                            (uint8_t *)networkPtr->preSharedKey, &size2);
+            if ((LE_OK == ret) && (size1 > 0) &&
+                (LE_OK == GetPmk(networkPtr->ssidBytes, networkPtr->ssidLength,
+                                 networkPtr->passphrase, pskHex)))
+            {
+                le_utf8_Copy(networkPtr->preSharedKey, pskHex, sizeof(networkPtr->preSharedKey),
+                             NULL);
+                memset(networkPtr->passphrase, 0, sizeof(networkPtr->passphrase));
+                memset(pskHex, 0, sizeof(pskHex));
+            }
+            break;
+
+        case LE_WIFICLIENT_SECURITY_WPA_EAP_PEAP0_ENTERPRISE:
+        case LE_WIFICLIENT_SECURITY_WPA2_EAP_PEAP0_ENTERPRISE:
+            ret = WifiClient_LoadCfg_WpaEap(ssidPtr, networkPtr->securityProtocol,
+                                            (uint8_t *)networkPtr->username, &size1,
+                                            (uint8_t *)networkPtr->password, &size2);
+            break;
+
+        default:
+            LE_ERROR("Invalid security protocol %d", networkPtr->securityProtocol);
+            ret = LE_FAULT;
+            break;
+    }
+    return ret;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Hand the saved networks of wifiService:/wifi/channel to wpa_supplicant, which chooses among
+ * them for the auto-connect. Networks whose credentials cannot be loaded are left out.
+ */
+//--------------------------------------------------------------------------------------------------
+static void UpdateSupplicantNetworks
+(
+    void
+)
+{
+    static pa_wifiClient_Network_t networks[PA_WIFICLIENT_MAX_NETWORKS];
+    char                           configPath[LE_CFG_STR_LEN_BYTES] = {0};
+    char                           name[LE_WIFIDEFS_MAX_SSID_BYTES];
+    size_t                         count = 0;
+    le_cfg_IteratorRef_t           cfg;
+    le_result_t                    result;
+
+    snprintf(configPath, sizeof(configPath), "%s/%s", CFG_TREE_ROOT_DIR, CFG_PATH_WIFI);
+    cfg = le_cfg_CreateReadTxn(configPath);
+    if (LE_OK == le_cfg_GoToFirstChild(cfg))
+    {
+        do
+        {
+            if ((LE_OK != le_cfg_GetNodeName(cfg, "", name, sizeof(name))) || ('\0' == name[0]))
+            {
+                continue;
+            }
+            if (PA_WIFICLIENT_MAX_NETWORKS == count)
+            {
+                LE_WARN("Too many saved networks, %s is left out", name);
+                continue;
+            }
+            if (LE_OK == LoadSavedNetwork(cfg, name, &networks[count]))
+            {
+                count++;
+            }
+        }
+        while (LE_OK == le_cfg_GoToNextSibling(cfg));
+    }
+    le_cfg_CancelTxn(cfg);
+
+    result = pa_wifiClient_SetNetworks(networks, count);
+    if (LE_OK != result)
+    {
+        LE_WARN("Unable to hand the saved networks to wpa_supplicant (%d)", result);
+    }
+    AutoConnect.hasNetworkList = (LE_OK == result) && (0 != count);
+
+    // The networks hold credentials
+    memset(networks, 0, sizeof(networks));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Cache in secStore a PMK derived by the scan worker, and hand it to wpa_supplicant in place of
+ * the passphrase of the saved network. Handler of PmkEventId, runs in the main thread.
+ */
+//--------------------------------------------------------------------------------------------------
+static void CommitPmk
+(
+    void *reportPtr
+        ///< [IN]
+        ///< PMK derivation
+)
+{
+    PmkJob_t   *jobPtr = *(PmkJob_t **)reportPtr;
+    char        secStorePath[LE_CFG_STR_LEN_BYTES] = {0};
+    le_result_t ret;
+
+    le_dls_Remove(&PmkJobList, &jobPtr->link);
+
+    if (LE_OK != jobPtr->result)
+    {
+        LE_WARN("PMK derivation failed (%d)", jobPtr->result);
+    }
+    else if (LE_OK == GetPmkPath(jobPtr->ssidBytes, jobPtr->ssidLength, secStorePath,
+                                 sizeof(secStorePath)))
+    {
+        ret = le_secStore_Write(secStorePath, (const uint8_t *)&jobPtr->record,
+                                sizeof(PmkRecord_t));
+        if (LE_OK != ret)
+        {
+            // Not fatal: the PMK is derived again on the next use
+            LE_WARN("Failed to write PMK into secStore path %s; retcode %d", secStorePath, ret);
+        }
+        else
+        {
+            // The saved networks were handed with the passphrase until now
+            UpdateSupplicantNetworks();
+        }
+    }
+
+    memset(jobPtr, 0, sizeof(PmkJob_t));
+    le_mem_Release(jobPtr);
+}
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Configure the given SSID to use WEP and the given WEP key in the respective input argument.
@@ -2223,6 +5618,7 @@ le_result_t le_wifiClient_ConfigureWep
         return LE_FAULT;
     }
 
+    UpdateSupplicantNetworks();
     LE_INFO("Succeeded to write WEP configs for SSID %s into secStore", ssid);
     return LE_OK;
 }
@@ -2315,12 +5711,21 @@ le_result_t le_wifiClient_ConfigurePsk
             }
             else
             {
+                char passphrase[LE_WIFIDEFS_MAX_PASSPHRASE_BYTES] = {0};
+
                 LE_DEBUG("Succeeded writing passphrase into secStore");
+
+                // Derive the PMK now rather than on the first connection, for the SSID as
+                // used in the secStore paths
+                memcpy(passphrase, passPhrasePtr, passPhrasePtrSize);
+                QueuePmkDerivation((const uint8_t *)ssid, strlen(ssid), passphrase);
+                memset(passphrase, 0, sizeof(passphrase));
             }
         }
 
         if (!pskPtr)
         {
+            UpdateSupplicantNetworks();
             return ((ret1 == LE_OK) ? LE_OK : ret1);
         }
     }
@@ -2351,6 +5756,7 @@ le_result_t le_wifiClient_ConfigurePsk
 
         if (!passPhrasePtr)
         {
+            UpdateSupplicantNetworks();
             return ((ret2 == LE_OK) ? LE_OK : ret2);
         }
     }
@@ -2360,6 +5766,7 @@ le_result_t le_wifiClient_ConfigurePsk
         return LE_FAULT;
     }
 
+    UpdateSupplicantNetworks();
     LE_INFO("Succeeded to write PSK configs for SSID %s into secStore", ssid);
     return LE_OK;
 }
@@ -2445,6 +5852,7 @@ le_result_t le_wifiClient_ConfigureEap
         return LE_FAULT;
     }
 
+    UpdateSupplicantNetworks();
     LE_INFO("Succeeded to write EAP configs for SSID %s into secStore", ssid);
     return LE_OK;
 }
@@ -2496,6 +5904,7 @@ le_result_t le_wifiClient_RemoveSsidSecurityConfigs
         cfg = le_cfg_CreateWriteTxn(configPath);
         le_cfg_SetInt(cfg, CFG_NODE_SECPROTOCOL, LE_WIFICLIENT_SECURITY_NONE);
         le_cfg_CommitTxn(cfg);
+        UpdateSupplicantNetworks();
         LE_INFO("Succeeded to delete from secStore user credentials for SSID %s", ssid);
     }
     else
@@ -2507,6 +5916,58 @@ le_result_t le_wifiClient_RemoveSsidSecurityConfigs
 }
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the auto-connect priority of a saved network. The saved networks found by a scan are tried
+ * by decreasing priority, then by decreasing signal.
+ *
+ * @return
+ *      - LE_OK             Function succeeded.
+ *      - LE_BAD_PARAMETER  Invalid SSID.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t le_wifiClientExt_SetProfilePriority
+(
+    const uint8_t *ssidPtr,
+        ///< [IN]
+        ///< SSID of the saved network.
+    size_t ssidSize,
+        ///< [IN]
+    int32_t priority
+        ///< [IN]
+        ///< Priority, 0 by default.
+)
+{
+    char configPath[LE_CFG_STR_LEN_BYTES] = {0};
+    char ssid[LE_WIFIDEFS_MAX_SSID_BYTES] = {0};
+    le_cfg_IteratorRef_t cfg;
+
+    if ((!ssidPtr) || (0 == ssidSize) || (ssidSize > LE_WIFIDEFS_MAX_SSID_LENGTH))
+    {
+        LE_ERROR("Invalid inputs: SSID size %d", (int)ssidSize);
+        return LE_BAD_PARAMETER;
+    }
+
+    // Copy the ssidPtr input over, in case it's not null terminated and has no extra space behind
+    // to set it there
+    memcpy(ssid, ssidPtr, ssidSize);
+    if ('\0' == ssid[0])
+    {
+        LE_ERROR("Invalid input: empty SSID");
+        return LE_BAD_PARAMETER;
+    }
+
+    snprintf(configPath, sizeof(configPath), "%s/%s/%s", CFG_TREE_ROOT_DIR, CFG_PATH_WIFI, ssid);
+    cfg = le_cfg_CreateWriteTxn(configPath);
+    le_cfg_SetInt(cfg, CFG_NODE_PRIORITY, priority);
+    le_cfg_CommitTxn(cfg);
+    UpdateSupplicantNetworks();
+
+    LE_INFO("Priority of SSID %s set to %d", ssid, priority);
+    return LE_OK;
+}
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  *  WiFi Client COMPONENT Init
@@ -2520,6 +5981,7 @@ void le_wifiClient_Init
     LE_DEBUG("WiFi client service starting...");
 
     pa_wifiClient_Init();
+    LoadClientConfig();
 
     // Create the Access Point object pool.
     AccessPointPool = le_mem_CreatePool("le_wifi_FoundAccessPointPool", sizeof(FoundAccessPoint_t));
@@ -2528,6 +5990,41 @@ void le_wifiClient_Init
     // Create the Safe Reference Map to use for FoundAccessPoint_t object Safe References.
     ScanApRefMap = le_ref_CreateMap("le_wifiClient_AccessPoints", INIT_AP_COUNT);
 
+    // Create the BSSID and SSID indexes of the access points.
+    BssidIndex = le_hashmap_Create("le_wifiClient_BssidIndex", INIT_AP_COUNT,
+                                   le_hashmap_HashString, le_hashmap_EqualsString);
+    SsidIndex = le_hashmap_Create("le_wifiClient_SsidIndex", INIT_AP_COUNT, HashSsid, EqualsSsid);
+    SsidEntryPool = le_mem_CreatePool("le_wifi_SsidEntryPool", sizeof(SsidEntry_t));
+    le_mem_ExpandPool(SsidEntryPool, INIT_AP_COUNT);
+
+    // Start the scan worker. Its results are committed in this thread.
+    ScanBatchPool = le_mem_CreatePool("le_wifi_ScanBatchPool", sizeof(ScanBatch_t));
+    ScanBatchEntryPool = le_mem_CreatePool("le_wifi_ScanBatchEntryPool",
+                                           sizeof(ScanBatchEntry_t));
+    le_mem_ExpandPool(ScanBatchEntryPool, INIT_AP_COUNT);
+    PmkJobPool = le_mem_CreatePool("le_wifi_PmkJobPool", sizeof(PmkJob_t));
+    PmkEventId = le_event_CreateId("WifiPmk", sizeof(PmkJob_t *));
+    le_event_AddHandler("WifiPmkHandler", PmkEventId, CommitPmk);
+    ScanChangePool = le_mem_CreatePool("le_wifi_ScanChangePool", sizeof(ScanChangeEntry_t));
+    le_mem_ExpandPool(ScanChangePool, INIT_AP_COUNT);
+    ScanChangesEventId = le_event_CreateId("WifiScanChanges", sizeof(ScanChangesReport_t));
+
+    // Create the scan scheduler
+    ScanRequestPool = le_mem_CreatePool("le_wifi_ScanRequestPool", sizeof(ScanRequest_t));
+    ScanRequestRefMap = le_ref_CreateMap("le_wifiClient_ScanRequests", INIT_AP_COUNT);
+    ScanTimerRef = le_timer_Create("WifiScanScheduler");
+    le_timer_SetHandler(ScanTimerRef, ScanTimerHandler);
+    MainThreadRef = le_thread_GetCurrent();
+    ScanWorkerThreadRef = le_thread_Create("WiFi Client Scan Worker", ScanWorkerThread, NULL);
+    le_thread_Start(ScanWorkerThreadRef);
+
+    // Create the roaming engine, started by the connection events
+    RoamTimerRef = le_timer_Create("WifiRoam");
+    le_timer_SetMsInterval(RoamTimerRef, ROAM_CHECK_INTERVAL_MS);
+    le_timer_SetRepeat(RoamTimerRef, 0);
+    le_timer_SetHandler(RoamTimerRef, RoamTimerHandler);
+    RoamEventId = le_event_CreateId("WifiRoam", sizeof(RoamReport_t));
+
     // Create an event indication Id for WiFi Events
     WifiEventIndicationId = le_event_CreateIdWithRefCounting("WifiConnectState");
     WifiEventPool = le_mem_CreatePool("WifiConnectStatePool", sizeof(le_wifiClient_EventInd_t));
@@ -2541,4 +6038,14 @@ void le_wifiClient_Init
 
     // Add a handler to handle the close
     le_msg_AddServiceCloseHandler(le_wifiClient_GetServiceRef(), CloseSessionEventHandler, NULL);
+    le_msg_AddServiceCloseHandler(le_wifiClientExt_GetServiceRef(), CloseExtSessionEventHandler,
+                                  NULL);
+
+    // Connect to the saved networks without waiting for a client
+    UpdateSupplicantNetworks();
+    le_wifiClient_AddConnectionEventHandler(AutoConnectEventHandler, NULL);
+    if (AutoConnect.isEnabled)
+    {
+        (void)EnableAutoConnect(true);
+    }
 }
@@ -6,20 +6,27 @@
  *
  */
 // -------------------------------------------------------------------------------------------------
+#include <sys/ioctl.h>
 #include <sys/types.h>
+#include <sys/stat.h>
 #include <sys/wait.h>
+#include <fcntl.h>
 #include <arpa/inet.h>
+#include <net/if.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include "legato.h"
 #include "interfaces.h"
 #include "pa_wifi_ap.h"
+#include "pa_wifi_apconf.h"
+#include "pa_wifi_nl80211.h"
+#include "pa_wifi_ctrl.h"
+#include "pa_wifi_dhcp.h"
 
 // Set of commands to drive the WiFi features.
 #define COMMAND_WIFI_HW_START        "WIFI_START"
+#define COMMAND_WIFI_START_FAILED    "WIFI_START_FAILED"
 #define COMMAND_WIFI_HW_STOP         "WIFI_STOP"
-#define COMMAND_WIFI_SET_EVENT       "WIFI_SET_EVENT"
-#define COMMAND_WIFI_UNSET_EVENT     "WIFI_UNSET_EVENT"
 #define COMMAND_WIFIAP_HOSTAPD_START "WIFIAP_HOSTAPD_START"
 #define COMMAND_WIFIAP_HOSTAPD_STOP  "WIFIAP_HOSTAPD_STOP"
 #define COMMAND_WIFIAP_WLAN_UP       "WIFIAP_WLAN_UP"
@@ -27,7 +34,6 @@
 // iptables rule to allow/disallow the DHCP port on WLAN interface
 #define COMMAND_IPTABLE_DHCP_INSERT  "IPTABLE_DHCP_INSERT"
 #define COMMAND_IPTABLE_DHCP_DELETE  "IPTABLE_DHCP_DELETE"
-#define COMMAND_DNSMASQ_RESTART       "DNSMASQ_RESTART"
 
 //--------------------------------------------------------------------------------------------------
 /**
@@ -38,16 +44,17 @@
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Link to the dnsmasq related configuration file
+ * Lease file of the DHCP server of the access point clients
  */
 //--------------------------------------------------------------------------------------------------
-#define DNSMASQ_CFG_LINK "/etc/dnsmasq.d/dnsmasq.wlan.conf"
+#define WIFI_DHCP_LEASE_FILE "/tmp/dhcp.wlan.leases"
+
 //--------------------------------------------------------------------------------------------------
 /**
- * dnsmasq related configuration file
+ * Subnet mask of the clients when the interface one cannot be read
  */
 //--------------------------------------------------------------------------------------------------
-#define DNSMASQ_CFG_FILE "/tmp/dnsmasq.wlan.conf"
+#define WIFI_DHCP_DEFAULT_NETMASK 0xFFFFFF00
 
 //--------------------------------------------------------------------------------------------------
 /**
@@ -56,6 +63,13 @@
 //--------------------------------------------------------------------------------------------------
 #define WIFI_HOSTAPD_FILE "/tmp/hostapd.conf"
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Temporary file renamed over hostapd.conf once written.
+ */
+//--------------------------------------------------------------------------------------------------
+#define WIFI_HOSTAPD_TMP_FILE WIFI_HOSTAPD_FILE ".tmp"
+
 // WiFi access point configuration.
 //--------------------------------------------------------------------------------------------------
 /**
@@ -112,6 +126,45 @@
  */
 //--------------------------------------------------------------------------------------------------
 #define TEMP_STRING_MAX_BYTES 1024
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum numbers of bytes of the whole hostapd.conf
+ */
+//--------------------------------------------------------------------------------------------------
+#define HOSTAPD_CONFIG_MAX_BYTES 2048
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Control interface of hostapd, as set by ctrl_interface in HOSTAPD_CONFIG_COMMON.
+ */
+//--------------------------------------------------------------------------------------------------
+#define HOSTAPD_CTRL_IFACE_PATH    "/var/run/hostapd/" PA_WIFINL80211_IFNAME
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of attempts and delay between attempts (us) to reach the hostapd control interface
+ * once the daemon is started.
+ */
+//--------------------------------------------------------------------------------------------------
+#define HOSTAPD_CTRL_OPEN_RETRIES  20
+#define HOSTAPD_CTRL_OPEN_DELAY_US 100000
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum numbers of bytes in a hostapd control command
+ */
+//--------------------------------------------------------------------------------------------------
+#define HOSTAPD_CMD_MAX_BYTES      256
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of beacons announcing a channel switch before it happens, giving the stations the time
+ * to follow the access point.
+ */
+//--------------------------------------------------------------------------------------------------
+#define CSA_BEACON_COUNT           5
+
 //--------------------------------------------------------------------------------------------------
 /**
  * The current security protocol
@@ -184,57 +237,76 @@ static char SavedPreSharedKey[LE_WIFIDEFS_MAX_PSK_BYTES]      = "";
 
 //--------------------------------------------------------------------------------------------------
 /**
- * The main thread running the WiFi service
+ * Connection to the control interface of the running hostapd. Settings changed while it is open
+ * are applied live.
  */
 //--------------------------------------------------------------------------------------------------
-static void            *WifiApPaThreadMain(void *contextPtr);
+static pa_wifiCtrl_Conn_t HostapdConn = { .fd = -1 };
+
 //--------------------------------------------------------------------------------------------------
 /**
- * The handle of the WiFi service thread
+ * Time taken (ms) by the last hostapd (re)start, used as reference for the live reconfiguration
+ * latency. 0 if unknown.
  */
 //--------------------------------------------------------------------------------------------------
-static le_thread_Ref_t  WifiApPaThread  = NULL;
+static uint32_t HostapdRestartLatencyMs = 0;
+
 //--------------------------------------------------------------------------------------------------
 /**
- * The handle of the input pipe used to be notified of the WiFi related events.
+ * Time taken (ms) by the last start of the WiFi hardware, until the WLAN interface was up. 0 if
+ * the hardware was not started yet.
  */
 //--------------------------------------------------------------------------------------------------
-static FILE            *IwThreadPipePtr = NULL;
+static uint32_t StartLatencyMs = 0;
 
 //--------------------------------------------------------------------------------------------------
 /**
- * WifiAp state event ID used to report WifiAp state events to the registered event handlers.
+ * hostapd.conf content the running hostapd is configured with, empty when hostapd is stopped.
  */
 //--------------------------------------------------------------------------------------------------
-static le_event_Id_t    WifiApPaEvent;
+static char RunningConfig[HOSTAPD_CONFIG_MAX_BYTES] = "";
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Thread destructor
+ * Flag set when the handler of the nl80211 notifications is registered.
  */
 //--------------------------------------------------------------------------------------------------
-static void ThreadDestructor
-(
-    void *contextPtr
-)
-{
-    int status;
+static bool             IsEventListenerStarted = false;
 
-    // Kill the script launched by popen() in PA thread
-    status = system(WIFI_SCRIPT_PATH COMMAND_WIFI_UNSET_EVENT);
+//--------------------------------------------------------------------------------------------------
+/**
+ * The iptables rule allowing the DHCP ports on the interface is inserted.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool             IsDhcpRuleInserted = false;
 
-    if ((!WIFEXITED(status)) || (0 != WEXITSTATUS(status)))
-    {
-        LE_ERROR("Unable to kill the WIFI events script");
-    }
+//--------------------------------------------------------------------------------------------------
+/**
+ * nl80211 socket of the station dumps, kept open while the access point is started.
+ */
+//--------------------------------------------------------------------------------------------------
+static pa_wifiNl80211_Socket_t StationSocket;
 
-    if (IwThreadPipePtr)
-    {
-        // And close the communication pipe used in created thread.
-        pclose(IwThreadPipePtr);
-        IwThreadPipePtr = NULL;
-    }
+//--------------------------------------------------------------------------------------------------
+/**
+ * Context of a station dump.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    pa_wifiAp_StationStats_t *statsPtr;     ///< Stations
+    size_t                    maxCount;     ///< Number of entries of statsPtr
+    size_t                    count;        ///< Number of stations returned
+    bool                      isTruncated;  ///< More stations than maxCount were dumped
 }
+StationDumpCtx_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * WifiAp state event ID used to report WifiAp state events to the registered event handlers.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_event_Id_t    WifiApPaEvent;
 
 //--------------------------------------------------------------------------------------------------
 /**
@@ -249,12 +321,12 @@ static void FirstLayerWifiApEventHandler
 )
 {
     pa_wifiAp_NewEventHandlerFunc_t  ApHandlerFunc = secondLayerHandlerFunc;
-    le_wifiAp_Event_t               *wifiEventPtr  = (le_wifiAp_Event_t *)reportPtr;
+    pa_wifiAp_EventInd_t            *wifiEventPtr  = (pa_wifiAp_EventInd_t *)reportPtr;
 
     if (NULL != wifiEventPtr)
     {
-        LE_INFO("Event: %d", *wifiEventPtr);
-        ApHandlerFunc(*wifiEventPtr, le_event_GetContextPtr());
+        LE_INFO("Event: %d", wifiEventPtr->event);
+        ApHandlerFunc(wifiEventPtr->event, le_event_GetContextPtr());
     }
     else
     {
@@ -264,84 +336,178 @@ static void FirstLayerWifiApEventHandler
 
 //--------------------------------------------------------------------------------------------------
 /**
- * WiFi access point platform adaptor thread
+ * The first-layer WiFi Ap Event Indication Handler.
  *
  */
 //--------------------------------------------------------------------------------------------------
-static void *WifiApPaThreadMain
+static void FirstLayerWifiApEventIndHandler
 (
-    void *contextPtr
+    void *reportPtr,
+    void *secondLayerHandlerFunc
 )
 {
-    char path[1024];
+    pa_wifiAp_EventIndHandlerFunc_t  ApHandlerFunc = secondLayerHandlerFunc;
+    pa_wifiAp_EventInd_t            *wifiEventIndPtr = reportPtr;
 
-    LE_INFO("Wifi event report thread started!");
+    if (NULL != wifiEventIndPtr)
+    {
+        LE_DEBUG("Event: %d, station: %s", wifiEventIndPtr->event, wifiEventIndPtr->stationMac);
+        ApHandlerFunc(wifiEventIndPtr, le_event_GetContextPtr());
+    }
+    else
+    {
+        LE_ERROR("wifiEventIndPtr is NULL");
+    }
+}
 
-    // Open the command "iw events" for reading.
-    IwThreadPipePtr = popen(WIFI_SCRIPT_PATH COMMAND_WIFI_SET_EVENT, "r");
+//--------------------------------------------------------------------------------------------------
+/**
+ * Handler of the nl80211 notifications, called in the context of the nl80211 event listener.
+ */
+//--------------------------------------------------------------------------------------------------
+static void NlEventHandler
+(
+    uint8_t        cmd,
+    struct nlattr *attrs[],
+    void          *contextPtr
+)
+{
+    pa_wifiAp_EventInd_t eventInd = { .stationMac = "" };
 
-    if (NULL == IwThreadPipePtr)
+    if (NL80211_CMD_NEW_STATION == cmd)
+    {
+        eventInd.event = LE_WIFIAP_EVENT_CLIENT_CONNECTED;
+    }
+    else if (NL80211_CMD_DEL_STATION == cmd)
     {
-        LE_ERROR("Failed to run command:\"%s\" errno:%d %s",
-                 COMMAND_WIFI_SET_EVENT,
-                 errno,
-                 LE_ERRNO_TXT(errno));
-        return NULL;
+        eventInd.event = LE_WIFIAP_EVENT_CLIENT_DISCONNECTED;
+    }
+    else
+    {
+        return;
     }
 
-    // Read the output a line at a time - output it.
-    while (NULL != fgets(path, sizeof(path)-1, IwThreadPipePtr))
+    if (NULL != attrs[NL80211_ATTR_MAC])
     {
-        LE_INFO("PARSING:%s: len:%d", path, (int) strnlen(path, sizeof(path)-1));
-        if (NULL != strstr(path, "new station"))
-        {
-            LE_INFO("FOUND new station");
-            // Report event: LE_WIFIAP_EVENT_CONNECTED
-            le_wifiAp_Event_t event = LE_WIFIAP_EVENT_CLIENT_CONNECTED;
-            LE_INFO( "InternalWifiApStateEvent event: %d ", event);
-            le_event_Report(WifiApPaEvent , (void *)&event, sizeof(le_wifiAp_Event_t));
-        }
-        else if (NULL != strstr(path, "del station"))
-        {
-            LE_INFO("FOUND del station");
-            // Report event: LE_WIFIAP_EVENT_DISCONNECTED
-            le_wifiAp_Event_t event = LE_WIFIAP_EVENT_CLIENT_DISCONNECTED;
-            LE_INFO("InternalWifiApStateEvent event: %d ", event);
-            le_event_Report(WifiApPaEvent , (void *)&event, sizeof(le_wifiAp_Event_t));
-        }
+        pa_wifiNl80211_FormatMac(pa_wifiNl80211_AttrData(attrs[NL80211_ATTR_MAC]),
+                                 eventInd.stationMac, sizeof(eventInd.stationMac));
     }
-    // Run the event loop
-    le_event_RunLoop();
-    return NULL;
+
+    LE_INFO("InternalWifiApStateEvent event: %d, station: %s",
+            eventInd.event, eventInd.stationMac);
+    le_event_Report(WifiApPaEvent, &eventInd, sizeof(eventInd));
 }
 
 //--------------------------------------------------------------------------------------------------
 /**
- * This function handles AP configuration file related operations.
+ * Handler of the NL80211_CMD_GET_STATION dump, called for each station.
  */
 //--------------------------------------------------------------------------------------------------
-static le_result_t WriteApCfgFile
+static void NlStationDumpHandler
 (
-    const char *dataPtr,
-    FILE *filePtr
+    uint8_t        cmd,
+    struct nlattr *attrs[],
+    void          *contextPtr
 )
 {
-    size_t length;
+    StationDumpCtx_t         *ctxPtr = contextPtr;
+    pa_wifiAp_StationStats_t *statsPtr;
+    struct nlattr            *staAttrs[NL80211_STA_INFO_MAX + 1];
+
+    if ((NL80211_CMD_NEW_STATION != cmd) || (NULL == attrs[NL80211_ATTR_MAC]) ||
+        (NULL == attrs[NL80211_ATTR_STA_INFO]))
+    {
+        return;
+    }
+
+    if (ctxPtr->count >= ctxPtr->maxCount)
+    {
+        ctxPtr->isTruncated = true;
+        return;
+    }
+
+    statsPtr = &ctxPtr->statsPtr[ctxPtr->count++];
+    memset(statsPtr, 0, sizeof(pa_wifiAp_StationStats_t));
+    statsPtr->signalStrength = LE_WIFIAPEXT_NO_SIGNAL_STRENGTH;
+    pa_wifiNl80211_FormatMac(pa_wifiNl80211_AttrData(attrs[NL80211_ATTR_MAC]),
+                             statsPtr->mac, sizeof(statsPtr->mac));
+
+    pa_wifiNl80211_ParseAttrs(staAttrs, NL80211_STA_INFO_MAX,
+                              pa_wifiNl80211_AttrData(attrs[NL80211_ATTR_STA_INFO]),
+                              pa_wifiNl80211_AttrLen(attrs[NL80211_ATTR_STA_INFO]));
+
+    // The 64 bits counters do not wrap after 4 GB
+    if (NULL != staAttrs[NL80211_STA_INFO_RX_BYTES64])
+    {
+        memcpy(&statsPtr->rxBytes, pa_wifiNl80211_AttrData(staAttrs[NL80211_STA_INFO_RX_BYTES64]),
+               sizeof(uint64_t));
+    }
+    else if (NULL != staAttrs[NL80211_STA_INFO_RX_BYTES])
+    {
+        statsPtr->rxBytes = pa_wifiNl80211_AttrU32(staAttrs[NL80211_STA_INFO_RX_BYTES]);
+    }
+
+    if (NULL != staAttrs[NL80211_STA_INFO_TX_BYTES64])
+    {
+        memcpy(&statsPtr->txBytes, pa_wifiNl80211_AttrData(staAttrs[NL80211_STA_INFO_TX_BYTES64]),
+               sizeof(uint64_t));
+    }
+    else if (NULL != staAttrs[NL80211_STA_INFO_TX_BYTES])
+    {
+        statsPtr->txBytes = pa_wifiNl80211_AttrU32(staAttrs[NL80211_STA_INFO_TX_BYTES]);
+    }
 
-    if ((NULL == filePtr) || (NULL == dataPtr))
+    if (NULL != staAttrs[NL80211_STA_INFO_RX_PACKETS])
+    {
+        statsPtr->rxPackets = pa_wifiNl80211_AttrU32(staAttrs[NL80211_STA_INFO_RX_PACKETS]);
+    }
+    if (NULL != staAttrs[NL80211_STA_INFO_TX_PACKETS])
+    {
+        statsPtr->txPackets = pa_wifiNl80211_AttrU32(staAttrs[NL80211_STA_INFO_TX_PACKETS]);
+    }
+    if (NULL != staAttrs[NL80211_STA_INFO_SIGNAL])
+    {
+        statsPtr->signalStrength =
+            (int8_t)pa_wifiNl80211_AttrU8(staAttrs[NL80211_STA_INFO_SIGNAL]);
+    }
+    if (NULL != staAttrs[NL80211_STA_INFO_INACTIVE_TIME])
+    {
+        statsPtr->inactiveMs = pa_wifiNl80211_AttrU32(staAttrs[NL80211_STA_INFO_INACTIVE_TIME]);
+    }
+    statsPtr->txBitrate = pa_wifiNl80211_ParseBitrate(staAttrs[NL80211_STA_INFO_TX_BITRATE]);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * This function appends configuration lines to the hostapd.conf content.
+ *
+ * @return LE_FAULT  The content does not fit.
+ * @return LE_OK     The function succeeded.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t AppendApCfg
+(
+    char       *configPtr,
+        ///< [IN/OUT]
+        ///< hostapd.conf content
+    size_t      configSize,
+        ///< [IN]
+        ///< Size of the content buffer
+    const char *dataPtr
+        ///< [IN]
+        ///< Lines to append
+)
+{
+    if ((NULL == configPtr) || (NULL == dataPtr))
     {
         LE_ERROR("Invalid parameter(s)");
         return LE_FAULT;
     }
 
-    length = strlen(dataPtr);
-    if (length > 0)
+    if (LE_OK != le_utf8_Append(configPtr, dataPtr, configSize, NULL))
     {
-        if (fwrite(dataPtr, 1, length, filePtr) != length)
-        {
-            LE_ERROR("Unable to generate the hostapd file.");
-            return LE_FAULT;
-        }
+        LE_ERROR("hostapd.conf exceeds %zu bytes", configSize);
+        return LE_FAULT;
     }
 
     return LE_OK;
@@ -349,7 +515,7 @@ static le_result_t WriteApCfgFile
 
 //--------------------------------------------------------------------------------------------------
 /**
- * This function writes configuration to hostapd.conf.
+ * This function generates the hostapd.conf content from the saved settings.
  *
  * @return LE_FAULT  The function failed.
  * @return LE_OK     The function succeeded.
@@ -357,19 +523,18 @@ static le_result_t WriteApCfgFile
 //--------------------------------------------------------------------------------------------------
 static le_result_t GenerateHostapdConf
 (
-    void
+    char   *configPtr,
+        ///< [OUT]
+        ///< hostapd.conf content
+    size_t  configSize
+        ///< [IN]
+        ///< Size of the content buffer
 )
 {
     char        tmpConfig[TEMP_STRING_MAX_BYTES];
     le_result_t result = LE_FAULT;
-    FILE        *configFilePtr  = NULL;
 
-    configFilePtr = fopen(WIFI_HOSTAPD_FILE, "w");
-    if (NULL ==  configFilePtr)
-    {
-        LE_ERROR("Unable to create hostapd.conf file.");
-        return LE_FAULT;
-    }
+    configPtr[0] = '\0';
 
     memset(tmpConfig, '\0', sizeof(tmpConfig));
     // prepare SSID, channel, country code etc in hostapd.conf
@@ -382,7 +547,7 @@ static le_result_t GenerateHostapdConf
             !SavedDiscoverable);
     // Write common config such as SSID, channel, country code, etc in hostapd.conf
     tmpConfig[TEMP_STRING_MAX_BYTES - 1] = '\0';
-    if (LE_OK != WriteApCfgFile(tmpConfig, configFilePtr))
+    if (LE_OK != AppendApCfg(configPtr, configSize, tmpConfig))
     {
         LE_ERROR("Unable to set SSID, channel, etc in hostapd.conf");
         goto error;
@@ -394,7 +559,7 @@ static le_result_t GenerateHostapdConf
     {
         case LE_WIFIAP_SECURITY_NONE:
             LE_DEBUG("LE_WIFIAP_SECURITY_NONE");
-            result = WriteApCfgFile(HOSTAPD_CONFIG_SECURITY_NONE, configFilePtr);
+            result = AppendApCfg(configPtr, configSize, HOSTAPD_CONFIG_SECURITY_NONE);
             break;
 
         case LE_WIFIAP_SECURITY_WPA2:
@@ -404,20 +569,22 @@ static le_result_t GenerateHostapdConf
                 snprintf(tmpConfig, sizeof(tmpConfig), (HOSTAPD_CONFIG_SECURITY_WPA2
                         "wpa_passphrase=%s\n"), SavedPassphrase);
                 tmpConfig[TEMP_STRING_MAX_BYTES - 1] = '\0';
-                result = WriteApCfgFile(tmpConfig, configFilePtr);
+                result = AppendApCfg(configPtr, configSize, tmpConfig);
             }
             else if ('\0' != SavedPreSharedKey[0])
             {
                 snprintf(tmpConfig, sizeof(tmpConfig), (HOSTAPD_CONFIG_SECURITY_WPA2
                         "wpa_psk=%s\n"), SavedPreSharedKey);
                 tmpConfig[TEMP_STRING_MAX_BYTES - 1] = '\0';
-                result = WriteApCfgFile(tmpConfig, configFilePtr);
+                result = AppendApCfg(configPtr, configSize, tmpConfig);
             }
             else
             {
                 LE_ERROR("Security protocol is missing!");
                 result = LE_FAULT;
             }
+            // Do not leave the credential on the stack
+            memset(tmpConfig, '\0', sizeof(tmpConfig));
             break;
 
         default:
@@ -481,21 +648,411 @@ static le_result_t GenerateHostapdConf
     }
     // Write IEEE std in hostapd.conf
     tmpConfig[TEMP_STRING_MAX_BYTES - 1] = '\0';
-    if (LE_OK != WriteApCfgFile(tmpConfig, configFilePtr))
+    if (LE_OK != AppendApCfg(configPtr, configSize, tmpConfig))
     {
         LE_ERROR("Unable to set IEEE std in hostapd.conf");
         goto error;
     }
-    fclose(configFilePtr);
     return LE_OK;
 
 error:
-    fclose(configFilePtr);
-    // Remove generated hostapd.conf file
-    remove(WIFI_HOSTAPD_FILE);
+    memset(configPtr, '\0', configSize);
     return LE_FAULT;
 }
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * This function writes the hostapd.conf file. The content goes to a temporary file renamed over
+ * hostapd.conf, so that a reading hostapd never gets a partial file.
+ *
+ * @return LE_FAULT  The function failed.
+ * @return LE_OK     The function succeeded.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t WriteHostapdConf
+(
+    const char *configPtr
+        ///< [IN]
+        ///< hostapd.conf content
+)
+{
+    size_t  length = strlen(configPtr);
+    size_t  written = 0;
+    int     fd;
+
+    // The file holds the credentials
+    fd = open(WIFI_HOSTAPD_TMP_FILE, O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+    if (-1 == fd)
+    {
+        LE_ERROR("Unable to create %s: errno %d (%s)",
+                 WIFI_HOSTAPD_TMP_FILE, errno, LE_ERRNO_TXT(errno));
+        return LE_FAULT;
+    }
+
+    while (written < length)
+    {
+        ssize_t count = write(fd, configPtr + written, length - written);
+
+        if (-1 == count)
+        {
+            if (EINTR == errno)
+            {
+                continue;
+            }
+            LE_ERROR("Unable to generate the hostapd file: errno %d (%s)",
+                     errno, LE_ERRNO_TXT(errno));
+            break;
+        }
+        written += (size_t)count;
+    }
+
+    if ((0 != close(fd)) || (written < length) ||
+        (0 != rename(WIFI_HOSTAPD_TMP_FILE, WIFI_HOSTAPD_FILE)))
+    {
+        LE_ERROR("Unable to write %s", WIFI_HOSTAPD_FILE);
+        unlink(WIFI_HOSTAPD_TMP_FILE);
+        return LE_FAULT;
+    }
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Compute the time elapsed since a given time, in milliseconds.
+ */
+//--------------------------------------------------------------------------------------------------
+static uint32_t GetElapsedMs
+(
+    le_clk_Time_t startTime
+)
+{
+    le_clk_Time_t duration = le_clk_Sub(le_clk_GetRelativeTime(), startTime);
+
+    return (uint32_t)(duration.sec * 1000 + duration.usec / 1000);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Convert a channel number of the configured hardware mode to its center frequency.
+ *
+ * @return Frequency in MHz.
+ */
+//--------------------------------------------------------------------------------------------------
+static uint32_t ChannelToFrequency
+(
+    uint16_t channelNumber
+)
+{
+    switch (SavedIeeeStdMask & HARDWARE_MODE_MASK)
+    {
+        case LE_WIFIAP_BITMASK_IEEE_STD_A:
+            // Channels 182 to 196 belong to the 4.9 GHz band
+            return (channelNumber >= 182) ? (4000 + 5 * channelNumber) :
+                                            (5000 + 5 * channelNumber);
+        case LE_WIFIAP_BITMASK_IEEE_STD_AD:
+            return 56160 + 2160 * channelNumber;
+        default:
+            return (14 == channelNumber) ? 2484 : (2407 + 5 * channelNumber);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Open the control interface of a freshly started hostapd.
+ *
+ * @return LE_FAULT  The function failed.
+ * @return LE_OK     The function succeeded.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t OpenHostapdCtrl
+(
+    void
+)
+{
+    le_result_t result = LE_NOT_FOUND;
+    int         retries;
+
+    // The control interface appears slightly after the daemon detached.
+    for (retries = 0; retries < HOSTAPD_CTRL_OPEN_RETRIES; retries++)
+    {
+        result = pa_wifiCtrl_Open(&HostapdConn, HOSTAPD_CTRL_IFACE_PATH);
+        if (LE_NOT_FOUND != result)
+        {
+            break;
+        }
+        usleep(HOSTAPD_CTRL_OPEN_DELAY_US);
+    }
+
+    if (LE_OK != result)
+    {
+        LE_WARN("Unable to reach hostapd on %s (%d), settings will apply on next start",
+                HOSTAPD_CTRL_IFACE_PATH, result);
+        return LE_FAULT;
+    }
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Terminate the running hostapd through its control interface and wait for it to exit.
+ */
+//--------------------------------------------------------------------------------------------------
+static void TerminateHostapd
+(
+    void
+)
+{
+    int retries;
+
+    if (!pa_wifiCtrl_IsOpen(&HostapdConn))
+    {
+        return;
+    }
+
+    pa_wifiCtrl_RequestOk(&HostapdConn, "TERMINATE");
+    pa_wifiCtrl_Close(&HostapdConn);
+
+    // hostapd removes its control interface when exiting
+    for (retries = 0; retries < HOSTAPD_CTRL_OPEN_RETRIES; retries++)
+    {
+        if (0 != access(HOSTAPD_CTRL_IFACE_PATH, F_OK))
+        {
+            return;
+        }
+        usleep(HOSTAPD_CTRL_OPEN_DELAY_US);
+    }
+    LE_WARN("hostapd still running after TERMINATE");
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Restart hostapd with a new configuration. This drops all the stations and is only used when the
+ * configuration cannot be applied live. The driver stays loaded.
+ *
+ * @return LE_FAULT  The function failed.
+ * @return LE_OK     The function succeeded.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t RestartHostapd
+(
+    const char *configPtr
+        ///< [IN]
+        ///< hostapd.conf content
+)
+{
+    le_clk_Time_t startTime = le_clk_GetRelativeTime();
+    int           systemResult;
+
+    if (LE_OK != WriteHostapdConf(configPtr))
+    {
+        LE_ERROR("Failed to generate hostapd.conf");
+        return LE_FAULT;
+    }
+
+    TerminateHostapd();
+    RunningConfig[0] = '\0';
+
+    systemResult = system(WIFI_SCRIPT_PATH COMMAND_WIFIAP_HOSTAPD_START);
+    if ((!WIFEXITED(systemResult)) || (0 != WEXITSTATUS(systemResult)))
+    {
+        LE_ERROR("WiFi AP Command \"%s\" Failed: (%d)",
+                 COMMAND_WIFIAP_HOSTAPD_START, systemResult);
+        return LE_FAULT;
+    }
+    le_utf8_Copy(RunningConfig, configPtr, sizeof(RunningConfig), NULL);
+
+    if (LE_OK == OpenHostapdCtrl())
+    {
+        HostapdRestartLatencyMs = GetElapsedMs(startTime);
+    }
+
+    LE_INFO("hostapd restarted in %u ms", GetElapsedMs(startTime));
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Send a SET command to the running hostapd for each parameter changed by a new hostapd.conf
+ * content.
+ *
+ * @return LE_FAULT  A command was rejected.
+ * @return LE_OK     The function succeeded.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t SetChangedParams
+(
+    const char *runningPtr,
+        ///< [IN]
+        ///< hostapd.conf content of the running hostapd
+    const char *newPtr,
+        ///< [IN]
+        ///< New hostapd.conf content
+    bool        isChannelSet
+        ///< [IN]
+        ///< Whether to SET the channel, otherwise switched with a CSA
+)
+{
+    char        cmd[HOSTAPD_CMD_MAX_BYTES];
+    const char *linePtr;
+    const char *valuePtr;
+    size_t      keyLen;
+    size_t      valueLen;
+    le_result_t result = LE_OK;
+
+    for (linePtr = newPtr; (NULL != linePtr) && (LE_OK == result); )
+    {
+        const char *keyPtr = linePtr;
+
+        linePtr = pa_wifiApConf_ParseLine(linePtr, &keyLen, &valuePtr, &valueLen);
+        if ((NULL == linePtr) || (0 == keyLen) ||
+            !pa_wifiApConf_IsValueChanged(runningPtr, keyPtr, keyLen, valuePtr, valueLen))
+        {
+            continue;
+        }
+        if ((!isChannelSet) && (0 == strncmp(keyPtr, "channel=", keyLen + 1)))
+        {
+            continue;
+        }
+
+        snprintf(cmd, sizeof(cmd), "SET %.*s %.*s",
+                 (int)keyLen, keyPtr, (int)valueLen, valuePtr);
+        result = pa_wifiCtrl_RequestOk(&HostapdConn, cmd);
+    }
+
+    // Do not leave a credential on the stack
+    memset(cmd, 0, sizeof(cmd));
+    return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Bring the running hostapd to the saved settings. The generated hostapd.conf is compared with
+ * the running one and only the changed parameters are applied, with the cheapest action they
+ * allow. hostapd is restarted if a change cannot be applied live or is rejected.
+ *
+ * @note Nothing is done when hostapd is not running: the saved setting is used on next start.
+ *
+ * @return LE_FAULT  The function failed.
+ * @return LE_OK     The function succeeded.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t ApplyHostapdConf
+(
+    const char *settingPtr
+        ///< [IN]
+        ///< Name of the setting, for the logs
+)
+{
+    char          newConfig[HOSTAPD_CONFIG_MAX_BYTES];
+    char          cmd[HOSTAPD_CMD_MAX_BYTES];
+    le_clk_Time_t startTime;
+    uint8_t       apply;
+    le_result_t   result = LE_OK;
+
+    if (!pa_wifiCtrl_IsOpen(&HostapdConn))
+    {
+        return LE_OK;
+    }
+
+    startTime = le_clk_GetRelativeTime();
+    if (LE_OK != GenerateHostapdConf(newConfig, sizeof(newConfig)))
+    {
+        // e.g. WPA2 selected before its credential is set
+        LE_WARN("Incomplete configuration, %s applies once completed", settingPtr);
+        return LE_OK;
+    }
+
+    apply = pa_wifiApConf_Diff(RunningConfig, newConfig);
+    if (0 == apply)
+    {
+        LE_DEBUG("%s unchanged", settingPtr);
+    }
+    else if (apply & PA_WIFIAPCONF_APPLY_RESTART)
+    {
+        LE_INFO("%s needs a hostapd restart", settingPtr);
+        result = RestartHostapd(newConfig);
+    }
+    else
+    {
+        if (apply & PA_WIFIAPCONF_APPLY_BSS)
+        {
+            // The BSS is restarted with all the changes, including the channel
+            result = pa_wifiCtrl_RequestOk(&HostapdConn, "DISABLE");
+            if (LE_OK == result)
+            {
+                result = SetChangedParams(RunningConfig, newConfig, true);
+            }
+            if (LE_OK == result)
+            {
+                result = pa_wifiCtrl_RequestOk(&HostapdConn, "ENABLE");
+            }
+        }
+        else
+        {
+            result = SetChangedParams(RunningConfig, newConfig, false);
+            if ((LE_OK == result) && (apply & PA_WIFIAPCONF_APPLY_RELOAD))
+            {
+                // RELOAD rebuilds the keys and the beacon but disconnects all the stations, which
+                // then join again with the new credential
+                result = pa_wifiCtrl_RequestOk(&HostapdConn, "RELOAD");
+            }
+            else if ((LE_OK == result) && (apply & PA_WIFIAPCONF_APPLY_BEACON))
+            {
+                // UPDATE_BEACON only rebuilds the beacon, the stations stay associated
+                result = pa_wifiCtrl_RequestOk(&HostapdConn, "UPDATE_BEACON");
+            }
+            if ((LE_OK == result) && (apply & PA_WIFIAPCONF_APPLY_CSA))
+            {
+                // Announce the new channel in the beacons so that the stations follow
+                snprintf(cmd, sizeof(cmd), "CHAN_SWITCH %d %u",
+                         CSA_BEACON_COUNT, ChannelToFrequency(SavedChannelNumber));
+                result = pa_wifiCtrl_RequestOk(&HostapdConn, cmd);
+            }
+        }
+
+        if (LE_OK == result)
+        {
+            LE_INFO("%s applied live in %u ms (hostapd restart: %u ms)",
+                    settingPtr, GetElapsedMs(startTime), HostapdRestartLatencyMs);
+
+            // Keep hostapd.conf in sync for the next start
+            le_utf8_Copy(RunningConfig, newConfig, sizeof(RunningConfig), NULL);
+            WriteHostapdConf(newConfig);
+        }
+        else
+        {
+            LE_WARN("Unable to apply %s live, restarting hostapd", settingPtr);
+            result = RestartHostapd(newConfig);
+        }
+    }
+
+    // Do not leave the credentials on the stack
+    memset(newConfig, 0, sizeof(newConfig));
+    return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Apply a setting just saved to the running hostapd. A failure is only logged: the setting stays
+ * saved and is used on the next start.
+ */
+//--------------------------------------------------------------------------------------------------
+static void ApplySavedSetting
+(
+    const char *settingPtr
+        ///< [IN]
+        ///< Name of the setting, for the logs
+)
+{
+    if (LE_OK != ApplyHostapdConf(settingPtr))
+    {
+        LE_ERROR("Failed to apply %s to the running hostapd, saved for the next start",
+                 settingPtr);
+    }
+}
+
 #ifdef SIMU
 // SIMU variable for timers
 static le_timer_Ref_t SimuClientConnectTimer = NULL;
@@ -585,7 +1142,9 @@ le_result_t pa_wifiAp_Init
 
     LE_INFO("pa_wifiAp_Init() called");
     // Create the event for signaling user handlers.
-    WifiApPaEvent = le_event_CreateId("WifiApPaEvent", sizeof(le_wifiAp_Event_t));
+    WifiApPaEvent = le_event_CreateId("WifiApPaEvent", sizeof(pa_wifiAp_EventInd_t));
+    StationSocket.fd = -1;
+    pa_wifiNl80211_Init();
 
     return result;
 }
@@ -611,6 +1170,10 @@ le_result_t pa_wifiAp_Release
  * This function starts the WiFi access point.
  * Note that all settings, if to be used, such as security, username, password must set prior to
  * starting the access point.
+ * Settings changed while the access point runs are applied live, with a hostapd restart only for
+ * the ones that need it, so that a Stop/Start is not needed to apply them. Starting the running
+ * access point only applies the pending changes. A setting which fails to apply live stays saved,
+ * and this function applies it again.
  *
  * @return LE_FAULT         The function failed.
  * @return LE_OK            The function succeeded.
@@ -624,7 +1187,10 @@ le_result_t pa_wifiAp_Start
     void
 )
 {
-    int     systemResult;
+    char          config[HOSTAPD_CONFIG_MAX_BYTES];
+    le_result_t   result;
+    int           systemResult;
+    le_clk_Time_t startTime;
 
     // Check that an SSID is provided before starting
     if ('\0' == SavedSsid[0])
@@ -641,18 +1207,39 @@ le_result_t pa_wifiAp_Start
         return LE_FAULT;
     }
 
+    // Already serving: only apply the settings changed since
+    if (pa_wifiCtrl_IsOpen(&HostapdConn))
+    {
+        return ApplyHostapdConf("Configuration");
+    }
+
     LE_DEBUG("Starting AP, SSID: %s", SavedSsid);
 
     // Create hostapd.conf file in /tmp
-    if ( LE_OK != GenerateHostapdConf())
+    result = GenerateHostapdConf(config, sizeof(config));
+    if (LE_OK == result)
+    {
+        result = WriteHostapdConf(config);
+    }
+    // Do not leave the credentials on the stack
+    memset(config, 0, sizeof(config));
+    if (LE_OK != result)
     {
         LE_ERROR("Failed to generate hostapd.conf");
         return LE_FAULT;
     }
 
+    startTime = le_clk_GetRelativeTime();
     systemResult = system(WIFI_SCRIPT_PATH COMMAND_WIFI_HW_START);
+    // The driver brings the interface up in the background: wait for it rather than polling
+    if ((0 == WEXITSTATUS(systemResult)) &&
+        (LE_OK != pa_wifiNl80211_WaitInterfaceUp(PA_WIFINL80211_IFNAME,
+                                                 PA_WIFINL80211_IF_UP_TIMEOUT_MS)))
+    {
+        systemResult = system(WIFI_SCRIPT_PATH COMMAND_WIFI_START_FAILED);
+    }
     /**
-     * Returned values:
+     * Returned values, of WIFI_START_FAILED when the interface is not up in time:
      *   0: if the interface is correctly moutned
      *  50: if WiFi card is not inserted
      * 100: if WiFi card may not work
@@ -662,12 +1249,17 @@ le_result_t pa_wifiAp_Start
 
     if (0 == WEXITSTATUS(systemResult))
     {
-        LE_DEBUG("WiFi hardware started correctly");
-        // Create WiFi AP PA Thread
-        WifiApPaThread = le_thread_Create("WifiApPaThread", WifiApPaThreadMain, NULL);
-        le_thread_SetJoinable(WifiApPaThread);
-        le_thread_AddChildDestructor(WifiApPaThread, ThreadDestructor, NULL);
-        le_thread_Start(WifiApPaThread);
+        StartLatencyMs = GetElapsedMs(startTime);
+        LE_INFO("WiFi hardware started in %u ms", StartLatencyMs);
+        // Listen to the nl80211 notifications to report the station events
+        if (LE_OK == pa_wifiNl80211_AddEventListener(NlEventHandler, NULL))
+        {
+            IsEventListenerStarted = true;
+        }
+        else
+        {
+            LE_ERROR("Unable to listen to nl80211 events, station events will not be reported");
+        }
     }
     // Return value of 50 means WiFi card is not inserted.
     else if ( PA_NOT_FOUND == WEXITSTATUS(systemResult))
@@ -690,6 +1282,7 @@ le_result_t pa_wifiAp_Start
     }
 
     // Start Access Point cmd: /bin/hostapd /etc/hostapd.conf
+    startTime = le_clk_GetRelativeTime();
     systemResult = system(WIFI_SCRIPT_PATH COMMAND_WIFIAP_HOSTAPD_START);
     if ((!WIFEXITED(systemResult)) || (0 != WEXITSTATUS(systemResult)))
     {
@@ -700,13 +1293,29 @@ le_result_t pa_wifiAp_Start
         remove(WIFI_HOSTAPD_FILE);
         goto error;
     }
+    GenerateHostapdConf(RunningConfig, sizeof(RunningConfig));
+
+    // Keep a connection to hostapd to apply the later settings live
+    if (LE_OK == OpenHostapdCtrl())
+    {
+        HostapdRestartLatencyMs = GetElapsedMs(startTime);
+    }
+
+    // Serve the clients as soon as they associate, the range is set by pa_wifiAp_SetIpRange()
+    if (LE_OK != pa_wifiDhcp_Start(PA_WIFINL80211_IFNAME, WIFI_DHCP_LEASE_FILE))
+    {
+        LE_ERROR("Unable to start the DHCP server");
+    }
 
     LE_INFO("WiFi AP started correclty");
     return LE_OK;
 
 error:
-    le_thread_Cancel(WifiApPaThread);
-    le_thread_Join(WifiApPaThread, NULL);
+    if (IsEventListenerStarted)
+    {
+        pa_wifiNl80211_RemoveEventListener(NlEventHandler, NULL);
+        IsEventListenerStarted = false;
+    }
     return LE_FAULT;
 }
 
@@ -726,12 +1335,20 @@ le_result_t pa_wifiAp_Stop
 {
     int status;
 
+    pa_wifiDhcp_Stop();
+
     // Try to delete the rule allowing the DHCP ports on WLAN. Ignore if it fails
     status = system(WIFI_SCRIPT_PATH COMMAND_IPTABLE_DHCP_DELETE);
     if ((!WIFEXITED(status)) || (0 != WEXITSTATUS(status)))
     {
         LE_WARN("Deleting rule for DHCP port fails");
     }
+    IsDhcpRuleInserted = false;
+
+    // Let hostapd deauthenticate the stations and exit cleanly, the script only kills it if
+    // it is still running.
+    TerminateHostapd();
+    memset(RunningConfig, 0, sizeof(RunningConfig));
 
     status = system(WIFI_SCRIPT_PATH COMMAND_WIFIAP_HOSTAPD_STOP);
     if ((!WIFEXITED(status)) || (0 != WEXITSTATUS(status)))
@@ -749,13 +1366,15 @@ le_result_t pa_wifiAp_Stop
         return LE_FAULT;
     }
 
-    // Cancel the previously created thread
-    le_thread_Cancel(WifiApPaThread);
-    if (LE_OK != le_thread_Join(WifiApPaThread, NULL))
+    // Stop listening to the nl80211 notifications
+    if (IsEventListenerStarted)
     {
-        return LE_FAULT;
+        pa_wifiNl80211_RemoveEventListener(NlEventHandler, NULL);
+        IsEventListenerStarted = false;
     }
 
+    pa_wifiNl80211_Close(&StationSocket);
+
     // Remove the previously created hostapd.conf file in /tmp
     remove(WIFI_HOSTAPD_FILE);
 
@@ -763,6 +1382,108 @@ le_result_t pa_wifiAp_Stop
     return LE_OK;
 }
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the traffic and signal of all the stations associated to the access point, with a single
+ * nl80211 station dump.
+ *
+ * @return LE_OK            The function succeeded.
+ * @return LE_OVERFLOW      More stations than maxCount are associated, the first ones are
+ *                          returned.
+ * @return LE_NOT_FOUND     The access point is not started.
+ * @return LE_FAULT         The function failed.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiAp_GetStationStats
+(
+    pa_wifiAp_StationStats_t *statsPtr,
+        ///< [OUT]
+        ///< Stations
+    size_t                    maxCount,
+        ///< [IN]
+        ///< Number of entries of statsPtr
+    size_t                   *countPtr
+        ///< [OUT]
+        ///< Number of stations returned
+)
+{
+    pa_wifiNl80211_Msg_t msg;
+    StationDumpCtx_t     ctx;
+    uint32_t             ifIndex;
+    le_result_t          result;
+
+    if ((NULL == statsPtr) || (NULL == countPtr))
+    {
+        LE_ERROR("Invalid parameter(s)");
+        return LE_FAULT;
+    }
+    *countPtr = 0;
+
+    if ('\0' == RunningConfig[0])
+    {
+        return LE_NOT_FOUND;
+    }
+
+    ifIndex = if_nametoindex(PA_WIFINL80211_IFNAME);
+    if (0 == ifIndex)
+    {
+        LE_ERROR("Interface %s not found", PA_WIFINL80211_IFNAME);
+        return LE_FAULT;
+    }
+
+    // The socket is kept open between the dumps
+    if ((StationSocket.fd < 0) && (LE_OK != pa_wifiNl80211_Open(&StationSocket)))
+    {
+        return LE_FAULT;
+    }
+
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.statsPtr = statsPtr;
+    ctx.maxCount = maxCount;
+
+    pa_wifiNl80211_InitMsg(&StationSocket, &msg, NL80211_CMD_GET_STATION, NLM_F_DUMP);
+    pa_wifiNl80211_PutU32(&msg, NL80211_ATTR_IFINDEX, ifIndex);
+    result = pa_wifiNl80211_Request(&StationSocket, &msg, NlStationDumpHandler, &ctx);
+    if (LE_OK != result)
+    {
+        LE_ERROR("Unable to dump the stations (%d)", result);
+        // Reopen the socket on the next dump, it may be out of sync
+        pa_wifiNl80211_Close(&StationSocket);
+        return LE_FAULT;
+    }
+
+    *countPtr = ctx.count;
+    return ctx.isTruncated ? LE_OVERFLOW : LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the time taken by the last start of the access point.
+ *
+ * @return LE_OK            The function succeeded.
+ * @return LE_UNAVAILABLE   The access point was not started yet.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiAp_GetStartLatency
+(
+    uint32_t *interfaceUpMsPtr,
+        ///< [OUT]
+        ///< Time from the start of the WiFi hardware until the WLAN interface was up (ms)
+    uint32_t *hostapdMsPtr
+        ///< [OUT]
+        ///< Time taken by the last hostapd (re)start (ms), 0 if unknown
+)
+{
+    if (0 == StartLatencyMs)
+    {
+        return LE_UNAVAILABLE;
+    }
+
+    *interfaceUpMsPtr = StartLatencyMs;
+    *hostapdMsPtr = HostapdRestartLatencyMs;
+    return LE_OK;
+}
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Add handler function for WiFi related events.
@@ -800,6 +1521,41 @@ le_result_t  pa_wifiAp_AddEventHandler
     return LE_OK;
 }
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add handler function for WiFi related event indications, which also give the station.
+ *
+ * @return LE_BAD_PARAMETER Some parameter is invalid.
+ * @return LE_OK            Function succeeded.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiAp_AddEventIndHandler
+(
+    pa_wifiAp_EventIndHandlerFunc_t handlerPtr,
+        ///< [IN]
+        ///< Event indication handler function pointer
+
+    void *contextPtr
+        ///< [IN]
+        ///< Associated event context
+)
+{
+    le_event_HandlerRef_t handlerRef;
+
+    handlerRef = le_event_AddLayeredHandler("WifiApPaIndHandler",
+                                            WifiApPaEvent,
+                                            FirstLayerWifiApEventIndHandler,
+                                            (le_event_HandlerFunc_t)handlerPtr);
+    if (NULL == handlerRef)
+    {
+        LE_ERROR("ERROR: le_event_AddLayeredHandler returned NULL");
+        return LE_BAD_PARAMETER;
+    }
+
+    le_event_SetContextPtr(handlerRef, contextPtr);
+    return LE_OK;
+}
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Set the Service Set IDentification (SSID) of the access point
@@ -834,6 +1590,8 @@ le_result_t pa_wifiAp_SetSsid
         memcpy(&SavedSsid[0], (const char *)&ssidPtr[0], ssidNumElements);
         // Make sure there is a null termination
         SavedSsid[ssidNumElements] = '\0';
+
+        ApplySavedSetting("SSID");
         result = LE_OK;
     }
     else
@@ -869,6 +1627,7 @@ le_result_t pa_wifiAp_SetSecurityProtocol
         case LE_WIFIAP_SECURITY_NONE:
         case LE_WIFIAP_SECURITY_WPA2:
             SavedSecurityProtocol = securityProtocol;
+            ApplySavedSetting("Security protocol");
             result = LE_OK;
             break;
 
@@ -910,6 +1669,7 @@ le_result_t pa_wifiAp_SetPassPhrase
         {
             // Store Passphrase to be used later during startup procedure
             le_utf8_Copy(SavedPassphrase, passphrasePtr, sizeof(SavedPassphrase), NULL);
+            ApplySavedSetting("Passphrase");
             result = LE_OK;
         }
         else
@@ -953,6 +1713,7 @@ le_result_t pa_wifiAp_SetPreSharedKey
         {
             // Store PSK to be used later during startup procedure
             le_utf8_Copy(SavedPreSharedKey, preSharedKeyPtr, sizeof(SavedPreSharedKey), NULL);
+            ApplySavedSetting("PSK");
             result = LE_OK;
         }
     }
@@ -979,6 +1740,8 @@ le_result_t pa_wifiAp_SetDiscoverable
     // Store Discoverable to be used later during startup procedure
     LE_INFO("Set discoverability");
     SavedDiscoverable = isDiscoverable;
+
+    ApplySavedSetting("Discoverability");
     return LE_OK;
 }
 
@@ -1029,8 +1792,9 @@ le_result_t pa_wifiAp_SetChannel
     if ((channelNumber >= MIN_CHANNEL_VALUE) &&
         (channelNumber <= MAX_CHANNEL_VALUE))
     {
-       SavedChannelNumber = channelNumber;
-       result = LE_OK;
+        SavedChannelNumber = channelNumber;
+        ApplySavedSetting("Channel");
+        result = LE_OK;
     }
     return result;
 }
@@ -1092,6 +1856,7 @@ le_result_t pa_wifiAp_SetIeeeStandard
     }
 
     SavedIeeeStdMask = stdMask;
+    ApplySavedSetting("IEEE standard");
     return LE_OK;
 }
 
@@ -1152,6 +1917,7 @@ le_result_t pa_wifiAp_SetCountryCode
         {
             strncpy(&SavedCountryCode[0], &countryCodePtr[0], length );
             SavedCountryCode[length] = '\0';
+            ApplySavedSetting("Country code");
             result = LE_OK;
         }
     }
@@ -1181,8 +1947,9 @@ le_result_t pa_wifiAp_SetMaxNumberClients
     LE_INFO("Set max clients");
     if ((maxNumberClients >= 1) && (maxNumberClients <= WIFI_MAX_USERS))
     {
-       SavedMaxNumClients = maxNumberClients;
-       result = LE_OK;
+        SavedMaxNumClients = maxNumberClients;
+        ApplySavedSetting("Max number of clients");
+        result = LE_OK;
     }
     return result;
 }
@@ -1192,6 +1959,7 @@ le_result_t pa_wifiAp_SetMaxNumberClients
  * Define the access point IP address and the client IP addresses range.
  *
  * @note The access point IP address must be defined outside the client IP addresses range.
+ * @note The range is applied to the embedded DHCP server at once, without restarting it.
  *
  * @return LE_BAD_PARAMETER At least, one of the given IP addresses is invalid.
  * @return LE_FAULT         A system call has failed.
@@ -1261,6 +2029,8 @@ le_result_t pa_wifiAp_SetIpRange
             start = start ^ stop;
             stop = stop ^ start;
             start = start ^ stop;
+            saStartPtr.sin_addr.s_addr = htonl(start);
+            saStopPtr.sin_addr.s_addr = htonl(stop);
         }
 
         if ((ap >= start) && (ap <= stop))
@@ -1274,8 +2044,12 @@ le_result_t pa_wifiAp_SetIpRange
         "/usr/bin:/bin:/usr/local/sbin:/usr/sbin:/sbin");
 
     {
-        char cmd[256];
-        int  systemResult;
+        char         cmd[256];
+        int          systemResult;
+        uint32_t     netmask = WIFI_DHCP_DEFAULT_NETMASK;
+        struct ifreq ifr;
+        int          fd;
+        le_result_t  result;
 
         snprintf((char *)&cmd, sizeof(cmd), "%s %s %s",
                 WIFI_SCRIPT_PATH,
@@ -1288,48 +2062,51 @@ le_result_t pa_wifiAp_SetIpRange
             LE_ERROR("Unable to mount the network interface.");
             return LE_FAULT;
         }
+
+        // Give the clients the subnet of the interface
+        memset(&ifr, 0, sizeof(ifr));
+        le_utf8_Copy(ifr.ifr_name, PA_WIFINL80211_IFNAME, sizeof(ifr.ifr_name), NULL);
+        fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+        if ((fd >= 0) && (0 == ioctl(fd, SIOCGIFNETMASK, &ifr)))
+        {
+            netmask = ntohl(((struct sockaddr_in *)&ifr.ifr_netmask)->sin_addr.s_addr);
+        }
         else
         {
-            FILE *filePtr;
-
-            LE_INFO("Creation of dnsmasq configuration file (%s)", DNSMASQ_CFG_FILE);
+            LE_WARN("Unable to read the netmask of %s, errno %d (%s)", PA_WIFINL80211_IFNAME,
+                    errno, LE_ERRNO_TXT(errno));
+        }
+        if (fd >= 0)
+        {
+            close(fd);
+        }
 
-            if (symlink(DNSMASQ_CFG_FILE, DNSMASQ_CFG_LINK) && (EEXIST != errno))
-            {
-                LE_ERROR("Unable to create link to dnsmasq configuration file: %m.");
-                return LE_FAULT;
-            }
-            filePtr = fopen (DNSMASQ_CFG_FILE, "w");
-            if (filePtr != NULL)
-            {
-                //Interface is generated when COMMAND_DNSMASQ_RESTART called
-                fprintf(filePtr, "dhcp-range=%s,%s,%dh\n", ipStartPtr, ipStopPtr, 24);
-                fprintf(filePtr, "dhcp-option=%d,%s\n", 3, ipApPtr);
-                fprintf(filePtr, "dhcp-option=%d,%s\n", 6, ipApPtr);
-                fclose(filePtr);
-            }
-            else
-            {
-                LE_ERROR("Unable to open the dnsmasq configuration file: %m.");
-                return LE_FAULT;
-            }
+        // The embedded DHCP server picks the range up live, the shared dnsmasq is left alone
+        result = pa_wifiDhcp_Start(PA_WIFINL80211_IFNAME, WIFI_DHCP_LEASE_FILE);
+        if ((LE_OK != result) && (LE_DUPLICATE != result))
+        {
+            LE_ERROR("Unable to start the DHCP server.");
+            return LE_FAULT;
+        }
+        if (LE_OK != pa_wifiDhcp_SetRange(ntohl(saApPtr.sin_addr.s_addr), netmask,
+                                          ntohl(saStartPtr.sin_addr.s_addr),
+                                          ntohl(saStopPtr.sin_addr.s_addr)))
+        {
+            return LE_BAD_PARAMETER;
+        }
 
-            LE_INFO("@AP=%s, @APstart=%s, @APstop=%s", ipApPtr, ipStartPtr, ipStopPtr);
+        LE_INFO("@AP=%s, @APstart=%s, @APstop=%s", ipApPtr, ipStartPtr, ipStopPtr);
 
-            // Insert the rule allowing the DHCP ports on WLAN
+        // Insert the rule allowing the DHCP ports on WLAN
+        if (!IsDhcpRuleInserted)
+        {
             systemResult = system(WIFI_SCRIPT_PATH COMMAND_IPTABLE_DHCP_INSERT);
             if (0 != WEXITSTATUS (systemResult))
             {
                 LE_ERROR("Unable to allow DHCP ports.");
                 return LE_FAULT;
             }
-
-            systemResult = system(WIFI_SCRIPT_PATH COMMAND_DNSMASQ_RESTART);
-            if (0 != WEXITSTATUS (systemResult))
-            {
-                LE_ERROR("Unable to restart the DHCP server.");
-                return LE_FAULT;
-            }
+            IsDhcpRuleInserted = true;
         }
     }
 
@@ -0,0 +1,242 @@
+// -------------------------------------------------------------------------------------------------
+/**
+ *  WiFi access point configuration diff
+ *
+ *  Copyright (C) Sierra Wireless Inc.
+ *
+ */
+// -------------------------------------------------------------------------------------------------
+#include "legato.h"
+
+#include "pa_wifi_apconf.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Action applying a change of each hostapd.conf parameter that can be changed live. A change of
+ * any other parameter, e.g. hw_mode or country_code, restarts hostapd.
+ */
+//--------------------------------------------------------------------------------------------------
+static const struct
+{
+    const char *keyPtr;     ///< Parameter name
+    uint8_t     apply;      ///< PA_WIFIAPCONF_APPLY_* action
+}
+HostapdParamApply[] =
+{
+    { "max_num_sta",            PA_WIFIAPCONF_APPLY_SET    },
+    { "wpa_passphrase",         PA_WIFIAPCONF_APPLY_RELOAD },
+    { "wpa_psk",                PA_WIFIAPCONF_APPLY_RELOAD },
+    { "ignore_broadcast_ssid",  PA_WIFIAPCONF_APPLY_BEACON },
+    { "channel",                PA_WIFIAPCONF_APPLY_CSA    },
+    { "ssid",                   PA_WIFIAPCONF_APPLY_BSS    },
+};
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Parse a "key=value" line of a hostapd.conf content.
+ *
+ * @return The next line, NULL at the end of the content.
+ */
+//--------------------------------------------------------------------------------------------------
+const char *pa_wifiApConf_ParseLine
+(
+    const char  *linePtr,
+        ///< [IN]
+        ///< Line to parse
+    size_t      *keyLenPtr,
+        ///< [OUT]
+        ///< Length of the key, 0 if the line is not a parameter
+    const char **valuePtrPtr,
+        ///< [OUT]
+        ///< Value
+    size_t      *valueLenPtr
+        ///< [OUT]
+        ///< Length of the value
+)
+{
+    size_t lineLen = strcspn(linePtr, "\n");
+    size_t keyLen = strcspn(linePtr, "=\n");
+
+    if ('\0' == linePtr[0])
+    {
+        return NULL;
+    }
+
+    *keyLenPtr = (keyLen < lineLen) ? keyLen : 0;
+    *valuePtrPtr = linePtr + keyLen + 1;
+    *valueLenPtr = (keyLen < lineLen) ? (lineLen - keyLen - 1) : 0;
+
+    return ('\n' == linePtr[lineLen]) ? (linePtr + lineLen + 1) : (linePtr + lineLen);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Look for a parameter in a hostapd.conf content.
+ *
+ * @return The value of the parameter, NULL if the parameter is absent.
+ */
+//--------------------------------------------------------------------------------------------------
+const char *pa_wifiApConf_FindValue
+(
+    const char *configPtr,
+        ///< [IN]
+        ///< hostapd.conf content
+    const char *keyPtr,
+        ///< [IN]
+        ///< Parameter name, not null terminated
+    size_t      keyLen,
+        ///< [IN]
+        ///< Length of the parameter name
+    size_t     *valueLenPtr
+        ///< [OUT]
+        ///< Length of the value
+)
+{
+    const char *linePtr = configPtr;
+    const char *valuePtr;
+    size_t      lineKeyLen;
+
+    while (NULL != linePtr)
+    {
+        const char *nextLinePtr = pa_wifiApConf_ParseLine(linePtr, &lineKeyLen, &valuePtr,
+                                                          valueLenPtr);
+
+        if ((NULL != nextLinePtr) && (keyLen == lineKeyLen) &&
+            (0 == memcmp(linePtr, keyPtr, keyLen)))
+        {
+            return valuePtr;
+        }
+        linePtr = nextLinePtr;
+    }
+
+    return NULL;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check whether a parameter of a new hostapd.conf content differs from the running one.
+ *
+ * @return true if the parameter is new or has a new value.
+ */
+//--------------------------------------------------------------------------------------------------
+bool pa_wifiApConf_IsValueChanged
+(
+    const char *runningPtr,
+        ///< [IN]
+        ///< hostapd.conf content of the running hostapd
+    const char *keyPtr,
+        ///< [IN]
+        ///< Parameter name, not null terminated
+    size_t      keyLen,
+        ///< [IN]
+        ///< Length of the parameter name
+    const char *valuePtr,
+        ///< [IN]
+        ///< New value, not null terminated
+    size_t      valueLen
+        ///< [IN]
+        ///< Length of the new value
+)
+{
+    size_t      runningLen;
+    const char *runningValuePtr = pa_wifiApConf_FindValue(runningPtr, keyPtr, keyLen, &runningLen);
+
+    return ((NULL == runningValuePtr) || (runningLen != valueLen) ||
+            (0 != memcmp(runningValuePtr, valuePtr, valueLen)));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the action applying a parameter change to the running hostapd.
+ *
+ * @return PA_WIFIAPCONF_APPLY_* action.
+ */
+//--------------------------------------------------------------------------------------------------
+uint8_t pa_wifiApConf_GetParamApply
+(
+    const char *keyPtr,
+        ///< [IN]
+        ///< Parameter name, not null terminated
+    size_t      keyLen
+        ///< [IN]
+        ///< Length of the parameter name
+)
+{
+    size_t i;
+
+    for (i = 0; i < NUM_ARRAY_MEMBERS(HostapdParamApply); i++)
+    {
+        if ((strlen(HostapdParamApply[i].keyPtr) == keyLen) &&
+            (0 == memcmp(HostapdParamApply[i].keyPtr, keyPtr, keyLen)))
+        {
+            return HostapdParamApply[i].apply;
+        }
+    }
+
+    return PA_WIFIAPCONF_APPLY_RESTART;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Compare a new hostapd.conf content with the running one.
+ *
+ * @return Mask of the PA_WIFIAPCONF_APPLY_* actions needed, 0 if both contents are equivalent.
+ */
+//--------------------------------------------------------------------------------------------------
+uint8_t pa_wifiApConf_Diff
+(
+    const char *runningPtr,
+        ///< [IN]
+        ///< hostapd.conf content of the running hostapd
+    const char *newPtr
+        ///< [IN]
+        ///< New hostapd.conf content
+)
+{
+    const char *linePtr;
+    const char *valuePtr;
+    size_t      keyLen;
+    size_t      valueLen;
+    uint8_t     apply = 0;
+
+    // New and changed parameters
+    for (linePtr = newPtr; NULL != linePtr; )
+    {
+        const char *keyPtr = linePtr;
+
+        linePtr = pa_wifiApConf_ParseLine(linePtr, &keyLen, &valuePtr, &valueLen);
+        if ((NULL != linePtr) && (0 != keyLen) &&
+            pa_wifiApConf_IsValueChanged(runningPtr, keyPtr, keyLen, valuePtr, valueLen))
+        {
+            apply |= pa_wifiApConf_GetParamApply(keyPtr, keyLen);
+        }
+    }
+
+    // Removed parameters cannot be reset over the control interface, except a WPA credential
+    // replaced by the other one: hostapd clears wpa_psk when setting wpa_passphrase and conversely.
+    for (linePtr = runningPtr; NULL != linePtr; )
+    {
+        const char *keyPtr = linePtr;
+
+        linePtr = pa_wifiApConf_ParseLine(linePtr, &keyLen, &valuePtr, &valueLen);
+        if ((NULL == linePtr) || (0 == keyLen) ||
+            (NULL != pa_wifiApConf_FindValue(newPtr, keyPtr, keyLen, &valueLen)))
+        {
+            continue;
+        }
+
+        if (((0 == strncmp(keyPtr, "wpa_psk=", keyLen + 1)) &&
+             (NULL != pa_wifiApConf_FindValue(newPtr, "wpa_passphrase", 14, &valueLen))) ||
+            ((0 == strncmp(keyPtr, "wpa_passphrase=", keyLen + 1)) &&
+             (NULL != pa_wifiApConf_FindValue(newPtr, "wpa_psk", 7, &valueLen))))
+        {
+            apply |= PA_WIFIAPCONF_APPLY_RELOAD;
+        }
+        else
+        {
+            apply |= PA_WIFIAPCONF_APPLY_RESTART;
+        }
+    }
+
+    return apply;
+}
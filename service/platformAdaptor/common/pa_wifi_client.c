@@ -8,12 +8,17 @@
 // -------------------------------------------------------------------------------------------------
 #include <sys/types.h>
 #include <sys/wait.h>
+#include <fcntl.h>
+#include <net/if.h>
 
 #include "legato.h"
 
 #include "interfaces.h"
 
 #include "pa_wifi.h"
+#include "pa_wifi_nl80211.h"
+#include "pa_wifi_ctrl.h"
+#include "pa_wifi_pmk.h"
 
 //--------------------------------------------------------------------------------------------------
 /**
@@ -26,32 +31,132 @@
 
 // Set of commands to drive the WiFi features.
 #define COMMAND_WIFI_HW_START           "WIFI_START"
+#define COMMAND_WIFI_START_FAILED       "WIFI_START_FAILED"
 #define COMMAND_WIFI_HW_STOP            "WIFI_STOP"
 #define COMMAND_WIFI_CHECK_HWSTATUS     "WIFI_CHECK_HWSTATUS"
-#define COMMAND_WIFI_SET_EVENT          "WIFI_SET_EVENT"
-#define COMMAND_WIFI_UNSET_EVENT        "WIFI_UNSET_EVENT"
 #define COMMAND_WIFICLIENT_START_SCAN   "WIFICLIENT_START_SCAN"
-#define COMMAND_WIFICLIENT_DISCONNECT   "WIFICLIENT_DISCONNECT"
 #define COMMAND_WIFICLIENT_GET_DATA     "WIFI_GET_DATA"   // using iw (interface) link command
 //Trailing space is needed to pass another argument by WIFI_SCRIPT_PATH
-#define COMMAND_WIFICLIENT_CONNECT      "WIFICLIENT_CONNECT "
+#define COMMAND_WIFICLIENT_SUPPLICANT_START "WIFICLIENT_SUPPLICANT_START "
 
 //--------------------------------------------------------------------------------------------------
 /**
- * The common wpa configuration.
+ * The wpa_supplicant configuration, followed by the network blocks of the saved networks. A
+ * network connected by pa_wifiClient_Connect() is added at run time through the control interface.
  */
 //--------------------------------------------------------------------------------------------------
-#define WPA_SUPPLICANT_CONFIG_COMMON \
-"ctrl_interface=/var/run/wpa_supplicant\n \
-ctrl_interface_group=0\n \
-update_config=1\n \
-network={\n \
-ssid=\"%.*s\"\n \
-scan_ssid=%d\n"
+#define WPA_SUPPLICANT_CONFIG_BASE \
+"ctrl_interface=/var/run/wpa_supplicant\n\
+ctrl_interface_group=0\n\
+update_config=1\n"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Temporary file renamed over WPA_SUPPLICANT_FILE, so that wpa_supplicant never reads a partially
+ * written configuration.
+ */
+//--------------------------------------------------------------------------------------------------
+#define WPA_SUPPLICANT_TMP_FILE WPA_SUPPLICANT_FILE ".tmp"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum size of the network block of a saved network, and of the whole configuration.
+ */
+//--------------------------------------------------------------------------------------------------
+#define WPA_NETWORK_BLOCK_MAX_BYTES     640
+#define WPA_SUPPLICANT_CONFIG_MAX_BYTES (sizeof(WPA_SUPPLICANT_CONFIG_BASE) + \
+                                         PA_WIFICLIENT_MAX_NETWORKS * WPA_NETWORK_BLOCK_MAX_BYTES)
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * wpa_supplicant control interface of the WLAN interface.
+ */
+//--------------------------------------------------------------------------------------------------
+#define WPA_CTRL_IFACE_PATH "/var/run/wpa_supplicant/" PA_WIFINL80211_IFNAME
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of attempts and delay between attempts to reach the control interface of a freshly
+ * started wpa_supplicant.
+ */
+//--------------------------------------------------------------------------------------------------
+#define WPA_CTRL_OPEN_RETRIES       20
+#define WPA_CTRL_OPEN_DELAY_US      100000
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum time given to a connection attempt before it is aborted (ms).
+ */
+//--------------------------------------------------------------------------------------------------
+#define CONNECT_TIMEOUT_MS          10000
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum time given to wpa_supplicant to connect to one of the saved networks, failing over from
+ * one to the next (ms).
+ */
+//--------------------------------------------------------------------------------------------------
+#define CONNECT_ANY_TIMEOUT_MS      30000
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum size of a wpa_supplicant command.
+ */
+//--------------------------------------------------------------------------------------------------
+#define WPA_CMD_MAX_BYTES           256
 
 //--------------------------------------------------------------------------------------------------
 #define PATH_MAX_BYTES      1024
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum time to wait for the end of a scan triggered through nl80211 (ms).
+ */
+//--------------------------------------------------------------------------------------------------
+#define NL80211_SCAN_TIMEOUT_MS     10000
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Information element identifier of the SSID.
+ */
+//--------------------------------------------------------------------------------------------------
+#define IE_ID_SSID                  0
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Information elements advertising the security of an access point: RSN (WPA2) and the vendor
+ * specific element which holds WPA when it starts with the WPA OUI and type.
+ */
+//--------------------------------------------------------------------------------------------------
+#define IE_ID_RSN                   48
+#define IE_ID_VENDOR                221
+#define IE_WPA_OUI_TYPE             "\x00\x50\xf2\x01"
+#define IE_WPA_OUI_TYPE_LEN         4
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Authentication and key management suite types using IEEE 802.1X: 802.1X, FT over 802.1X and
+ * 802.1X with SHA-256.
+ */
+//--------------------------------------------------------------------------------------------------
+#define AKM_SUITE_8021X             1
+#define AKM_SUITE_FT_8021X          3
+#define AKM_SUITE_8021X_SHA256      5
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Privacy bit of the capability information of a BSS.
+ */
+//--------------------------------------------------------------------------------------------------
+#define BSS_CAPABILITY_PRIVACY      0x0010
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Directory of the byte counters of the WLAN interface.
+ */
+//--------------------------------------------------------------------------------------------------
+#define INTERFACE_STATS_PATH        "/sys/class/net/" PA_WIFINL80211_IFNAME "/statistics/"
+
 //--------------------------------------------------------------------------------------------------
 /**
  * The current security protocol.
@@ -102,18 +207,78 @@ static char SavedPassword[LE_WIFIDEFS_MAX_PASSWORD_BYTES] = {0};
  */
 //--------------------------------------------------------------------------------------------------
 static bool HiddenAccessPoint = false;
+
 //--------------------------------------------------------------------------------------------------
 /**
- * The handle of the input pipe used to be notified of the WiFi events during the scan.
+ * Connection to the control interface of the wpa_supplicant started with the WiFi client.
  */
 //--------------------------------------------------------------------------------------------------
-static FILE *IwScanPipePtr    = NULL;
+static pa_wifiCtrl_Conn_t SupplicantConn = { .fd = -1 };
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Flag set when a network is selected in wpa_supplicant, until pa_wifiClient_Disconnect().
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsNetworkSelected = false;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Saved networks set by pa_wifiClient_SetNetworks(), written to the wpa_supplicant configuration.
+ */
+//--------------------------------------------------------------------------------------------------
+static pa_wifiClient_Network_t Networks[PA_WIFICLIENT_MAX_NETWORKS];
+static size_t                  NetworkCount = 0;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * SHA-1 of the configuration last written to WPA_SUPPLICANT_FILE: an identical configuration is
+ * not written again.
+ */
+//--------------------------------------------------------------------------------------------------
+static uint8_t ConfigHash[PA_WIFIPMK_SHA1_BYTES];
+static bool    HasConfigHash = false;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Flag set while the saved networks are selected by pa_wifiClient_ConnectAny(): wpa_supplicant
+ * fails over from one to the next, so a failed association does not end the attempt. Only
+ * accessed from PaThreadRef.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsNetworkListSelected = false;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Thread running the PA API, where the connection attempts are completed and the nl80211
+ * connection notifications are processed.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_thread_Ref_t PaThreadRef;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Connection attempt in progress: set by pa_wifiClient_Connect(), cleared when the association
+ * result is received or when ConnectTimer expires. Only accessed from PaThreadRef.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool           IsConnectPending = false;
+static le_clk_Time_t  ConnectStartTime;
+static le_timer_Ref_t ConnectTimer;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Start and stop the wpa_supplicant driven through SupplicantConn.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t StartSupplicant(void);
+static void StopSupplicant(void);
 //--------------------------------------------------------------------------------------------------
 /**
- * The handle of the input pipe used to be notified of the WiFi events.
+ * The handle of the input pipe used to be notified of the WiFi events during the scan.
  */
 //--------------------------------------------------------------------------------------------------
-static FILE *IwThreadPipePtr  = NULL;
+static FILE *IwScanPipePtr    = NULL;
 //--------------------------------------------------------------------------------------------------
 /**
  * Flag set when a WiFi scan is in progress.
@@ -123,80 +288,175 @@ static bool  IsScanRunning    = false;
 
 //--------------------------------------------------------------------------------------------------
 /**
- * The main thread running the WiFi platform adaptor.
+ * Backend used by the next scan.
  */
 //--------------------------------------------------------------------------------------------------
-static void *WifiClientPaThreadMain(void *contextPtr);
+static pa_wifiClient_ScanBackend_t ScanBackend = PA_WIFICLIENT_SCAN_BACKEND_NL80211;
+
 //--------------------------------------------------------------------------------------------------
 /**
- * The handle of the WiFi platform adaptor thread.
+ * Time at which the ongoing scan was started, used to log the scan latency.
  */
 //--------------------------------------------------------------------------------------------------
-static le_thread_Ref_t WifiClientPaThread = NULL;
+static le_clk_Time_t ScanStartTime;
 
 //--------------------------------------------------------------------------------------------------
 /**
- * WifiClient state event ID.
- * Used to report WifiClient state events to the registered event handlers.
+ * Time taken (ms) by the last start of the WiFi hardware, until the WLAN interface was up. 0 if
+ * the hardware was not started yet.
  */
 //--------------------------------------------------------------------------------------------------
-static le_event_Id_t WifiClientPaEvent;
+static uint32_t StartLatencyMs = 0;
+
 //--------------------------------------------------------------------------------------------------
 /**
- * WifiClient state event ID.
- * Used to report WifiClient state events to the registered event handlers.
+ * Access point found by an nl80211 scan.
  */
 //--------------------------------------------------------------------------------------------------
-static le_event_Id_t WifiClientPaEventId;
+typedef struct
+{
+    pa_wifiClient_AccessPoint_t accessPoint;    ///< Access point information
+    le_dls_Link_t               link;           ///< Link in NlScanResultList
+}
+NlScanResult_t;
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Pool for WifiClient state events reporting.
+ * Context of an nl80211 scan.
  */
 //--------------------------------------------------------------------------------------------------
-static le_mem_PoolRef_t WifiPaEventPool;
+typedef struct
+{
+    uint32_t ifIndex;   ///< Index of the scanned interface
+    bool     isDone;    ///< Scan completed or aborted
+    bool     isAborted; ///< Scan aborted by the kernel
+}
+NlScanCtx_t;
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Maximum numbers of bytes in temparatory string
+ * nl80211 socket used by the scan. It is kept open and subscribed to the "scan" group between
+ * scans; pa_wifiClient_Scan() being always called from the same thread, it has a single user.
  */
 //--------------------------------------------------------------------------------------------------
-#define TEMP_STRING_MAX_BYTES 192
+static pa_wifiNl80211_Socket_t NlScanSocket;
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Maximum numbers of bytes in temparatory config string written to wpa_supplicant.conf
+ * Pool and list of the access points found by the last nl80211 scan.
  */
 //--------------------------------------------------------------------------------------------------
-#define TEMP_CONFIG_MAX_BYTES 512
+static le_mem_PoolRef_t NlScanResultPool;
+static le_dls_List_t    NlScanResultList = LE_DLS_LIST_INIT;
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Thread destructor
+ * Flag set when the results of an nl80211 scan are available through
+ * pa_wifiClient_GetScanResult().
  */
 //--------------------------------------------------------------------------------------------------
-static void ThreadDestructor
-(
-    void *contextPtr
-)
+static bool IsNlScanResultAvailable = false;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Context of a link query.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
 {
-    int systemResult;
+    pa_wifiClient_LinkInfo_t *linkInfoPtr;                    ///< Link information to fill
+    uint8_t                   bssid[PA_WIFINL80211_MAC_BYTES]; ///< BSSID of the access point
+    bool                      isFound;                        ///< Associated access point found
+    bool                      hasRxBytes;                     ///< RX bytes reported by the driver
+    bool                      hasTxBytes;                     ///< TX bytes reported by the driver
+}
+NlLinkCtx_t;
 
-    // Kill the script launched by popen() in Client thread
-    systemResult = system(WIFI_SCRIPT_PATH COMMAND_WIFI_UNSET_EVENT);
+//--------------------------------------------------------------------------------------------------
+/**
+ * nl80211 socket used by the link queries.
+ */
+//--------------------------------------------------------------------------------------------------
+static pa_wifiNl80211_Socket_t LinkSocket;
 
-    if ((!WIFEXITED(systemResult)) || (0 != WEXITSTATUS(systemResult)))
-    {
-        LE_WARN("Unable to kill the WIFI events script");
-    }
+//--------------------------------------------------------------------------------------------------
+/**
+ * Flag set when the handler of the nl80211 notifications is registered.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsEventListenerStarted = false;
 
-    if (IwThreadPipePtr)
-    {
-        // And close FP used in created thread
-        pclose(IwThreadPipePtr);
-        IwThreadPipePtr = NULL;
-    }
+//--------------------------------------------------------------------------------------------------
+/**
+ * nl80211 connection notification, copied by the nl80211 event listener and processed in
+ * PaThreadRef.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    uint8_t  cmd;                                   ///< NL80211_CMD_* notification
+    char     ifName[LE_WIFIDEFS_MAX_IFNAME_BYTES];  ///< WLAN interface, empty if unknown
+    char     bssid[LE_WIFIDEFS_MAX_BSSID_BYTES];    ///< BSSID of the AP, empty if absent
+    uint16_t statusCode;                            ///< Status code of a connection
+    uint16_t reasonCode;                            ///< Reason code of a disconnection
+    bool     isTimedOut;                            ///< No answer from the AP to the connection
+    bool     isByAp;                                ///< Disconnection requested by the AP
 }
+NlEvent_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Event reporting the nl80211 connection notifications to PaThreadRef.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_event_Id_t NlEventId;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * BSSID and WLAN interface of the current connection, reported with the disconnection event.
+ * Only accessed from PaThreadRef.
+ */
+//--------------------------------------------------------------------------------------------------
+static char ConnectedBssid[LE_WIFIDEFS_MAX_BSSID_BYTES] = {0};
+static char ConnectedIfName[LE_WIFIDEFS_MAX_IFNAME_BYTES] = {0};
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Disconnection cause detected before the disconnection itself (e.g. beacon loss).
+ * Only accessed from PaThreadRef.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_wifiClient_DisconnectionCause_t PendingDisconnectCause = LE_WIFICLIENT_UNKNOWN_CAUSE;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * WifiClient state event ID.
+ * Used to report WifiClient state events to the registered event handlers.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_event_Id_t WifiClientPaEvent;
+//--------------------------------------------------------------------------------------------------
+/**
+ * WifiClient state event ID.
+ * Used to report WifiClient state events to the registered event handlers.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_event_Id_t WifiClientPaEventId;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Pool for WifiClient state events reporting.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_mem_PoolRef_t WifiPaEventPool;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum numbers of bytes in temparatory string
+ */
+//--------------------------------------------------------------------------------------------------
+#define TEMP_STRING_MAX_BYTES 192
+
 
 //--------------------------------------------------------------------------------------------------
 /**
@@ -263,198 +523,1001 @@ static void FirstLayerWifiClientEventIndHandler
 
 //--------------------------------------------------------------------------------------------------
 /**
- * WiFi Client PA Thread
- *
+ * Report a connection state event to the registered handlers.
  */
 //--------------------------------------------------------------------------------------------------
-static void *WifiClientPaThreadMain
+static void ReportClientEvent
 (
-    void *contextPtr
+    le_wifiClient_Event_t              event,
+    le_wifiClient_DisconnectionCause_t cause,
+    const char                        *ifNamePtr,
+    const char                        *bssidPtr
 )
 {
-    le_wifiClient_DisconnectionCause_t cause;
-    le_wifiClient_Event_t              event;
-    char path[PATH_MAX_BYTES];
-    char apBssid[LE_WIFIDEFS_MAX_BSSID_BYTES];
-    char *ret;
-    char *pathReentrant;
-    int  systemResult;
-
-    LE_INFO("Wifi event report thread started!");
-
-    IwThreadPipePtr = popen(WIFI_SCRIPT_PATH COMMAND_WIFI_SET_EVENT, "r");
-
-    if (NULL == IwThreadPipePtr)
-    {
-        LE_ERROR("Failed to run command:\"%s\" errno:%d %s",
-                COMMAND_WIFI_SET_EVENT,
-                errno,
-                LE_ERRNO_TXT(errno));
-        return NULL;
-    }
-
-    memset(apBssid, 0, LE_WIFIDEFS_MAX_BSSID_BYTES);
-    cause = LE_WIFICLIENT_UNKNOWN_CAUSE;
-    // Read the output one line at a time - output it.
-    while (NULL != fgets(path, sizeof(path) - 1, IwThreadPipePtr))
-    {
-        LE_DEBUG("PARSING:%s: len:%d", path, (int) strnlen(path, sizeof(path) - 1));
-
-        if (NULL != strstr(path, "Beacon loss"))
-        {
-            cause = LE_WIFICLIENT_BEACON_LOSS;
-        }
-        if (NULL != (ret = strstr(path, "del station")))
-        {
-            memset(apBssid, 0, LE_WIFIDEFS_MAX_BSSID_BYTES);
-            memcpy(apBssid, &ret[sizeof("del station")],
-                   LE_WIFIDEFS_MAX_BSSID_LENGTH);
-            apBssid[LE_WIFIDEFS_MAX_BSSID_LENGTH] = '\0';
-        }
-        if (NULL != (ret = strstr(path, "connected to")))
-        {
-            LE_INFO("FOUND connected");
-
-            cause = LE_WIFICLIENT_UNKNOWN_CAUSE;
-            le_wifiClient_EventInd_t* WifiClientPaEventPtr = le_mem_ForceAlloc(WifiPaEventPool);
-            memset(WifiClientPaEventPtr, 0, sizeof(le_wifiClient_EventInd_t));
-            WifiClientPaEventPtr->event = LE_WIFICLIENT_EVENT_CONNECTED;
-            WifiClientPaEventPtr->disconnectionCause = cause;
-            // Retrieve AP BSSID
-            memcpy(WifiClientPaEventPtr->apBssid, &ret[sizeof("connected to")],
-                    LE_WIFIDEFS_MAX_BSSID_LENGTH);
-            WifiClientPaEventPtr->apBssid[LE_WIFIDEFS_MAX_BSSID_LENGTH] = '\0';
-            // Retrieve WLAN interface name
-            pathReentrant = path;
-            ret = strtok_r(pathReentrant, " ", &pathReentrant);
-            if (NULL == ret)
-            {
-                LE_WARN("Failed to retrieve WLAN interface");
-                WifiClientPaEventPtr->ifName[0] = '\0';
-            }
-            else
-            {
-                memcpy(WifiClientPaEventPtr->ifName, ret, strlen(ret));
-                WifiClientPaEventPtr->ifName[LE_WIFIDEFS_MAX_IFNAME_LENGTH] = '\0';
-            }
-            // Report event: LE_WIFICLIENT_EVENT_CONNECTED
-            LE_DEBUG("WiFi event: %d, interface: %s, bssid: %s",
-                     WifiClientPaEventPtr->event,
-                     WifiClientPaEventPtr->ifName,
-                     WifiClientPaEventPtr->apBssid);
-
-            le_event_ReportWithRefCounting(WifiClientPaEventId, WifiClientPaEventPtr);
-
-            // Report event: LE_WIFICLIENT_EVENT_CONNECTED (will be deprecated)
-            event = LE_WIFICLIENT_EVENT_CONNECTED;
-            le_event_Report(WifiClientPaEvent, (void *)&event, sizeof(le_wifiClient_Event_t));
-
-        }
-        else if (NULL != strstr(path, "disconnected"))
-        {
-            LE_INFO("FOUND disconnected");
-
-            if (LE_WIFICLIENT_BEACON_LOSS != cause)
-            {
-                if (NULL != strstr(path, "local request"))
-                {
-                    // Check WLAN interface, not available means hardware removed
-                    systemResult = system(WIFI_SCRIPT_PATH COMMAND_WIFI_CHECK_HWSTATUS);
-
-                    switch (WEXITSTATUS(systemResult))
-                    {
-                        case 0:
-                            // WLAN interface is up, local request
-                            cause = LE_WIFICLIENT_CLIENT_REQUEST;
-                            break;
-                        case PA_NOT_POSSIBLE:
-                            // Driver removed, WiFi stop called
-                            cause = LE_WIFICLIENT_HARDWARE_STOP;
-                            break;
-                        case PA_NOT_FOUND:
-                            // WLAN interface is gone, WiFi hardware is removed
-                            cause = LE_WIFICLIENT_HARDWARE_DETACHED;
-                            break;
-                        default:
-                            LE_WARN("WiFi Client Command \"%s\" Failed: (%d)",
-                                COMMAND_WIFI_CHECK_HWSTATUS, systemResult);
-                            cause = LE_WIFICLIENT_CLIENT_REQUEST;
-
-                    }
-                }
-                // AP terminated connection
-                else if (NULL != strstr(path, "by AP"))
-                {
-                    cause = LE_WIFICLIENT_BY_AP;
-                }
-            }
-
-            le_wifiClient_EventInd_t* WifiClientPaEventPtr = le_mem_ForceAlloc(WifiPaEventPool);
-            memset(WifiClientPaEventPtr, 0, sizeof(le_wifiClient_EventInd_t));
-            WifiClientPaEventPtr->event = LE_WIFICLIENT_EVENT_DISCONNECTED;
-            //Disconnection cause
-            WifiClientPaEventPtr->disconnectionCause = cause;
-            // Retrieve WLAN interface name
-            pathReentrant = path;
-            ret = strtok_r(pathReentrant, " ", &pathReentrant);
-            if (NULL == ret)
-            {
-                LE_WARN("Failed to retrieve WLAN interface");
-                WifiClientPaEventPtr->ifName[0] = '\0';
-            }
-            else
-            {
-                memcpy(WifiClientPaEventPtr->ifName, ret, strlen(ret));
-                WifiClientPaEventPtr->ifName[LE_WIFIDEFS_MAX_IFNAME_LENGTH] = '\0';
-            }
-            // Retrieve AP BSSID
-            memcpy(WifiClientPaEventPtr->apBssid, apBssid, LE_WIFIDEFS_MAX_BSSID_LENGTH);
-            WifiClientPaEventPtr->apBssid[LE_WIFIDEFS_MAX_BSSID_LENGTH] = '\0';
-
-            // Report event: LE_WIFICLIENT_EVENT_DISCONNECTED
-            LE_DEBUG("WiFi event: %d, disconnectCause: %d, interface: %s, bssid: %s",
-                     WifiClientPaEventPtr->event,
-                     WifiClientPaEventPtr->disconnectionCause,
-                     WifiClientPaEventPtr->ifName,
-                     WifiClientPaEventPtr->apBssid);
-
-            // Report event: LE_WIFICLIENT_EVENT_DISCONNECTED (will be deprecated)
-            event = LE_WIFICLIENT_EVENT_DISCONNECTED;
-            le_event_Report(WifiClientPaEvent, (void *)&event, sizeof(le_wifiClient_Event_t));
-
-            // Restore to default value
-            cause = LE_WIFICLIENT_UNKNOWN_CAUSE;
-            memset(apBssid, 0, LE_WIFIDEFS_MAX_BSSID_BYTES);
-            le_event_ReportWithRefCounting(WifiClientPaEventId, WifiClientPaEventPtr);
-        }
-    }
-    // Run the event loop
-    le_event_RunLoop();
-    return NULL;
+    le_wifiClient_EventInd_t *wifiClientPaEventPtr = le_mem_ForceAlloc(WifiPaEventPool);
+
+    memset(wifiClientPaEventPtr, 0, sizeof(le_wifiClient_EventInd_t));
+    wifiClientPaEventPtr->event = event;
+    wifiClientPaEventPtr->disconnectionCause = cause;
+    le_utf8_Copy(wifiClientPaEventPtr->ifName, ifNamePtr,
+                 sizeof(wifiClientPaEventPtr->ifName), NULL);
+    le_utf8_Copy(wifiClientPaEventPtr->apBssid, bssidPtr,
+                 sizeof(wifiClientPaEventPtr->apBssid), NULL);
+
+    LE_DEBUG("WiFi event: %d, disconnectCause: %d, interface: %s, bssid: %s",
+             wifiClientPaEventPtr->event,
+             wifiClientPaEventPtr->disconnectionCause,
+             wifiClientPaEventPtr->ifName,
+             wifiClientPaEventPtr->apBssid);
+
+    // Report event (will be deprecated)
+    le_event_Report(WifiClientPaEvent, (void *)&event, sizeof(le_wifiClient_Event_t));
+
+    le_event_ReportWithRefCounting(WifiClientPaEventId, wifiClientPaEventPtr);
 }
 
-//--------------------------------------------------------------------------------------------------
-// Public declarations
-//--------------------------------------------------------------------------------------------------
-
 //--------------------------------------------------------------------------------------------------
 /**
- * This function must be called to initialize the PA WiFi Module.
- *
- * @return LE_OK     The function succeeded.
+ * Get the cause of a disconnection requested locally by checking the WLAN interface.
  */
 //--------------------------------------------------------------------------------------------------
-le_result_t pa_wifiClient_Init
+static le_wifiClient_DisconnectionCause_t GetLocalDisconnectCause
 (
     void
 )
 {
-    LE_INFO("Init called");
+    // Check WLAN interface, not available means hardware removed
+    int systemResult = system(WIFI_SCRIPT_PATH COMMAND_WIFI_CHECK_HWSTATUS);
+
+    switch (WEXITSTATUS(systemResult))
+    {
+        case 0:
+            // WLAN interface is up, local request
+            return LE_WIFICLIENT_CLIENT_REQUEST;
+        case PA_NOT_POSSIBLE:
+            // Driver removed, WiFi stop called
+            return LE_WIFICLIENT_HARDWARE_STOP;
+        case PA_NOT_FOUND:
+            // WLAN interface is gone, WiFi hardware is removed
+            return LE_WIFICLIENT_HARDWARE_DETACHED;
+        default:
+            LE_WARN("WiFi Client Command \"%s\" Failed: (%d)",
+                    COMMAND_WIFI_CHECK_HWSTATUS, systemResult);
+            return LE_WIFICLIENT_CLIENT_REQUEST;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stop tracking the connection attempt in progress, if any.
+ */
+//--------------------------------------------------------------------------------------------------
+static void ClearPendingConnect
+(
+    void
+)
+{
+    if (IsConnectPending)
+    {
+        le_timer_Stop(ConnectTimer);
+        IsConnectPending = false;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stop the connection attempts of wpa_supplicant and forget the selected network.
+ */
+//--------------------------------------------------------------------------------------------------
+static void AbortConnect
+(
+    void
+)
+{
+    if (pa_wifiCtrl_IsOpen(&SupplicantConn))
+    {
+        pa_wifiCtrl_RequestOk(&SupplicantConn, "DISCONNECT");
+        pa_wifiCtrl_RequestOk(&SupplicantConn, "REMOVE_NETWORK all");
+    }
+    IsNetworkSelected = false;
+    IsNetworkListSelected = false;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Complete the connection attempt in progress with the association result. Called by
+ * ProcessNlEvent(), which already reported a successful connection. A failure is only reported
+ * here, as the end of the attempt of pa_wifiClient_Connect(): the reconnections retried by
+ * wpa_supplicant on its own stay silent.
+ */
+//--------------------------------------------------------------------------------------------------
+static void CompleteConnect
+(
+    void *param1Ptr,    ///< [IN] Association result
+    void *param2Ptr     ///< [IN] Disconnection cause of a failed association
+)
+{
+    le_result_t   result = (le_result_t)(intptr_t)param1Ptr;
+    le_clk_Time_t duration;
+
+    if (!IsConnectPending)
+    {
+        // Reconnection managed by wpa_supplicant, nothing is waiting for it
+        return;
+    }
+    if ((LE_OK != result) && IsNetworkListSelected)
+    {
+        // wpa_supplicant goes on with the next saved network until ConnectTimer expires
+        LE_INFO("Trying the next network");
+        return;
+    }
+    ClearPendingConnect();
+
+    duration = le_clk_Sub(le_clk_GetRelativeTime(), ConnectStartTime);
+    if (LE_OK == result)
+    {
+        LE_INFO("WiFi Client connected in %lu ms",
+                (unsigned long)(duration.sec * 1000 + duration.usec / 1000));
+    }
+    else
+    {
+        LE_INFO("WiFi Client connection failed after %lu ms",
+                (unsigned long)(duration.sec * 1000 + duration.usec / 1000));
+        AbortConnect();
+        ReportClientEvent(LE_WIFICLIENT_EVENT_DISCONNECTED,
+                          (le_wifiClient_DisconnectionCause_t)(intptr_t)param2Ptr,
+                          PA_WIFINL80211_IFNAME, "");
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Abort a connection attempt without association result in time.
+ */
+//--------------------------------------------------------------------------------------------------
+static void ConnectTimerHandler
+(
+    le_timer_Ref_t timerRef
+)
+{
+    if (!IsConnectPending)
+    {
+        return;
+    }
+    IsConnectPending = false;
+
+    LE_WARN("Connection time out");
+    AbortConnect();
+    ReportClientEvent(LE_WIFICLIENT_EVENT_DISCONNECTED, LE_WIFICLIENT_UNKNOWN_CAUSE,
+                      PA_WIFINL80211_IFNAME, "");
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Process an nl80211 connection notification in PaThreadRef: the cause of a local disconnection
+ * is found by checking the WLAN interface, which must not stall the shared nl80211 listener.
+ */
+//--------------------------------------------------------------------------------------------------
+static void ProcessNlEvent
+(
+    void *reportPtr
+)
+{
+    const NlEvent_t *eventPtr = reportPtr;
+
+    switch (eventPtr->cmd)
+    {
+        // A reassociation to another BSS of the network is reported like a new connection
+        case NL80211_CMD_ROAM:
+        case NL80211_CMD_CONNECT:
+            if ((0 != eventPtr->statusCode) || ('\0' == eventPtr->bssid[0]))
+            {
+                // No answer from the AP is a local timeout, anything else is a rejection
+                le_wifiClient_DisconnectionCause_t cause =
+                    eventPtr->isTimedOut ? LE_WIFICLIENT_UNKNOWN_CAUSE : LE_WIFICLIENT_BY_AP;
+
+                // Reported by CompleteConnect() only if a connection attempt is waiting for it
+                LE_WARN("Connection failed, status code %u", eventPtr->statusCode);
+                CompleteConnect((void *)(intptr_t)LE_FAULT, (void *)(intptr_t)cause);
+                return;
+            }
+
+            le_utf8_Copy(ConnectedBssid, eventPtr->bssid, sizeof(ConnectedBssid), NULL);
+            le_utf8_Copy(ConnectedIfName, eventPtr->ifName, sizeof(ConnectedIfName), NULL);
+            PendingDisconnectCause = LE_WIFICLIENT_UNKNOWN_CAUSE;
+
+            LE_INFO("Connected to %s on %s", ConnectedBssid, ConnectedIfName);
+            ReportClientEvent(LE_WIFICLIENT_EVENT_CONNECTED, LE_WIFICLIENT_UNKNOWN_CAUSE,
+                              ConnectedIfName, ConnectedBssid);
+            CompleteConnect((void *)(intptr_t)LE_OK, NULL);
+            break;
+
+        case NL80211_CMD_DISCONNECT:
+        {
+            le_wifiClient_DisconnectionCause_t cause = PendingDisconnectCause;
+
+            if (LE_WIFICLIENT_BEACON_LOSS != cause)
+            {
+                if (eventPtr->isByAp)
+                {
+                    // AP terminated connection
+                    cause = LE_WIFICLIENT_BY_AP;
+                }
+                else
+                {
+                    cause = GetLocalDisconnectCause();
+                }
+            }
+
+            LE_INFO("Disconnected from %s, reason code %u", ConnectedBssid, eventPtr->reasonCode);
+            ReportClientEvent(LE_WIFICLIENT_EVENT_DISCONNECTED, cause,
+                              ('\0' != eventPtr->ifName[0]) ? eventPtr->ifName : ConnectedIfName,
+                              ConnectedBssid);
+
+            // Restore to default value
+            PendingDisconnectCause = LE_WIFICLIENT_UNKNOWN_CAUSE;
+            memset(ConnectedBssid, 0, sizeof(ConnectedBssid));
+            break;
+        }
+
+        // Only the beacon losses are reported
+        case NL80211_CMD_NOTIFY_CQM:
+            LE_INFO("Beacon loss");
+            PendingDisconnectCause = LE_WIFICLIENT_BEACON_LOSS;
+            break;
+
+        default:
+            break;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Handler of the nl80211 notifications, called in the context of the nl80211 event listener. The
+ * notification is only copied and reported to PaThreadRef.
+ */
+//--------------------------------------------------------------------------------------------------
+static void NlEventHandler
+(
+    uint8_t        cmd,
+    struct nlattr *attrs[],
+    void          *contextPtr
+)
+{
+    NlEvent_t event;
+    char      ifNameBuf[IF_NAMESIZE];
+
+    if ((NL80211_CMD_CONNECT != cmd) && (NL80211_CMD_ROAM != cmd) &&
+        (NL80211_CMD_DISCONNECT != cmd) && (NL80211_CMD_NOTIFY_CQM != cmd))
+    {
+        return;
+    }
+
+    memset(&event, 0, sizeof(event));
+    event.cmd = cmd;
+
+    if (NL80211_CMD_NOTIFY_CQM == cmd)
+    {
+        struct nlattr *cqmAttrs[NL80211_ATTR_CQM_MAX + 1];
+
+        if (NULL == attrs[NL80211_ATTR_CQM])
+        {
+            return;
+        }
+
+        pa_wifiNl80211_ParseAttrs(cqmAttrs, NL80211_ATTR_CQM_MAX,
+                                  pa_wifiNl80211_AttrData(attrs[NL80211_ATTR_CQM]),
+                                  pa_wifiNl80211_AttrLen(attrs[NL80211_ATTR_CQM]));
+        if (NULL == cqmAttrs[NL80211_ATTR_CQM_BEACON_LOSS_EVENT])
+        {
+            return;
+        }
+    }
+
+    if ((NULL != attrs[NL80211_ATTR_IFINDEX]) &&
+        (NULL != if_indextoname(pa_wifiNl80211_AttrU32(attrs[NL80211_ATTR_IFINDEX]), ifNameBuf)))
+    {
+        le_utf8_Copy(event.ifName, ifNameBuf, sizeof(event.ifName), NULL);
+    }
+    if (NULL != attrs[NL80211_ATTR_MAC])
+    {
+        pa_wifiNl80211_FormatMac(pa_wifiNl80211_AttrData(attrs[NL80211_ATTR_MAC]),
+                                 event.bssid, sizeof(event.bssid));
+    }
+    if (NULL != attrs[NL80211_ATTR_STATUS_CODE])
+    {
+        event.statusCode = pa_wifiNl80211_AttrU16(attrs[NL80211_ATTR_STATUS_CODE]);
+    }
+    if (NULL != attrs[NL80211_ATTR_REASON_CODE])
+    {
+        event.reasonCode = pa_wifiNl80211_AttrU16(attrs[NL80211_ATTR_REASON_CODE]);
+    }
+    event.isTimedOut = (NULL != attrs[NL80211_ATTR_TIMED_OUT]);
+    event.isByAp = (NULL != attrs[NL80211_ATTR_DISCONNECTED_BY_AP]);
+
+    le_event_Report(NlEventId, &event, sizeof(event));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Release the access points found by the last nl80211 scan.
+ */
+//--------------------------------------------------------------------------------------------------
+static void ReleaseNlScanResults
+(
+    void
+)
+{
+    le_dls_Link_t *linkPtr;
+
+    while (NULL != (linkPtr = le_dls_Pop(&NlScanResultList)))
+    {
+        le_mem_Release(CONTAINER_OF(linkPtr, NlScanResult_t, link));
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Look for the SSID in a buffer of information elements.
+ *
+ * @return LE_OK         The SSID was found.
+ * @return LE_NOT_FOUND  No valid SSID element in the buffer.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t GetSsidFromIes
+(
+    const uint8_t               *iePtr,
+    size_t                       ieLen,
+    pa_wifiClient_AccessPoint_t *accessPointPtr
+)
+{
+    while (ieLen >= 2)
+    {
+        uint8_t id = iePtr[0];
+        uint8_t len = iePtr[1];
+
+        if ((size_t)len + 2 > ieLen)
+        {
+            break;
+        }
+
+        if (IE_ID_SSID == id)
+        {
+            if (len > LE_WIFIDEFS_MAX_SSID_LENGTH)
+            {
+                return LE_NOT_FOUND;
+            }
+            memcpy(accessPointPtr->ssidBytes, &iePtr[2], len);
+            accessPointPtr->ssidLength = len;
+            return LE_OK;
+        }
+
+        ieLen -= len + 2;
+        iePtr += len + 2;
+    }
+
+    return LE_NOT_FOUND;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check whether the authentication and key management suites of a WPA or RSN element use
+ * IEEE 802.1X.
+ *
+ * @return true when an 802.1X suite is advertised.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool HasEapAkmSuite
+(
+    const uint8_t *bodyPtr,     ///< [IN] Element body, starting at the group cipher suite
+    size_t         bodyLen      ///< [IN] Length of the element body
+)
+{
+    size_t count;
+
+    // Group cipher suite, then the pairwise cipher suites
+    if (bodyLen < 4 + 2)
+    {
+        return false;
+    }
+    bodyPtr += 4;
+    bodyLen -= 4;
+    count = bodyPtr[0] | (bodyPtr[1] << 8);
+    bodyPtr += 2;
+    bodyLen -= 2;
+    if (count * 4 + 2 > bodyLen)
+    {
+        return false;
+    }
+    bodyPtr += count * 4;
+    bodyLen -= count * 4;
+
+    // Authentication and key management suites
+    count = bodyPtr[0] | (bodyPtr[1] << 8);
+    bodyPtr += 2;
+    bodyLen -= 2;
+    for (; (count > 0) && (bodyLen >= 4); count--, bodyPtr += 4, bodyLen -= 4)
+    {
+        if ((AKM_SUITE_8021X == bodyPtr[3]) || (AKM_SUITE_FT_8021X == bodyPtr[3]) ||
+            (AKM_SUITE_8021X_SHA256 == bodyPtr[3]))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Look for the WPA and RSN elements in a buffer of information elements.
+ *
+ * @return PA_WIFICLIENT_SCAN_SECURITY_WPA, _WPA2 and _EAP flags found in the buffer.
+ */
+//--------------------------------------------------------------------------------------------------
+static uint8_t GetSecurityFromIes
+(
+    const uint8_t *iePtr,
+    size_t         ieLen
+)
+{
+    uint8_t flags = 0;
+
+    while (ieLen >= 2)
+    {
+        uint8_t id = iePtr[0];
+        uint8_t len = iePtr[1];
+
+        if ((size_t)len + 2 > ieLen)
+        {
+            break;
+        }
+
+        // Both elements start with a 2 bytes version
+        if ((IE_ID_RSN == id) && (len >= 2))
+        {
+            flags |= PA_WIFICLIENT_SCAN_SECURITY_WPA2;
+            if (HasEapAkmSuite(&iePtr[2 + 2], len - 2))
+            {
+                flags |= PA_WIFICLIENT_SCAN_SECURITY_EAP;
+            }
+        }
+        else if ((IE_ID_VENDOR == id) && (len >= IE_WPA_OUI_TYPE_LEN + 2) &&
+                 (0 == memcmp(&iePtr[2], IE_WPA_OUI_TYPE, IE_WPA_OUI_TYPE_LEN)))
+        {
+            flags |= PA_WIFICLIENT_SCAN_SECURITY_WPA;
+            if (HasEapAkmSuite(&iePtr[2 + IE_WPA_OUI_TYPE_LEN + 2], len - IE_WPA_OUI_TYPE_LEN - 2))
+            {
+                flags |= PA_WIFICLIENT_SCAN_SECURITY_EAP;
+            }
+        }
+
+        ieLen -= len + 2;
+        iePtr += len + 2;
+    }
+
+    return flags;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Handler of the nl80211 "scan" notifications received while waiting for the end of a scan.
+ */
+//--------------------------------------------------------------------------------------------------
+static void NlScanEventHandler
+(
+    uint8_t        cmd,
+    struct nlattr *attrs[],
+    void          *contextPtr
+)
+{
+    NlScanCtx_t *ctxPtr = contextPtr;
+
+    if ((NULL == attrs[NL80211_ATTR_IFINDEX]) ||
+        (pa_wifiNl80211_AttrU32(attrs[NL80211_ATTR_IFINDEX]) != ctxPtr->ifIndex))
+    {
+        return;
+    }
+
+    if (NL80211_CMD_NEW_SCAN_RESULTS == cmd)
+    {
+        ctxPtr->isDone = true;
+    }
+    else if (NL80211_CMD_SCAN_ABORTED == cmd)
+    {
+        ctxPtr->isDone = true;
+        ctxPtr->isAborted = true;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Handler of the NL80211_CMD_GET_SCAN dump: one message per BSS.
+ */
+//--------------------------------------------------------------------------------------------------
+static void NlScanResultHandler
+(
+    uint8_t        cmd,
+    struct nlattr *attrs[],
+    void          *contextPtr
+)
+{
+    struct nlattr  *bssAttrs[NL80211_BSS_MAX + 1];
+    NlScanResult_t *resultPtr;
+    struct nlattr  *iesPtr;
+
+    if ((NL80211_CMD_NEW_SCAN_RESULTS != cmd) || (NULL == attrs[NL80211_ATTR_BSS]))
+    {
+        return;
+    }
+
+    pa_wifiNl80211_ParseAttrs(bssAttrs, NL80211_BSS_MAX,
+                              pa_wifiNl80211_AttrData(attrs[NL80211_ATTR_BSS]),
+                              pa_wifiNl80211_AttrLen(attrs[NL80211_ATTR_BSS]));
+
+    if ((NULL == bssAttrs[NL80211_BSS_BSSID]) ||
+        (pa_wifiNl80211_AttrLen(bssAttrs[NL80211_BSS_BSSID]) < 6))
+    {
+        return;
+    }
+
+    resultPtr = le_mem_ForceAlloc(NlScanResultPool);
+    memset(resultPtr, 0, sizeof(NlScanResult_t));
+    resultPtr->link = LE_DLS_LINK_INIT;
+    resultPtr->accessPoint.signalStrength = LE_WIFICLIENT_NO_SIGNAL_STRENGTH;
+
+    pa_wifiNl80211_FormatMac(pa_wifiNl80211_AttrData(bssAttrs[NL80211_BSS_BSSID]),
+                             resultPtr->accessPoint.bssid,
+                             sizeof(resultPtr->accessPoint.bssid));
+
+    if (NULL != bssAttrs[NL80211_BSS_SIGNAL_MBM])
+    {
+        // Signal is reported in mBm (1/100 dBm).
+        resultPtr->accessPoint.signalStrength =
+            (int32_t)pa_wifiNl80211_AttrU32(bssAttrs[NL80211_BSS_SIGNAL_MBM]) / 100;
+    }
+
+    if (NULL != bssAttrs[NL80211_BSS_FREQUENCY])
+    {
+        resultPtr->accessPoint.frequency = pa_wifiNl80211_AttrU32(bssAttrs[NL80211_BSS_FREQUENCY]);
+    }
+
+    if (NULL != bssAttrs[NL80211_BSS_SEEN_MS_AGO])
+    {
+        resultPtr->accessPoint.ageMs = pa_wifiNl80211_AttrU32(bssAttrs[NL80211_BSS_SEEN_MS_AGO]);
+    }
+
+    if ((NULL != bssAttrs[NL80211_BSS_CAPABILITY]) &&
+        (pa_wifiNl80211_AttrU16(bssAttrs[NL80211_BSS_CAPABILITY]) & BSS_CAPABILITY_PRIVACY))
+    {
+        resultPtr->accessPoint.securityFlags |= PA_WIFICLIENT_SCAN_SECURITY_PRIVACY;
+    }
+
+    iesPtr = bssAttrs[NL80211_BSS_INFORMATION_ELEMENTS];
+    if (NULL != iesPtr)
+    {
+        resultPtr->accessPoint.securityFlags |=
+            GetSecurityFromIes(pa_wifiNl80211_AttrData(iesPtr), pa_wifiNl80211_AttrLen(iesPtr));
+    }
+    if ((NULL == iesPtr) ||
+        (LE_OK != GetSsidFromIes(pa_wifiNl80211_AttrData(iesPtr), pa_wifiNl80211_AttrLen(iesPtr),
+                                 &resultPtr->accessPoint)))
+    {
+        iesPtr = bssAttrs[NL80211_BSS_BEACON_IES];
+        if (NULL != iesPtr)
+        {
+            GetSsidFromIes(pa_wifiNl80211_AttrData(iesPtr), pa_wifiNl80211_AttrLen(iesPtr),
+                           &resultPtr->accessPoint);
+            resultPtr->accessPoint.securityFlags |=
+                GetSecurityFromIes(pa_wifiNl80211_AttrData(iesPtr),
+                                   pa_wifiNl80211_AttrLen(iesPtr));
+        }
+    }
+
+    LE_DEBUG("BSS %s, SSID '%.*s', signal %d, freq %u, security 0x%02x",
+             resultPtr->accessPoint.bssid,
+             resultPtr->accessPoint.ssidLength, resultPtr->accessPoint.ssidBytes,
+             resultPtr->accessPoint.signalStrength, resultPtr->accessPoint.frequency,
+             resultPtr->accessPoint.securityFlags);
+
+    le_dls_Queue(&NlScanResultList, &resultPtr->link);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Append the frequencies and the SSIDs of a directed scan to a NL80211_CMD_TRIGGER_SCAN request.
+ *
+ * @return LE_OK            The function succeeded.
+ * @return LE_OVERFLOW      The request buffer is full.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t PutScanParams
+(
+    pa_wifiNl80211_Msg_t             *msgPtr,
+    const pa_wifiClient_ScanParams_t *paramsPtr
+)
+{
+    struct nlattr *nestPtr;
+    size_t         i;
+
+    if (paramsPtr->frequencyCount > 0)
+    {
+        nestPtr = pa_wifiNl80211_NestStart(msgPtr, NL80211_ATTR_SCAN_FREQUENCIES);
+        if (NULL == nestPtr)
+        {
+            return LE_OVERFLOW;
+        }
+        for (i = 0; i < paramsPtr->frequencyCount; i++)
+        {
+            if (LE_OK != pa_wifiNl80211_PutU32(msgPtr, i + 1, paramsPtr->frequencies[i]))
+            {
+                return LE_OVERFLOW;
+            }
+        }
+        pa_wifiNl80211_NestEnd(msgPtr, nestPtr);
+    }
+
+    if (paramsPtr->ssidCount > 0)
+    {
+        // Probing for SSIDs makes the scan active: hidden networks answer the directed probes.
+        nestPtr = pa_wifiNl80211_NestStart(msgPtr, NL80211_ATTR_SCAN_SSIDS);
+        if (NULL == nestPtr)
+        {
+            return LE_OVERFLOW;
+        }
+        for (i = 0; i < paramsPtr->ssidCount; i++)
+        {
+            if (LE_OK != pa_wifiNl80211_PutAttr(msgPtr, i + 1, paramsPtr->ssids[i].bytes,
+                                                paramsPtr->ssids[i].length))
+            {
+                return LE_OVERFLOW;
+            }
+        }
+        pa_wifiNl80211_NestEnd(msgPtr, nestPtr);
+    }
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Trigger an nl80211 scan and wait for its completion.
+ *
+ * @return LE_OK            The function succeeded.
+ * @return LE_FAULT         The function failed.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t Nl80211TriggerScan
+(
+    NlScanCtx_t                      *ctxPtr,
+        ///< [IN]
+        ///< Context of the scan
+    const pa_wifiClient_ScanParams_t *paramsPtr
+        ///< [IN]
+        ///< Frequencies and SSIDs of the scan, NULL for a full scan
+)
+{
+    pa_wifiNl80211_Msg_t msg;
+    le_clk_Time_t        deadline;
+    le_result_t          result;
+
+    pa_wifiNl80211_InitMsg(&NlScanSocket, &msg, NL80211_CMD_TRIGGER_SCAN, 0);
+    pa_wifiNl80211_PutU32(&msg, NL80211_ATTR_IFINDEX, ctxPtr->ifIndex);
+    if ((NULL != paramsPtr) && (LE_OK != PutScanParams(&msg, paramsPtr)))
+    {
+        return LE_FAULT;
+    }
+    result = pa_wifiNl80211_Request(&NlScanSocket, &msg, NlScanEventHandler, ctxPtr);
+    if (LE_BUSY == result)
+    {
+        // A scan requested by another entity (e.g. wpa_supplicant) is ongoing: use its results.
+        LE_DEBUG("Scan already ongoing, waiting for its results");
+    }
+    else if (LE_OK != result)
+    {
+        LE_ERROR("Unable to trigger the scan (%d)", result);
+        return LE_FAULT;
+    }
+
+    le_clk_Time_t timeout = { .sec = NL80211_SCAN_TIMEOUT_MS / 1000,
+                              .usec = (NL80211_SCAN_TIMEOUT_MS % 1000) * 1000 };
+    deadline = le_clk_Add(le_clk_GetRelativeTime(), timeout);
+    while (!ctxPtr->isDone)
+    {
+        le_clk_Time_t remaining = le_clk_Sub(deadline, le_clk_GetRelativeTime());
+        int           timeoutMs = remaining.sec * 1000 + remaining.usec / 1000;
+
+        if ((timeoutMs <= 0) ||
+            (LE_FAULT == pa_wifiNl80211_Receive(&NlScanSocket, NlScanEventHandler, ctxPtr,
+                                                timeoutMs)))
+        {
+            break;
+        }
+    }
+
+    if ((!ctxPtr->isDone) || (ctxPtr->isAborted))
+    {
+        LE_ERROR("Scan %s", ctxPtr->isAborted ? "aborted" : "timeout");
+        return LE_FAULT;
+    }
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Scan through nl80211: trigger the scan, wait for its completion and dump the results in
+ * NlScanResultList. A cached scan only dumps the results kept by the kernel.
+ *
+ * @return LE_OK            The function succeeded.
+ * @return LE_UNSUPPORTED   nl80211 is not available.
+ * @return LE_FAULT         The function failed.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t Nl80211Scan
+(
+    const pa_wifiClient_ScanParams_t *paramsPtr,
+        ///< [IN]
+        ///< Frequencies and SSIDs of the scan, NULL for a full scan
+    bool                              isCached
+        ///< [IN]
+        ///< Read the cached results without scanning
+)
+{
+    pa_wifiNl80211_Msg_t msg;
+    NlScanCtx_t          ctx;
+    le_result_t          result;
+
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.ifIndex = if_nametoindex(PA_WIFINL80211_IFNAME);
+    if (0 == ctx.ifIndex)
+    {
+        LE_ERROR("Interface %s not found", PA_WIFINL80211_IFNAME);
+        return LE_FAULT;
+    }
+
+    if (NlScanSocket.fd < 0)
+    {
+        result = pa_wifiNl80211_Open(&NlScanSocket);
+        if (LE_OK != result)
+        {
+            return result;
+        }
+
+        // Subscribe before triggering the scan so that its completion cannot be missed.
+        result = pa_wifiNl80211_JoinGroup(&NlScanSocket, "scan");
+        if (LE_OK != result)
+        {
+            result = LE_FAULT;
+            goto error;
+        }
+    }
+    else
+    {
+        // Drop the notifications of the scans run by other entities since the last scan: they
+        // must not be taken for the end of this one.
+        while (LE_OK == (result = pa_wifiNl80211_Receive(&NlScanSocket, NULL, NULL, 0)))
+        {
+        }
+        if (LE_TIMEOUT != result)
+        {
+            result = LE_FAULT;
+            goto error;
+        }
+    }
+
+    if (!isCached)
+    {
+        result = Nl80211TriggerScan(&ctx, paramsPtr);
+        if (LE_OK != result)
+        {
+            goto error;
+        }
+    }
+
+    pa_wifiNl80211_InitMsg(&NlScanSocket, &msg, NL80211_CMD_GET_SCAN, NLM_F_DUMP);
+    pa_wifiNl80211_PutU32(&msg, NL80211_ATTR_IFINDEX, ctx.ifIndex);
+    result = pa_wifiNl80211_Request(&NlScanSocket, &msg, NlScanResultHandler, NULL);
+    if (LE_OK != result)
+    {
+        LE_ERROR("Unable to read the scan results (%d)", result);
+        ReleaseNlScanResults();
+        result = LE_FAULT;
+        goto error;
+    }
+
+    IsNlScanResultAvailable = true;
+    return LE_OK;
+
+error:
+    // Reopened by the next scan
+    pa_wifiNl80211_Close(&NlScanSocket);
+    return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Public declarations
+//--------------------------------------------------------------------------------------------------
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Handler of the NL80211_CMD_GET_SCAN dump looking for the BSS the interface is associated with.
+ */
+//--------------------------------------------------------------------------------------------------
+static void NlLinkBssHandler
+(
+    uint8_t        cmd,
+    struct nlattr *attrs[],
+    void          *contextPtr
+)
+{
+    NlLinkCtx_t   *ctxPtr = contextPtr;
+    struct nlattr *bssAttrs[NL80211_BSS_MAX + 1];
+    struct nlattr *iesPtr;
+
+    if ((NL80211_CMD_NEW_SCAN_RESULTS != cmd) || (NULL == attrs[NL80211_ATTR_BSS]) ||
+        (ctxPtr->isFound))
+    {
+        return;
+    }
+
+    pa_wifiNl80211_ParseAttrs(bssAttrs, NL80211_BSS_MAX,
+                              pa_wifiNl80211_AttrData(attrs[NL80211_ATTR_BSS]),
+                              pa_wifiNl80211_AttrLen(attrs[NL80211_ATTR_BSS]));
+
+    if ((NULL == bssAttrs[NL80211_BSS_STATUS]) ||
+        (NL80211_BSS_STATUS_ASSOCIATED != pa_wifiNl80211_AttrU32(bssAttrs[NL80211_BSS_STATUS])) ||
+        (NULL == bssAttrs[NL80211_BSS_BSSID]) ||
+        (pa_wifiNl80211_AttrLen(bssAttrs[NL80211_BSS_BSSID]) < PA_WIFINL80211_MAC_BYTES))
+    {
+        return;
+    }
+
+    ctxPtr->isFound = true;
+    memcpy(ctxPtr->bssid, pa_wifiNl80211_AttrData(bssAttrs[NL80211_BSS_BSSID]),
+           PA_WIFINL80211_MAC_BYTES);
+    pa_wifiNl80211_FormatMac(ctxPtr->bssid, ctxPtr->linkInfoPtr->accessPoint.bssid,
+                             sizeof(ctxPtr->linkInfoPtr->accessPoint.bssid));
+
+    if (NULL != bssAttrs[NL80211_BSS_FREQUENCY])
+    {
+        ctxPtr->linkInfoPtr->frequency = pa_wifiNl80211_AttrU32(bssAttrs[NL80211_BSS_FREQUENCY]);
+    }
+
+    iesPtr = bssAttrs[NL80211_BSS_INFORMATION_ELEMENTS];
+    if (NULL != iesPtr)
+    {
+        GetSsidFromIes(pa_wifiNl80211_AttrData(iesPtr), pa_wifiNl80211_AttrLen(iesPtr),
+                       &ctxPtr->linkInfoPtr->accessPoint);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Handler of the NL80211_CMD_GET_STATION reply for the associated access point.
+ */
+//--------------------------------------------------------------------------------------------------
+static void NlLinkStationHandler
+(
+    uint8_t        cmd,
+    struct nlattr *attrs[],
+    void          *contextPtr
+)
+{
+    NlLinkCtx_t                 *ctxPtr = contextPtr;
+    pa_wifiClient_AccessPoint_t *apPtr = &ctxPtr->linkInfoPtr->accessPoint;
+    struct nlattr               *staAttrs[NL80211_STA_INFO_MAX + 1];
+
+    if ((NL80211_CMD_NEW_STATION != cmd) || (NULL == attrs[NL80211_ATTR_STA_INFO]))
+    {
+        return;
+    }
+
+    pa_wifiNl80211_ParseAttrs(staAttrs, NL80211_STA_INFO_MAX,
+                              pa_wifiNl80211_AttrData(attrs[NL80211_ATTR_STA_INFO]),
+                              pa_wifiNl80211_AttrLen(attrs[NL80211_ATTR_STA_INFO]));
+
+    if (NULL != staAttrs[NL80211_STA_INFO_SIGNAL])
+    {
+        apPtr->signalStrength = (int8_t)pa_wifiNl80211_AttrU8(staAttrs[NL80211_STA_INFO_SIGNAL]);
+    }
+
+    if (NULL != staAttrs[NL80211_STA_INFO_RX_BYTES64])
+    {
+        memcpy(&apPtr->rx, pa_wifiNl80211_AttrData(staAttrs[NL80211_STA_INFO_RX_BYTES64]),
+               sizeof(uint64_t));
+        ctxPtr->hasRxBytes = true;
+    }
+    else if (NULL != staAttrs[NL80211_STA_INFO_RX_BYTES])
+    {
+        apPtr->rx = pa_wifiNl80211_AttrU32(staAttrs[NL80211_STA_INFO_RX_BYTES]);
+        ctxPtr->hasRxBytes = true;
+    }
+
+    if (NULL != staAttrs[NL80211_STA_INFO_TX_BYTES64])
+    {
+        memcpy(&apPtr->tx, pa_wifiNl80211_AttrData(staAttrs[NL80211_STA_INFO_TX_BYTES64]),
+               sizeof(uint64_t));
+        ctxPtr->hasTxBytes = true;
+    }
+    else if (NULL != staAttrs[NL80211_STA_INFO_TX_BYTES])
+    {
+        apPtr->tx = pa_wifiNl80211_AttrU32(staAttrs[NL80211_STA_INFO_TX_BYTES]);
+        ctxPtr->hasTxBytes = true;
+    }
+
+    ctxPtr->linkInfoPtr->rxBitrate =
+        pa_wifiNl80211_ParseBitrate(staAttrs[NL80211_STA_INFO_RX_BITRATE]);
+    ctxPtr->linkInfoPtr->txBitrate =
+        pa_wifiNl80211_ParseBitrate(staAttrs[NL80211_STA_INFO_TX_BITRATE]);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read a byte counter of the WLAN interface from sysfs.
+ *
+ * @return LE_OK     The counter was read.
+ * @return LE_FAULT  The function failed.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t ReadInterfaceStatistic
+(
+    const char *namePtr,
+    uint64_t   *valuePtr
+)
+{
+    char                path[PATH_MAX_BYTES];
+    FILE               *filePtr;
+    unsigned long long  value;
+    int                 count;
+
+    snprintf(path, sizeof(path), INTERFACE_STATS_PATH "%s", namePtr);
+    filePtr = fopen(path, "r");
+    if (NULL == filePtr)
+    {
+        return LE_FAULT;
+    }
+    count = fscanf(filePtr, "%llu", &value);
+    fclose(filePtr);
+
+    if (1 != count)
+    {
+        return LE_FAULT;
+    }
+    *valuePtr = value;
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * This function must be called to initialize the PA WiFi Module.
+ *
+ * @return LE_OK     The function succeeded.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiClient_Init
+(
+    void
+)
+{
+    LE_INFO("Init called");
     // pa_wifiClient_AddEventHandler() will be deprecated
     WifiClientPaEvent = le_event_CreateId("WifiClientPaEvent", sizeof(le_wifiClient_Event_t));
     // Create the event for signaling user handlers.
     WifiClientPaEventId = le_event_CreateIdWithRefCounting("WifiConnectEvent");
     WifiPaEventPool = le_mem_CreatePool("WifiPaEventPool", sizeof(le_wifiClient_EventInd_t));
+    NlScanResultPool = le_mem_CreatePool("NlScanResultPool", sizeof(NlScanResult_t));
+    NlScanSocket.fd = -1;
+    LinkSocket.fd = -1;
+    pa_wifiNl80211_Init();
+
+    // Connection attempts and nl80211 notifications are processed in the thread calling the PA API
+    PaThreadRef = le_thread_GetCurrent();
+    NlEventId = le_event_CreateId("WifiClientNlEvent", sizeof(NlEvent_t));
+    le_event_AddHandler("WifiClientNlEventHandler", NlEventId, ProcessNlEvent);
+    ConnectTimer = le_timer_Create("WifiClientConnectTimer");
+    le_timer_SetMsInterval(ConnectTimer, CONNECT_TIMEOUT_MS);
+    le_timer_SetHandler(ConnectTimer, ConnectTimerHandler);
 
     return LE_OK;
 }
@@ -490,12 +1553,21 @@ le_result_t pa_wifiClient_Start
     void
 )
 {
-    int systemResult;
-    le_result_t result = LE_OK;
+    int           systemResult;
+    le_result_t   result = LE_OK;
+    le_clk_Time_t startTime = le_clk_GetRelativeTime();
+    le_clk_Time_t duration;
 
     systemResult = system(WIFI_SCRIPT_PATH COMMAND_WIFI_HW_START);
+    // The driver brings the interface up in the background: wait for it rather than polling
+    if ((0 == WEXITSTATUS(systemResult)) &&
+        (LE_OK != pa_wifiNl80211_WaitInterfaceUp(PA_WIFINL80211_IFNAME,
+                                                 PA_WIFINL80211_IF_UP_TIMEOUT_MS)))
+    {
+        systemResult = system(WIFI_SCRIPT_PATH COMMAND_WIFI_START_FAILED);
+    }
     /**
-     * Returned values:
+     * Returned values, of WIFI_START_FAILED when the interface is not up in time:
      *   0: if the interface is correctly moutned
      *  50: if WiFi card is not inserted
      * 100: if WiFi card may not work
@@ -505,13 +1577,25 @@ le_result_t pa_wifiClient_Start
     // Return value of 0 means WLAN interface is up.
     if (0 == WEXITSTATUS(systemResult))
     {
-        LE_DEBUG("WiFi client started correctly");
+        duration = le_clk_Sub(le_clk_GetRelativeTime(), startTime);
+        StartLatencyMs = (uint32_t)(duration.sec * 1000 + duration.usec / 1000);
+        LE_INFO("WiFi client started in %u ms", StartLatencyMs);
+
+        // Listen to the nl80211 notifications to report the connection events
+        if (LE_OK == pa_wifiNl80211_AddEventListener(NlEventHandler, NULL))
+        {
+            IsEventListenerStarted = true;
+        }
+        else
+        {
+            LE_ERROR("Unable to listen to nl80211 events, connection events will not be reported");
+        }
 
-        /* Create WiFi Client PA Thread */
-        WifiClientPaThread = le_thread_Create("WifiClientPaThread", WifiClientPaThreadMain, NULL);
-        le_thread_SetJoinable(WifiClientPaThread);
-        le_thread_AddChildDestructor(WifiClientPaThread, ThreadDestructor, NULL);
-        le_thread_Start(WifiClientPaThread);
+        // Keep one wpa_supplicant running for all the connections
+        if (LE_OK != StartSupplicant())
+        {
+            LE_WARN("wpa_supplicant not started, retrying on connection");
+        }
         return LE_OK;
     }
     // Return value of 50 means WiFi card is not inserted.
@@ -550,7 +1634,12 @@ le_result_t pa_wifiClient_Stop
     void
 )
 {
-    int systemResult = system(WIFI_SCRIPT_PATH COMMAND_WIFI_HW_STOP);
+    int systemResult;
+
+    ClearPendingConnect();
+    StopSupplicant();
+
+    systemResult = system(WIFI_SCRIPT_PATH COMMAND_WIFI_HW_STOP);
     /**
      * Returned values:
      *  0: if the interface is correctly unmounted
@@ -564,11 +1653,10 @@ le_result_t pa_wifiClient_Stop
         return LE_FAULT;
     }
 
-    /* Terminate the created thread */
-    le_thread_Cancel(WifiClientPaThread);
-    if (LE_OK != le_thread_Join(WifiClientPaThread, NULL))
+    if (IsEventListenerStarted)
     {
-        return LE_FAULT;
+        pa_wifiNl80211_RemoveEventListener(NlEventHandler, NULL);
+        IsEventListenerStarted = false;
     }
 
     LE_DEBUG("WiFi client stopped correctly");
@@ -577,22 +1665,53 @@ le_result_t pa_wifiClient_Stop
 
 //--------------------------------------------------------------------------------------------------
 /**
- * This function will start a scan and returns when it is done.
- * It should NOT return until the scan is done.
- * Results are read via pa_wifiClient_GetScanResult.
- * When the reading is done pa_wifiClient_ScanDone MUST be called.
+ * Get the time taken by the last start of the WiFi client.
  *
- * @return LE_FAULT  The function failed.
- * @return LE_BUSY   The function is already ongoing.
- * @return LE_OK     The function succeeded.
+ * @return LE_OK            The function succeeded.
+ * @return LE_UNAVAILABLE   The WiFi client was not started yet.
  */
 //--------------------------------------------------------------------------------------------------
-le_result_t pa_wifiClient_Scan
+le_result_t pa_wifiClient_GetStartLatency
 (
-    void
+    uint32_t *interfaceUpMsPtr
+        ///< [OUT]
+        ///< Time from the start of the WiFi hardware until the WLAN interface was up (ms)
+)
+{
+    if (0 == StartLatencyMs)
+    {
+        return LE_UNAVAILABLE;
+    }
+
+    *interfaceUpMsPtr = StartLatencyMs;
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Run a full, directed or cached scan and return when it is done.
+ *
+ * @return LE_FAULT         The function failed.
+ * @return LE_BUSY          The function is already ongoing.
+ * @return LE_UNSUPPORTED   Directed probes are not supported by the script backend.
+ * @return LE_OK            The function succeeded.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t RunScan
+(
+    const pa_wifiClient_ScanParams_t *paramsPtr,
+        ///< [IN]
+        ///< Frequencies and SSIDs of the scan, NULL for a full scan
+    bool                              isCached
+        ///< [IN]
+        ///< Read the cached results without scanning
 )
 {
     le_result_t result = LE_OK;
+    char        cmd[sizeof(WIFI_SCRIPT_PATH COMMAND_WIFICLIENT_START_SCAN " freq") +
+                    PA_WIFICLIENT_SCAN_MAX_FREQUENCIES * sizeof(" 65535")];
+    size_t      cmdLen;
+    size_t      i;
 
     LE_INFO("Scanning");
     if (IsScanRunning)
@@ -601,14 +1720,53 @@ le_result_t pa_wifiClient_Scan
         return LE_BUSY;
     }
 
-    if (NULL != IwScanPipePtr)
+    if ((NULL != IwScanPipePtr) || (IsNlScanResultAvailable))
     {
         return LE_BUSY;
     }
 
     IsScanRunning = true;
+    ScanStartTime = le_clk_GetRelativeTime();
+
+    if (PA_WIFICLIENT_SCAN_BACKEND_NL80211 == ScanBackend)
+    {
+        result = Nl80211Scan(paramsPtr, isCached);
+        if (LE_UNSUPPORTED != result)
+        {
+            IsScanRunning = false;
+            return result;
+        }
+
+        LE_WARN("nl80211 is not available, falling back to the script scan backend");
+        ScanBackend = PA_WIFICLIENT_SCAN_BACKEND_SCRIPT;
+        result = LE_OK;
+    }
+
+    // The SSIDs cannot be passed safely through the shell
+    if ((NULL != paramsPtr) && (paramsPtr->ssidCount > 0))
+    {
+        LE_ERROR("Directed probes need the nl80211 scan backend");
+        IsScanRunning = false;
+        return LE_UNSUPPORTED;
+    }
+
+    cmdLen = snprintf(cmd, sizeof(cmd), "%s", WIFI_SCRIPT_PATH COMMAND_WIFICLIENT_START_SCAN);
+    if (isCached)
+    {
+        cmdLen += snprintf(&cmd[cmdLen], sizeof(cmd) - cmdLen, " dump");
+    }
+    else if ((NULL != paramsPtr) && (paramsPtr->frequencyCount > 0))
+    {
+        cmdLen += snprintf(&cmd[cmdLen], sizeof(cmd) - cmdLen, " freq");
+        for (i = 0; i < paramsPtr->frequencyCount; i++)
+        {
+            cmdLen += snprintf(&cmd[cmdLen], sizeof(cmd) - cmdLen, " %u",
+                               paramsPtr->frequencies[i]);
+        }
+    }
+
     /* Open the command for reading. */
-    IwScanPipePtr = popen(WIFI_SCRIPT_PATH COMMAND_WIFICLIENT_START_SCAN, "r");
+    IwScanPipePtr = popen(cmd, "r");
 
     if (NULL == IwScanPipePtr)
     {
@@ -623,6 +1781,73 @@ le_result_t pa_wifiClient_Scan
     return result;
 }
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * This function will start a scan and returns when it is done.
+ * It should NOT return until the scan is done.
+ * Results are read via pa_wifiClient_GetScanResult.
+ * When the reading is done pa_wifiClient_ScanDone MUST be called.
+ *
+ * @return LE_FAULT  The function failed.
+ * @return LE_BUSY   The function is already ongoing.
+ * @return LE_OK     The function succeeded.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiClient_Scan
+(
+    void
+)
+{
+    return RunScan(NULL, false);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Start a scan limited to some frequencies and/or probing some SSIDs, and return when it is done.
+ * The results are read like the results of pa_wifiClient_Scan(); they may hold access points
+ * found on other frequencies by earlier scans.
+ *
+ * @return LE_FAULT         The function failed.
+ * @return LE_BUSY          The function is already ongoing.
+ * @return LE_UNSUPPORTED   Directed probes are not supported by the script backend.
+ * @return LE_OK            The function succeeded.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiClient_DirectedScan
+(
+    const pa_wifiClient_ScanParams_t *paramsPtr
+        ///< [IN]
+        ///< Frequencies and SSIDs of the scan.
+)
+{
+    if ((NULL == paramsPtr) ||
+        (paramsPtr->frequencyCount > PA_WIFICLIENT_SCAN_MAX_FREQUENCIES) ||
+        (paramsPtr->ssidCount > PA_WIFICLIENT_SCAN_MAX_SSIDS))
+    {
+        return LE_FAULT;
+    }
+
+    return RunScan(paramsPtr, false);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read the access points cached by the kernel from the previous scans, without scanning. The
+ * results are read like the results of pa_wifiClient_Scan(), with their age.
+ *
+ * @return LE_FAULT  The function failed.
+ * @return LE_BUSY   The function is already ongoing.
+ * @return LE_OK     The function succeeded.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiClient_CachedScan
+(
+    void
+)
+{
+    return RunScan(NULL, true);
+}
+
 //--------------------------------------------------------------------------------------------------
 /**
  * This function is used to determine if target is connected to an a AP or not.
@@ -806,6 +2031,106 @@ cleanup:
     return ret;
 }
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the state of the current link with a single query to the driver.
+ *
+ * @return LE_OK            The function succeeded.
+ * @return LE_BAD_PARAMETER The function failed due to an invalid parameter.
+ * @return LE_NOT_FOUND     The target is not connected.
+ * @return LE_FAULT         The function failed.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiClient_GetLinkInfo
+(
+    pa_wifiClient_LinkInfo_t *linkInfoPtr
+        ///< [OUT]
+        ///< State of the link, filled out if result was LE_OK.
+)
+{
+    pa_wifiNl80211_Msg_t msg;
+    NlLinkCtx_t          ctx;
+    uint32_t             ifIndex;
+    le_result_t          result;
+
+    if (NULL == linkInfoPtr)
+    {
+        LE_ERROR("linkInfoPtr is NULL");
+        return LE_BAD_PARAMETER;
+    }
+
+    memset(linkInfoPtr, 0, sizeof(pa_wifiClient_LinkInfo_t));
+    linkInfoPtr->accessPoint.signalStrength = LE_WIFICLIENT_NO_SIGNAL_STRENGTH;
+
+    ifIndex = if_nametoindex(PA_WIFINL80211_IFNAME);
+    if (0 == ifIndex)
+    {
+        LE_ERROR("Interface %s not found", PA_WIFINL80211_IFNAME);
+        return LE_FAULT;
+    }
+
+    // The socket is kept open between the queries
+    if ((LinkSocket.fd < 0) && (LE_OK != pa_wifiNl80211_Open(&LinkSocket)))
+    {
+        return LE_FAULT;
+    }
+
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.linkInfoPtr = linkInfoPtr;
+
+    // The associated BSS gives the BSSID, SSID and frequency of the link
+    pa_wifiNl80211_InitMsg(&LinkSocket, &msg, NL80211_CMD_GET_SCAN, NLM_F_DUMP);
+    pa_wifiNl80211_PutU32(&msg, NL80211_ATTR_IFINDEX, ifIndex);
+    result = pa_wifiNl80211_Request(&LinkSocket, &msg, NlLinkBssHandler, &ctx);
+    if (LE_OK != result)
+    {
+        LE_ERROR("Unable to read the BSS list (%d)", result);
+        goto error;
+    }
+    if (!ctx.isFound)
+    {
+        LE_DEBUG("Connection is not available");
+        return LE_NOT_FOUND;
+    }
+
+    // The access point station entry gives the signal, byte counters and bitrates
+    pa_wifiNl80211_InitMsg(&LinkSocket, &msg, NL80211_CMD_GET_STATION, 0);
+    pa_wifiNl80211_PutU32(&msg, NL80211_ATTR_IFINDEX, ifIndex);
+    pa_wifiNl80211_PutAttr(&msg, NL80211_ATTR_MAC, ctx.bssid, PA_WIFINL80211_MAC_BYTES);
+    result = pa_wifiNl80211_Request(&LinkSocket, &msg, NlLinkStationHandler, &ctx);
+    if (LE_NOT_FOUND == result)
+    {
+        // Disassociated in between
+        return LE_NOT_FOUND;
+    }
+    if (LE_OK != result)
+    {
+        LE_ERROR("Unable to read the station information (%d)", result);
+        goto error;
+    }
+
+    // Fall back to the interface counters when the driver does not track the station bytes
+    if (!ctx.hasRxBytes)
+    {
+        ReadInterfaceStatistic("rx_bytes", &linkInfoPtr->accessPoint.rx);
+    }
+    if (!ctx.hasTxBytes)
+    {
+        ReadInterfaceStatistic("tx_bytes", &linkInfoPtr->accessPoint.tx);
+    }
+
+    LE_DEBUG("Link %s, signal %d, freq %u, rx %" PRIu64 " tx %" PRIu64 ", bitrate rx %u tx %u",
+             linkInfoPtr->accessPoint.bssid, linkInfoPtr->accessPoint.signalStrength,
+             linkInfoPtr->frequency, linkInfoPtr->accessPoint.rx, linkInfoPtr->accessPoint.tx,
+             linkInfoPtr->rxBitrate, linkInfoPtr->txBitrate);
+    return LE_OK;
+
+error:
+    // Reopen the socket on the next query, it may be out of sync
+    pa_wifiNl80211_Close(&LinkSocket);
+    return LE_FAULT;
+}
+
 //--------------------------------------------------------------------------------------------------
 /**
  * This function is used to find out if a scan is currently running.
@@ -848,9 +2173,15 @@ le_result_t pa_wifiClient_GetScanResult
     const char bssidPrefix[] = "BSS ";
     const char ssidPrefix[] = "\tSSID: ";
     const char signalPrefix[] = "\tsignal: ";
+    const char freqPrefix[] = "\tfreq: ";
+    const char capabilityPrefix[] = "\tcapability: ";
+    const char lastSeenPrefix[] = "\tlast seen: ";
     const unsigned int bssidPrefixLen = NUM_ARRAY_MEMBERS(bssidPrefix) - 1;
     const unsigned int ssidPrefixLen = NUM_ARRAY_MEMBERS(ssidPrefix) - 1;
     const unsigned int signalPrefixLen = NUM_ARRAY_MEMBERS(signalPrefix) - 1;
+    const unsigned int freqPrefixLen = NUM_ARRAY_MEMBERS(freqPrefix) - 1;
+    const unsigned int capabilityPrefixLen = NUM_ARRAY_MEMBERS(capabilityPrefix) - 1;
+    const unsigned int lastSeenPrefixLen = NUM_ARRAY_MEMBERS(lastSeenPrefix) - 1;
     char path[PATH_MAX_BYTES];
     struct timeval tv;
     fd_set fds;
@@ -862,6 +2193,34 @@ le_result_t pa_wifiClient_GetScanResult
 
     LE_INFO("Scan results");
 
+    if (IsNlScanResultAvailable)
+    {
+        le_dls_Link_t *linkPtr;
+
+        if (NULL == accessPointPtr)
+        {
+           LE_ERROR("ERROR : accessPoint == NULL");
+           return LE_BAD_PARAMETER;
+        }
+
+        linkPtr = le_dls_Pop(&NlScanResultList);
+        if (NULL == linkPtr)
+        {
+            LE_DEBUG("End of scan results");
+            return LE_NOT_FOUND;
+        }
+
+        NlScanResult_t *resultPtr = CONTAINER_OF(linkPtr, NlScanResult_t, link);
+        *accessPointPtr = resultPtr->accessPoint;
+        le_mem_Release(resultPtr);
+
+        if ('\0' == scanIfName[0])
+        {
+            le_utf8_Copy(scanIfName, PA_WIFINL80211_IFNAME, LE_WIFIDEFS_MAX_IFNAME_BYTES, NULL);
+        }
+        return LE_OK;
+    }
+
     if (NULL == IwScanPipePtr)
     {
        LE_ERROR("ERROR must call pa_wifi_Scan first");
@@ -876,6 +2235,9 @@ le_result_t pa_wifiClient_GetScanResult
     /* Default values */
     accessPointPtr->signalStrength = LE_WIFICLIENT_NO_SIGNAL_STRENGTH;
     accessPointPtr->ssidLength = 0;
+    accessPointPtr->frequency = 0;
+    accessPointPtr->securityFlags = 0;
+    accessPointPtr->ageMs = 0;
     memset(&accessPointPtr->ssidBytes, 0, LE_WIFIDEFS_MAX_SSID_BYTES);
     memset(&accessPointPtr->bssid, 0, LE_WIFIDEFS_MAX_BSSID_BYTES);
 
@@ -931,6 +2293,24 @@ le_result_t pa_wifiClient_GetScanResult
                     accessPointPtr->signalStrength = strtol(&path[signalPrefixLen], NULL, 10);
                     LE_DEBUG("signal(%d)", accessPointPtr->signalStrength);
                 }
+                else if (0 == strncmp(freqPrefix, path, freqPrefixLen))
+                {
+                    accessPointPtr->frequency = strtoul(&path[freqPrefixLen], NULL, 10);
+                }
+                else if (0 == strncmp(lastSeenPrefix, path, lastSeenPrefixLen))
+                {
+                    // "last seen: <ms> ms ago"
+                    accessPointPtr->ageMs = strtoul(&path[lastSeenPrefixLen], NULL, 10);
+                }
+                else if (0 == strncmp(capabilityPrefix, path, capabilityPrefixLen))
+                {
+                    // The WPA and RSN elements follow the SSID in the iw output: only the
+                    // privacy bit is known here.
+                    if (NULL != strstr(&path[capabilityPrefixLen], "Privacy"))
+                    {
+                        accessPointPtr->securityFlags |= PA_WIFICLIENT_SCAN_SECURITY_PRIVACY;
+                    }
+                }
                 else if (0 == strncmp(bssidPrefix, path, bssidPrefixLen))
                 {
                     LE_DEBUG("FOUND BSSID: '%s'", &path[bssidPrefixLen]);
@@ -976,7 +2356,17 @@ le_result_t pa_wifiClient_ScanDone
     void
 )
 {
-    le_result_t res = LE_OK;
+    le_result_t   res = LE_OK;
+    le_clk_Time_t duration = le_clk_Sub(le_clk_GetRelativeTime(), ScanStartTime);
+
+    if (IsNlScanResultAvailable)
+    {
+        ReleaseNlScanResults();
+        IsNlScanResultAvailable = false;
+        IsScanRunning = false;
+        LE_INFO("nl80211 scan completed in %lu ms",
+                (unsigned long)(duration.sec * 1000 + duration.usec / 1000));
+    }
 
     if (NULL != IwScanPipePtr)
     {
@@ -994,6 +2384,8 @@ le_result_t pa_wifiClient_ScanDone
 
         IwScanPipePtr = NULL;
         IsScanRunning = false;
+        LE_INFO("Script scan completed in %lu ms",
+                (unsigned long)(duration.sec * 1000 + duration.usec / 1000));
     }
 
     return res;
@@ -1001,68 +2393,454 @@ le_result_t pa_wifiClient_ScanDone
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Set the security protocol for communication.
- *
- * @return LE_BAD_PARAMETER  The function failed due to an invalid parameter.
- * @return LE_OK             The function succeeded.
+ * Select the backend used by pa_wifiClient_Scan().
+ *
+ * The nl80211 backend triggers the scan and reads the results through generic netlink without
+ * spawning any process. When nl80211 is not available the PA falls back to the script backend.
+ *
+ * @return LE_OK             The function succeeded.
+ * @return LE_BAD_PARAMETER  Unknown backend.
+ * @return LE_BUSY           A scan is ongoing.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiClient_SetScanBackend
+(
+    pa_wifiClient_ScanBackend_t backend
+        ///< [IN]
+        ///< Scan backend to use.
+)
+{
+    if ((PA_WIFICLIENT_SCAN_BACKEND_SCRIPT != backend) &&
+        (PA_WIFICLIENT_SCAN_BACKEND_NL80211 != backend))
+    {
+        LE_ERROR("Unknown scan backend %d", backend);
+        return LE_BAD_PARAMETER;
+    }
+
+    if ((IsScanRunning) || (NULL != IwScanPipePtr) || (IsNlScanResultAvailable))
+    {
+        return LE_BUSY;
+    }
+
+    LE_INFO("Scan backend: %s",
+            (PA_WIFICLIENT_SCAN_BACKEND_NL80211 == backend) ? "nl80211" : "script");
+    ScanBackend = backend;
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the security protocol for communication.
+ *
+ * @return LE_BAD_PARAMETER  The function failed due to an invalid parameter.
+ * @return LE_OK             The function succeeded.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiClient_SetSecurityProtocol
+(
+    const le_wifiClient_SecurityProtocol_t securityProtocol
+        ///< [IN]
+        ///< Security protocol used for communication.
+)
+{
+    le_result_t result = LE_OK;
+
+    LE_DEBUG("Security protocol: %d", securityProtocol);
+    switch (securityProtocol)
+    {
+        case LE_WIFICLIENT_SECURITY_NONE:
+        case LE_WIFICLIENT_SECURITY_WEP:
+        case LE_WIFICLIENT_SECURITY_WPA_PSK_PERSONAL:
+        case LE_WIFICLIENT_SECURITY_WPA2_PSK_PERSONAL:
+        case LE_WIFICLIENT_SECURITY_WPA_EAP_PEAP0_ENTERPRISE:
+        case LE_WIFICLIENT_SECURITY_WPA2_EAP_PEAP0_ENTERPRISE:
+            SavedSecurityProtocol = securityProtocol;
+            result = LE_OK;
+            break;
+
+        default:
+            result = LE_BAD_PARAMETER;
+            break;
+    }
+    return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * This function writes configurations to wpa_supplicant file. The data is written to a temporary
+ * file renamed over it, so that the file is replaced atomically.
+ *
+ * @return LE_OK     The function succeeded.
+ * @return LE_FAULT  The function failed.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t WriteClientCfgFile
+(
+    const char *dataPtr,
+    size_t      length
+)
+{
+    size_t written = 0;
+    int    fd;
+    bool   ok;
+
+    // Only readable by its owner, as it holds credentials
+    fd = open(WPA_SUPPLICANT_TMP_FILE, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, S_IRUSR | S_IWUSR);
+    if (fd < 0)
+    {
+        LE_ERROR("Unable to create \"%s\" file, errno %d (%s)", WPA_SUPPLICANT_TMP_FILE, errno,
+                 LE_ERRNO_TXT(errno));
+        return LE_FAULT;
+    }
+
+    while (written < length)
+    {
+        ssize_t count = write(fd, dataPtr + written, length - written);
+
+        if (count < 0)
+        {
+            if (EINTR == errno)
+            {
+                continue;
+            }
+            break;
+        }
+        written += count;
+    }
+    ok = (written == length) && (0 == fsync(fd));
+    ok = (0 == close(fd)) && ok;
+    ok = ok && (0 == rename(WPA_SUPPLICANT_TMP_FILE, WPA_SUPPLICANT_FILE));
+    if (!ok)
+    {
+        LE_ERROR("Unable to write the wpa_supplicant file, errno %d (%s)", errno,
+                 LE_ERRNO_TXT(errno));
+        unlink(WPA_SUPPLICANT_TMP_FILE);
+        return LE_FAULT;
+    }
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Append formatted text to the wpa_supplicant configuration being built.
+ *
+ * @return LE_OK        The function succeeded.
+ * @return LE_OVERFLOW  The configuration buffer is full.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t AppendConfig
+(
+    char       *bufferPtr,
+    size_t      bufferSize,
+    size_t     *lengthPtr,
+    const char *formatPtr,
+    ...
+)
+{
+    va_list args;
+    int     len;
+
+    va_start(args, formatPtr);
+    len = vsnprintf(bufferPtr + *lengthPtr, bufferSize - *lengthPtr, formatPtr, args);
+    va_end(args);
+    if ((len < 0) || ((size_t)len >= bufferSize - *lengthPtr))
+    {
+        return LE_OVERFLOW;
+    }
+
+    *lengthPtr += len;
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Append a parameter to the network block being built, its value in hexadecimal. wpa_supplicant
+ * accepts this form for the string parameters, so that any byte of the value is written safely.
+ *
+ * @return LE_OK        The function succeeded.
+ * @return LE_OVERFLOW  The configuration buffer is full.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t AppendConfigHex
+(
+    char          *bufferPtr,
+    size_t         bufferSize,
+    size_t        *lengthPtr,
+    const char    *namePtr,
+    const uint8_t *valuePtr,
+    size_t         valueLen
+)
+{
+    size_t i;
+
+    if (LE_OK != AppendConfig(bufferPtr, bufferSize, lengthPtr, "\t%s=", namePtr))
+    {
+        return LE_OVERFLOW;
+    }
+    for (i = 0; i < valueLen; i++)
+    {
+        if (LE_OK != AppendConfig(bufferPtr, bufferSize, lengthPtr, "%02x", valuePtr[i]))
+        {
+            return LE_OVERFLOW;
+        }
+    }
+    return AppendConfig(bufferPtr, bufferSize, lengthPtr, "\n");
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Append the network block of a saved network to the wpa_supplicant configuration being built.
+ * The network is disabled until pa_wifiClient_ConnectAny() enables all of them.
+ *
+ * @return LE_OK        The function succeeded.
+ * @return LE_OVERFLOW  The configuration buffer is full.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t AppendNetworkBlock
+(
+    char                          *bufferPtr,
+    size_t                         bufferSize,
+    size_t                        *lengthPtr,
+    const pa_wifiClient_Network_t *networkPtr
+)
+{
+    bool ok;
+
+    ok = (LE_OK == AppendConfig(bufferPtr, bufferSize, lengthPtr, "network={\n")) &&
+         (LE_OK == AppendConfigHex(bufferPtr, bufferSize, lengthPtr, "ssid",
+                                   networkPtr->ssidBytes, networkPtr->ssidLength)) &&
+         (LE_OK == AppendConfig(bufferPtr, bufferSize, lengthPtr,
+                                "\tscan_ssid=%d\n\tpriority=%"PRId32"\n\tdisabled=1\n",
+                                networkPtr->isHidden ? 1 : 0, networkPtr->priority));
+
+    switch (networkPtr->securityProtocol)
+    {
+        case LE_WIFICLIENT_SECURITY_NONE:
+            ok = ok && (LE_OK == AppendConfig(bufferPtr, bufferSize, lengthPtr,
+                                              "\tkey_mgmt=NONE\n"));
+            break;
+
+        case LE_WIFICLIENT_SECURITY_WEP:
+            ok = ok && (LE_OK == AppendConfig(bufferPtr, bufferSize, lengthPtr,
+                                              "\tkey_mgmt=NONE\n")) &&
+                 (LE_OK == AppendConfigHex(bufferPtr, bufferSize, lengthPtr, "wep_key0",
+                                           (const uint8_t *)networkPtr->wepKey,
+                                           strlen(networkPtr->wepKey)));
+            break;
+
+        case LE_WIFICLIENT_SECURITY_WPA_PSK_PERSONAL:
+        case LE_WIFICLIENT_SECURITY_WPA2_PSK_PERSONAL:
+            // Passphrase is set, psk is generated by wpa_supplicant
+            if ('\0' != networkPtr->passphrase[0])
+            {
+                ok = ok && (LE_OK == AppendConfig(bufferPtr, bufferSize, lengthPtr,
+                                                  "\tpsk=\"%s\"\n", networkPtr->passphrase));
+            }
+            else
+            {
+                ok = ok && (LE_OK == AppendConfig(bufferPtr, bufferSize, lengthPtr,
+                                                  "\tpsk=%s\n", networkPtr->preSharedKey));
+            }
+            break;
+
+        case LE_WIFICLIENT_SECURITY_WPA_EAP_PEAP0_ENTERPRISE:
+        case LE_WIFICLIENT_SECURITY_WPA2_EAP_PEAP0_ENTERPRISE:
+            ok = ok && (LE_OK == AppendConfig(bufferPtr, bufferSize, lengthPtr,
+                                              "\tkey_mgmt=WPA-EAP\n\teap=PEAP\n")) &&
+                 (LE_OK == AppendConfigHex(bufferPtr, bufferSize, lengthPtr, "identity",
+                                           (const uint8_t *)networkPtr->username,
+                                           strlen(networkPtr->username))) &&
+                 (LE_OK == AppendConfigHex(bufferPtr, bufferSize, lengthPtr, "password",
+                                           (const uint8_t *)networkPtr->password,
+                                           strlen(networkPtr->password))) &&
+                 (LE_OK == AppendConfig(bufferPtr, bufferSize, lengthPtr,
+                                        "\tphase1=\"peapver=0\"\n\tphase2=\"auth=MSCHAPV2\"\n"));
+            break;
+
+        default:
+            ok = false;
+            break;
+    }
+
+    ok = ok && (LE_OK == AppendConfig(bufferPtr, bufferSize, lengthPtr, "}\n"));
+    return ok ? LE_OK : LE_OVERFLOW;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Write the wpa_supplicant configuration with the saved networks. The file is not written again
+ * if its content did not change since it was last written.
+ *
+ * @return LE_OK     The function succeeded.
+ * @return LE_FAULT  The function failed.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t WriteSupplicantConfig
+(
+    void
+)
+{
+    static char config[WPA_SUPPLICANT_CONFIG_MAX_BYTES];
+    uint8_t     hash[PA_WIFIPMK_SHA1_BYTES];
+    size_t      length = 0;
+    size_t      i;
+    le_result_t result;
+
+    result = AppendConfig(config, sizeof(config), &length, "%s", WPA_SUPPLICANT_CONFIG_BASE);
+    for (i = 0; (LE_OK == result) && (i < NetworkCount); i++)
+    {
+        result = AppendNetworkBlock(config, sizeof(config), &length, &Networks[i]);
+    }
+
+    if (LE_OK != result)
+    {
+        LE_ERROR("wpa_supplicant configuration too large");
+        result = LE_FAULT;
+    }
+    else
+    {
+        pa_wifiPmk_Sha1((const uint8_t *)config, length, hash);
+        if (HasConfigHash && (0 == memcmp(hash, ConfigHash, sizeof(hash))) &&
+            (0 == access(WPA_SUPPLICANT_FILE, F_OK)))
+        {
+            LE_DEBUG("wpa_supplicant configuration unchanged");
+        }
+        else
+        {
+            result = WriteClientCfgFile(config, length);
+            HasConfigHash = (LE_OK == result);
+            memcpy(ConfigHash, hash, sizeof(ConfigHash));
+            LE_DEBUG("wpa_supplicant configuration written, %zu networks", NetworkCount);
+        }
+    }
+
+    // The configuration holds credentials
+    memset(config, 0, length);
+    return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Start wpa_supplicant on the WLAN interface, if it is not running yet, and connect to its control
+ * interface.
+ *
+ * @return LE_OK     The function succeeded.
+ * @return LE_FAULT  The function failed.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t StartSupplicant
+(
+    void
+)
+{
+    int         systemResult;
+    int         retries;
+    le_result_t result = LE_FAULT;
+
+    if (pa_wifiCtrl_IsOpen(&SupplicantConn))
+    {
+        return LE_OK;
+    }
+
+    if (LE_OK != WriteSupplicantConfig())
+    {
+        return LE_FAULT;
+    }
+
+    systemResult = system(WIFI_SCRIPT_PATH COMMAND_WIFICLIENT_SUPPLICANT_START WPA_SUPPLICANT_FILE);
+    if ((!WIFEXITED(systemResult)) || (0 != WEXITSTATUS(systemResult)))
+    {
+        LE_ERROR("WiFi Client Command \"%s\" Failed: (%d)",
+                 COMMAND_WIFICLIENT_SUPPLICANT_START, systemResult);
+        return LE_FAULT;
+    }
+
+    // The control interface may appear slightly after the daemon detached.
+    for (retries = 0; retries < WPA_CTRL_OPEN_RETRIES; retries++)
+    {
+        result = pa_wifiCtrl_Open(&SupplicantConn, WPA_CTRL_IFACE_PATH);
+        if (LE_NOT_FOUND != result)
+        {
+            break;
+        }
+        usleep(WPA_CTRL_OPEN_DELAY_US);
+    }
+
+    if (LE_OK != result)
+    {
+        LE_ERROR("Unable to reach wpa_supplicant on %s (%d)", WPA_CTRL_IFACE_PATH, result);
+        return LE_FAULT;
+    }
+
+    // Start from a clean state: a running supplicant may remember a previous network.
+    pa_wifiCtrl_RequestOk(&SupplicantConn, "REMOVE_NETWORK all");
+    IsNetworkSelected = false;
+    IsNetworkListSelected = false;
+
+    LE_INFO("wpa_supplicant ready on %s", WPA_CTRL_IFACE_PATH);
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Terminate wpa_supplicant and close its control interface.
  */
 //--------------------------------------------------------------------------------------------------
-le_result_t pa_wifiClient_SetSecurityProtocol
+static void StopSupplicant
 (
-    const le_wifiClient_SecurityProtocol_t securityProtocol
-        ///< [IN]
-        ///< Security protocol used for communication.
+    void
 )
 {
-    le_result_t result = LE_OK;
-
-    LE_DEBUG("Security protocol: %d", securityProtocol);
-    switch (securityProtocol)
+    if (!pa_wifiCtrl_IsOpen(&SupplicantConn))
     {
-        case LE_WIFICLIENT_SECURITY_NONE:
-        case LE_WIFICLIENT_SECURITY_WEP:
-        case LE_WIFICLIENT_SECURITY_WPA_PSK_PERSONAL:
-        case LE_WIFICLIENT_SECURITY_WPA2_PSK_PERSONAL:
-        case LE_WIFICLIENT_SECURITY_WPA_EAP_PEAP0_ENTERPRISE:
-        case LE_WIFICLIENT_SECURITY_WPA2_EAP_PEAP0_ENTERPRISE:
-            SavedSecurityProtocol = securityProtocol;
-            result = LE_OK;
-            break;
+        return;
+    }
 
-        default:
-            result = LE_BAD_PARAMETER;
-            break;
+    if (LE_OK != pa_wifiCtrl_RequestOk(&SupplicantConn, "TERMINATE"))
+    {
+        LE_WARN("Unable to terminate wpa_supplicant");
     }
-    return result;
+    pa_wifiCtrl_Close(&SupplicantConn);
+    IsNetworkSelected = false;
+    IsNetworkListSelected = false;
 }
 
 //--------------------------------------------------------------------------------------------------
 /**
- * This function writes configurations to wpa_supplicant file.
+ * Set a parameter of a wpa_supplicant network.
+ *
+ * @return LE_OK     The function succeeded.
+ * @return LE_FAULT  The function failed.
  */
 //--------------------------------------------------------------------------------------------------
-static le_result_t WriteClientCfgFile
+static le_result_t SetNetwork
 (
-    const char *dataPtr,
-    FILE *filePtr
+    int         networkId,
+    const char *fieldPtr,
+    const char *valuePtr,
+    bool        isQuoted
 )
 {
-    size_t length;
+    char        cmd[WPA_CMD_MAX_BYTES];
+    int         len;
+    le_result_t result;
 
-    if ((NULL == filePtr) || (NULL == dataPtr))
+    len = snprintf(cmd, sizeof(cmd), isQuoted ? "SET_NETWORK %d %s \"%s\"" : "SET_NETWORK %d %s %s",
+                   networkId, fieldPtr, valuePtr);
+    if ((len < 0) || (len >= (int)sizeof(cmd)))
     {
-        LE_ERROR("Invalid parameter(s)");
+        LE_ERROR("Value of %s is too long", fieldPtr);
         return LE_FAULT;
     }
 
-    length = strlen(dataPtr);
-    if (length > 0)
+    result = pa_wifiCtrl_RequestOk(&SupplicantConn, cmd);
+    // The command may contain a credential.
+    memset(cmd, 0, sizeof(cmd));
+    if (LE_OK != result)
     {
-        if (fwrite(dataPtr, 1, length, filePtr) != length)
-        {
-            LE_ERROR("Unable to write the wpa_supplicant file.");
-            return LE_FAULT;
-        }
+        LE_ERROR("Unable to set network %s", fieldPtr);
+        return LE_FAULT;
     }
 
     return LE_OK;
@@ -1070,146 +2848,162 @@ static le_result_t WriteClientCfgFile
 
 //--------------------------------------------------------------------------------------------------
 /**
- * This function generates the WPA supplicant configuration file.
+ * Check that the credentials required by the security protocol are set.
+ *
+ * @return LE_OK             The configuration is complete.
+ * @return LE_BAD_PARAMETER  A credential is missing.
  */
 //--------------------------------------------------------------------------------------------------
-static le_result_t GenerateWpaSupplicant
+static le_result_t CheckSecurityConfig
 (
-    char *ssidPtr,
-    const uint32_t ssidLength
+    void
 )
 {
-    FILE    *filePtr;
-    char     tmpConfig[TEMP_CONFIG_MAX_BYTES];
-    char     tmpString[TEMP_STRING_MAX_BYTES];
+    switch (SavedSecurityProtocol)
+    {
+        case LE_WIFICLIENT_SECURITY_NONE:
+            return LE_OK;
 
-    LE_DEBUG("Generate Wpa Supplicant");
+        case LE_WIFICLIENT_SECURITY_WEP:
+            if (0 == SavedWepKey[0])
+            {
+                LE_ERROR("No valid WEP key");
+                return LE_BAD_PARAMETER;
+            }
+            return LE_OK;
 
-    // Check SSID
-    if ((NULL == ssidPtr) || (0 == ssidLength) || (ssidLength > LE_WIFIDEFS_MAX_SSID_LENGTH))
+        case LE_WIFICLIENT_SECURITY_WPA_PSK_PERSONAL:
+        case LE_WIFICLIENT_SECURITY_WPA2_PSK_PERSONAL:
+            if ((0 == SavedPassphrase[0]) && (0 == SavedPreSharedKey[0]))
+            {
+                LE_ERROR("No valid PassPhrase or PreSharedKey");
+                return LE_BAD_PARAMETER;
+            }
+            return LE_OK;
+
+        case LE_WIFICLIENT_SECURITY_WPA_EAP_PEAP0_ENTERPRISE:
+        case LE_WIFICLIENT_SECURITY_WPA2_EAP_PEAP0_ENTERPRISE:
+            if ((0 == SavedUsername[0]) && (0 == SavedPassword[0]))
+            {
+                LE_ERROR("No valid Username or Password");
+                return LE_BAD_PARAMETER;
+            }
+            return LE_OK;
+
+        default:
+            LE_ERROR("No valid Security Protocol");
+            return LE_BAD_PARAMETER;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add the network to wpa_supplicant, replacing any previous one.
+ *
+ * @return LE_OK     The function succeeded.
+ * @return LE_FAULT  The function failed.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t AddNetwork
+(
+    const uint8_t *ssidPtr,
+    uint8_t        ssidLength,
+    int           *networkIdPtr
+)
+{
+    char reply[PA_WIFICTRL_MSG_MAX_BYTES];
+    char ssidHex[2 * LE_WIFIDEFS_MAX_SSID_LENGTH + 1];
+    char *endPtr;
+    int  networkId;
+    int  i;
+    bool ok;
+
+    if (LE_OK != pa_wifiCtrl_RequestOk(&SupplicantConn, "REMOVE_NETWORK all"))
     {
-        LE_ERROR("Invalid SSID");
         return LE_FAULT;
     }
 
-    // Create the WPA supplicant file
-    filePtr = fopen(WPA_SUPPLICANT_FILE, "w");
-    if (filePtr == NULL)
+    if (LE_OK != pa_wifiCtrl_Request(&SupplicantConn, "ADD_NETWORK", reply, sizeof(reply),
+                                     PA_WIFICTRL_REQUEST_TIMEOUT_MS))
     {
-        LE_ERROR("Unable to create \"%s\" file.", WPA_SUPPLICANT_FILE);
+        return LE_FAULT;
+    }
+    networkId = strtol(reply, &endPtr, 10);
+    if ((endPtr == reply) || (networkId < 0))
+    {
+        LE_ERROR("ADD_NETWORK failed: %s", reply);
         return LE_FAULT;
     }
 
-    //used to store configuration to be written into wpa_supplicant.conf
-    memset(tmpConfig, '\0', sizeof(tmpConfig));
-    //used to store optional elements to be appended
-    memset(tmpString, '\0', sizeof(tmpString));
-    //common contents of wpa_supplicant.conf
-    snprintf(tmpConfig, sizeof(tmpConfig), WPA_SUPPLICANT_CONFIG_COMMON,
-             ssidLength, (char *)ssidPtr, HiddenAccessPoint);
-
-    //The common part and the security protocol part are written to wpa_supplicant.conf
-    //separately for easier debug.
-    tmpConfig[TEMP_CONFIG_MAX_BYTES - 1] = '\0';
-    if (LE_OK != WriteClientCfgFile(tmpConfig, filePtr))
+    // The SSID is given in hexadecimal so that any byte is accepted.
+    for (i = 0; i < ssidLength; i++)
     {
-        LE_ERROR("Unable to write wpa_supplicant common part");
-        goto WRONG_CONFIG;
+        snprintf(&ssidHex[2 * i], 3, "%02x", ssidPtr[i]);
     }
+    ssidHex[2 * ssidLength] = '\0';
+
+    ok = (LE_OK == SetNetwork(networkId, "ssid", ssidHex, false)) &&
+         (LE_OK == SetNetwork(networkId, "scan_ssid", HiddenAccessPoint ? "1" : "0", false));
 
-    memset(tmpConfig, '\0', sizeof(tmpConfig));
     switch (SavedSecurityProtocol)
     {
         case LE_WIFICLIENT_SECURITY_NONE:
-            le_utf8_Copy(tmpConfig, "key_mgmt=NONE\n", sizeof(tmpConfig), NULL);
+            ok = ok && (LE_OK == SetNetwork(networkId, "key_mgmt", "NONE", false));
             break;
 
         case LE_WIFICLIENT_SECURITY_WEP:
-
-            if (0 == SavedWepKey[0])
-            {
-                LE_ERROR("No valid WEP key");
-                goto WRONG_CONFIG;
-            }
-            le_utf8_Copy(tmpConfig, "key_mgmt=NONE\n", sizeof(tmpConfig), NULL);
-            snprintf(tmpString, sizeof(tmpString), "wep_key0=\"%s\"\n", SavedWepKey);
-            le_utf8_Append(tmpConfig, tmpString, sizeof(tmpConfig), NULL);
+            ok = ok && (LE_OK == SetNetwork(networkId, "key_mgmt", "NONE", false)) &&
+                 (LE_OK == SetNetwork(networkId, "wep_key0", SavedWepKey, true));
             break;
 
         case LE_WIFICLIENT_SECURITY_WPA_PSK_PERSONAL:
         case LE_WIFICLIENT_SECURITY_WPA2_PSK_PERSONAL:
-
-            if ((0 == SavedPassphrase[0]) && (0 == SavedPreSharedKey[0]))
-            {
-                LE_ERROR("No valid PassPhrase or PreSharedKey");
-                goto WRONG_CONFIG;
-            }
-            // Passphrase is set, generate psk here
+            // Passphrase is set, psk is generated by wpa_supplicant
             if (0 != SavedPassphrase[0])
             {
-                snprintf(tmpString, sizeof(tmpString), "psk=\"%s\"\n", SavedPassphrase);
+                ok = ok && (LE_OK == SetNetwork(networkId, "psk", SavedPassphrase, true));
             }
             else
             {
-                snprintf(tmpString, sizeof(tmpString), "psk=%s\n", SavedPreSharedKey);
+                ok = ok && (LE_OK == SetNetwork(networkId, "psk", SavedPreSharedKey, false));
             }
-            le_utf8_Copy(tmpConfig, tmpString, sizeof(tmpConfig), NULL);
             break;
 
         case LE_WIFICLIENT_SECURITY_WPA_EAP_PEAP0_ENTERPRISE:
         case LE_WIFICLIENT_SECURITY_WPA2_EAP_PEAP0_ENTERPRISE:
-
-            if ((0 == SavedUsername[0]) && (0 == SavedPassword[0]))
-            {
-                LE_ERROR("No valid Username or Password");
-                goto WRONG_CONFIG;
-            }
-            le_utf8_Copy(tmpConfig, "key_mgmt=WPA-EAP\n", sizeof(tmpConfig), NULL);
-            le_utf8_Append(tmpConfig, "eap=PEAP\n", sizeof(tmpConfig), NULL);
-            snprintf(tmpString, sizeof(tmpString), "identity=\"%s\"\n", SavedUsername);
-            le_utf8_Append(tmpConfig, tmpString, sizeof(tmpConfig), NULL);
-            memset(tmpString, '\0', sizeof(tmpString));
-            snprintf(tmpString, sizeof(tmpString), "password=\"%s\"\n", SavedPassword);
-            le_utf8_Append(tmpConfig, tmpString, sizeof(tmpConfig), NULL);
-            le_utf8_Append(tmpConfig, "phase1=\"peapver=0\"\n", sizeof(tmpConfig), NULL);
-            le_utf8_Append(tmpConfig, "phase2=\"auth=MSCHAPV2\"\n", sizeof(tmpConfig), NULL);
+            ok = ok && (LE_OK == SetNetwork(networkId, "key_mgmt", "WPA-EAP", false)) &&
+                 (LE_OK == SetNetwork(networkId, "eap", "PEAP", false)) &&
+                 (LE_OK == SetNetwork(networkId, "identity", SavedUsername, true)) &&
+                 (LE_OK == SetNetwork(networkId, "password", SavedPassword, true)) &&
+                 (LE_OK == SetNetwork(networkId, "phase1", "peapver=0", true)) &&
+                 (LE_OK == SetNetwork(networkId, "phase2", "auth=MSCHAPV2", true));
             break;
 
         default:
-            LE_ERROR("No valid Security Protocol");;
-            goto WRONG_CONFIG;
+            ok = false;
+            break;
     }
 
-    // Append "}" to complete the network block
-    le_utf8_Append(tmpConfig, "}\n", sizeof(tmpConfig), NULL);
-    tmpConfig[TEMP_CONFIG_MAX_BYTES - 1] = '\0';
-
-    if (LE_OK != WriteClientCfgFile(tmpConfig, filePtr))
+    if (!ok)
     {
-        LE_ERROR("Unable to write wpa_supplicant security protocol part");
-        goto WRONG_CONFIG;
+        pa_wifiCtrl_RequestOk(&SupplicantConn, "REMOVE_NETWORK all");
+        return LE_FAULT;
     }
 
-    fclose(filePtr);
+    *networkIdPtr = networkId;
     return LE_OK;
-
-WRONG_CONFIG:
-
-    LE_ERROR("Unable to generate the WPA supplicant file \"%s\".", WPA_SUPPLICANT_FILE);
-    fclose(filePtr);
-    return LE_FAULT;
 }
 
-
 //--------------------------------------------------------------------------------------------------
 /**
- * This function connects a wifiClient.
+ * This function starts the connection of a wifiClient and returns without waiting for it.
+ * The result is reported by a LE_WIFICLIENT_EVENT_CONNECTED event, or a
+ * LE_WIFICLIENT_EVENT_DISCONNECTED event if the attempt fails or times out.
  *
  * @return LE_FAULT             The function failed.
  * @return LE_BAD_PARAMETER     Invalid parameter.
  * @return LE_DUPLICATE         Duplicated request.
- * @return LE_TIMEOUT           Connection request time out.
- * @return LE_OK                The function succeeded.
+ * @return LE_OK                The connection attempt is started.
  */
 //--------------------------------------------------------------------------------------------------
 le_result_t pa_wifiClient_Connect
@@ -1222,9 +3016,8 @@ le_result_t pa_wifiClient_Connect
         ///< The number of Bytes in the ssidBytes
 )
 {
-    int         systemResult;
-    char        tmpString[TEMP_STRING_MAX_BYTES];
-    le_result_t result  = LE_OK;
+    int  networkId;
+    char cmd[WPA_CMD_MAX_BYTES];
 
     // Check SSID
     if (( 0 == ssidLength) || (ssidLength > LE_WIFIDEFS_MAX_SSID_LENGTH))
@@ -1236,41 +3029,224 @@ le_result_t pa_wifiClient_Connect
     LE_INFO("Connecting over SSID length %d SSID: \"%.*s\"", ssidLength, ssidLength,
             (char *)ssidBytes);
 
-    if (LE_OK != GenerateWpaSupplicant((char *)&ssidBytes[0], ssidLength))
+    if (LE_OK != CheckSecurityConfig())
     {
         return LE_BAD_PARAMETER;
     }
-    le_utf8_Copy(tmpString, WIFI_SCRIPT_PATH, sizeof(tmpString), NULL);
-    le_utf8_Append(tmpString, COMMAND_WIFICLIENT_CONNECT, sizeof(tmpString), NULL);
-    le_utf8_Append(tmpString, WPA_SUPPLICANT_FILE, sizeof(tmpString), NULL);
 
-    systemResult = system(tmpString);
-    // Return value of 0 means WiFi client connected.
-    if (0 == WEXITSTATUS(systemResult))
+    if (IsNetworkSelected)
     {
-        LE_DEBUG("WiFi Client connected");
-        result = LE_OK;
+        LE_WARN("A network is selected already");
+        return LE_DUPLICATE;
     }
-    // Return value of 8 means connection time out.
-    else if ( PA_TIMEOUT == WEXITSTATUS(systemResult))
+
+    // Restart wpa_supplicant if it is not reachable anymore
+    if (LE_OK != StartSupplicant())
     {
-        LE_DEBUG("Connection time out");
-        result = LE_TIMEOUT;
+        return LE_FAULT;
     }
-    // Return value of 14 means wpa_supplicant is running.
-    else if ( PA_DUPLICATE == WEXITSTATUS(systemResult))
+
+    if (LE_OK != AddNetwork(ssidBytes, ssidLength, &networkId))
     {
-        LE_WARN("WPA_SUPPLICANT is running already");
-        result = LE_DUPLICATE;
+        // wpa_supplicant may have died: reconnect to it on the next attempt
+        pa_wifiCtrl_Close(&SupplicantConn);
+        return LE_FAULT;
     }
-    // Return value of -1 means that the fork() has failed (see man system).
-    else
+
+    // The association result is reported by the nl80211 events
+    snprintf(cmd, sizeof(cmd), "SELECT_NETWORK %d", networkId);
+    if (LE_OK != pa_wifiCtrl_RequestOk(&SupplicantConn, cmd))
     {
-        LE_ERROR("WiFi Client Command %s Failed: (%d)", tmpString, systemResult);
-        result = LE_FAULT;
+        LE_ERROR("Unable to select the network");
+        pa_wifiCtrl_RequestOk(&SupplicantConn, "REMOVE_NETWORK all");
+        return LE_FAULT;
     }
 
-    return result;
+    IsNetworkSelected = true;
+    IsConnectPending = true;
+    ConnectStartTime = le_clk_GetRelativeTime();
+    le_timer_SetMsInterval(ConnectTimer, CONNECT_TIMEOUT_MS);
+    le_timer_Start(ConnectTimer);
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check a saved network before it is written to the wpa_supplicant configuration: the credentials
+ * required by its security protocol must be set, and must fit on a line of the file.
+ *
+ * @return LE_OK             The network is valid.
+ * @return LE_BAD_PARAMETER  The network is invalid.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t CheckNetwork
+(
+    const pa_wifiClient_Network_t *networkPtr
+)
+{
+    const char *charPtr;
+
+    if ((0 == networkPtr->ssidLength) || (networkPtr->ssidLength > LE_WIFIDEFS_MAX_SSID_LENGTH))
+    {
+        LE_ERROR("Invalid SSID");
+        return LE_BAD_PARAMETER;
+    }
+
+    switch (networkPtr->securityProtocol)
+    {
+        case LE_WIFICLIENT_SECURITY_NONE:
+            return LE_OK;
+
+        case LE_WIFICLIENT_SECURITY_WEP:
+            if ('\0' == networkPtr->wepKey[0])
+            {
+                LE_ERROR("No valid WEP key");
+                return LE_BAD_PARAMETER;
+            }
+            return LE_OK;
+
+        case LE_WIFICLIENT_SECURITY_WPA_PSK_PERSONAL:
+        case LE_WIFICLIENT_SECURITY_WPA2_PSK_PERSONAL:
+            // The passphrase is quoted and the pre-shared key is given in hexadecimal
+            for (charPtr = networkPtr->passphrase; '\0' != *charPtr; charPtr++)
+            {
+                if ((*charPtr < ' ') || (*charPtr > '~'))
+                {
+                    LE_ERROR("Invalid PassPhrase");
+                    return LE_BAD_PARAMETER;
+                }
+            }
+            if (('\0' == networkPtr->passphrase[0]) &&
+                (('\0' == networkPtr->preSharedKey[0]) ||
+                 (strspn(networkPtr->preSharedKey, "0123456789abcdefABCDEF") !=
+                  strlen(networkPtr->preSharedKey))))
+            {
+                LE_ERROR("No valid PassPhrase or PreSharedKey");
+                return LE_BAD_PARAMETER;
+            }
+            return LE_OK;
+
+        case LE_WIFICLIENT_SECURITY_WPA_EAP_PEAP0_ENTERPRISE:
+        case LE_WIFICLIENT_SECURITY_WPA2_EAP_PEAP0_ENTERPRISE:
+            if (('\0' == networkPtr->username[0]) && ('\0' == networkPtr->password[0]))
+            {
+                LE_ERROR("No valid Username or Password");
+                return LE_BAD_PARAMETER;
+            }
+            return LE_OK;
+
+        default:
+            LE_ERROR("No valid Security Protocol");
+            return LE_BAD_PARAMETER;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * This function sets the saved networks among which wpa_supplicant chooses when
+ * pa_wifiClient_ConnectAny() is called. The wpa_supplicant configuration file is rewritten only
+ * if its content changes; a connection in progress is not affected.
+ *
+ * @return LE_BAD_PARAMETER  Too many networks, or invalid SSID or credentials.
+ * @return LE_FAULT          The configuration file cannot be written.
+ * @return LE_OK             The function succeeded.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiClient_SetNetworks
+(
+    const pa_wifiClient_Network_t *networksPtr,
+        ///< [IN]
+        ///< Saved networks
+    size_t                         networkCount
+        ///< [IN]
+        ///< Number of networks, up to PA_WIFICLIENT_MAX_NETWORKS
+)
+{
+    size_t i;
+
+    if ((networkCount > PA_WIFICLIENT_MAX_NETWORKS) ||
+        ((0 != networkCount) && (NULL == networksPtr)))
+    {
+        LE_ERROR("Invalid network list");
+        return LE_BAD_PARAMETER;
+    }
+    for (i = 0; i < networkCount; i++)
+    {
+        if (LE_OK != CheckNetwork(&networksPtr[i]))
+        {
+            return LE_BAD_PARAMETER;
+        }
+    }
+
+    memset(Networks, 0, sizeof(Networks));
+    if (0 != networkCount)
+    {
+        memcpy(Networks, networksPtr, networkCount * sizeof(pa_wifiClient_Network_t));
+    }
+    NetworkCount = networkCount;
+
+    // Read by wpa_supplicant on the next pa_wifiClient_ConnectAny(), without restarting it
+    return WriteSupplicantConfig();
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * This function starts a connection to the saved networks and returns without waiting for it.
+ * wpa_supplicant chooses the network by priority then signal, and fails over to the next one when
+ * a connection fails or is lost. The result is reported by a LE_WIFICLIENT_EVENT_CONNECTED event,
+ * or a LE_WIFICLIENT_EVENT_DISCONNECTED event if no network could be connected in time.
+ *
+ * @return LE_NOT_FOUND     No saved network is set.
+ * @return LE_DUPLICATE     A network is selected already.
+ * @return LE_FAULT         The function failed.
+ * @return LE_OK            The connection attempt is started.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiClient_ConnectAny
+(
+    void
+)
+{
+    if (0 == NetworkCount)
+    {
+        return LE_NOT_FOUND;
+    }
+
+    if (IsNetworkSelected)
+    {
+        LE_WARN("A network is selected already");
+        return LE_DUPLICATE;
+    }
+
+    // Restart wpa_supplicant if it is not reachable anymore
+    if (LE_OK != StartSupplicant())
+    {
+        return LE_FAULT;
+    }
+
+    // Reloading the configuration replaces the networks known by wpa_supplicant by the saved
+    // ones. REASSOCIATE clears a previous DISCONNECT.
+    if ((LE_OK != WriteSupplicantConfig()) ||
+        (LE_OK != pa_wifiCtrl_RequestOk(&SupplicantConn, "RECONFIGURE")) ||
+        (LE_OK != pa_wifiCtrl_RequestOk(&SupplicantConn, "ENABLE_NETWORK all")) ||
+        (LE_OK != pa_wifiCtrl_RequestOk(&SupplicantConn, "REASSOCIATE")))
+    {
+        LE_ERROR("Unable to select the saved networks");
+        // wpa_supplicant may have died: reconnect to it on the next attempt
+        pa_wifiCtrl_Close(&SupplicantConn);
+        return LE_FAULT;
+    }
+
+    LE_INFO("Connecting to %zu saved networks", NetworkCount);
+    IsNetworkSelected = true;
+    IsNetworkListSelected = true;
+    IsConnectPending = true;
+    ConnectStartTime = le_clk_GetRelativeTime();
+    le_timer_SetMsInterval(ConnectTimer, CONNECT_ANY_TIMEOUT_MS);
+    le_timer_Start(ConnectTimer);
+
+    return LE_OK;
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -1286,23 +3262,80 @@ le_result_t pa_wifiClient_Disconnect
     void
 )
 {
-    int         systemResult;
-    le_result_t result       = LE_OK;
+    le_result_t result;
 
-    // Terminate connection
-    systemResult = system(WIFI_SCRIPT_PATH COMMAND_WIFICLIENT_DISCONNECT);
-    if (0 == WEXITSTATUS(systemResult))
+    ClearPendingConnect();
+
+    if (!pa_wifiCtrl_IsOpen(&SupplicantConn))
     {
-        LE_INFO("WiFi Client Command \"%s\" OK:", COMMAND_WIFICLIENT_DISCONNECT);
-        result = LE_OK;
+        LE_ERROR("wpa_supplicant is not running");
+        return LE_FAULT;
     }
-    else
+
+    // Terminate connection, wpa_supplicant stays running for the next connection
+    result = pa_wifiCtrl_RequestOk(&SupplicantConn, "DISCONNECT");
+    if (LE_OK == result)
     {
-        LE_ERROR("WiFi Client Command \"%s\" Failed: (%d)",
-                COMMAND_WIFICLIENT_DISCONNECT, systemResult);
-        result = LE_FAULT;
+        result = pa_wifiCtrl_RequestOk(&SupplicantConn, "REMOVE_NETWORK all");
     }
-    return result;
+
+    if (LE_OK != result)
+    {
+        LE_ERROR("Unable to disconnect (%d)", result);
+        return LE_FAULT;
+    }
+
+    IsNetworkSelected = false;
+    IsNetworkListSelected = false;
+    LE_INFO("WiFi client disconnected");
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * This function starts the reassociation to another BSSID of the selected network and returns
+ * without waiting for it. The target must have been found by a recent scan. The result is reported
+ * by a LE_WIFICLIENT_EVENT_CONNECTED event carrying the new BSSID.
+ *
+ * @return LE_BAD_PARAMETER  Invalid BSSID.
+ * @return LE_FAULT          No network is selected or the request was rejected.
+ * @return LE_OK             The reassociation is started.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiClient_Roam
+(
+    const char *bssidPtr
+        ///< [IN]
+        ///< BSSID to reassociate to, as "xx:xx:xx:xx:xx:xx"
+)
+{
+    uint8_t mac[6];
+    char    cmd[WPA_CMD_MAX_BYTES];
+
+    if ((NULL == bssidPtr) || (LE_WIFIDEFS_MAX_BSSID_LENGTH != strlen(bssidPtr)) ||
+        (6 != sscanf(bssidPtr, "%hhx:%hhx:%hhx:%hhx:%hhx:%hhx",
+                     &mac[0], &mac[1], &mac[2], &mac[3], &mac[4], &mac[5])))
+    {
+        LE_ERROR("Invalid BSSID");
+        return LE_BAD_PARAMETER;
+    }
+
+    if ((!IsNetworkSelected) || (!pa_wifiCtrl_IsOpen(&SupplicantConn)))
+    {
+        LE_ERROR("No network selected");
+        return LE_FAULT;
+    }
+
+    // wpa_supplicant picks the BSS from its scan table, which is fed by every scan on the interface
+    snprintf(cmd, sizeof(cmd), "ROAM %s", bssidPtr);
+    if (LE_OK != pa_wifiCtrl_RequestOk(&SupplicantConn, cmd))
+    {
+        LE_ERROR("Unable to roam to %s", bssidPtr);
+        return LE_FAULT;
+    }
+
+    LE_INFO("Roaming from %s to %s", ConnectedBssid, bssidPtr);
+    return LE_OK;
 }
 
 //--------------------------------------------------------------------------------------------------
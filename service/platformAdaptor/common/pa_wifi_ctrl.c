@@ -0,0 +1,363 @@
+// -------------------------------------------------------------------------------------------------
+/**
+ *  WiFi control interface client
+ *
+ *  Copyright (C) Sierra Wireless Inc.
+ *
+ */
+// -------------------------------------------------------------------------------------------------
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "legato.h"
+
+#include "pa_wifi_ctrl.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Directory of the local sockets bound by the clients.
+ */
+//--------------------------------------------------------------------------------------------------
+#define LOCAL_SOCKET_DIR        "/tmp"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Length of the command name, used to log commands without their arguments which may hold
+ * credentials.
+ */
+//--------------------------------------------------------------------------------------------------
+#define CMD_NAME_LEN(cmdPtr)    ((int)strcspn((cmdPtr), " "))
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Counter used to build unique local socket paths within the process.
+ */
+//--------------------------------------------------------------------------------------------------
+static uint32_t LocalSocketCounter = 0;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Wait for a datagram on the connection and read it.
+ *
+ * @return LE_OK            A datagram was read.
+ * @return LE_TIMEOUT       Nothing was received before the timeout.
+ * @return LE_FAULT         The function failed.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t ReadMsg
+(
+    pa_wifiCtrl_Conn_t *connPtr,
+    char               *bufPtr,
+    size_t              bufSize,
+    int                 timeoutMs
+)
+{
+    struct pollfd pfd;
+    ssize_t       len;
+    int           rc;
+
+    pfd.fd = connPtr->fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+
+    do
+    {
+        rc = poll(&pfd, 1, timeoutMs);
+    }
+    while ((rc < 0) && (EINTR == errno));
+
+    if (0 == rc)
+    {
+        return LE_TIMEOUT;
+    }
+    if (rc < 0)
+    {
+        LE_ERROR("poll() failed, errno %d (%s)", errno, LE_ERRNO_TXT(errno));
+        return LE_FAULT;
+    }
+
+    len = recv(connPtr->fd, bufPtr, bufSize - 1, 0);
+    if (len < 0)
+    {
+        LE_ERROR("recv() failed, errno %d (%s)", errno, LE_ERRNO_TXT(errno));
+        return LE_FAULT;
+    }
+
+    bufPtr[len] = '\0';
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Public declarations
+//--------------------------------------------------------------------------------------------------
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Open a connection to a control interface.
+ *
+ * @return LE_OK            The function succeeded.
+ * @return LE_NOT_FOUND     The control interface does not exist.
+ * @return LE_FAULT         The function failed.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiCtrl_Open
+(
+    pa_wifiCtrl_Conn_t *connPtr,
+        ///< [OUT]
+        ///< Connection to initialize
+    const char         *ctrlPathPtr
+        ///< [IN]
+        ///< Path of the control interface socket (e.g. /var/run/wpa_supplicant/wlan0)
+)
+{
+    struct sockaddr_un addr;
+
+    memset(connPtr, 0, sizeof(pa_wifiCtrl_Conn_t));
+
+    connPtr->fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (connPtr->fd < 0)
+    {
+        LE_ERROR("Unable to open control socket, errno %d (%s)", errno, LE_ERRNO_TXT(errno));
+        return LE_FAULT;
+    }
+
+    // The daemon replies to the address of the client: bind to a unique local path.
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    snprintf(connPtr->localPath, sizeof(connPtr->localPath), "%s/wifi_ctrl_%d-%u",
+             LOCAL_SOCKET_DIR, (int)getpid(), __sync_fetch_and_add(&LocalSocketCounter, 1));
+    le_utf8_Copy(addr.sun_path, connPtr->localPath, sizeof(addr.sun_path), NULL);
+    unlink(connPtr->localPath);
+    if (bind(connPtr->fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        LE_ERROR("Unable to bind %s, errno %d (%s)", connPtr->localPath,
+                 errno, LE_ERRNO_TXT(errno));
+        goto error;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (LE_OK != le_utf8_Copy(addr.sun_path, ctrlPathPtr, sizeof(addr.sun_path), NULL))
+    {
+        LE_ERROR("Control interface path too long: %s", ctrlPathPtr);
+        goto error;
+    }
+    if (connect(connPtr->fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        le_result_t result = ((ENOENT == errno) || (ECONNREFUSED == errno)) ?
+                             LE_NOT_FOUND : LE_FAULT;
+
+        LE_DEBUG("Unable to connect to %s, errno %d (%s)", ctrlPathPtr,
+                 errno, LE_ERRNO_TXT(errno));
+        pa_wifiCtrl_Close(connPtr);
+        return result;
+    }
+
+    return LE_OK;
+
+error:
+    pa_wifiCtrl_Close(connPtr);
+    return LE_FAULT;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Close a connection to a control interface.
+ */
+//--------------------------------------------------------------------------------------------------
+void pa_wifiCtrl_Close
+(
+    pa_wifiCtrl_Conn_t *connPtr
+        ///< [IN]
+        ///< Connection to close
+)
+{
+    if (connPtr->fd >= 0)
+    {
+        close(connPtr->fd);
+        connPtr->fd = -1;
+    }
+    if ('\0' != connPtr->localPath[0])
+    {
+        unlink(connPtr->localPath);
+        connPtr->localPath[0] = '\0';
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Send a command and wait for its reply. Unsolicited event messages received in between are
+ * dropped.
+ *
+ * @return LE_OK            The reply was received.
+ * @return LE_TIMEOUT       No reply was received in time.
+ * @return LE_FAULT         The function failed.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiCtrl_Request
+(
+    pa_wifiCtrl_Conn_t *connPtr,
+        ///< [IN]
+        ///< Connection
+    const char         *cmdPtr,
+        ///< [IN]
+        ///< Command
+    char               *replyPtr,
+        ///< [OUT]
+        ///< Null terminated reply
+    size_t              replySize,
+        ///< [IN]
+        ///< Size of the reply buffer
+    int                 timeoutMs
+        ///< [IN]
+        ///< Timeout in milliseconds
+)
+{
+    le_clk_Time_t deadline;
+    le_clk_Time_t timeout = { .sec = timeoutMs / 1000, .usec = (timeoutMs % 1000) * 1000 };
+    le_result_t   result;
+
+    if ((connPtr->fd < 0) || (NULL == replyPtr) || (0 == replySize))
+    {
+        return LE_FAULT;
+    }
+
+    if (send(connPtr->fd, cmdPtr, strlen(cmdPtr), 0) < 0)
+    {
+        LE_ERROR("Unable to send '%.*s', errno %d (%s)", CMD_NAME_LEN(cmdPtr), cmdPtr,
+                 errno, LE_ERRNO_TXT(errno));
+        return LE_FAULT;
+    }
+
+    deadline = le_clk_Add(le_clk_GetRelativeTime(), timeout);
+    for (;;)
+    {
+        le_clk_Time_t remaining = le_clk_Sub(deadline, le_clk_GetRelativeTime());
+        int           remainingMs = remaining.sec * 1000 + remaining.usec / 1000;
+
+        if (remainingMs <= 0)
+        {
+            result = LE_TIMEOUT;
+            break;
+        }
+
+        result = ReadMsg(connPtr, replyPtr, replySize, remainingMs);
+        if (LE_OK != result)
+        {
+            break;
+        }
+
+        // Event messages start with "<level>", replies never do.
+        if ('<' != replyPtr[0])
+        {
+            return LE_OK;
+        }
+    }
+
+    LE_WARN("No reply to '%.*s' (%d)", CMD_NAME_LEN(cmdPtr), cmdPtr, result);
+    return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Send a command that is expected to be acknowledged by "OK".
+ *
+ * @return LE_OK            The command was acknowledged.
+ * @return LE_TIMEOUT       No reply was received in time.
+ * @return LE_FAULT         The command was rejected or the function failed.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiCtrl_RequestOk
+(
+    pa_wifiCtrl_Conn_t *connPtr,
+        ///< [IN]
+        ///< Connection
+    const char         *cmdPtr
+        ///< [IN]
+        ///< Command
+)
+{
+    char        reply[64];
+    le_result_t result;
+
+    result = pa_wifiCtrl_Request(connPtr, cmdPtr, reply, sizeof(reply),
+                                 PA_WIFICTRL_REQUEST_TIMEOUT_MS);
+    if (LE_OK != result)
+    {
+        return result;
+    }
+
+    if (0 != strncmp(reply, "OK", 2))
+    {
+        LE_ERROR("Command '%.*s' failed: %s", CMD_NAME_LEN(cmdPtr), cmdPtr, reply);
+        return LE_FAULT;
+    }
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Register the connection as an event monitor (ATTACH).
+ *
+ * @return LE_OK            The function succeeded.
+ * @return LE_FAULT         The function failed.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiCtrl_Attach
+(
+    pa_wifiCtrl_Conn_t *connPtr
+        ///< [IN]
+        ///< Connection
+)
+{
+    return (LE_OK == pa_wifiCtrl_RequestOk(connPtr, "ATTACH")) ? LE_OK : LE_FAULT;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Wait for an event message on an attached connection. The "<level>" prefix is removed.
+ *
+ * @return LE_OK            An event was received.
+ * @return LE_TIMEOUT       Nothing was received before the timeout.
+ * @return LE_FAULT         The function failed.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiCtrl_Recv
+(
+    pa_wifiCtrl_Conn_t *connPtr,
+        ///< [IN]
+        ///< Connection
+    char               *eventPtr,
+        ///< [OUT]
+        ///< Null terminated event
+    size_t              eventSize,
+        ///< [IN]
+        ///< Size of the event buffer
+    int                 timeoutMs
+        ///< [IN]
+        ///< Timeout in milliseconds, -1 to wait forever
+)
+{
+    le_result_t result;
+    char       *endPtr;
+
+    if ((connPtr->fd < 0) || (NULL == eventPtr) || (0 == eventSize))
+    {
+        return LE_FAULT;
+    }
+
+    result = ReadMsg(connPtr, eventPtr, eventSize, timeoutMs);
+    if (LE_OK != result)
+    {
+        return result;
+    }
+
+    if (('<' == eventPtr[0]) && (NULL != (endPtr = strchr(eventPtr, '>'))))
+    {
+        memmove(eventPtr, endPtr + 1, strlen(endPtr + 1) + 1);
+    }
+
+    return LE_OK;
+}
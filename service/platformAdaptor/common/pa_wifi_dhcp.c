@@ -0,0 +1,1350 @@
+// -------------------------------------------------------------------------------------------------
+/**
+ *  WiFi access point DHCP server
+ *
+ *  Copyright (C) Sierra Wireless Inc.
+ *
+ */
+// -------------------------------------------------------------------------------------------------
+#include <arpa/inet.h>
+#include <ctype.h>
+#include <limits.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+
+#include "legato.h"
+
+#include "pa_wifi_dhcp.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * UDP ports of the server and of the clients.
+ */
+//--------------------------------------------------------------------------------------------------
+#define DHCP_SERVER_PORT            67
+#define DHCP_CLIENT_PORT            68
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * BOOTP header values (RFC 951, RFC 2131).
+ */
+//--------------------------------------------------------------------------------------------------
+#define BOOTP_OP_REQUEST            1
+#define BOOTP_OP_REPLY              2
+#define BOOTP_HTYPE_ETHERNET        1
+#define BOOTP_HLEN_ETHERNET         6
+#define BOOTP_FLAG_BROADCAST        0x8000
+#define BOOTP_MIN_BYTES             300
+#define DHCP_MAGIC_COOKIE           0x63825363
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * DHCP options (RFC 2132).
+ */
+//--------------------------------------------------------------------------------------------------
+#define DHCP_OPT_PAD                0
+#define DHCP_OPT_SUBNET_MASK        1
+#define DHCP_OPT_ROUTER             3
+#define DHCP_OPT_DNS_SERVER         6
+#define DHCP_OPT_HOSTNAME           12
+#define DHCP_OPT_REQUESTED_ADDR     50
+#define DHCP_OPT_LEASE_TIME         51
+#define DHCP_OPT_MSG_TYPE           53
+#define DHCP_OPT_SERVER_ID          54
+#define DHCP_OPT_RENEWAL_TIME       58
+#define DHCP_OPT_REBINDING_TIME     59
+#define DHCP_OPT_END                255
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * DHCP message types.
+ */
+//--------------------------------------------------------------------------------------------------
+#define DHCP_DISCOVER               1
+#define DHCP_OFFER                  2
+#define DHCP_REQUEST                3
+#define DHCP_DECLINE                4
+#define DHCP_ACK                    5
+#define DHCP_NAK                    6
+#define DHCP_RELEASE                7
+#define DHCP_INFORM                 8
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Time an offered address is kept for the client, in seconds.
+ */
+//--------------------------------------------------------------------------------------------------
+#define OFFER_HOLD_SEC              30
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum size of a line of the lease file, including the null termination.
+ */
+//--------------------------------------------------------------------------------------------------
+#define LEASE_LINE_MAX_BYTES        (PA_WIFIDHCP_HOSTNAME_MAX_BYTES + 64)
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum length of a host name of the lease file, as a literal for the sscanf() field width.
+ */
+//--------------------------------------------------------------------------------------------------
+#define LEASE_HOSTNAME_MAX_LEN      63
+_Static_assert(LEASE_HOSTNAME_MAX_LEN == PA_WIFIDHCP_HOSTNAME_MAX_BYTES - 1,
+               "Lease host name width does not match PA_WIFIDHCP_HOSTNAME_MAX_BYTES");
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Expand a macro into a string literal.
+ */
+//--------------------------------------------------------------------------------------------------
+#define STRINGIFY(x)                #x
+#define STRINGIFY_VALUE(x)          STRINGIFY(x)
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Size of the fixed part of a DHCP message, magic cookie included.
+ */
+//--------------------------------------------------------------------------------------------------
+#define DHCP_HEADER_BYTES           240
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * DHCP message. Multi-byte fields are in network byte order.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    uint8_t  op;                                                    ///< BOOTP_OP_*
+    uint8_t  htype;                                                 ///< Hardware address type
+    uint8_t  hlen;                                                  ///< Hardware address length
+    uint8_t  hops;                                                  ///< Relay hops
+    uint32_t xid;                                                   ///< Transaction ID
+    uint16_t secs;                                                  ///< Time since the start
+    uint16_t flags;                                                 ///< BOOTP_FLAG_*
+    uint32_t ciaddr;                                                ///< Client address
+    uint32_t yiaddr;                                                ///< Address given
+    uint32_t siaddr;                                                ///< Next server address
+    uint32_t giaddr;                                                ///< Relay address
+    uint8_t  chaddr[16];                                            ///< Client hardware address
+    uint8_t  sname[64];                                             ///< Server host name
+    uint8_t  file[128];                                             ///< Boot file name
+    uint32_t magic;                                                 ///< DHCP_MAGIC_COOKIE
+    uint8_t  options[PA_WIFIDHCP_MSG_MAX_BYTES - DHCP_HEADER_BYTES]; ///< Options
+}
+DhcpMsg_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Options of a client message.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    uint8_t  type;                                          ///< DHCP message type
+    uint32_t requestedAddr;                                 ///< Requested address, or 0
+    uint32_t serverId;                                      ///< Server chosen by the client, or 0
+    char     hostname[PA_WIFIDHCP_HOSTNAME_MAX_BYTES];      ///< Client host name, or empty
+}
+DhcpOptions_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * State of a lease.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef enum
+{
+    LEASE_FREE,         ///< Unused entry
+    LEASE_OFFERED,      ///< Address offered, waiting for the request of the client
+    LEASE_BOUND,        ///< Address given to the client
+    LEASE_DECLINED      ///< Address in use on the network, not given until the lease expires
+}
+LeaseState_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Lease. Addresses are in host byte order.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    LeaseState_t state;                                     ///< State of the lease
+    uint8_t      mac[BOOTP_HLEN_ETHERNET];                  ///< MAC address of the client
+    uint32_t     addr;                                      ///< Address of the client
+    time_t       expiry;                                    ///< Absolute expiry time (s)
+    char         hostname[PA_WIFIDHCP_HOSTNAME_MAX_BYTES];  ///< Client host name, or empty
+}
+Lease_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Lease table.
+ */
+//--------------------------------------------------------------------------------------------------
+static Lease_t Leases[PA_WIFIDHCP_MAX_LEASES];
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * DHCP server. Addresses are in host byte order, startAddr is 0 until a range is set.
+ */
+//--------------------------------------------------------------------------------------------------
+static struct
+{
+    bool               isStarted;                           ///< Server started
+    int                fd;                                  ///< Server socket, or -1
+    le_fdMonitor_Ref_t fdMonitorRef;                        ///< Monitor of the server socket
+    char               leaseFile[PATH_MAX];                 ///< Lease file, or empty
+    bool               isSavePending;                       ///< Lease table to save
+    uint32_t           serverAddr;                          ///< Server address
+    uint32_t           netmask;                             ///< Subnet mask of the clients
+    uint32_t           startAddr;                           ///< First client address
+    uint32_t           stopAddr;                            ///< Last client address
+}
+Server = { .fd = -1 };
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Lease handler and its context.
+ */
+//--------------------------------------------------------------------------------------------------
+static pa_wifiDhcp_LeaseHandlerFunc_t LeaseHandlerPtr;
+static void                          *LeaseHandlerContextPtr;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the absolute time, in seconds.
+ */
+//--------------------------------------------------------------------------------------------------
+static time_t GetNow
+(
+    void
+)
+{
+    return le_clk_GetAbsoluteTime().sec;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Format a MAC address as a lowercase string.
+ */
+//--------------------------------------------------------------------------------------------------
+static void FormatMac
+(
+    const uint8_t *macPtr,
+    char          *bufPtr,
+    size_t         bufSize
+)
+{
+    snprintf(bufPtr, bufSize, "%02x:%02x:%02x:%02x:%02x:%02x",
+             macPtr[0], macPtr[1], macPtr[2], macPtr[3], macPtr[4], macPtr[5]);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Format an address in host byte order.
+ */
+//--------------------------------------------------------------------------------------------------
+static void FormatAddr
+(
+    uint32_t  addr,
+    char     *bufPtr,
+    size_t    bufSize
+)
+{
+    struct in_addr inAddr = { .s_addr = htonl(addr) };
+
+    if (NULL == inet_ntop(AF_INET, &inAddr, bufPtr, bufSize))
+    {
+        bufPtr[0] = '\0';
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check whether an address is in the client range.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsInRange
+(
+    uint32_t addr
+)
+{
+    return (0 != Server.startAddr) && (addr >= Server.startAddr) && (addr <= Server.stopAddr);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check whether a lease holds its address.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsLeaseActive
+(
+    const Lease_t *leasePtr,
+    time_t         now
+)
+{
+    return (LEASE_FREE != leasePtr->state) && (leasePtr->expiry > now);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Report a bound lease, or the release of a lease, to the lease handler.
+ */
+//--------------------------------------------------------------------------------------------------
+static void ReportLease
+(
+    const Lease_t *leasePtr,
+    bool           isBound
+)
+{
+    pa_wifiDhcp_Lease_t lease;
+
+    if (NULL == LeaseHandlerPtr)
+    {
+        return;
+    }
+
+    memset(&lease, 0, sizeof(lease));
+    FormatMac(leasePtr->mac, lease.mac, sizeof(lease.mac));
+    if (isBound)
+    {
+        lease.addr = leasePtr->addr;
+        lease.expiry = leasePtr->expiry;
+        le_utf8_Copy(lease.hostname, leasePtr->hostname, sizeof(lease.hostname), NULL);
+    }
+    LeaseHandlerPtr(&lease, LeaseHandlerContextPtr);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Look the lease of a client up, whatever its state.
+ *
+ * @return The lease, or NULL.
+ */
+//--------------------------------------------------------------------------------------------------
+static Lease_t *FindLeaseByMac
+(
+    const uint8_t *macPtr
+)
+{
+    size_t i;
+
+    for (i = 0; i < PA_WIFIDHCP_MAX_LEASES; i++)
+    {
+        if ((LEASE_FREE != Leases[i].state) && (LEASE_DECLINED != Leases[i].state) &&
+            (0 == memcmp(Leases[i].mac, macPtr, BOOTP_HLEN_ETHERNET)))
+        {
+            return &Leases[i];
+        }
+    }
+    return NULL;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Look the lease of an address up, whatever its state.
+ *
+ * @return The lease, or NULL.
+ */
+//--------------------------------------------------------------------------------------------------
+static Lease_t *FindLeaseByAddr
+(
+    uint32_t addr
+)
+{
+    size_t i;
+
+    for (i = 0; i < PA_WIFIDHCP_MAX_LEASES; i++)
+    {
+        if ((LEASE_FREE != Leases[i].state) && (Leases[i].addr == addr))
+        {
+            return &Leases[i];
+        }
+    }
+    return NULL;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Find an unused entry of the lease table.
+ *
+ * @return The entry, or NULL if the table is full.
+ */
+//--------------------------------------------------------------------------------------------------
+static Lease_t *FindFreeLease
+(
+    void
+)
+{
+    size_t i;
+
+    for (i = 0; i < PA_WIFIDHCP_MAX_LEASES; i++)
+    {
+        if (LEASE_FREE == Leases[i].state)
+        {
+            return &Leases[i];
+        }
+    }
+    return NULL;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check whether an address of the range can be given to a client.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsAddrAvailable
+(
+    uint32_t       addr,
+    const uint8_t *macPtr,
+    time_t         now
+)
+{
+    const Lease_t *leasePtr = FindLeaseByAddr(addr);
+
+    return IsInRange(addr) && (addr != Server.serverAddr) &&
+           ((NULL == leasePtr) || (!IsLeaseActive(leasePtr, now)) ||
+            ((LEASE_DECLINED != leasePtr->state) &&
+             (0 == memcmp(leasePtr->mac, macPtr, BOOTP_HLEN_ETHERNET))));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the lease of a client for an address, reusing the entry of an expired lease of this address
+ * if any.
+ *
+ * @return The lease, or NULL if the table is full.
+ */
+//--------------------------------------------------------------------------------------------------
+static Lease_t *TakeLease
+(
+    const uint8_t *macPtr,
+    uint32_t       addr
+)
+{
+    Lease_t *leasePtr = FindLeaseByMac(macPtr);
+    Lease_t *addrLeasePtr = FindLeaseByAddr(addr);
+
+    if ((NULL != addrLeasePtr) && (addrLeasePtr != leasePtr))
+    {
+        addrLeasePtr->state = LEASE_FREE;
+    }
+    if (NULL == leasePtr)
+    {
+        leasePtr = (NULL != addrLeasePtr) ? addrLeasePtr : FindFreeLease();
+    }
+    if (NULL == leasePtr)
+    {
+        return NULL;
+    }
+
+    if ((leasePtr->addr != addr) || (0 != memcmp(leasePtr->mac, macPtr, BOOTP_HLEN_ETHERNET)))
+    {
+        memset(leasePtr, 0, sizeof(Lease_t));
+    }
+    memcpy(leasePtr->mac, macPtr, BOOTP_HLEN_ETHERNET);
+    leasePtr->addr = addr;
+    return leasePtr;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Choose the address offered to a client: its current address, the address it requests, the
+ * first unused address of the range or, once the table is full, the address of the oldest expired
+ * lease.
+ *
+ * @return The lease of the client, or NULL if no address is available.
+ */
+//--------------------------------------------------------------------------------------------------
+static Lease_t *AllocLease
+(
+    const uint8_t *macPtr,
+    uint32_t       requestedAddr,
+    time_t         now
+)
+{
+    Lease_t  *leasePtr = FindLeaseByMac(macPtr);
+    Lease_t  *oldestPtr = NULL;
+    uint32_t  addr;
+    size_t    i;
+
+    if ((NULL != leasePtr) && IsAddrAvailable(leasePtr->addr, macPtr, now))
+    {
+        return leasePtr;
+    }
+    if (IsAddrAvailable(requestedAddr, macPtr, now))
+    {
+        return TakeLease(macPtr, requestedAddr);
+    }
+
+    // The table is smaller than most ranges: stop at the first address without a lease
+    for (addr = Server.startAddr; (addr <= Server.stopAddr) && (0 != addr); addr++)
+    {
+        if ((addr != Server.serverAddr) && (NULL == FindLeaseByAddr(addr)))
+        {
+            leasePtr = TakeLease(macPtr, addr);
+            if (NULL != leasePtr)
+            {
+                return leasePtr;
+            }
+            break;
+        }
+    }
+
+    for (i = 0; i < PA_WIFIDHCP_MAX_LEASES; i++)
+    {
+        if ((!IsLeaseActive(&Leases[i], now)) && IsInRange(Leases[i].addr) &&
+            ((NULL == oldestPtr) || (Leases[i].expiry < oldestPtr->expiry)))
+        {
+            oldestPtr = &Leases[i];
+        }
+    }
+    return (NULL == oldestPtr) ? NULL : TakeLease(macPtr, oldestPtr->addr);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Write the bound leases to the lease file, through a temporary file renamed over it.
+ */
+//--------------------------------------------------------------------------------------------------
+static void SaveLeases
+(
+    void
+)
+{
+    char    tmpPath[PATH_MAX + 4];
+    char    mac[18];
+    char    addr[INET_ADDRSTRLEN];
+    time_t  now = GetNow();
+    FILE   *filePtr;
+    size_t  i;
+
+    Server.isSavePending = false;
+    if ('\0' == Server.leaseFile[0])
+    {
+        return;
+    }
+
+    snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", Server.leaseFile);
+    filePtr = fopen(tmpPath, "w");
+    if (NULL == filePtr)
+    {
+        LE_ERROR("Unable to open %s, errno %d (%s)", tmpPath, errno, LE_ERRNO_TXT(errno));
+        return;
+    }
+
+    // Same layout as the dnsmasq lease file: expiry, MAC, address, host name
+    for (i = 0; i < PA_WIFIDHCP_MAX_LEASES; i++)
+    {
+        if ((LEASE_BOUND == Leases[i].state) && IsLeaseActive(&Leases[i], now))
+        {
+            FormatMac(Leases[i].mac, mac, sizeof(mac));
+            FormatAddr(Leases[i].addr, addr, sizeof(addr));
+            fprintf(filePtr, "%lld %s %s %s\n", (long long)Leases[i].expiry, mac, addr,
+                    ('\0' != Leases[i].hostname[0]) ? Leases[i].hostname : "*");
+        }
+    }
+
+    if ((0 != fclose(filePtr)) || (0 != rename(tmpPath, Server.leaseFile)))
+    {
+        LE_ERROR("Unable to write %s, errno %d (%s)", Server.leaseFile, errno,
+                 LE_ERRNO_TXT(errno));
+        remove(tmpPath);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Save the lease table once the current message is answered.
+ */
+//--------------------------------------------------------------------------------------------------
+static void SavePendingLeases
+(
+    void *param1Ptr,
+    void *param2Ptr
+)
+{
+    if (Server.isSavePending)
+    {
+        SaveLeases();
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Schedule the save of the lease table, after the reply is sent.
+ */
+//--------------------------------------------------------------------------------------------------
+static void ScheduleSave
+(
+    void
+)
+{
+    if (!Server.isSavePending)
+    {
+        Server.isSavePending = true;
+        le_event_QueueFunction(SavePendingLeases, NULL, NULL);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Restore the leases of the lease file which have not expired.
+ */
+//--------------------------------------------------------------------------------------------------
+static void LoadLeases
+(
+    void
+)
+{
+    char            line[LEASE_LINE_MAX_BYTES];
+    char            mac[18];
+    char            addr[INET_ADDRSTRLEN];
+    char            hostname[PA_WIFIDHCP_HOSTNAME_MAX_BYTES];
+    long long       expiry;
+    struct in_addr  inAddr;
+    Lease_t        *leasePtr;
+    time_t          now = GetNow();
+    FILE           *filePtr;
+    int             count = 0;
+
+    memset(Leases, 0, sizeof(Leases));
+    if ('\0' == Server.leaseFile[0])
+    {
+        return;
+    }
+
+    filePtr = fopen(Server.leaseFile, "r");
+    if (NULL == filePtr)
+    {
+        return;
+    }
+
+    while ((NULL != fgets(line, sizeof(line), filePtr)) &&
+           (NULL != (leasePtr = FindFreeLease())))
+    {
+        if ((4 != sscanf(line, "%lld %17s %15s %" STRINGIFY_VALUE(LEASE_HOSTNAME_MAX_LEN) "s",
+                         &expiry, mac, addr, hostname)) ||
+            (expiry <= now) || (1 != inet_pton(AF_INET, addr, &inAddr)) ||
+            (6 != sscanf(mac, "%hhx:%hhx:%hhx:%hhx:%hhx:%hhx", &leasePtr->mac[0],
+                         &leasePtr->mac[1], &leasePtr->mac[2], &leasePtr->mac[3],
+                         &leasePtr->mac[4], &leasePtr->mac[5])))
+        {
+            continue;
+        }
+        leasePtr->state = LEASE_BOUND;
+        leasePtr->addr = ntohl(inAddr.s_addr);
+        leasePtr->expiry = expiry;
+        if (0 != strcmp(hostname, "*"))
+        {
+            le_utf8_Copy(leasePtr->hostname, hostname, sizeof(leasePtr->hostname), NULL);
+        }
+        count++;
+    }
+    fclose(filePtr);
+
+    LE_INFO("%d lease(s) restored from %s", count, Server.leaseFile);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Parse the options of a client message.
+ *
+ * @return LE_OK            The function succeeded.
+ * @return LE_FORMAT_ERROR  The options are invalid or the message type is missing.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t ParseOptions
+(
+    const uint8_t *optPtr,
+    size_t         optLen,
+    DhcpOptions_t *optionsPtr
+)
+{
+    size_t i = 0;
+
+    memset(optionsPtr, 0, sizeof(DhcpOptions_t));
+
+    while ((i < optLen) && (DHCP_OPT_END != optPtr[i]))
+    {
+        uint8_t        code = optPtr[i];
+        uint8_t        len;
+        const uint8_t *valuePtr;
+
+        if (DHCP_OPT_PAD == code)
+        {
+            i++;
+            continue;
+        }
+        if ((i + 2 > optLen) || (i + 2 + optPtr[i + 1] > optLen))
+        {
+            return LE_FORMAT_ERROR;
+        }
+        len = optPtr[i + 1];
+        valuePtr = &optPtr[i + 2];
+
+        if ((DHCP_OPT_MSG_TYPE == code) && (1 == len))
+        {
+            optionsPtr->type = valuePtr[0];
+        }
+        else if ((DHCP_OPT_REQUESTED_ADDR == code) && (4 == len))
+        {
+            memcpy(&optionsPtr->requestedAddr, valuePtr, 4);
+            optionsPtr->requestedAddr = ntohl(optionsPtr->requestedAddr);
+        }
+        else if ((DHCP_OPT_SERVER_ID == code) && (4 == len))
+        {
+            memcpy(&optionsPtr->serverId, valuePtr, 4);
+            optionsPtr->serverId = ntohl(optionsPtr->serverId);
+        }
+        else if ((DHCP_OPT_HOSTNAME == code) && (len > 0))
+        {
+            size_t hostnameLen = (len < sizeof(optionsPtr->hostname)) ?
+                                 len : (sizeof(optionsPtr->hostname) - 1);
+            size_t j;
+
+            // Kept as a single printable word for the lease file
+            for (j = 0; j < hostnameLen; j++)
+            {
+                optionsPtr->hostname[j] = isgraph(valuePtr[j]) ? (char)valuePtr[j] : '_';
+            }
+            optionsPtr->hostname[hostnameLen] = '\0';
+        }
+        i += 2 + len;
+    }
+
+    return (0 == optionsPtr->type) ? LE_FORMAT_ERROR : LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Append an option to a reply.
+ */
+//--------------------------------------------------------------------------------------------------
+static void PutOption
+(
+    uint8_t    *optPtr,
+    size_t     *offsetPtr,
+    uint8_t     code,
+    const void *valuePtr,
+    uint8_t     len
+)
+{
+    optPtr[(*offsetPtr)++] = code;
+    optPtr[(*offsetPtr)++] = len;
+    memcpy(&optPtr[*offsetPtr], valuePtr, len);
+    *offsetPtr += len;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Append an address or a duration option to a reply, from a value in host byte order.
+ */
+//--------------------------------------------------------------------------------------------------
+static void PutOptionU32
+(
+    uint8_t  *optPtr,
+    size_t   *offsetPtr,
+    uint8_t   code,
+    uint32_t  value
+)
+{
+    uint32_t netValue = htonl(value);
+
+    PutOption(optPtr, offsetPtr, code, &netValue, sizeof(netValue));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Build a reply to a client message.
+ */
+//--------------------------------------------------------------------------------------------------
+static void BuildReply
+(
+    const DhcpMsg_t *requestPtr,
+    uint8_t          type,
+    const Lease_t   *leasePtr,
+    time_t           now,
+    DhcpMsg_t       *replyPtr,
+    size_t          *replyLenPtr
+)
+{
+    size_t offset = 0;
+
+    memset(replyPtr, 0, sizeof(DhcpMsg_t));
+    replyPtr->op = BOOTP_OP_REPLY;
+    replyPtr->htype = requestPtr->htype;
+    replyPtr->hlen = requestPtr->hlen;
+    replyPtr->xid = requestPtr->xid;
+    replyPtr->flags = requestPtr->flags;
+    replyPtr->giaddr = requestPtr->giaddr;
+    memcpy(replyPtr->chaddr, requestPtr->chaddr, sizeof(replyPtr->chaddr));
+    replyPtr->magic = htonl(DHCP_MAGIC_COOKIE);
+
+    PutOption(replyPtr->options, &offset, DHCP_OPT_MSG_TYPE, &type, 1);
+    PutOptionU32(replyPtr->options, &offset, DHCP_OPT_SERVER_ID, Server.serverAddr);
+
+    if (DHCP_NAK != type)
+    {
+        if (NULL != leasePtr)
+        {
+            uint32_t leaseSec = (leasePtr->expiry > now) ? (uint32_t)(leasePtr->expiry - now) : 0;
+
+            if (LEASE_OFFERED == leasePtr->state)
+            {
+                leaseSec = PA_WIFIDHCP_LEASE_SEC;
+            }
+            replyPtr->yiaddr = htonl(leasePtr->addr);
+            PutOptionU32(replyPtr->options, &offset, DHCP_OPT_LEASE_TIME, leaseSec);
+            PutOptionU32(replyPtr->options, &offset, DHCP_OPT_RENEWAL_TIME, leaseSec / 2);
+            PutOptionU32(replyPtr->options, &offset, DHCP_OPT_REBINDING_TIME,
+                         leaseSec / 8 * 7);
+        }
+        else
+        {
+            // DHCPINFORM: the client already has its address
+            replyPtr->ciaddr = requestPtr->ciaddr;
+        }
+        PutOptionU32(replyPtr->options, &offset, DHCP_OPT_SUBNET_MASK, Server.netmask);
+        PutOptionU32(replyPtr->options, &offset, DHCP_OPT_ROUTER, Server.serverAddr);
+        PutOptionU32(replyPtr->options, &offset, DHCP_OPT_DNS_SERVER, Server.serverAddr);
+    }
+    replyPtr->options[offset++] = DHCP_OPT_END;
+
+    *replyLenPtr = DHCP_HEADER_BYTES + offset;
+    if (*replyLenPtr < BOOTP_MIN_BYTES)
+    {
+        *replyLenPtr = BOOTP_MIN_BYTES;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Process a DHCPREQUEST.
+ *
+ * @return The type of the reply, DHCP_ACK or DHCP_NAK, or 0 if the request is not for this
+ *         server.
+ */
+//--------------------------------------------------------------------------------------------------
+static uint8_t ProcessRequest
+(
+    const DhcpMsg_t     *msgPtr,
+    const DhcpOptions_t *optionsPtr,
+    time_t               now,
+    Lease_t            **leasePtrPtr
+)
+{
+    const uint8_t *macPtr = msgPtr->chaddr;
+    Lease_t       *leasePtr = FindLeaseByMac(macPtr);
+    uint32_t       addr = optionsPtr->requestedAddr;
+
+    // The client chose another server: release the offer
+    if ((0 != optionsPtr->serverId) && (optionsPtr->serverId != Server.serverAddr))
+    {
+        if ((NULL != leasePtr) && (LEASE_OFFERED == leasePtr->state))
+        {
+            leasePtr->state = LEASE_FREE;
+        }
+        return 0;
+    }
+
+    // Renewing and rebinding clients give their address in ciaddr
+    if (0 == addr)
+    {
+        addr = ntohl(msgPtr->ciaddr);
+    }
+
+    if ((NULL == leasePtr) || (leasePtr->addr != addr))
+    {
+        // Client rebooting with an address unknown to the server, e.g. after the loss of the
+        // lease file: keep its address if it is still available
+        if (IsAddrAvailable(addr, macPtr, now))
+        {
+            leasePtr = TakeLease(macPtr, addr);
+        }
+        else
+        {
+            leasePtr = NULL;
+        }
+    }
+    if ((NULL == leasePtr) || (!IsInRange(addr)))
+    {
+        return DHCP_NAK;
+    }
+
+    leasePtr->state = LEASE_BOUND;
+    leasePtr->expiry = now + PA_WIFIDHCP_LEASE_SEC;
+    if ('\0' != optionsPtr->hostname[0])
+    {
+        le_utf8_Copy(leasePtr->hostname, optionsPtr->hostname, sizeof(leasePtr->hostname), NULL);
+    }
+    *leasePtrPtr = leasePtr;
+    return DHCP_ACK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Send a reply to a client: to the relay if any, to the address of a configured client, or
+ * broadcast otherwise since the client cannot receive unicast frames before it has an address.
+ */
+//--------------------------------------------------------------------------------------------------
+static void SendReply
+(
+    const DhcpMsg_t *replyPtr,
+    size_t           replyLen
+)
+{
+    struct sockaddr_in dest;
+    uint8_t            type = replyPtr->options[2];
+
+    memset(&dest, 0, sizeof(dest));
+    dest.sin_family = AF_INET;
+    dest.sin_port = htons(DHCP_CLIENT_PORT);
+    dest.sin_addr.s_addr = htonl(INADDR_BROADCAST);
+
+    if (0 != replyPtr->giaddr)
+    {
+        dest.sin_port = htons(DHCP_SERVER_PORT);
+        dest.sin_addr.s_addr = replyPtr->giaddr;
+    }
+    else if ((0 != replyPtr->ciaddr) && (DHCP_NAK != type))
+    {
+        dest.sin_addr.s_addr = replyPtr->ciaddr;
+    }
+
+    if (sendto(Server.fd, replyPtr, replyLen, 0, (struct sockaddr *)&dest, sizeof(dest)) < 0)
+    {
+        LE_ERROR("Unable to send DHCP reply, errno %d (%s)", errno, LE_ERRNO_TXT(errno));
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Handler of the server socket: answer the messages received.
+ */
+//--------------------------------------------------------------------------------------------------
+static void SocketHandler
+(
+    int   fd,
+    short events
+)
+{
+    DhcpMsg_t msg;
+    DhcpMsg_t reply;
+    size_t    replyLen;
+    ssize_t   len;
+
+    if (!(events & POLLIN))
+    {
+        LE_ERROR("Unexpected event 0x%x on DHCP socket", events);
+        return;
+    }
+
+    while ((len = recv(fd, &msg, sizeof(msg), 0)) >= 0)
+    {
+        if (LE_OK == pa_wifiDhcp_ProcessMessage((const uint8_t *)&msg, len,
+                                                (uint8_t *)&reply, &replyLen))
+        {
+            SendReply(&reply, replyLen);
+        }
+    }
+    if ((EAGAIN != errno) && (EWOULDBLOCK != errno) && (EINTR != errno))
+    {
+        LE_ERROR("Unable to receive DHCP message, errno %d (%s)", errno, LE_ERRNO_TXT(errno));
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Open the server socket on an interface.
+ *
+ * @return LE_OK            The function succeeded.
+ * @return LE_FAULT         The function failed.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t OpenSocket
+(
+    const char *ifNamePtr
+)
+{
+    struct sockaddr_in addr;
+    int                on = 1;
+
+    Server.fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (Server.fd < 0)
+    {
+        LE_ERROR("Unable to create DHCP socket, errno %d (%s)", errno, LE_ERRNO_TXT(errno));
+        return LE_FAULT;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(DHCP_SERVER_PORT);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+
+    // Bound to the interface, the socket coexists with a DHCP server serving other interfaces
+    if ((setsockopt(Server.fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) < 0) ||
+        (setsockopt(Server.fd, SOL_SOCKET, SO_BROADCAST, &on, sizeof(on)) < 0) ||
+        (setsockopt(Server.fd, SOL_SOCKET, SO_BINDTODEVICE, ifNamePtr,
+                    strlen(ifNamePtr) + 1) < 0) ||
+        (bind(Server.fd, (struct sockaddr *)&addr, sizeof(addr)) < 0))
+    {
+        LE_ERROR("Unable to bind DHCP socket to %s, errno %d (%s)", ifNamePtr, errno,
+                 LE_ERRNO_TXT(errno));
+        close(Server.fd);
+        Server.fd = -1;
+        return LE_FAULT;
+    }
+
+    Server.fdMonitorRef = le_fdMonitor_Create("WifiDhcpServer", Server.fd, SocketHandler, POLLIN);
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Start the DHCP server. The leases of the lease file are restored; the addresses are only given
+ * once a range is set with pa_wifiDhcp_SetRange().
+ *
+ * @return LE_OK            The function succeeded.
+ * @return LE_DUPLICATE     The server is already started.
+ * @return LE_FAULT         The function failed.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiDhcp_Start
+(
+    const char *ifNamePtr,
+        ///< [IN]
+        ///< Interface to serve, NULL to only run the lease engine (see
+        ///< pa_wifiDhcp_ProcessMessage())
+    const char *leaseFilePtr
+        ///< [IN]
+        ///< Lease file, NULL to keep the leases in memory only
+)
+{
+    if (Server.isStarted)
+    {
+        return LE_DUPLICATE;
+    }
+
+    Server.leaseFile[0] = '\0';
+    if ((NULL != leaseFilePtr) &&
+        (LE_OK != le_utf8_Copy(Server.leaseFile, leaseFilePtr, sizeof(Server.leaseFile), NULL)))
+    {
+        LE_ERROR("Lease file path too long");
+        return LE_FAULT;
+    }
+    LoadLeases();
+
+    if ((NULL != ifNamePtr) && (LE_OK != OpenSocket(ifNamePtr)))
+    {
+        return LE_FAULT;
+    }
+
+    Server.isStarted = true;
+    LE_INFO("DHCP server started on %s", (NULL != ifNamePtr) ? ifNamePtr : "no interface");
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stop the DHCP server. The leases stay in the lease file.
+ */
+//--------------------------------------------------------------------------------------------------
+void pa_wifiDhcp_Stop
+(
+    void
+)
+{
+    if (!Server.isStarted)
+    {
+        return;
+    }
+
+    if (NULL != Server.fdMonitorRef)
+    {
+        le_fdMonitor_Delete(Server.fdMonitorRef);
+        Server.fdMonitorRef = NULL;
+    }
+    if (Server.fd >= 0)
+    {
+        close(Server.fd);
+        Server.fd = -1;
+    }
+    if (Server.isSavePending)
+    {
+        SaveLeases();
+    }
+
+    Server.isStarted = false;
+    LE_INFO("DHCP server stopped");
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the address of the server and the range of the client addresses, in host byte order. It
+ * applies to the next messages; the leases out of the new range are dropped.
+ *
+ * @return LE_OK            The function succeeded.
+ * @return LE_BAD_PARAMETER The range is invalid or holds the server address.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiDhcp_SetRange
+(
+    uint32_t serverAddr,
+        ///< [IN]
+        ///< Server address, also given as router and DNS server
+    uint32_t netmask,
+        ///< [IN]
+        ///< Subnet mask of the clients
+    uint32_t startAddr,
+        ///< [IN]
+        ///< First client address
+    uint32_t stopAddr
+        ///< [IN]
+        ///< Last client address
+)
+{
+    size_t i;
+
+    if ((0 == serverAddr) || (0 == netmask) || (0 == startAddr) || (startAddr > stopAddr) ||
+        ((serverAddr >= startAddr) && (serverAddr <= stopAddr)))
+    {
+        return LE_BAD_PARAMETER;
+    }
+    if (((startAddr & netmask) != (serverAddr & netmask)) ||
+        ((stopAddr & netmask) != (serverAddr & netmask)))
+    {
+        LE_WARN("Range out of the subnet of the server");
+    }
+
+    Server.serverAddr = serverAddr;
+    Server.netmask = netmask;
+    Server.startAddr = startAddr;
+    Server.stopAddr = stopAddr;
+
+    for (i = 0; i < PA_WIFIDHCP_MAX_LEASES; i++)
+    {
+        if ((LEASE_FREE != Leases[i].state) && (!IsInRange(Leases[i].addr)))
+        {
+            if (LEASE_BOUND == Leases[i].state)
+            {
+                ReportLease(&Leases[i], false);
+            }
+            Leases[i].state = LEASE_FREE;
+            ScheduleSave();
+        }
+    }
+
+    LE_INFO("DHCP range %08x-%08x, server %08x", startAddr, stopAddr, serverAddr);
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Process a DHCP message received from a client and build the reply, if any. The server calls it
+ * for each message received on its socket.
+ *
+ * @return LE_OK            The reply is built.
+ * @return LE_NOT_FOUND     The message needs no reply.
+ * @return LE_FORMAT_ERROR  The message is not a valid DHCP request.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiDhcp_ProcessMessage
+(
+    const uint8_t *msgPtr,
+        ///< [IN]
+        ///< Message received
+    size_t         msgLen,
+        ///< [IN]
+        ///< Size of the message
+    uint8_t       *replyPtr,
+        ///< [OUT]
+        ///< Reply, PA_WIFIDHCP_MSG_MAX_BYTES long
+    size_t        *replyLenPtr
+        ///< [OUT]
+        ///< Size of the reply
+)
+{
+    DhcpMsg_t      msg;
+    DhcpMsg_t      reply;
+    DhcpOptions_t  options;
+    Lease_t       *leasePtr = NULL;
+    time_t         now = GetNow();
+    uint8_t        replyType = 0;
+    char           mac[18];
+    char           addr[INET_ADDRSTRLEN];
+
+    if ((msgLen < DHCP_HEADER_BYTES) || (msgLen > sizeof(msg)))
+    {
+        return LE_FORMAT_ERROR;
+    }
+    memset(&msg, 0, sizeof(msg));
+    memcpy(&msg, msgPtr, msgLen);
+
+    if ((BOOTP_OP_REQUEST != msg.op) || (BOOTP_HTYPE_ETHERNET != msg.htype) ||
+        (BOOTP_HLEN_ETHERNET != msg.hlen) || (htonl(DHCP_MAGIC_COOKIE) != msg.magic) ||
+        (LE_OK != ParseOptions(msg.options, msgLen - DHCP_HEADER_BYTES, &options)))
+    {
+        return LE_FORMAT_ERROR;
+    }
+
+    // No address to give yet
+    if (0 == Server.startAddr)
+    {
+        return LE_NOT_FOUND;
+    }
+
+    FormatMac(msg.chaddr, mac, sizeof(mac));
+
+    switch (options.type)
+    {
+        case DHCP_DISCOVER:
+            leasePtr = AllocLease(msg.chaddr, options.requestedAddr, now);
+            if (NULL == leasePtr)
+            {
+                LE_WARN("No address left for %s", mac);
+                return LE_NOT_FOUND;
+            }
+            if ((LEASE_BOUND != leasePtr->state) || (!IsLeaseActive(leasePtr, now)))
+            {
+                leasePtr->state = LEASE_OFFERED;
+                leasePtr->expiry = now + OFFER_HOLD_SEC;
+            }
+            replyType = DHCP_OFFER;
+            break;
+
+        case DHCP_REQUEST:
+            replyType = ProcessRequest(&msg, &options, now, &leasePtr);
+            if (DHCP_ACK == replyType)
+            {
+                ReportLease(leasePtr, true);
+                ScheduleSave();
+            }
+            break;
+
+        case DHCP_DECLINE:
+            leasePtr = FindLeaseByMac(msg.chaddr);
+            if ((NULL != leasePtr) && (leasePtr->addr == options.requestedAddr))
+            {
+                FormatAddr(leasePtr->addr, addr, sizeof(addr));
+                LE_WARN("Address %s declined by %s", addr, mac);
+                if (LEASE_BOUND == leasePtr->state)
+                {
+                    ReportLease(leasePtr, false);
+                }
+                memset(leasePtr->mac, 0, sizeof(leasePtr->mac));
+                leasePtr->hostname[0] = '\0';
+                leasePtr->state = LEASE_DECLINED;
+                leasePtr->expiry = now + PA_WIFIDHCP_LEASE_SEC;
+                ScheduleSave();
+            }
+            return LE_NOT_FOUND;
+
+        case DHCP_RELEASE:
+            leasePtr = FindLeaseByMac(msg.chaddr);
+            if ((NULL != leasePtr) && (leasePtr->addr == ntohl(msg.ciaddr)))
+            {
+                if (LEASE_BOUND == leasePtr->state)
+                {
+                    ReportLease(leasePtr, false);
+                }
+                leasePtr->state = LEASE_FREE;
+                ScheduleSave();
+            }
+            return LE_NOT_FOUND;
+
+        case DHCP_INFORM:
+            replyType = DHCP_ACK;
+            break;
+
+        default:
+            return LE_NOT_FOUND;
+    }
+
+    if (0 == replyType)
+    {
+        return LE_NOT_FOUND;
+    }
+
+    BuildReply(&msg, replyType, leasePtr, now, &reply, replyLenPtr);
+    memcpy(replyPtr, &reply, *replyLenPtr);
+
+    if (NULL != leasePtr)
+    {
+        FormatAddr(leasePtr->addr, addr, sizeof(addr));
+    }
+    else
+    {
+        FormatAddr((0 != options.requestedAddr) ? options.requestedAddr : ntohl(msg.ciaddr),
+                   addr, sizeof(addr));
+    }
+    LE_DEBUG("DHCP %s %s to %s",
+             (DHCP_OFFER == replyType) ? "OFFER" : ((DHCP_ACK == replyType) ? "ACK" : "NAK"),
+             addr, mac);
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the lease handler, NULL to remove it. It is called by the thread running the server before
+ * the reply to the client is sent, so it must not block.
+ */
+//--------------------------------------------------------------------------------------------------
+void pa_wifiDhcp_SetLeaseHandler
+(
+    pa_wifiDhcp_LeaseHandlerFunc_t handlerPtr,
+        ///< [IN]
+        ///< Lease handler
+    void                          *contextPtr
+        ///< [IN]
+        ///< Context given to the handler
+)
+{
+    LeaseHandlerPtr = handlerPtr;
+    LeaseHandlerContextPtr = contextPtr;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the active lease of a client.
+ *
+ * @return LE_OK            The function succeeded.
+ * @return LE_NOT_FOUND     The client has no active lease.
+ * @return LE_BAD_PARAMETER The MAC address is invalid.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiDhcp_GetLease
+(
+    const char          *macPtr,
+        ///< [IN]
+        ///< MAC address of the client
+    pa_wifiDhcp_Lease_t *leasePtr
+        ///< [OUT]
+        ///< Lease of the client
+)
+{
+    uint8_t        mac[BOOTP_HLEN_ETHERNET];
+    const Lease_t *foundPtr;
+
+    if (6 != sscanf(macPtr, "%hhx:%hhx:%hhx:%hhx:%hhx:%hhx",
+                    &mac[0], &mac[1], &mac[2], &mac[3], &mac[4], &mac[5]))
+    {
+        return LE_BAD_PARAMETER;
+    }
+
+    foundPtr = FindLeaseByMac(mac);
+    if ((NULL == foundPtr) || (LEASE_BOUND != foundPtr->state) ||
+        (!IsLeaseActive(foundPtr, GetNow())))
+    {
+        return LE_NOT_FOUND;
+    }
+
+    memset(leasePtr, 0, sizeof(pa_wifiDhcp_Lease_t));
+    FormatMac(foundPtr->mac, leasePtr->mac, sizeof(leasePtr->mac));
+    leasePtr->addr = foundPtr->addr;
+    leasePtr->expiry = foundPtr->expiry;
+    le_utf8_Copy(leasePtr->hostname, foundPtr->hostname, sizeof(leasePtr->hostname), NULL);
+    return LE_OK;
+}
@@ -0,0 +1,1424 @@
+// -------------------------------------------------------------------------------------------------
+/**
+ *  WiFi nl80211 generic netlink helpers
+ *
+ *  Copyright (C) Sierra Wireless Inc.
+ *
+ */
+// -------------------------------------------------------------------------------------------------
+#include <net/if.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <linux/rtnetlink.h>
+
+#include "legato.h"
+
+#include "pa_wifi_nl80211.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Timeout used when waiting for the answer to a request (ms).
+ */
+//--------------------------------------------------------------------------------------------------
+#define REQUEST_TIMEOUT_MS      5000
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Size of the receive socket buffer requested to the kernel. Multicast notifications are dropped
+ * by the kernel when this buffer overflows.
+ */
+//--------------------------------------------------------------------------------------------------
+#define SOCKET_RCVBUF_BYTES     (256 * 1024)
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Size of the receive buffer of the route netlink socket: the kernel sizes the datagrams of a
+ * link dump after the buffers given to recv().
+ */
+//--------------------------------------------------------------------------------------------------
+#define RTNL_RX_BUFFER_BYTES    8192
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Pointer to the tail of a request.
+ */
+//--------------------------------------------------------------------------------------------------
+#define MSG_TAIL(msgPtr) \
+    ((struct nlattr *)((msgPtr)->buf + NLMSG_ALIGN((msgPtr)->hdr.nlmsg_len)))
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Context used while resolving the nl80211 family.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    pa_wifiNl80211_Socket_t *sockPtr;   ///< Socket being initialized
+    bool                     found;     ///< Family found
+}
+ResolveCtx_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Handler registered on the shared event listener.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    pa_wifiNl80211_HandlerFunc_t handlerFunc;   ///< Notification handler
+    void                        *contextPtr;    ///< Context passed to the handler
+}
+Listener_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Multicast groups the shared event listener is subscribed to.
+ */
+//--------------------------------------------------------------------------------------------------
+static const char *EventGroups[] = { "mlme", "scan", "config" };
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Handlers registered on the shared event listener. Changed with both ListenerLifecycleMutex and
+ * ListenerMutex held, read by the listener thread with ListenerMutex held.
+ */
+//--------------------------------------------------------------------------------------------------
+static Listener_t       Listeners[PA_WIFINL80211_MAX_LISTENERS];
+static uint32_t         ListenerCount = 0;
+static le_mutex_Ref_t   ListenerMutex = NULL;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Serialize the registrations of the client and access point PA threads, so that the listener
+ * thread is started and stopped once. Never taken by the listener thread, which is joined with
+ * this mutex held.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_mutex_Ref_t   ListenerLifecycleMutex = NULL;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Shared event listener thread, its socket and the monitor of the socket. The thread and the
+ * socket are started and stopped with ListenerLifecycleMutex held.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_thread_Ref_t          ListenerThread = NULL;
+static pa_wifiNl80211_Socket_t  EventSocket;
+static le_fdMonitor_Ref_t       EventFdMonitor = NULL;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Convert a negative errno returned by the kernel into a Legato result.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t ErrnoToResult
+(
+    int error
+)
+{
+    switch (-error)
+    {
+        case 0:
+            return LE_OK;
+        case EBUSY:
+            return LE_BUSY;
+        case ENOENT:
+        case ENODEV:
+        case ENOLINK:
+            return LE_NOT_FOUND;
+        case EOPNOTSUPP:
+            return LE_UNSUPPORTED;
+        default:
+            return LE_FAULT;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Send a request on the socket.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t SendMsg
+(
+    pa_wifiNl80211_Socket_t *sockPtr,
+    pa_wifiNl80211_Msg_t    *msgPtr
+)
+{
+    struct sockaddr_nl addr;
+    ssize_t            sent;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.nl_family = AF_NETLINK;
+
+    do
+    {
+        sent = sendto(sockPtr->fd, msgPtr->buf, msgPtr->hdr.nlmsg_len, 0,
+                      (struct sockaddr *)&addr, sizeof(addr));
+    }
+    while ((sent < 0) && (EINTR == errno));
+
+    if (sent != (ssize_t)msgPtr->hdr.nlmsg_len)
+    {
+        LE_ERROR("Unable to send nl80211 request, errno %d (%s)", errno, LE_ERRNO_TXT(errno));
+        return LE_FAULT;
+    }
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read one datagram from the socket and dispatch its messages.
+ *
+ * @return LE_OK         The datagram was processed and the expected answer was not complete yet.
+ * @return LE_TERMINATED The answer to the request identified by seq is complete; *errorPtr holds
+ *                       the kernel status.
+ * @return LE_TIMEOUT    Nothing was received before the timeout.
+ * @return LE_FAULT      Reading failed.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t ReceiveDatagram
+(
+    pa_wifiNl80211_Socket_t     *sockPtr,
+    pa_wifiNl80211_HandlerFunc_t handlerFunc,
+    void                        *contextPtr,
+    int                          timeoutMs,
+    uint32_t                     seq,
+    int                         *errorPtr
+)
+{
+    struct pollfd    pfd;
+    struct nlmsghdr *hdrPtr;
+    ssize_t          len;
+    int              rc;
+    le_result_t      result = LE_OK;
+
+    pfd.fd = sockPtr->fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+
+    do
+    {
+        rc = poll(&pfd, 1, timeoutMs);
+    }
+    while ((rc < 0) && (EINTR == errno));
+
+    if (0 == rc)
+    {
+        return LE_TIMEOUT;
+    }
+    if (rc < 0)
+    {
+        LE_ERROR("poll() failed, errno %d (%s)", errno, LE_ERRNO_TXT(errno));
+        return LE_FAULT;
+    }
+
+    len = recv(sockPtr->fd, sockPtr->rxBuf, sizeof(sockPtr->rxBuf), 0);
+    if (len < 0)
+    {
+        if ((EINTR == errno) || (EAGAIN == errno))
+        {
+            return LE_OK;
+        }
+        if (ENOBUFS == errno)
+        {
+            // The kernel dropped multicast notifications, keep going.
+            LE_WARN("nl80211 socket overrun, some notifications were lost");
+            return LE_OK;
+        }
+        LE_ERROR("recv() failed, errno %d (%s)", errno, LE_ERRNO_TXT(errno));
+        return LE_FAULT;
+    }
+
+    for (hdrPtr = (struct nlmsghdr *)sockPtr->rxBuf;
+         NLMSG_OK(hdrPtr, (size_t)len);
+         hdrPtr = NLMSG_NEXT(hdrPtr, len))
+    {
+        bool isAnswer = (0 != seq) && (hdrPtr->nlmsg_seq == seq);
+
+        if (NLMSG_ERROR == hdrPtr->nlmsg_type)
+        {
+            struct nlmsgerr *errPtr = NLMSG_DATA(hdrPtr);
+
+            if (hdrPtr->nlmsg_len < NLMSG_LENGTH(sizeof(struct nlmsgerr)))
+            {
+                continue;
+            }
+            if (isAnswer)
+            {
+                *errorPtr = errPtr->error;
+                result = LE_TERMINATED;
+            }
+            continue;
+        }
+
+        if (NLMSG_DONE == hdrPtr->nlmsg_type)
+        {
+            if (isAnswer)
+            {
+                *errorPtr = 0;
+                result = LE_TERMINATED;
+            }
+            continue;
+        }
+
+        // A message shorter than its generic netlink header has no attribute to parse
+        if ((hdrPtr->nlmsg_type != sockPtr->familyId) || (NULL == handlerFunc) ||
+            (hdrPtr->nlmsg_len < NLMSG_LENGTH(GENL_HDRLEN)))
+        {
+            continue;
+        }
+
+        struct genlmsghdr *genlPtr = NLMSG_DATA(hdrPtr);
+        struct nlattr     *attrs[NL80211_ATTR_MAX + 1];
+
+        pa_wifiNl80211_ParseAttrs(attrs, NL80211_ATTR_MAX,
+                                  (uint8_t *)genlPtr + GENL_HDRLEN,
+                                  hdrPtr->nlmsg_len - NLMSG_HDRLEN - GENL_HDRLEN);
+        handlerFunc(genlPtr->cmd, attrs, contextPtr);
+    }
+
+    return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Parse the CTRL_CMD_GETFAMILY answer: family id and multicast groups.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t ParseFamily
+(
+    pa_wifiNl80211_Socket_t *sockPtr,
+    struct nlmsghdr         *hdrPtr
+)
+{
+    struct nlattr *attrs[CTRL_ATTR_MAX + 1];
+    struct nlattr *groupPtr;
+    int            rem;
+
+    if (hdrPtr->nlmsg_len < NLMSG_LENGTH(GENL_HDRLEN))
+    {
+        return LE_FAULT;
+    }
+
+    pa_wifiNl80211_ParseAttrs(attrs, CTRL_ATTR_MAX,
+                              (uint8_t *)NLMSG_DATA(hdrPtr) + GENL_HDRLEN,
+                              hdrPtr->nlmsg_len - NLMSG_HDRLEN - GENL_HDRLEN);
+
+    if (NULL == attrs[CTRL_ATTR_FAMILY_ID])
+    {
+        return LE_FAULT;
+    }
+    sockPtr->familyId = pa_wifiNl80211_AttrU16(attrs[CTRL_ATTR_FAMILY_ID]);
+
+    if (NULL == attrs[CTRL_ATTR_MCAST_GROUPS])
+    {
+        return LE_OK;
+    }
+
+    groupPtr = pa_wifiNl80211_AttrData(attrs[CTRL_ATTR_MCAST_GROUPS]);
+    rem = pa_wifiNl80211_AttrLen(attrs[CTRL_ATTR_MCAST_GROUPS]);
+    while ((rem >= (int)NLA_HDRLEN) && (groupPtr->nla_len >= NLA_HDRLEN) &&
+           (groupPtr->nla_len <= rem) && (sockPtr->groupCount < PA_WIFINL80211_MAX_GROUPS))
+    {
+        struct nlattr *groupAttrs[CTRL_ATTR_MCAST_GRP_MAX + 1];
+
+        pa_wifiNl80211_ParseAttrs(groupAttrs, CTRL_ATTR_MCAST_GRP_MAX,
+                                  pa_wifiNl80211_AttrData(groupPtr),
+                                  pa_wifiNl80211_AttrLen(groupPtr));
+        if ((NULL != groupAttrs[CTRL_ATTR_MCAST_GRP_NAME]) &&
+            (NULL != groupAttrs[CTRL_ATTR_MCAST_GRP_ID]))
+        {
+            pa_wifiNl80211_Group_t *grpPtr = &sockPtr->groups[sockPtr->groupCount];
+
+            le_utf8_Copy(grpPtr->name,
+                         pa_wifiNl80211_AttrData(groupAttrs[CTRL_ATTR_MCAST_GRP_NAME]),
+                         sizeof(grpPtr->name), NULL);
+            grpPtr->id = pa_wifiNl80211_AttrU32(groupAttrs[CTRL_ATTR_MCAST_GRP_ID]);
+            sockPtr->groupCount++;
+        }
+
+        rem -= NLA_ALIGN(groupPtr->nla_len);
+        groupPtr = (struct nlattr *)((uint8_t *)groupPtr + NLA_ALIGN(groupPtr->nla_len));
+    }
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Resolve the nl80211 generic netlink family.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t ResolveFamily
+(
+    pa_wifiNl80211_Socket_t *sockPtr
+)
+{
+    pa_wifiNl80211_Msg_t msg;
+    struct genlmsghdr   *genlPtr;
+    le_result_t          result = LE_FAULT;
+    int                  error = 0;
+
+    memset(&msg, 0, sizeof(msg));
+    msg.hdr.nlmsg_len = NLMSG_LENGTH(GENL_HDRLEN);
+    msg.hdr.nlmsg_type = GENL_ID_CTRL;
+    msg.hdr.nlmsg_flags = NLM_F_REQUEST | NLM_F_ACK;
+    msg.hdr.nlmsg_seq = ++sockPtr->seq;
+    genlPtr = NLMSG_DATA(&msg.hdr);
+    genlPtr->cmd = CTRL_CMD_GETFAMILY;
+    genlPtr->version = 1;
+
+    if (LE_OK != pa_wifiNl80211_PutAttr(&msg, CTRL_ATTR_FAMILY_NAME,
+                                        NL80211_GENL_NAME, sizeof(NL80211_GENL_NAME)))
+    {
+        return LE_FAULT;
+    }
+
+    if (LE_OK != SendMsg(sockPtr, &msg))
+    {
+        return LE_FAULT;
+    }
+
+    for (;;)
+    {
+        struct pollfd    pfd = { .fd = sockPtr->fd, .events = POLLIN, .revents = 0 };
+        struct nlmsghdr *hdrPtr;
+        ssize_t          len;
+
+        if (poll(&pfd, 1, REQUEST_TIMEOUT_MS) <= 0)
+        {
+            return LE_TIMEOUT;
+        }
+
+        len = recv(sockPtr->fd, sockPtr->rxBuf, sizeof(sockPtr->rxBuf), 0);
+        if (len < 0)
+        {
+            return LE_FAULT;
+        }
+
+        for (hdrPtr = (struct nlmsghdr *)sockPtr->rxBuf;
+             NLMSG_OK(hdrPtr, (size_t)len);
+             hdrPtr = NLMSG_NEXT(hdrPtr, len))
+        {
+            if (hdrPtr->nlmsg_seq != sockPtr->seq)
+            {
+                continue;
+            }
+            if ((NLMSG_ERROR == hdrPtr->nlmsg_type) &&
+                (hdrPtr->nlmsg_len >= NLMSG_LENGTH(sizeof(struct nlmsgerr))))
+            {
+                error = ((struct nlmsgerr *)NLMSG_DATA(hdrPtr))->error;
+                if (0 != error)
+                {
+                    return (-ENOENT == error) ? LE_UNSUPPORTED : LE_FAULT;
+                }
+                return result;
+            }
+            if (GENL_ID_CTRL == hdrPtr->nlmsg_type)
+            {
+                result = ParseFamily(sockPtr, hdrPtr);
+            }
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Pass a notification to every handler registered on the shared event listener.
+ */
+//--------------------------------------------------------------------------------------------------
+static void DispatchEvent
+(
+    uint8_t        cmd,
+    struct nlattr *attrs[],
+    void          *contextPtr
+)
+{
+    uint32_t i;
+
+    le_mutex_Lock(ListenerMutex);
+    for (i = 0; i < ListenerCount; i++)
+    {
+        Listeners[i].handlerFunc(cmd, attrs, Listeners[i].contextPtr);
+    }
+    le_mutex_Unlock(ListenerMutex);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Handler of the events on the shared event listener socket.
+ */
+//--------------------------------------------------------------------------------------------------
+static void EventSocketHandler
+(
+    int   fd,
+    short events
+)
+{
+    if (events & POLLIN)
+    {
+        pa_wifiNl80211_Receive(&EventSocket, DispatchEvent, NULL, 0);
+    }
+    else
+    {
+        LE_ERROR("Unexpected event 0x%x on nl80211 socket", events);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Shared event listener thread.
+ */
+//--------------------------------------------------------------------------------------------------
+static void *ListenerThreadMain
+(
+    void *contextPtr
+)
+{
+    LE_INFO("nl80211 event listener started");
+
+    EventFdMonitor = le_fdMonitor_Create("WifiNl80211Events", EventSocket.fd,
+                                         EventSocketHandler, POLLIN);
+    le_event_RunLoop();
+    return NULL;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Shared event listener thread destructor.
+ */
+//--------------------------------------------------------------------------------------------------
+static void ListenerThreadDestructor
+(
+    void *contextPtr
+)
+{
+    if (NULL != EventFdMonitor)
+    {
+        le_fdMonitor_Delete(EventFdMonitor);
+        EventFdMonitor = NULL;
+    }
+    pa_wifiNl80211_Close(&EventSocket);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Terminate the shared event listener thread. Queued to the thread itself so that it exits
+ * between two notifications.
+ */
+//--------------------------------------------------------------------------------------------------
+static void ExitListenerThread
+(
+    void *param1Ptr,
+    void *param2Ptr
+)
+{
+    le_thread_Exit(NULL);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Open the shared event listener socket and start its thread.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t StartListener
+(
+    void
+)
+{
+    le_result_t result;
+    uint32_t    joined = 0;
+    uint32_t    i;
+
+    result = pa_wifiNl80211_Open(&EventSocket);
+    if (LE_OK != result)
+    {
+        return result;
+    }
+
+    for (i = 0; i < NUM_ARRAY_MEMBERS(EventGroups); i++)
+    {
+        if (LE_OK == pa_wifiNl80211_JoinGroup(&EventSocket, EventGroups[i]))
+        {
+            joined++;
+        }
+    }
+
+    if (0 == joined)
+    {
+        pa_wifiNl80211_Close(&EventSocket);
+        return LE_FAULT;
+    }
+
+    ListenerThread = le_thread_Create("WifiNl80211Listener", ListenerThreadMain, NULL);
+    le_thread_SetJoinable(ListenerThread);
+    le_thread_AddChildDestructor(ListenerThread, ListenerThreadDestructor, NULL);
+    le_thread_Start(ListenerThread);
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stop the shared event listener thread and wait for its termination.
+ */
+//--------------------------------------------------------------------------------------------------
+static void StopListener
+(
+    void
+)
+{
+    le_event_QueueFunctionToThread(ListenerThread, ExitListenerThread, NULL, NULL);
+    le_thread_Join(ListenerThread, NULL);
+    ListenerThread = NULL;
+    LE_INFO("nl80211 event listener stopped");
+}
+
+//--------------------------------------------------------------------------------------------------
+// Public declarations
+//--------------------------------------------------------------------------------------------------
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Request the state of all the network interfaces on a route netlink socket.
+ *
+ * @return LE_OK            The function succeeded.
+ * @return LE_FAULT         The function failed.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t RequestLinkDump
+(
+    int fd
+)
+{
+    struct
+    {
+        struct nlmsghdr  hdr;
+        struct ifinfomsg ifi;
+    }
+    req;
+
+    memset(&req, 0, sizeof(req));
+    req.hdr.nlmsg_len = NLMSG_LENGTH(sizeof(struct ifinfomsg));
+    req.hdr.nlmsg_type = RTM_GETLINK;
+    req.hdr.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    req.ifi.ifi_family = AF_UNSPEC;
+
+    if (send(fd, &req, req.hdr.nlmsg_len, 0) < 0)
+    {
+        LE_ERROR("Unable to request the links, errno %d (%s)", errno, LE_ERRNO_TXT(errno));
+        return LE_FAULT;
+    }
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the flags of a network interface from a RTM_NEWLINK message.
+ *
+ * @return true if the message describes the interface.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool ParseLink
+(
+    const struct nlmsghdr *hdrPtr,
+    const char            *ifNamePtr,
+    unsigned int          *flagsPtr
+)
+{
+    const struct ifinfomsg *ifiPtr = NLMSG_DATA(hdrPtr);
+    const struct rtattr    *attrPtr;
+    size_t                  nameLen = strlen(ifNamePtr);
+    int                     len;
+
+    if ((RTM_NEWLINK != hdrPtr->nlmsg_type) ||
+        (hdrPtr->nlmsg_len < NLMSG_LENGTH(sizeof(struct ifinfomsg))))
+    {
+        return false;
+    }
+
+    len = IFLA_PAYLOAD(hdrPtr);
+    for (attrPtr = IFLA_RTA(ifiPtr); RTA_OK(attrPtr, len); attrPtr = RTA_NEXT(attrPtr, len))
+    {
+        if (IFLA_IFNAME == attrPtr->rta_type)
+        {
+            if ((RTA_PAYLOAD(attrPtr) <= nameLen) ||
+                (0 != memcmp(RTA_DATA(attrPtr), ifNamePtr, nameLen + 1)))
+            {
+                return false;
+            }
+            *flagsPtr = ifiPtr->ifi_flags;
+            return true;
+        }
+    }
+    return false;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set a network interface up.
+ *
+ * @return LE_OK            The function succeeded.
+ * @return LE_FAULT         The function failed.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t SetInterfaceUp
+(
+    const char *ifNamePtr
+)
+{
+    struct ifreq ifr;
+    le_result_t  result = LE_OK;
+    int          fd;
+
+    fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+    {
+        LE_ERROR("Unable to open socket, errno %d (%s)", errno, LE_ERRNO_TXT(errno));
+        return LE_FAULT;
+    }
+
+    memset(&ifr, 0, sizeof(ifr));
+    le_utf8_Copy(ifr.ifr_name, ifNamePtr, sizeof(ifr.ifr_name), NULL);
+    if (ioctl(fd, SIOCGIFFLAGS, &ifr) < 0)
+    {
+        result = LE_FAULT;
+    }
+    else if (0 == (ifr.ifr_flags & IFF_UP))
+    {
+        ifr.ifr_flags |= IFF_UP;
+        if (ioctl(fd, SIOCSIFFLAGS, &ifr) < 0)
+        {
+            result = LE_FAULT;
+        }
+    }
+    if (LE_OK != result)
+    {
+        LE_WARN("Unable to set %s up, errno %d (%s)", ifNamePtr, errno, LE_ERRNO_TXT(errno));
+    }
+
+    close(fd);
+    return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Open a generic netlink socket and resolve the nl80211 family and its multicast groups.
+ *
+ * @return LE_OK            The function succeeded.
+ * @return LE_UNSUPPORTED   nl80211 is not available on this kernel.
+ * @return LE_FAULT         The function failed.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiNl80211_Open
+(
+    pa_wifiNl80211_Socket_t *sockPtr
+        ///< [OUT]
+        ///< Socket to initialize
+)
+{
+    struct sockaddr_nl addr;
+    int                rcvBuf = SOCKET_RCVBUF_BYTES;
+    int                one = 1;
+    le_result_t        result;
+
+    memset(sockPtr, 0, offsetof(pa_wifiNl80211_Socket_t, rxBuf));
+
+    sockPtr->fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_GENERIC);
+    if (sockPtr->fd < 0)
+    {
+        LE_ERROR("Unable to open generic netlink socket, errno %d (%s)",
+                 errno, LE_ERRNO_TXT(errno));
+        return LE_FAULT;
+    }
+
+    setsockopt(sockPtr->fd, SOL_SOCKET, SO_RCVBUF, &rcvBuf, sizeof(rcvBuf));
+    // Do not report ENOBUFS on the unicast answers because of a multicast overrun.
+    setsockopt(sockPtr->fd, SOL_NETLINK, NETLINK_NO_ENOBUFS, &one, sizeof(one));
+
+    memset(&addr, 0, sizeof(addr));
+    addr.nl_family = AF_NETLINK;
+    if (bind(sockPtr->fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        LE_ERROR("Unable to bind generic netlink socket, errno %d (%s)",
+                 errno, LE_ERRNO_TXT(errno));
+        close(sockPtr->fd);
+        sockPtr->fd = -1;
+        return LE_FAULT;
+    }
+
+    result = ResolveFamily(sockPtr);
+    if (LE_OK != result)
+    {
+        LE_WARN("Unable to resolve the nl80211 family (%d)", result);
+        close(sockPtr->fd);
+        sockPtr->fd = -1;
+        return (LE_UNSUPPORTED == result) ? LE_UNSUPPORTED : LE_FAULT;
+    }
+
+    LE_DEBUG("nl80211 family %d, %d multicast groups", sockPtr->familyId, sockPtr->groupCount);
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Close an nl80211 socket.
+ */
+//--------------------------------------------------------------------------------------------------
+void pa_wifiNl80211_Close
+(
+    pa_wifiNl80211_Socket_t *sockPtr
+        ///< [IN]
+        ///< Socket to close
+)
+{
+    if ((NULL != sockPtr) && (sockPtr->fd >= 0))
+    {
+        close(sockPtr->fd);
+        sockPtr->fd = -1;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Subscribe the socket to an nl80211 multicast group ("scan", "mlme", "config", ...).
+ *
+ * @return LE_OK            The function succeeded.
+ * @return LE_NOT_FOUND     The group is not provided by the kernel.
+ * @return LE_FAULT         The function failed.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiNl80211_JoinGroup
+(
+    pa_wifiNl80211_Socket_t *sockPtr,
+        ///< [IN]
+        ///< Socket
+    const char              *groupNamePtr
+        ///< [IN]
+        ///< Multicast group name
+)
+{
+    uint32_t i;
+
+    for (i = 0; i < sockPtr->groupCount; i++)
+    {
+        if (0 == strcmp(sockPtr->groups[i].name, groupNamePtr))
+        {
+            if (setsockopt(sockPtr->fd, SOL_NETLINK, NETLINK_ADD_MEMBERSHIP,
+                           &sockPtr->groups[i].id, sizeof(sockPtr->groups[i].id)) < 0)
+            {
+                LE_ERROR("Unable to join nl80211 group '%s', errno %d (%s)",
+                         groupNamePtr, errno, LE_ERRNO_TXT(errno));
+                return LE_FAULT;
+            }
+            return LE_OK;
+        }
+    }
+
+    LE_WARN("nl80211 multicast group '%s' not found", groupNamePtr);
+    return LE_NOT_FOUND;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Initialize an nl80211 request.
+ */
+//--------------------------------------------------------------------------------------------------
+void pa_wifiNl80211_InitMsg
+(
+    pa_wifiNl80211_Socket_t *sockPtr,
+        ///< [IN]
+        ///< Socket the request will be sent on
+    pa_wifiNl80211_Msg_t    *msgPtr,
+        ///< [OUT]
+        ///< Request to initialize
+    uint8_t                  cmd,
+        ///< [IN]
+        ///< nl80211 command (NL80211_CMD_*)
+    uint16_t                 flags
+        ///< [IN]
+        ///< Additional netlink flags (e.g. NLM_F_DUMP)
+)
+{
+    struct genlmsghdr *genlPtr;
+
+    memset(msgPtr, 0, NLMSG_LENGTH(GENL_HDRLEN));
+    msgPtr->hdr.nlmsg_len = NLMSG_LENGTH(GENL_HDRLEN);
+    msgPtr->hdr.nlmsg_type = sockPtr->familyId;
+    msgPtr->hdr.nlmsg_flags = NLM_F_REQUEST | NLM_F_ACK | flags;
+    genlPtr = NLMSG_DATA(&msgPtr->hdr);
+    genlPtr->cmd = cmd;
+    genlPtr->version = 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Append an attribute to a request.
+ *
+ * @return LE_OK            The function succeeded.
+ * @return LE_OVERFLOW      The request buffer is full.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiNl80211_PutAttr
+(
+    pa_wifiNl80211_Msg_t    *msgPtr,
+        ///< [IN]
+        ///< Request
+    uint16_t                 type,
+        ///< [IN]
+        ///< Attribute type
+    const void              *dataPtr,
+        ///< [IN]
+        ///< Attribute payload
+    size_t                   length
+        ///< [IN]
+        ///< Payload length
+)
+{
+    struct nlattr *attrPtr = MSG_TAIL(msgPtr);
+    size_t         newLen = NLMSG_ALIGN(msgPtr->hdr.nlmsg_len) + NLA_ALIGN(NLA_HDRLEN + length);
+
+    if (newLen > sizeof(msgPtr->buf))
+    {
+        LE_ERROR("nl80211 request overflow");
+        return LE_OVERFLOW;
+    }
+
+    attrPtr->nla_type = type;
+    attrPtr->nla_len = NLA_HDRLEN + length;
+    if (length)
+    {
+        memcpy(pa_wifiNl80211_AttrData(attrPtr), dataPtr, length);
+    }
+    msgPtr->hdr.nlmsg_len = newLen;
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Append an unsigned 32 bits attribute to a request.
+ *
+ * @return LE_OK            The function succeeded.
+ * @return LE_OVERFLOW      The request buffer is full.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiNl80211_PutU32
+(
+    pa_wifiNl80211_Msg_t    *msgPtr,
+        ///< [IN]
+        ///< Request
+    uint16_t                 type,
+        ///< [IN]
+        ///< Attribute type
+    uint32_t                 value
+        ///< [IN]
+        ///< Attribute value
+)
+{
+    return pa_wifiNl80211_PutAttr(msgPtr, type, &value, sizeof(value));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Open a nested attribute. Attributes appended until pa_wifiNl80211_NestEnd() is called are
+ * placed inside it.
+ *
+ * @return Pointer to the nested attribute, NULL if the request buffer is full.
+ */
+//--------------------------------------------------------------------------------------------------
+struct nlattr *pa_wifiNl80211_NestStart
+(
+    pa_wifiNl80211_Msg_t    *msgPtr,
+        ///< [IN]
+        ///< Request
+    uint16_t                 type
+        ///< [IN]
+        ///< Attribute type
+)
+{
+    struct nlattr *nestPtr = MSG_TAIL(msgPtr);
+
+    if (LE_OK != pa_wifiNl80211_PutAttr(msgPtr, type | NLA_F_NESTED, NULL, 0))
+    {
+        return NULL;
+    }
+
+    return nestPtr;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Close a nested attribute opened by pa_wifiNl80211_NestStart().
+ */
+//--------------------------------------------------------------------------------------------------
+void pa_wifiNl80211_NestEnd
+(
+    pa_wifiNl80211_Msg_t    *msgPtr,
+        ///< [IN]
+        ///< Request
+    struct nlattr           *nestPtr
+        ///< [IN]
+        ///< Nested attribute
+)
+{
+    if (NULL != nestPtr)
+    {
+        nestPtr->nla_len = (uint8_t *)MSG_TAIL(msgPtr) - (uint8_t *)nestPtr;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Parse a stream of attributes into a table indexed by attribute type.
+ */
+//--------------------------------------------------------------------------------------------------
+void pa_wifiNl80211_ParseAttrs
+(
+    struct nlattr           *attrs[],
+        ///< [OUT]
+        ///< Table of maxType + 1 entries
+    int                      maxType,
+        ///< [IN]
+        ///< Highest attribute type stored in the table
+    const void              *dataPtr,
+        ///< [IN]
+        ///< First attribute
+    size_t                   length
+        ///< [IN]
+        ///< Length of the attribute stream
+)
+{
+    struct nlattr *attrPtr = (struct nlattr *)dataPtr;
+    int            rem = (int)length;
+
+    memset(attrs, 0, (maxType + 1) * sizeof(struct nlattr *));
+
+    while ((rem >= (int)NLA_HDRLEN) && (attrPtr->nla_len >= NLA_HDRLEN) &&
+           (attrPtr->nla_len <= rem))
+    {
+        int type = attrPtr->nla_type & NLA_TYPE_MASK;
+
+        if (type <= maxType)
+        {
+            attrs[type] = attrPtr;
+        }
+
+        rem -= NLA_ALIGN(attrPtr->nla_len);
+        attrPtr = (struct nlattr *)((uint8_t *)attrPtr + NLA_ALIGN(attrPtr->nla_len));
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Send a request and process the replies until the kernel acknowledges it, or until the end of a
+ * dump. Every nl80211 message received in between, including multicast notifications, is passed
+ * to the handler.
+ *
+ * @return LE_OK            The request succeeded.
+ * @return LE_BUSY          The kernel returned EBUSY.
+ * @return LE_NOT_FOUND     The kernel returned ENOENT, ENODEV or ENOLINK.
+ * @return LE_UNSUPPORTED   The kernel returned EOPNOTSUPP.
+ * @return LE_TIMEOUT       No answer was received in time.
+ * @return LE_FAULT         The request failed.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiNl80211_Request
+(
+    pa_wifiNl80211_Socket_t     *sockPtr,
+        ///< [IN]
+        ///< Socket
+    pa_wifiNl80211_Msg_t        *msgPtr,
+        ///< [IN]
+        ///< Request to send
+    pa_wifiNl80211_HandlerFunc_t handlerFunc,
+        ///< [IN]
+        ///< Reply handler, can be NULL
+    void                        *contextPtr
+        ///< [IN]
+        ///< Context passed to the handler
+)
+{
+    le_result_t result;
+    int         error = 0;
+
+    if (sockPtr->fd < 0)
+    {
+        return LE_FAULT;
+    }
+
+    msgPtr->hdr.nlmsg_seq = ++sockPtr->seq;
+    if (0 == msgPtr->hdr.nlmsg_seq)
+    {
+        // Sequence number 0 is used by multicast notifications.
+        msgPtr->hdr.nlmsg_seq = ++sockPtr->seq;
+    }
+
+    result = SendMsg(sockPtr, msgPtr);
+    if (LE_OK != result)
+    {
+        return result;
+    }
+
+    do
+    {
+        result = ReceiveDatagram(sockPtr, handlerFunc, contextPtr, REQUEST_TIMEOUT_MS,
+                                 msgPtr->hdr.nlmsg_seq, &error);
+    }
+    while (LE_OK == result);
+
+    if (LE_TERMINATED == result)
+    {
+        result = ErrnoToResult(error);
+        if (LE_OK != result)
+        {
+            LE_DEBUG("nl80211 request failed, error %d (%s)", error, LE_ERRNO_TXT(-error));
+        }
+    }
+
+    return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Wait for incoming messages (typically multicast notifications) and pass them to the handler.
+ *
+ * @return LE_OK            At least one message was processed.
+ * @return LE_TIMEOUT       Nothing was received before the timeout.
+ * @return LE_FAULT         The function failed.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiNl80211_Receive
+(
+    pa_wifiNl80211_Socket_t     *sockPtr,
+        ///< [IN]
+        ///< Socket
+    pa_wifiNl80211_HandlerFunc_t handlerFunc,
+        ///< [IN]
+        ///< Message handler
+    void                        *contextPtr,
+        ///< [IN]
+        ///< Context passed to the handler
+    int                          timeoutMs
+        ///< [IN]
+        ///< Timeout in milliseconds, -1 to wait forever
+)
+{
+    int error = 0;
+
+    if (sockPtr->fd < 0)
+    {
+        return LE_FAULT;
+    }
+
+    return ReceiveDatagram(sockPtr, handlerFunc, contextPtr, timeoutMs, 0, &error);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get a bitrate from a NL80211_STA_INFO_*_BITRATE nested attribute.
+ *
+ * @return Bitrate in kbit/s, 0 if unknown.
+ */
+//--------------------------------------------------------------------------------------------------
+uint32_t pa_wifiNl80211_ParseBitrate
+(
+    struct nlattr           *rateAttrPtr
+        ///< [IN]
+        ///< Nested attribute, can be NULL
+)
+{
+    struct nlattr *rateAttrs[NL80211_RATE_INFO_MAX + 1];
+
+    if (NULL == rateAttrPtr)
+    {
+        return 0;
+    }
+
+    pa_wifiNl80211_ParseAttrs(rateAttrs, NL80211_RATE_INFO_MAX,
+                              pa_wifiNl80211_AttrData(rateAttrPtr),
+                              pa_wifiNl80211_AttrLen(rateAttrPtr));
+
+    // Bitrates are reported in units of 100 kbit/s
+    if (NULL != rateAttrs[NL80211_RATE_INFO_BITRATE32])
+    {
+        return pa_wifiNl80211_AttrU32(rateAttrs[NL80211_RATE_INFO_BITRATE32]) * 100;
+    }
+    if (NULL != rateAttrs[NL80211_RATE_INFO_BITRATE])
+    {
+        return pa_wifiNl80211_AttrU16(rateAttrs[NL80211_RATE_INFO_BITRATE]) * 100;
+    }
+    return 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Format a 6 bytes MAC address as "xx:xx:xx:xx:xx:xx".
+ */
+//--------------------------------------------------------------------------------------------------
+void pa_wifiNl80211_FormatMac
+(
+    const uint8_t           *macPtr,
+        ///< [IN]
+        ///< MAC address (6 bytes)
+    char                    *strPtr,
+        ///< [OUT]
+        ///< Output string
+    size_t                   strSize
+        ///< [IN]
+        ///< Size of the output string
+)
+{
+    snprintf(strPtr, strSize, "%02x:%02x:%02x:%02x:%02x:%02x",
+             macPtr[0], macPtr[1], macPtr[2], macPtr[3], macPtr[4], macPtr[5]);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Initialize the shared nl80211 event listener. Called by the initialization of each PA, before
+ * any of them registers a handler.
+ */
+//--------------------------------------------------------------------------------------------------
+void pa_wifiNl80211_Init
+(
+    void
+)
+{
+    if (NULL == ListenerLifecycleMutex)
+    {
+        ListenerLifecycleMutex = le_mutex_CreateNonRecursive("WifiNl80211Lifecycle");
+        ListenerMutex = le_mutex_CreateNonRecursive("WifiNl80211Listeners");
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Register a handler on the shared nl80211 event listener.
+ *
+ * The listener is a single thread subscribed to the "mlme", "scan" and "config" multicast groups.
+ * It is started with the first handler and stopped with the last one. Handlers are called in the
+ * context of the listener thread for every notification received, with the handler list locked:
+ * a handler must not block, and only copies the notification for its own thread.
+ *
+ * @return LE_OK            The function succeeded.
+ * @return LE_UNSUPPORTED   nl80211 is not available on this kernel.
+ * @return LE_OVERFLOW      Too many handlers are registered.
+ * @return LE_FAULT         The function failed.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiNl80211_AddEventListener
+(
+    pa_wifiNl80211_HandlerFunc_t handlerFunc,
+        ///< [IN]
+        ///< Notification handler
+    void                        *contextPtr
+        ///< [IN]
+        ///< Context passed to the handler
+)
+{
+    le_result_t result = LE_OK;
+
+    if ((NULL == handlerFunc) || (NULL == ListenerLifecycleMutex))
+    {
+        return LE_FAULT;
+    }
+
+    le_mutex_Lock(ListenerLifecycleMutex);
+
+    if (ListenerCount >= PA_WIFINL80211_MAX_LISTENERS)
+    {
+        LE_ERROR("Too many nl80211 event handlers");
+        result = LE_OVERFLOW;
+    }
+    else if (NULL == ListenerThread)
+    {
+        result = StartListener();
+        if (LE_OK != result)
+        {
+            LE_ERROR("Unable to start the nl80211 event listener (%d)", result);
+        }
+    }
+
+    if (LE_OK == result)
+    {
+        le_mutex_Lock(ListenerMutex);
+        Listeners[ListenerCount].handlerFunc = handlerFunc;
+        Listeners[ListenerCount].contextPtr = contextPtr;
+        ListenerCount++;
+        le_mutex_Unlock(ListenerMutex);
+    }
+
+    le_mutex_Unlock(ListenerLifecycleMutex);
+
+    return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Unregister a handler from the shared nl80211 event listener.
+ */
+//--------------------------------------------------------------------------------------------------
+void pa_wifiNl80211_RemoveEventListener
+(
+    pa_wifiNl80211_HandlerFunc_t handlerFunc,
+        ///< [IN]
+        ///< Notification handler
+    void                        *contextPtr
+        ///< [IN]
+        ///< Context given to pa_wifiNl80211_AddEventListener()
+)
+{
+    uint32_t i;
+
+    if (NULL == ListenerLifecycleMutex)
+    {
+        return;
+    }
+
+    le_mutex_Lock(ListenerLifecycleMutex);
+
+    le_mutex_Lock(ListenerMutex);
+    for (i = 0; i < ListenerCount; i++)
+    {
+        if ((Listeners[i].handlerFunc == handlerFunc) && (Listeners[i].contextPtr == contextPtr))
+        {
+            ListenerCount--;
+            Listeners[i] = Listeners[ListenerCount];
+            break;
+        }
+    }
+    le_mutex_Unlock(ListenerMutex);
+
+    // ListenerMutex is released: the listener thread may need it to finish a notification
+    if ((0 == ListenerCount) && (NULL != ListenerThread))
+    {
+        StopListener();
+    }
+
+    le_mutex_Unlock(ListenerLifecycleMutex);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Wait for a network interface to be created, set it up and wait until the kernel reports it up,
+ * from the RTM_NEWLINK notifications of a route netlink socket.
+ *
+ * @return LE_OK            The interface is up.
+ * @return LE_TIMEOUT       The interface is not up before the timeout.
+ * @return LE_FAULT         The function failed.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiNl80211_WaitInterfaceUp
+(
+    const char              *ifNamePtr,
+        ///< [IN]
+        ///< Interface name
+    uint32_t                 timeoutMs
+        ///< [IN]
+        ///< Timeout in milliseconds
+)
+{
+    uint8_t            buf[RTNL_RX_BUFFER_BYTES];
+    struct sockaddr_nl addr;
+    struct pollfd      pfd;
+    struct nlmsghdr   *hdrPtr;
+    le_clk_Time_t      timeout = { timeoutMs / 1000, (timeoutMs % 1000) * 1000 };
+    le_clk_Time_t      deadline = le_clk_Add(le_clk_GetRelativeTime(), timeout);
+    le_result_t        result = LE_TIMEOUT;
+    bool               isUpSet = false;
+    unsigned int       flags;
+    ssize_t            len;
+    int                rc;
+
+    pfd.fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (pfd.fd < 0)
+    {
+        LE_ERROR("Unable to open route netlink socket, errno %d (%s)", errno,
+                 LE_ERRNO_TXT(errno));
+        return LE_FAULT;
+    }
+    pfd.events = POLLIN;
+
+    // Subscribe before the dump so that no change is missed in between
+    memset(&addr, 0, sizeof(addr));
+    addr.nl_family = AF_NETLINK;
+    addr.nl_groups = RTMGRP_LINK;
+    if ((bind(pfd.fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) ||
+        (LE_OK != RequestLinkDump(pfd.fd)))
+    {
+        LE_ERROR("Unable to listen to the links, errno %d (%s)", errno, LE_ERRNO_TXT(errno));
+        close(pfd.fd);
+        return LE_FAULT;
+    }
+
+    while (LE_TIMEOUT == result)
+    {
+        le_clk_Time_t remaining = le_clk_Sub(deadline, le_clk_GetRelativeTime());
+
+        if ((remaining.sec < 0) || ((0 == remaining.sec) && (0 == remaining.usec)))
+        {
+            break;
+        }
+
+        pfd.revents = 0;
+        rc = poll(&pfd, 1, remaining.sec * 1000 + (remaining.usec + 999) / 1000);
+        if (0 == rc)
+        {
+            break;
+        }
+        if (rc < 0)
+        {
+            if (EINTR != errno)
+            {
+                LE_ERROR("poll() failed, errno %d (%s)", errno, LE_ERRNO_TXT(errno));
+                result = LE_FAULT;
+            }
+            continue;
+        }
+
+        len = recv(pfd.fd, buf, sizeof(buf), 0);
+        if (len < 0)
+        {
+            // Notifications were dropped: read the state again
+            if ((ENOBUFS == errno) && (LE_OK != RequestLinkDump(pfd.fd)))
+            {
+                result = LE_FAULT;
+            }
+            else if ((ENOBUFS != errno) && (EINTR != errno) && (EAGAIN != errno))
+            {
+                LE_ERROR("recv() failed, errno %d (%s)", errno, LE_ERRNO_TXT(errno));
+                result = LE_FAULT;
+            }
+            continue;
+        }
+
+        for (hdrPtr = (struct nlmsghdr *)buf;
+             NLMSG_OK(hdrPtr, (size_t)len);
+             hdrPtr = NLMSG_NEXT(hdrPtr, len))
+        {
+            if (!ParseLink(hdrPtr, ifNamePtr, &flags))
+            {
+                continue;
+            }
+            if (0 != (flags & IFF_UP))
+            {
+                result = LE_OK;
+                break;
+            }
+            // The kernel notifies the change once the interface is set up
+            if ((!isUpSet) && (LE_OK == SetInterfaceUp(ifNamePtr)))
+            {
+                isUpSet = true;
+            }
+        }
+    }
+
+    close(pfd.fd);
+    if (LE_TIMEOUT == result)
+    {
+        LE_WARN("%s not up after %u ms", ifNamePtr, timeoutMs);
+    }
+    return result;
+}
@@ -0,0 +1,506 @@
+// -------------------------------------------------------------------------------------------------
+/**
+ *  WiFi pairwise master key derivation
+ *
+ *  Copyright (C) Sierra Wireless Inc.
+ *
+ */
+// -------------------------------------------------------------------------------------------------
+#include "legato.h"
+
+#include "pa_wifi_pmk.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Size of a SHA-1 block.
+ */
+//--------------------------------------------------------------------------------------------------
+#define SHA1_BLOCK_BYTES        64
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Bounds of a WPA passphrase (characters) and of an SSID (bytes).
+ */
+//--------------------------------------------------------------------------------------------------
+#define PASSPHRASE_MIN_LENGTH   8
+#define PASSPHRASE_MAX_LENGTH   63
+#define SSID_MAX_LENGTH         32
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Rotate a 32-bit word left.
+ */
+//--------------------------------------------------------------------------------------------------
+#define ROTL32(x, n)            (((x) << (n)) | ((x) >> (32 - (n))))
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * SHA-1 hashing state.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    uint32_t state[5];                      ///< Intermediate hash
+    uint64_t length;                        ///< Number of bytes hashed
+    uint8_t  block[SHA1_BLOCK_BYTES];       ///< Partial block
+    size_t   blockLen;                      ///< Number of bytes in the partial block
+}
+Sha1Ctx_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * HMAC-SHA1 state with the key already absorbed, so that the key is processed once for the many
+ * HMACs of a PBKDF2 derivation.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    Sha1Ctx_t inner;                        ///< Hash of the key XOR ipad
+    Sha1Ctx_t outer;                        ///< Hash of the key XOR opad
+}
+HmacCtx_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Process one 64-byte block.
+ */
+//--------------------------------------------------------------------------------------------------
+static void Sha1Transform
+(
+    uint32_t       state[5],
+    const uint8_t *blockPtr
+)
+{
+    uint32_t w[80];
+    uint32_t a = state[0];
+    uint32_t b = state[1];
+    uint32_t c = state[2];
+    uint32_t d = state[3];
+    uint32_t e = state[4];
+    int      i;
+
+    for (i = 0; i < 16; i++)
+    {
+        w[i] = ((uint32_t)blockPtr[4 * i] << 24) | ((uint32_t)blockPtr[4 * i + 1] << 16) |
+               ((uint32_t)blockPtr[4 * i + 2] << 8) | (uint32_t)blockPtr[4 * i + 3];
+    }
+    for (i = 16; i < 80; i++)
+    {
+        w[i] = ROTL32(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+    }
+
+    for (i = 0; i < 80; i++)
+    {
+        uint32_t f;
+        uint32_t k;
+        uint32_t temp;
+
+        if (i < 20)
+        {
+            f = (b & c) | (~b & d);
+            k = 0x5A827999;
+        }
+        else if (i < 40)
+        {
+            f = b ^ c ^ d;
+            k = 0x6ED9EBA1;
+        }
+        else if (i < 60)
+        {
+            f = (b & c) | (b & d) | (c & d);
+            k = 0x8F1BBCDC;
+        }
+        else
+        {
+            f = b ^ c ^ d;
+            k = 0xCA62C1D6;
+        }
+
+        temp = ROTL32(a, 5) + f + e + k + w[i];
+        e = d;
+        d = c;
+        c = ROTL32(b, 30);
+        b = a;
+        a = temp;
+    }
+
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Start a SHA-1 hash.
+ */
+//--------------------------------------------------------------------------------------------------
+static void Sha1Init
+(
+    Sha1Ctx_t *ctxPtr
+)
+{
+    ctxPtr->state[0] = 0x67452301;
+    ctxPtr->state[1] = 0xEFCDAB89;
+    ctxPtr->state[2] = 0x98BADCFE;
+    ctxPtr->state[3] = 0x10325476;
+    ctxPtr->state[4] = 0xC3D2E1F0;
+    ctxPtr->length = 0;
+    ctxPtr->blockLen = 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add bytes to a SHA-1 hash.
+ */
+//--------------------------------------------------------------------------------------------------
+static void Sha1Update
+(
+    Sha1Ctx_t     *ctxPtr,
+    const uint8_t *dataPtr,
+    size_t         len
+)
+{
+    ctxPtr->length += len;
+
+    while (len > 0)
+    {
+        size_t chunk = SHA1_BLOCK_BYTES - ctxPtr->blockLen;
+
+        if ((0 == ctxPtr->blockLen) && (len >= SHA1_BLOCK_BYTES))
+        {
+            // Whole blocks are processed in place
+            Sha1Transform(ctxPtr->state, dataPtr);
+            dataPtr += SHA1_BLOCK_BYTES;
+            len -= SHA1_BLOCK_BYTES;
+            continue;
+        }
+
+        if (chunk > len)
+        {
+            chunk = len;
+        }
+        memcpy(&ctxPtr->block[ctxPtr->blockLen], dataPtr, chunk);
+        ctxPtr->blockLen += chunk;
+        dataPtr += chunk;
+        len -= chunk;
+
+        if (SHA1_BLOCK_BYTES == ctxPtr->blockLen)
+        {
+            Sha1Transform(ctxPtr->state, ctxPtr->block);
+            ctxPtr->blockLen = 0;
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Pad the message and get the digest. The state is consumed.
+ */
+//--------------------------------------------------------------------------------------------------
+static void Sha1Final
+(
+    Sha1Ctx_t *ctxPtr,
+    uint8_t    digest[PA_WIFIPMK_SHA1_BYTES]
+)
+{
+    uint64_t bitLength = ctxPtr->length * 8;
+    int      i;
+
+    ctxPtr->block[ctxPtr->blockLen++] = 0x80;
+    if (ctxPtr->blockLen > SHA1_BLOCK_BYTES - 8)
+    {
+        memset(&ctxPtr->block[ctxPtr->blockLen], 0, SHA1_BLOCK_BYTES - ctxPtr->blockLen);
+        Sha1Transform(ctxPtr->state, ctxPtr->block);
+        ctxPtr->blockLen = 0;
+    }
+    memset(&ctxPtr->block[ctxPtr->blockLen], 0, SHA1_BLOCK_BYTES - 8 - ctxPtr->blockLen);
+    for (i = 0; i < 8; i++)
+    {
+        ctxPtr->block[SHA1_BLOCK_BYTES - 1 - i] = (uint8_t)(bitLength >> (8 * i));
+    }
+    Sha1Transform(ctxPtr->state, ctxPtr->block);
+
+    for (i = 0; i < 5; i++)
+    {
+        digest[4 * i] = (uint8_t)(ctxPtr->state[i] >> 24);
+        digest[4 * i + 1] = (uint8_t)(ctxPtr->state[i] >> 16);
+        digest[4 * i + 2] = (uint8_t)(ctxPtr->state[i] >> 8);
+        digest[4 * i + 3] = (uint8_t)ctxPtr->state[i];
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Absorb the HMAC key.
+ */
+//--------------------------------------------------------------------------------------------------
+static void HmacInit
+(
+    HmacCtx_t     *ctxPtr,
+    const uint8_t *keyPtr,
+    size_t         keyLen
+)
+{
+    uint8_t pad[SHA1_BLOCK_BYTES];
+    uint8_t keyDigest[PA_WIFIPMK_SHA1_BYTES];
+    size_t  i;
+
+    // Keys longer than a block are replaced by their digest
+    if (keyLen > SHA1_BLOCK_BYTES)
+    {
+        pa_wifiPmk_Sha1(keyPtr, keyLen, keyDigest);
+        keyPtr = keyDigest;
+        keyLen = sizeof(keyDigest);
+    }
+
+    memset(pad, 0x36, sizeof(pad));
+    for (i = 0; i < keyLen; i++)
+    {
+        pad[i] ^= keyPtr[i];
+    }
+    Sha1Init(&ctxPtr->inner);
+    Sha1Update(&ctxPtr->inner, pad, sizeof(pad));
+
+    memset(pad, 0x5C, sizeof(pad));
+    for (i = 0; i < keyLen; i++)
+    {
+        pad[i] ^= keyPtr[i];
+    }
+    Sha1Init(&ctxPtr->outer);
+    Sha1Update(&ctxPtr->outer, pad, sizeof(pad));
+
+    memset(pad, 0, sizeof(pad));
+    memset(keyDigest, 0, sizeof(keyDigest));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Compute the HMAC of the concatenation of two messages with an absorbed key.
+ */
+//--------------------------------------------------------------------------------------------------
+static void HmacCompute
+(
+    const HmacCtx_t *ctxPtr,
+    const uint8_t   *msg1Ptr,
+    size_t           msg1Len,
+    const uint8_t   *msg2Ptr,
+    size_t           msg2Len,
+    uint8_t          mac[PA_WIFIPMK_SHA1_BYTES]
+)
+{
+    Sha1Ctx_t ctx = ctxPtr->inner;
+    uint8_t   innerDigest[PA_WIFIPMK_SHA1_BYTES];
+
+    Sha1Update(&ctx, msg1Ptr, msg1Len);
+    Sha1Update(&ctx, msg2Ptr, msg2Len);
+    Sha1Final(&ctx, innerDigest);
+
+    ctx = ctxPtr->outer;
+    Sha1Update(&ctx, innerDigest, sizeof(innerDigest));
+    Sha1Final(&ctx, mac);
+}
+
+//--------------------------------------------------------------------------------------------------
+// Public declarations
+//--------------------------------------------------------------------------------------------------
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Compute the SHA-1 digest of a message.
+ */
+//--------------------------------------------------------------------------------------------------
+void pa_wifiPmk_Sha1
+(
+    const uint8_t *msgPtr,
+        ///< [IN]
+        ///< Message
+    size_t         msgLen,
+        ///< [IN]
+        ///< Length of the message
+    uint8_t        digest[PA_WIFIPMK_SHA1_BYTES]
+        ///< [OUT]
+        ///< Digest
+)
+{
+    Sha1Ctx_t ctx;
+
+    Sha1Init(&ctx);
+    Sha1Update(&ctx, msgPtr, msgLen);
+    Sha1Final(&ctx, digest);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Compute the HMAC-SHA1 of a message (RFC 2104).
+ */
+//--------------------------------------------------------------------------------------------------
+void pa_wifiPmk_HmacSha1
+(
+    const uint8_t *keyPtr,
+        ///< [IN]
+        ///< Key
+    size_t         keyLen,
+        ///< [IN]
+        ///< Length of the key
+    const uint8_t *msgPtr,
+        ///< [IN]
+        ///< Message
+    size_t         msgLen,
+        ///< [IN]
+        ///< Length of the message
+    uint8_t        mac[PA_WIFIPMK_SHA1_BYTES]
+        ///< [OUT]
+        ///< Message authentication code
+)
+{
+    HmacCtx_t ctx;
+
+    HmacInit(&ctx, keyPtr, keyLen);
+    HmacCompute(&ctx, msgPtr, msgLen, NULL, 0, mac);
+    memset(&ctx, 0, sizeof(ctx));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Derive a key with PBKDF2-HMAC-SHA1 (RFC 8018).
+ */
+//--------------------------------------------------------------------------------------------------
+void pa_wifiPmk_Pbkdf2Sha1
+(
+    const uint8_t *passwordPtr,
+        ///< [IN]
+        ///< Password
+    size_t         passwordLen,
+        ///< [IN]
+        ///< Length of the password
+    const uint8_t *saltPtr,
+        ///< [IN]
+        ///< Salt
+    size_t         saltLen,
+        ///< [IN]
+        ///< Length of the salt
+    uint32_t       iterations,
+        ///< [IN]
+        ///< Number of iterations, at least 1
+    uint8_t       *keyPtr,
+        ///< [OUT]
+        ///< Derived key
+    size_t         keyLen
+        ///< [IN]
+        ///< Length of the derived key
+)
+{
+    HmacCtx_t ctx;
+    uint32_t  blockIndex = 1;
+
+    HmacInit(&ctx, passwordPtr, passwordLen);
+
+    while (keyLen > 0)
+    {
+        uint8_t  u[PA_WIFIPMK_SHA1_BYTES];
+        uint8_t  t[PA_WIFIPMK_SHA1_BYTES];
+        uint8_t  indexBytes[4];
+        size_t   chunk = (keyLen < sizeof(t)) ? keyLen : sizeof(t);
+        uint32_t i;
+        size_t   j;
+
+        // U1 = PRF(P, S || INT(i)), Uc = PRF(P, Uc-1), T = U1 ^ ... ^ Uc
+        indexBytes[0] = (uint8_t)(blockIndex >> 24);
+        indexBytes[1] = (uint8_t)(blockIndex >> 16);
+        indexBytes[2] = (uint8_t)(blockIndex >> 8);
+        indexBytes[3] = (uint8_t)blockIndex;
+        HmacCompute(&ctx, saltPtr, saltLen, indexBytes, sizeof(indexBytes), u);
+        memcpy(t, u, sizeof(t));
+
+        for (i = 1; i < iterations; i++)
+        {
+            HmacCompute(&ctx, u, sizeof(u), NULL, 0, u);
+            for (j = 0; j < sizeof(t); j++)
+            {
+                t[j] ^= u[j];
+            }
+        }
+
+        memcpy(keyPtr, t, chunk);
+        keyPtr += chunk;
+        keyLen -= chunk;
+        blockIndex++;
+
+        memset(u, 0, sizeof(u));
+        memset(t, 0, sizeof(t));
+    }
+
+    memset(&ctx, 0, sizeof(ctx));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Derive the pairwise master key of a WPA/WPA2-Personal network from its passphrase and SSID.
+ *
+ * @return LE_BAD_PARAMETER  Invalid passphrase or SSID length.
+ * @return LE_OK             The function succeeded.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiPmk_Derive
+(
+    const char    *passphrasePtr,
+        ///< [IN]
+        ///< Passphrase, 8 to 63 characters
+    const uint8_t *ssidPtr,
+        ///< [IN]
+        ///< SSID
+    size_t         ssidLen,
+        ///< [IN]
+        ///< Length of the SSID, 1 to 32 bytes
+    uint8_t        pmk[PA_WIFIPMK_BYTES]
+        ///< [OUT]
+        ///< Pairwise master key
+)
+{
+    size_t passphraseLen;
+
+    if ((NULL == passphrasePtr) || (NULL == ssidPtr) || (0 == ssidLen) ||
+        (ssidLen > SSID_MAX_LENGTH))
+    {
+        return LE_BAD_PARAMETER;
+    }
+
+    passphraseLen = strnlen(passphrasePtr, PASSPHRASE_MAX_LENGTH + 1);
+    if ((passphraseLen < PASSPHRASE_MIN_LENGTH) || (passphraseLen > PASSPHRASE_MAX_LENGTH))
+    {
+        return LE_BAD_PARAMETER;
+    }
+
+    pa_wifiPmk_Pbkdf2Sha1((const uint8_t *)passphrasePtr, passphraseLen, ssidPtr, ssidLen,
+                          PA_WIFIPMK_ITERATIONS, pmk, PA_WIFIPMK_BYTES);
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Format a pairwise master key as the 64 hexadecimal digits expected as PSK by wpa_supplicant and
+ * hostapd.
+ */
+//--------------------------------------------------------------------------------------------------
+void pa_wifiPmk_ToHex
+(
+    const uint8_t pmk[PA_WIFIPMK_BYTES],
+        ///< [IN]
+        ///< Pairwise master key
+    char          hex[PA_WIFIPMK_HEX_BYTES]
+        ///< [OUT]
+        ///< Null terminated hexadecimal digits
+)
+{
+    static const char digits[] = "0123456789abcdef";
+    int               i;
+
+    for (i = 0; i < PA_WIFIPMK_BYTES; i++)
+    {
+        hex[2 * i] = digits[pmk[i] >> 4];
+        hex[2 * i + 1] = digits[pmk[i] & 0x0F];
+    }
+    hex[2 * PA_WIFIPMK_BYTES] = '\0';
+}
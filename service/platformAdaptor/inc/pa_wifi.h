@@ -25,6 +25,17 @@
 #define PA_DUPLICATE        14
 #define PA_NOT_FOUND        50
 #define PA_NOT_POSSIBLE     100
+//--------------------------------------------------------------------------------------------------
+/**
+ * Security flags of an access point found during a scan.
+ */
+//--------------------------------------------------------------------------------------------------
+#define PA_WIFICLIENT_SCAN_SECURITY_PRIVACY 0x01    ///< Encryption required (WEP if neither WPA
+                                                    ///< nor WPA2 is advertised).
+#define PA_WIFICLIENT_SCAN_SECURITY_WPA     0x02    ///< WPA information element advertised.
+#define PA_WIFICLIENT_SCAN_SECURITY_WPA2    0x04    ///< RSN information element advertised.
+#define PA_WIFICLIENT_SCAN_SECURITY_EAP     0x08    ///< IEEE 802.1X authentication advertised.
+
 //--------------------------------------------------------------------------------------------------
 /**
  * AccessPoint structure.
@@ -39,8 +50,95 @@ typedef struct
     char     bssid[LE_WIFIDEFS_MAX_BSSID_BYTES];    ///< Contains the bssid.
     uint64_t rx;                                    ///< Rx of access point (bytes).
     uint64_t tx;                                    ///< Tx of access point (bytes).
+    uint16_t frequency;                             ///< Frequency (MHz), 0 if unknown.
+    uint8_t  securityFlags;                         ///< PA_WIFICLIENT_SCAN_SECURITY_* flags.
+    uint32_t ageMs;                                 ///< Time since the access point was last
+                                                    ///< seen by a scan (ms), 0 if just seen.
 } pa_wifiClient_AccessPoint_t;
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * State of the current link.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    pa_wifiClient_AccessPoint_t accessPoint;    ///< Connected access point, signal and bytes.
+    uint32_t                    rxBitrate;      ///< Bitrate of the last received frame (kbit/s),
+                                                ///< 0 if unknown.
+    uint32_t                    txBitrate;      ///< Bitrate of the last sent frame (kbit/s),
+                                                ///< 0 if unknown.
+    uint32_t                    frequency;      ///< Operating frequency (MHz).
+} pa_wifiClient_LinkInfo_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Scan backends.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef enum
+{
+    PA_WIFICLIENT_SCAN_BACKEND_SCRIPT = 0,  ///< Scan through the pa_wifi script and iw.
+    PA_WIFICLIENT_SCAN_BACKEND_NL80211      ///< Scan through nl80211 generic netlink messages.
+}
+pa_wifiClient_ScanBackend_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum number of frequencies and SSIDs of a directed scan.
+ */
+//--------------------------------------------------------------------------------------------------
+#define PA_WIFICLIENT_SCAN_MAX_FREQUENCIES  16
+#define PA_WIFICLIENT_SCAN_MAX_SSIDS        4
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Parameters of a directed scan.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    uint16_t frequencies[PA_WIFICLIENT_SCAN_MAX_FREQUENCIES];   ///< Frequencies to scan (MHz).
+    size_t   frequencyCount;                                    ///< 0 to scan all the channels.
+    struct
+    {
+        uint8_t length;                                         ///< SSID length.
+        uint8_t bytes[LE_WIFIDEFS_MAX_SSID_BYTES];              ///< SSID bytes.
+    }
+    ssids[PA_WIFICLIENT_SCAN_MAX_SSIDS];                        ///< SSIDs to probe.
+    size_t   ssidCount;                                         ///< 0 for no directed probe.
+}
+pa_wifiClient_ScanParams_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum number of saved networks handed to wpa_supplicant.
+ */
+//--------------------------------------------------------------------------------------------------
+#define PA_WIFICLIENT_MAX_NETWORKS  16
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Saved network handed to wpa_supplicant, which chooses among them. Only the credentials of the
+ * security protocol are used: for WPA-Personal, a passphrase or a pre-shared key.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    uint8_t  ssidLength;                                    ///< SSID length.
+    uint8_t  ssidBytes[LE_WIFIDEFS_MAX_SSID_BYTES];         ///< SSID bytes.
+    bool     isHidden;                                      ///< The SSID must be probed.
+    int32_t  priority;                                      ///< Higher priorities are chosen
+                                                            ///< first.
+    le_wifiClient_SecurityProtocol_t securityProtocol;      ///< Security protocol.
+    char     wepKey[LE_WIFIDEFS_MAX_WEPKEY_BYTES];          ///< WEP key.
+    char     passphrase[LE_WIFIDEFS_MAX_PASSPHRASE_BYTES];  ///< WPA passphrase, or
+    char     preSharedKey[LE_WIFIDEFS_MAX_PSK_BYTES];       ///< WPA pre-shared key (hex).
+    char     username[LE_WIFIDEFS_MAX_USERNAME_BYTES];      ///< EAP username.
+    char     password[LE_WIFIDEFS_MAX_PASSWORD_BYTES];      ///< EAP password.
+}
+pa_wifiClient_Network_t;
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Event handler for PA WiFi access point changes.
@@ -145,6 +243,8 @@ LE_SHARED le_result_t pa_wifiClient_Release
  * It should NOT return until the scan is done.
  * Results are read via pa_wifiClient_GetScanResult.
  * When the reading is done pa_wifiClient_ScanDone MUST be called.
+ * The scan functions must always be called from the same thread: the resources of the scan are
+ * kept between two scans.
  *
  * @return LE_FAULT  The function failed.
  * @return LE_BUSY   The function is already ongoing.
@@ -156,6 +256,59 @@ LE_SHARED le_result_t pa_wifiClient_Scan
     void
 );
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Start a scan limited to some frequencies and/or probing some SSIDs, and return when it is done.
+ * The results are read like the results of pa_wifiClient_Scan(); they may hold access points
+ * found on other frequencies by earlier scans.
+ *
+ * @return LE_FAULT         The function failed.
+ * @return LE_BUSY          The function is already ongoing.
+ * @return LE_UNSUPPORTED   Directed probes are not supported by the script backend.
+ * @return LE_OK            The function succeeded.
+ */
+//--------------------------------------------------------------------------------------------------
+LE_SHARED le_result_t pa_wifiClient_DirectedScan
+(
+    const pa_wifiClient_ScanParams_t *paramsPtr
+        ///< [IN]
+        ///< Frequencies and SSIDs of the scan.
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read the access points cached by the kernel from the previous scans, without scanning. The
+ * results are read like the results of pa_wifiClient_Scan(), with their age.
+ *
+ * @return LE_FAULT  The function failed.
+ * @return LE_BUSY   The function is already ongoing.
+ * @return LE_OK     The function succeeded.
+ */
+//--------------------------------------------------------------------------------------------------
+LE_SHARED le_result_t pa_wifiClient_CachedScan
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Select the backend used by pa_wifiClient_Scan().
+ *
+ * The nl80211 backend triggers the scan and reads the results through generic netlink without
+ * spawning any process. When nl80211 is not available the PA falls back to the script backend.
+ *
+ * @return LE_OK             The function succeeded.
+ * @return LE_BAD_PARAMETER  Unknown backend.
+ * @return LE_BUSY           A scan is ongoing.
+ */
+//--------------------------------------------------------------------------------------------------
+LE_SHARED le_result_t pa_wifiClient_SetScanBackend
+(
+    pa_wifiClient_ScanBackend_t backend
+        ///< [IN]
+        ///< Scan backend to use.
+);
+
 //--------------------------------------------------------------------------------------------------
 /**
  * This function is used to find out if a scan is currently running.
@@ -229,13 +382,31 @@ LE_SHARED le_result_t pa_wifiClient_GetLinkResult
 
 //--------------------------------------------------------------------------------------------------
 /**
- * This function connects a wifiClient.
+ * Get the state of the current link with a single query to the driver.
+ *
+ * @return LE_OK            The function succeeded.
+ * @return LE_BAD_PARAMETER The function failed due to an invalid parameter.
+ * @return LE_NOT_FOUND     The target is not connected.
+ * @return LE_FAULT         The function failed.
+ */
+//--------------------------------------------------------------------------------------------------
+LE_SHARED le_result_t pa_wifiClient_GetLinkInfo
+(
+    pa_wifiClient_LinkInfo_t *linkInfoPtr
+        ///< [OUT]
+        ///< State of the link, filled out if result was LE_OK.
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * This function starts the connection of a wifiClient and returns without waiting for it.
+ * The result is reported by a LE_WIFICLIENT_EVENT_CONNECTED event, or a
+ * LE_WIFICLIENT_EVENT_DISCONNECTED event if the attempt fails or times out.
  *
  * @return LE_FAULT             The function failed.
  * @return LE_BAD_PARAMETER     Invalid parameter.
  * @return LE_DUPLICATE         Duplicated request.
- * @return LE_TIMEOUT           Connection request time out.
- * @return LE_OK                The function succeeded.
+ * @return LE_OK                The connection attempt is started.
  */
 //--------------------------------------------------------------------------------------------------
 LE_SHARED le_result_t pa_wifiClient_Connect
@@ -261,6 +432,63 @@ LE_SHARED le_result_t pa_wifiClient_Disconnect
     void
 );
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * This function starts the reassociation to another BSSID of the selected network and returns
+ * without waiting for it. The target must have been found by a recent scan. The result is reported
+ * by a LE_WIFICLIENT_EVENT_CONNECTED event carrying the new BSSID.
+ *
+ * @return LE_BAD_PARAMETER  Invalid BSSID.
+ * @return LE_FAULT          No network is selected or the request was rejected.
+ * @return LE_OK             The reassociation is started.
+ */
+//--------------------------------------------------------------------------------------------------
+LE_SHARED le_result_t pa_wifiClient_Roam
+(
+    const char *bssidPtr
+        ///< [IN]
+        ///< BSSID to reassociate to, as "xx:xx:xx:xx:xx:xx"
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * This function sets the saved networks among which wpa_supplicant chooses when
+ * pa_wifiClient_ConnectAny() is called. The wpa_supplicant configuration file is rewritten only
+ * if its content changes; a connection in progress is not affected.
+ *
+ * @return LE_BAD_PARAMETER  Too many networks, or invalid SSID or credentials.
+ * @return LE_FAULT          The configuration file cannot be written.
+ * @return LE_OK             The function succeeded.
+ */
+//--------------------------------------------------------------------------------------------------
+LE_SHARED le_result_t pa_wifiClient_SetNetworks
+(
+    const pa_wifiClient_Network_t *networksPtr,
+        ///< [IN]
+        ///< Saved networks
+    size_t                         networkCount
+        ///< [IN]
+        ///< Number of networks, up to PA_WIFICLIENT_MAX_NETWORKS
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * This function starts a connection to the saved networks and returns without waiting for it.
+ * wpa_supplicant chooses the network by priority then signal, and fails over to the next one when
+ * a connection fails or is lost. The result is reported by a LE_WIFICLIENT_EVENT_CONNECTED event,
+ * or a LE_WIFICLIENT_EVENT_DISCONNECTED event if no network could be connected in time.
+ *
+ * @return LE_NOT_FOUND     No saved network is set.
+ * @return LE_DUPLICATE     A network is selected already.
+ * @return LE_FAULT         The function failed.
+ * @return LE_OK            The connection attempt is started.
+ */
+//--------------------------------------------------------------------------------------------------
+LE_SHARED le_result_t pa_wifiClient_ConnectAny
+(
+    void
+);
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Set the username and password (WPA-Entreprise).
@@ -401,4 +629,19 @@ LE_SHARED le_result_t pa_wifiClient_Stop
 (
     void
 );
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the time taken by the last start of the WiFi client.
+ *
+ * @return LE_OK            The function succeeded.
+ * @return LE_UNAVAILABLE   The WiFi client was not started yet.
+ */
+//--------------------------------------------------------------------------------------------------
+LE_SHARED le_result_t pa_wifiClient_GetStartLatency
+(
+    uint32_t *interfaceUpMsPtr
+        ///< [OUT]
+        ///< Time from the start of the WiFi hardware until the WLAN interface was up (ms)
+);
 #endif // PA_WIFI_H
@@ -19,6 +19,33 @@
 //--------------------------------------------------------------------------------------------------
 #define PA_NOT_FOUND        50
 #define PA_NOT_POSSIBLE     100
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum number of stations returned by pa_wifiAp_GetStationStats().
+ */
+//--------------------------------------------------------------------------------------------------
+#define PA_WIFIAP_MAX_STATIONS          32
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Traffic and signal of a station associated to the access point.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    char     mac[LE_WIFIDEFS_MAX_BSSID_BYTES];  ///< MAC address, lowercase.
+    uint64_t rxBytes;                           ///< Bytes received from the station.
+    uint64_t txBytes;                           ///< Bytes sent to the station.
+    uint32_t rxPackets;                         ///< Packets received from the station.
+    uint32_t txPackets;                         ///< Packets sent to the station.
+    int16_t  signalStrength;                    ///< Signal strength (dBm),
+                                                ///< LE_WIFIAPEXT_NO_SIGNAL_STRENGTH if unknown.
+    uint32_t txBitrate;                         ///< Bitrate of the last sent frame (kbit/s),
+                                                ///< 0 if unknown.
+    uint32_t inactiveMs;                        ///< Time since the last activity (ms).
+}
+pa_wifiAp_StationStats_t;
 //--------------------------------------------------------------------------------------------------
 /**
  * Event handler for PA WiFi access point changes.
@@ -56,6 +83,54 @@ LE_SHARED le_result_t pa_wifiAp_AddEventHandler
         ///< Associated event context
 );
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * WiFi access point event indication.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    le_wifiAp_Event_t event;                                ///< WiFi access point event
+    char              stationMac[LE_WIFIDEFS_MAX_BSSID_BYTES];
+                                                            ///< MAC address of the station,
+                                                            ///< lowercase, empty if unknown
+}
+pa_wifiAp_EventInd_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Event indication handler for PA WiFi access point changes.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef void (*pa_wifiAp_EventIndHandlerFunc_t)
+(
+    const pa_wifiAp_EventInd_t *eventIndPtr,
+        ///< [IN]
+        ///< WiFi event indication to process
+    void *contextPtr
+        ///< [IN]
+        ///< Associated WiFi event context
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add handler function for WiFi related event indications, which also give the station.
+ *
+ * @return LE_BAD_PARAMETER Some parameter is invalid.
+ * @return LE_OK            Function succeeded.
+ */
+//--------------------------------------------------------------------------------------------------
+LE_SHARED le_result_t pa_wifiAp_AddEventIndHandler
+(
+    pa_wifiAp_EventIndHandlerFunc_t handlerPtr,
+        ///< [IN]
+        ///< Event indication handler function pointer
+
+    void *contextPtr
+        ///< [IN]
+        ///< Associated event context
+);
+
 //--------------------------------------------------------------------------------------------------
 /**
  * This function must be called to initialize the PA WiFi Access Point.
@@ -85,6 +160,10 @@ LE_SHARED le_result_t pa_wifiAp_Release
  * This function starts the WiFi access point.
  * Note that all settings, if to be used, such as security, username, password must set prior to
  * starting the access point.
+ * Settings changed while the access point runs are applied live, with a hostapd restart only for
+ * the ones that need it, so that a Stop/Start is not needed to apply them. Starting the running
+ * access point only applies the pending changes. A setting which fails to apply live stays saved,
+ * and this function applies it again.
  *
  * @return LE_FAULT         The function failed.
  * @return LE_OK            The function succeeded.
@@ -112,6 +191,49 @@ le_result_t pa_wifiAp_Stop
     void
 );
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the traffic and signal of all the stations associated to the access point, with a single
+ * nl80211 station dump.
+ *
+ * @return LE_OK            The function succeeded.
+ * @return LE_OVERFLOW      More stations than maxCount are associated, the first ones are
+ *                          returned.
+ * @return LE_NOT_FOUND     The access point is not started.
+ * @return LE_FAULT         The function failed.
+ */
+//--------------------------------------------------------------------------------------------------
+LE_SHARED le_result_t pa_wifiAp_GetStationStats
+(
+    pa_wifiAp_StationStats_t *statsPtr,
+        ///< [OUT]
+        ///< Stations
+    size_t                    maxCount,
+        ///< [IN]
+        ///< Number of entries of statsPtr
+    size_t                   *countPtr
+        ///< [OUT]
+        ///< Number of stations returned
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the time taken by the last start of the access point.
+ *
+ * @return LE_OK            The function succeeded.
+ * @return LE_UNAVAILABLE   The access point was not started yet.
+ */
+//--------------------------------------------------------------------------------------------------
+LE_SHARED le_result_t pa_wifiAp_GetStartLatency
+(
+    uint32_t *interfaceUpMsPtr,
+        ///< [OUT]
+        ///< Time from the start of the WiFi hardware until the WLAN interface was up (ms)
+    uint32_t *hostapdMsPtr
+        ///< [OUT]
+        ///< Time taken by the last hostapd (re)start (ms), 0 if unknown
+);
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Set the security protocol to use.
@@ -305,6 +427,7 @@ le_result_t pa_wifiAp_SetMaxNumberClients
  * Define the access point IP address and the client IP addresses range.
  *
  * @note The access point IP address must be defined outside the client IP addresses range.
+ * @note The range is applied to the embedded DHCP server at once, without restarting it.
  *
  * @return LE_BAD_PARAMETER At least, one of the given IP addresses is invalid.
  * @return LE_FAULT         A system call has failed.
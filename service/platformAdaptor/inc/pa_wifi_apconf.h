@@ -0,0 +1,137 @@
+// -------------------------------------------------------------------------------------------------
+/**
+ *  WiFi access point configuration diff
+ *
+ *  Compares a hostapd.conf content with the one of the running hostapd, and gets the cheapest
+ *  action applying the changes to it over the control interface, without restarting hostapd when
+ *  the changed parameters allow it.
+ *
+ *  Copyright (C) Sierra Wireless Inc.
+ *
+ */
+// -------------------------------------------------------------------------------------------------
+#ifndef PA_WIFI_APCONF_H
+#define PA_WIFI_APCONF_H
+
+#include "legato.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Actions applying a hostapd.conf change to the running hostapd, from the cheapest to the
+ * costliest.
+ */
+//--------------------------------------------------------------------------------------------------
+#define PA_WIFIAPCONF_APPLY_SET         0x01 ///< SET only, checked by hostapd on next use
+#define PA_WIFIAPCONF_APPLY_BEACON      0x02 ///< SET then UPDATE_BEACON, the stations stay
+#define PA_WIFIAPCONF_APPLY_RELOAD      0x04 ///< SET then RELOAD, disconnects the stations
+#define PA_WIFIAPCONF_APPLY_CSA         0x08 ///< Channel switch announced to the stations
+#define PA_WIFIAPCONF_APPLY_BSS         0x10 ///< SET between DISABLE and ENABLE, restarts the BSS
+#define PA_WIFIAPCONF_APPLY_RESTART     0x20 ///< hostapd restart, the driver stays loaded
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Parse a "key=value" line of a hostapd.conf content.
+ *
+ * @return The next line, NULL at the end of the content.
+ */
+//--------------------------------------------------------------------------------------------------
+const char *pa_wifiApConf_ParseLine
+(
+    const char  *linePtr,
+        ///< [IN]
+        ///< Line to parse
+    size_t      *keyLenPtr,
+        ///< [OUT]
+        ///< Length of the key, 0 if the line is not a parameter
+    const char **valuePtrPtr,
+        ///< [OUT]
+        ///< Value
+    size_t      *valueLenPtr
+        ///< [OUT]
+        ///< Length of the value
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Look for a parameter in a hostapd.conf content.
+ *
+ * @return The value of the parameter, NULL if the parameter is absent.
+ */
+//--------------------------------------------------------------------------------------------------
+const char *pa_wifiApConf_FindValue
+(
+    const char *configPtr,
+        ///< [IN]
+        ///< hostapd.conf content
+    const char *keyPtr,
+        ///< [IN]
+        ///< Parameter name, not null terminated
+    size_t      keyLen,
+        ///< [IN]
+        ///< Length of the parameter name
+    size_t     *valueLenPtr
+        ///< [OUT]
+        ///< Length of the value
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check whether a parameter of a new hostapd.conf content differs from the running one.
+ *
+ * @return true if the parameter is new or has a new value.
+ */
+//--------------------------------------------------------------------------------------------------
+bool pa_wifiApConf_IsValueChanged
+(
+    const char *runningPtr,
+        ///< [IN]
+        ///< hostapd.conf content of the running hostapd
+    const char *keyPtr,
+        ///< [IN]
+        ///< Parameter name, not null terminated
+    size_t      keyLen,
+        ///< [IN]
+        ///< Length of the parameter name
+    const char *valuePtr,
+        ///< [IN]
+        ///< New value, not null terminated
+    size_t      valueLen
+        ///< [IN]
+        ///< Length of the new value
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the action applying a parameter change to the running hostapd.
+ *
+ * @return PA_WIFIAPCONF_APPLY_* action.
+ */
+//--------------------------------------------------------------------------------------------------
+uint8_t pa_wifiApConf_GetParamApply
+(
+    const char *keyPtr,
+        ///< [IN]
+        ///< Parameter name, not null terminated
+    size_t      keyLen
+        ///< [IN]
+        ///< Length of the parameter name
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Compare a new hostapd.conf content with the running one.
+ *
+ * @return Mask of the PA_WIFIAPCONF_APPLY_* actions needed, 0 if both contents are equivalent.
+ */
+//--------------------------------------------------------------------------------------------------
+uint8_t pa_wifiApConf_Diff
+(
+    const char *runningPtr,
+        ///< [IN]
+        ///< hostapd.conf content of the running hostapd
+    const char *newPtr
+        ///< [IN]
+        ///< New hostapd.conf content
+);
+
+#endif // PA_WIFI_APCONF_H
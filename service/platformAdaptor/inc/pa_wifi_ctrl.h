@@ -0,0 +1,185 @@
+// -------------------------------------------------------------------------------------------------
+/**
+ *  WiFi control interface client
+ *
+ *  Client of the UNIX datagram control interface exposed by wpa_supplicant and hostapd
+ *  (ctrl_interface). Requests are plain text commands; replies are plain text. Once attached, the
+ *  daemon also sends unsolicited event messages starting with "<level>".
+ *
+ *  Copyright (C) Sierra Wireless Inc.
+ *
+ */
+// -------------------------------------------------------------------------------------------------
+#ifndef PA_WIFI_CTRL_H
+#define PA_WIFI_CTRL_H
+
+#include <sys/un.h>
+
+#include "legato.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum size of a reply or an event, including the null termination.
+ */
+//--------------------------------------------------------------------------------------------------
+#define PA_WIFICTRL_MSG_MAX_BYTES       4096
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Default timeout of a request (ms).
+ */
+//--------------------------------------------------------------------------------------------------
+#define PA_WIFICTRL_REQUEST_TIMEOUT_MS  5000
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum size of a UNIX socket path, including the null termination.
+ */
+//--------------------------------------------------------------------------------------------------
+#define PA_WIFICTRL_PATH_MAX_BYTES      sizeof(((struct sockaddr_un *)0)->sun_path)
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Connection to a control interface.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    int  fd;                                        ///< Socket connected to the daemon, or -1
+    char localPath[PA_WIFICTRL_PATH_MAX_BYTES];    ///< Local socket path
+}
+pa_wifiCtrl_Conn_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Open a connection to a control interface.
+ *
+ * @return LE_OK            The function succeeded.
+ * @return LE_NOT_FOUND     The control interface does not exist.
+ * @return LE_FAULT         The function failed.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiCtrl_Open
+(
+    pa_wifiCtrl_Conn_t *connPtr,
+        ///< [OUT]
+        ///< Connection to initialize
+    const char         *ctrlPathPtr
+        ///< [IN]
+        ///< Path of the control interface socket (e.g. /var/run/wpa_supplicant/wlan0)
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Close a connection to a control interface.
+ */
+//--------------------------------------------------------------------------------------------------
+void pa_wifiCtrl_Close
+(
+    pa_wifiCtrl_Conn_t *connPtr
+        ///< [IN]
+        ///< Connection to close
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check whether a connection is open.
+ */
+//--------------------------------------------------------------------------------------------------
+static inline bool pa_wifiCtrl_IsOpen
+(
+    const pa_wifiCtrl_Conn_t *connPtr
+)
+{
+    return (connPtr->fd >= 0);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Send a command and wait for its reply. Unsolicited event messages received in between are
+ * dropped.
+ *
+ * @return LE_OK            The reply was received.
+ * @return LE_TIMEOUT       No reply was received in time.
+ * @return LE_FAULT         The function failed.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiCtrl_Request
+(
+    pa_wifiCtrl_Conn_t *connPtr,
+        ///< [IN]
+        ///< Connection
+    const char         *cmdPtr,
+        ///< [IN]
+        ///< Command
+    char               *replyPtr,
+        ///< [OUT]
+        ///< Null terminated reply
+    size_t              replySize,
+        ///< [IN]
+        ///< Size of the reply buffer
+    int                 timeoutMs
+        ///< [IN]
+        ///< Timeout in milliseconds
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Send a command that is expected to be acknowledged by "OK".
+ *
+ * @return LE_OK            The command was acknowledged.
+ * @return LE_TIMEOUT       No reply was received in time.
+ * @return LE_FAULT         The command was rejected or the function failed.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiCtrl_RequestOk
+(
+    pa_wifiCtrl_Conn_t *connPtr,
+        ///< [IN]
+        ///< Connection
+    const char         *cmdPtr
+        ///< [IN]
+        ///< Command
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Register the connection as an event monitor (ATTACH).
+ *
+ * @return LE_OK            The function succeeded.
+ * @return LE_FAULT         The function failed.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiCtrl_Attach
+(
+    pa_wifiCtrl_Conn_t *connPtr
+        ///< [IN]
+        ///< Connection
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Wait for an event message on an attached connection. The "<level>" prefix is removed.
+ *
+ * @return LE_OK            An event was received.
+ * @return LE_TIMEOUT       Nothing was received before the timeout.
+ * @return LE_FAULT         The function failed.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiCtrl_Recv
+(
+    pa_wifiCtrl_Conn_t *connPtr,
+        ///< [IN]
+        ///< Connection
+    char               *eventPtr,
+        ///< [OUT]
+        ///< Null terminated event
+    size_t              eventSize,
+        ///< [IN]
+        ///< Size of the event buffer
+    int                 timeoutMs
+        ///< [IN]
+        ///< Timeout in milliseconds, -1 to wait forever
+);
+
+#endif // PA_WIFI_CTRL_H
@@ -0,0 +1,194 @@
+// -------------------------------------------------------------------------------------------------
+/**
+ *  WiFi access point DHCP server
+ *
+ *  DHCPv4 server of the access point clients. It serves a single interface from one UDP socket
+ *  monitored by the event loop of the calling thread, keeps the leases in memory and saves them
+ *  to a lease file so that the clients keep their address across restarts of the service.
+ *
+ *  Copyright (C) Sierra Wireless Inc.
+ *
+ */
+// -------------------------------------------------------------------------------------------------
+#ifndef PA_WIFI_DHCP_H
+#define PA_WIFI_DHCP_H
+
+#include "legato.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum number of leases, offered addresses included.
+ */
+//--------------------------------------------------------------------------------------------------
+#define PA_WIFIDHCP_MAX_LEASES          64
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Duration of a lease, in seconds.
+ */
+//--------------------------------------------------------------------------------------------------
+#define PA_WIFIDHCP_LEASE_SEC           (24 * 60 * 60)
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum size of a client host name, including the null termination.
+ */
+//--------------------------------------------------------------------------------------------------
+#define PA_WIFIDHCP_HOSTNAME_MAX_BYTES  64
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum size of a DHCP message.
+ */
+//--------------------------------------------------------------------------------------------------
+#define PA_WIFIDHCP_MSG_MAX_BYTES       576
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Lease of a client, as reported to the lease handler.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    char     mac[18];                                       ///< MAC address, lowercase
+    uint32_t addr;                                          ///< Address in host byte order, 0 if
+                                                            ///< the lease is released
+    char     hostname[PA_WIFIDHCP_HOSTNAME_MAX_BYTES];      ///< Client host name, or empty
+    time_t   expiry;                                        ///< Absolute expiry time (s)
+}
+pa_wifiDhcp_Lease_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Lease handler, called when an address is given to a client or renewed, and when a lease is
+ * released, declined or dropped by a range change.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef void (*pa_wifiDhcp_LeaseHandlerFunc_t)
+(
+    const pa_wifiDhcp_Lease_t *leasePtr,
+        ///< [IN]
+        ///< Lease of the client
+    void                      *contextPtr
+        ///< [IN]
+        ///< Context given to pa_wifiDhcp_SetLeaseHandler()
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Start the DHCP server. The leases of the lease file are restored; the addresses are only given
+ * once a range is set with pa_wifiDhcp_SetRange().
+ *
+ * @return LE_OK            The function succeeded.
+ * @return LE_DUPLICATE     The server is already started.
+ * @return LE_FAULT         The function failed.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiDhcp_Start
+(
+    const char *ifNamePtr,
+        ///< [IN]
+        ///< Interface to serve, NULL to only run the lease engine (see
+        ///< pa_wifiDhcp_ProcessMessage())
+    const char *leaseFilePtr
+        ///< [IN]
+        ///< Lease file, NULL to keep the leases in memory only
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stop the DHCP server. The leases stay in the lease file.
+ */
+//--------------------------------------------------------------------------------------------------
+void pa_wifiDhcp_Stop
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the address of the server and the range of the client addresses, in host byte order. It
+ * applies to the next messages; the leases out of the new range are dropped.
+ *
+ * @return LE_OK            The function succeeded.
+ * @return LE_BAD_PARAMETER The range is invalid or holds the server address.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiDhcp_SetRange
+(
+    uint32_t serverAddr,
+        ///< [IN]
+        ///< Server address, also given as router and DNS server
+    uint32_t netmask,
+        ///< [IN]
+        ///< Subnet mask of the clients
+    uint32_t startAddr,
+        ///< [IN]
+        ///< First client address
+    uint32_t stopAddr
+        ///< [IN]
+        ///< Last client address
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Process a DHCP message received from a client and build the reply, if any. The server calls it
+ * for each message received on its socket.
+ *
+ * @return LE_OK            The reply is built.
+ * @return LE_NOT_FOUND     The message needs no reply.
+ * @return LE_FORMAT_ERROR  The message is not a valid DHCP request.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiDhcp_ProcessMessage
+(
+    const uint8_t *msgPtr,
+        ///< [IN]
+        ///< Message received
+    size_t         msgLen,
+        ///< [IN]
+        ///< Size of the message
+    uint8_t       *replyPtr,
+        ///< [OUT]
+        ///< Reply, PA_WIFIDHCP_MSG_MAX_BYTES long
+    size_t        *replyLenPtr
+        ///< [OUT]
+        ///< Size of the reply
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the lease handler, NULL to remove it. It is called by the thread running the server before
+ * the reply to the client is sent, so it must not block.
+ */
+//--------------------------------------------------------------------------------------------------
+void pa_wifiDhcp_SetLeaseHandler
+(
+    pa_wifiDhcp_LeaseHandlerFunc_t handlerPtr,
+        ///< [IN]
+        ///< Lease handler
+    void                          *contextPtr
+        ///< [IN]
+        ///< Context given to the handler
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the active lease of a client.
+ *
+ * @return LE_OK            The function succeeded.
+ * @return LE_NOT_FOUND     The client has no active lease.
+ * @return LE_BAD_PARAMETER The MAC address is invalid.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiDhcp_GetLease
+(
+    const char          *macPtr,
+        ///< [IN]
+        ///< MAC address of the client
+    pa_wifiDhcp_Lease_t *leasePtr
+        ///< [OUT]
+        ///< Lease of the client
+);
+
+#endif // PA_WIFI_DHCP_H
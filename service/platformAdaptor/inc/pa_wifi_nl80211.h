@@ -0,0 +1,535 @@
+// -------------------------------------------------------------------------------------------------
+/**
+ *  WiFi nl80211 generic netlink helpers
+ *
+ *  Minimal generic netlink (nl80211) transport shared by the WiFi client and access point
+ *  platform adaptors. It allows the PA to talk directly to cfg80211 without spawning iw.
+ *
+ *  Copyright (C) Sierra Wireless Inc.
+ *
+ */
+// -------------------------------------------------------------------------------------------------
+#ifndef PA_WIFI_NL80211_H
+#define PA_WIFI_NL80211_H
+
+#include <linux/netlink.h>
+#include <linux/genetlink.h>
+#include <linux/nl80211.h>
+
+#include "legato.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Name of the WLAN interface driven by the platform adaptor.
+ */
+//--------------------------------------------------------------------------------------------------
+#define PA_WIFINL80211_IFNAME               "wlan0"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum size of a request built with pa_wifiNl80211_InitMsg().
+ */
+//--------------------------------------------------------------------------------------------------
+#define PA_WIFINL80211_MSG_MAX_BYTES        1024
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Size of the receive buffer. Scan dumps carry the information elements of every BSS, so the
+ * buffer is large enough to hold the biggest dump chunk sent by the kernel.
+ */
+//--------------------------------------------------------------------------------------------------
+#define PA_WIFINL80211_RX_BUFFER_BYTES      32768
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum number of nl80211 multicast groups tracked per socket.
+ */
+//--------------------------------------------------------------------------------------------------
+#define PA_WIFINL80211_MAX_GROUPS           8
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum length of a multicast group name, including the null termination.
+ */
+//--------------------------------------------------------------------------------------------------
+#define PA_WIFINL80211_GROUP_NAME_BYTES     GENL_NAMSIZ
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum number of handlers registered on the shared event listener.
+ */
+//--------------------------------------------------------------------------------------------------
+#define PA_WIFINL80211_MAX_LISTENERS        4
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Size of a MAC address attribute (NL80211_ATTR_MAC, NL80211_BSS_BSSID).
+ */
+//--------------------------------------------------------------------------------------------------
+#define PA_WIFINL80211_MAC_BYTES            6
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Time given to the driver to bring the WLAN interface up when the WiFi hardware is started (ms).
+ */
+//--------------------------------------------------------------------------------------------------
+#define PA_WIFINL80211_IF_UP_TIMEOUT_MS     10000
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * nl80211 multicast group.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    char     name[PA_WIFINL80211_GROUP_NAME_BYTES]; ///< Group name, e.g. "scan", "mlme".
+    uint32_t id;                                    ///< Group identifier.
+}
+pa_wifiNl80211_Group_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * nl80211 socket.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    int                    fd;                                      ///< Netlink socket.
+    uint16_t               familyId;                                ///< nl80211 family id.
+    uint32_t               seq;                                     ///< Last sequence number.
+    uint32_t               groupCount;                              ///< Number of groups.
+    pa_wifiNl80211_Group_t groups[PA_WIFINL80211_MAX_GROUPS];       ///< Multicast groups.
+    uint8_t                rxBuf[PA_WIFINL80211_RX_BUFFER_BYTES];   ///< Receive buffer.
+}
+pa_wifiNl80211_Socket_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * nl80211 request under construction.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    union
+    {
+        struct nlmsghdr hdr;                            ///< Netlink header, for alignment.
+        uint8_t         buf[PA_WIFINL80211_MSG_MAX_BYTES];  ///< Message buffer.
+    };
+}
+pa_wifiNl80211_Msg_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Handler called for every nl80211 message received on a socket.
+ *
+ * attrs[] is indexed by nl80211 attribute type (NL80211_ATTR_*); absent attributes are NULL.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef void (*pa_wifiNl80211_HandlerFunc_t)
+(
+    uint8_t         cmd,
+        ///< [IN]
+        ///< nl80211 command (NL80211_CMD_*)
+    struct nlattr  *attrs[],
+        ///< [IN]
+        ///< Parsed top level attributes
+    void           *contextPtr
+        ///< [IN]
+        ///< Context given by the caller
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get a pointer to the payload of an attribute.
+ */
+//--------------------------------------------------------------------------------------------------
+static inline void *pa_wifiNl80211_AttrData
+(
+    const struct nlattr *attrPtr
+)
+{
+    return (uint8_t *)attrPtr + NLA_HDRLEN;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the payload length of an attribute.
+ */
+//--------------------------------------------------------------------------------------------------
+static inline size_t pa_wifiNl80211_AttrLen
+(
+    const struct nlattr *attrPtr
+)
+{
+    return attrPtr->nla_len - NLA_HDRLEN;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the value of an unsigned 32 bits attribute.
+ */
+//--------------------------------------------------------------------------------------------------
+static inline uint32_t pa_wifiNl80211_AttrU32
+(
+    const struct nlattr *attrPtr
+)
+{
+    uint32_t value;
+    memcpy(&value, pa_wifiNl80211_AttrData(attrPtr), sizeof(value));
+    return value;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the value of an unsigned 16 bits attribute.
+ */
+//--------------------------------------------------------------------------------------------------
+static inline uint16_t pa_wifiNl80211_AttrU16
+(
+    const struct nlattr *attrPtr
+)
+{
+    uint16_t value;
+    memcpy(&value, pa_wifiNl80211_AttrData(attrPtr), sizeof(value));
+    return value;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the value of an unsigned 8 bits attribute.
+ */
+//--------------------------------------------------------------------------------------------------
+static inline uint8_t pa_wifiNl80211_AttrU8
+(
+    const struct nlattr *attrPtr
+)
+{
+    return *(uint8_t *)pa_wifiNl80211_AttrData(attrPtr);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Open a generic netlink socket and resolve the nl80211 family and its multicast groups.
+ *
+ * @return LE_OK            The function succeeded.
+ * @return LE_UNSUPPORTED   nl80211 is not available on this kernel.
+ * @return LE_FAULT         The function failed.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiNl80211_Open
+(
+    pa_wifiNl80211_Socket_t *sockPtr
+        ///< [OUT]
+        ///< Socket to initialize
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Close an nl80211 socket.
+ */
+//--------------------------------------------------------------------------------------------------
+void pa_wifiNl80211_Close
+(
+    pa_wifiNl80211_Socket_t *sockPtr
+        ///< [IN]
+        ///< Socket to close
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Subscribe the socket to an nl80211 multicast group ("scan", "mlme", "config", ...).
+ *
+ * @return LE_OK            The function succeeded.
+ * @return LE_NOT_FOUND     The group is not provided by the kernel.
+ * @return LE_FAULT         The function failed.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiNl80211_JoinGroup
+(
+    pa_wifiNl80211_Socket_t *sockPtr,
+        ///< [IN]
+        ///< Socket
+    const char              *groupNamePtr
+        ///< [IN]
+        ///< Multicast group name
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Initialize an nl80211 request.
+ */
+//--------------------------------------------------------------------------------------------------
+void pa_wifiNl80211_InitMsg
+(
+    pa_wifiNl80211_Socket_t *sockPtr,
+        ///< [IN]
+        ///< Socket the request will be sent on
+    pa_wifiNl80211_Msg_t    *msgPtr,
+        ///< [OUT]
+        ///< Request to initialize
+    uint8_t                  cmd,
+        ///< [IN]
+        ///< nl80211 command (NL80211_CMD_*)
+    uint16_t                 flags
+        ///< [IN]
+        ///< Additional netlink flags (e.g. NLM_F_DUMP)
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Append an attribute to a request.
+ *
+ * @return LE_OK            The function succeeded.
+ * @return LE_OVERFLOW      The request buffer is full.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiNl80211_PutAttr
+(
+    pa_wifiNl80211_Msg_t    *msgPtr,
+        ///< [IN]
+        ///< Request
+    uint16_t                 type,
+        ///< [IN]
+        ///< Attribute type
+    const void              *dataPtr,
+        ///< [IN]
+        ///< Attribute payload
+    size_t                   length
+        ///< [IN]
+        ///< Payload length
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Append an unsigned 32 bits attribute to a request.
+ *
+ * @return LE_OK            The function succeeded.
+ * @return LE_OVERFLOW      The request buffer is full.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiNl80211_PutU32
+(
+    pa_wifiNl80211_Msg_t    *msgPtr,
+        ///< [IN]
+        ///< Request
+    uint16_t                 type,
+        ///< [IN]
+        ///< Attribute type
+    uint32_t                 value
+        ///< [IN]
+        ///< Attribute value
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Open a nested attribute. Attributes appended until pa_wifiNl80211_NestEnd() is called are
+ * placed inside it.
+ *
+ * @return Pointer to the nested attribute, NULL if the request buffer is full.
+ */
+//--------------------------------------------------------------------------------------------------
+struct nlattr *pa_wifiNl80211_NestStart
+(
+    pa_wifiNl80211_Msg_t    *msgPtr,
+        ///< [IN]
+        ///< Request
+    uint16_t                 type
+        ///< [IN]
+        ///< Attribute type
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Close a nested attribute opened by pa_wifiNl80211_NestStart().
+ */
+//--------------------------------------------------------------------------------------------------
+void pa_wifiNl80211_NestEnd
+(
+    pa_wifiNl80211_Msg_t    *msgPtr,
+        ///< [IN]
+        ///< Request
+    struct nlattr           *nestPtr
+        ///< [IN]
+        ///< Nested attribute
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Parse a stream of attributes into a table indexed by attribute type.
+ */
+//--------------------------------------------------------------------------------------------------
+void pa_wifiNl80211_ParseAttrs
+(
+    struct nlattr           *attrs[],
+        ///< [OUT]
+        ///< Table of maxType + 1 entries
+    int                      maxType,
+        ///< [IN]
+        ///< Highest attribute type stored in the table
+    const void              *dataPtr,
+        ///< [IN]
+        ///< First attribute
+    size_t                   length
+        ///< [IN]
+        ///< Length of the attribute stream
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Send a request and process the replies until the kernel acknowledges it, or until the end of a
+ * dump. Every nl80211 message received in between, including multicast notifications, is passed
+ * to the handler.
+ *
+ * @return LE_OK            The request succeeded.
+ * @return LE_BUSY          The kernel returned EBUSY.
+ * @return LE_NOT_FOUND     The kernel returned ENOENT, ENODEV or ENOLINK.
+ * @return LE_UNSUPPORTED   The kernel returned EOPNOTSUPP.
+ * @return LE_TIMEOUT       No answer was received in time.
+ * @return LE_FAULT         The request failed.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiNl80211_Request
+(
+    pa_wifiNl80211_Socket_t     *sockPtr,
+        ///< [IN]
+        ///< Socket
+    pa_wifiNl80211_Msg_t        *msgPtr,
+        ///< [IN]
+        ///< Request to send
+    pa_wifiNl80211_HandlerFunc_t handlerFunc,
+        ///< [IN]
+        ///< Reply handler, can be NULL
+    void                        *contextPtr
+        ///< [IN]
+        ///< Context passed to the handler
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Wait for incoming messages (typically multicast notifications) and pass them to the handler.
+ *
+ * @return LE_OK            At least one message was processed.
+ * @return LE_TIMEOUT       Nothing was received before the timeout.
+ * @return LE_FAULT         The function failed.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiNl80211_Receive
+(
+    pa_wifiNl80211_Socket_t     *sockPtr,
+        ///< [IN]
+        ///< Socket
+    pa_wifiNl80211_HandlerFunc_t handlerFunc,
+        ///< [IN]
+        ///< Message handler
+    void                        *contextPtr,
+        ///< [IN]
+        ///< Context passed to the handler
+    int                          timeoutMs
+        ///< [IN]
+        ///< Timeout in milliseconds, -1 to wait forever
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get a bitrate from a NL80211_STA_INFO_*_BITRATE nested attribute.
+ *
+ * @return Bitrate in kbit/s, 0 if unknown.
+ */
+//--------------------------------------------------------------------------------------------------
+uint32_t pa_wifiNl80211_ParseBitrate
+(
+    struct nlattr           *rateAttrPtr
+        ///< [IN]
+        ///< Nested attribute, can be NULL
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Format a 6 bytes MAC address as "xx:xx:xx:xx:xx:xx".
+ */
+//--------------------------------------------------------------------------------------------------
+void pa_wifiNl80211_FormatMac
+(
+    const uint8_t           *macPtr,
+        ///< [IN]
+        ///< MAC address (6 bytes)
+    char                    *strPtr,
+        ///< [OUT]
+        ///< Output string
+    size_t                   strSize
+        ///< [IN]
+        ///< Size of the output string
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Initialize the shared nl80211 event listener. Called by the initialization of each PA, before
+ * any of them registers a handler.
+ */
+//--------------------------------------------------------------------------------------------------
+void pa_wifiNl80211_Init
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Register a handler on the shared nl80211 event listener.
+ *
+ * The listener is a single thread subscribed to the "mlme", "scan" and "config" multicast groups.
+ * It is started with the first handler and stopped with the last one. Handlers are called in the
+ * context of the listener thread for every notification received, with the handler list locked:
+ * a handler must not block, and only copies the notification for its own thread.
+ *
+ * @return LE_OK            The function succeeded.
+ * @return LE_UNSUPPORTED   nl80211 is not available on this kernel.
+ * @return LE_OVERFLOW      Too many handlers are registered.
+ * @return LE_FAULT         The function failed.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiNl80211_AddEventListener
+(
+    pa_wifiNl80211_HandlerFunc_t handlerFunc,
+        ///< [IN]
+        ///< Notification handler
+    void                        *contextPtr
+        ///< [IN]
+        ///< Context passed to the handler
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Unregister a handler from the shared nl80211 event listener.
+ */
+//--------------------------------------------------------------------------------------------------
+void pa_wifiNl80211_RemoveEventListener
+(
+    pa_wifiNl80211_HandlerFunc_t handlerFunc,
+        ///< [IN]
+        ///< Notification handler
+    void                        *contextPtr
+        ///< [IN]
+        ///< Context given to pa_wifiNl80211_AddEventListener()
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Wait for a network interface to be created, set it up and wait until the kernel reports it up,
+ * from the RTM_NEWLINK notifications of a route netlink socket.
+ *
+ * @return LE_OK            The interface is up.
+ * @return LE_TIMEOUT       The interface is not up before the timeout.
+ * @return LE_FAULT         The function failed.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiNl80211_WaitInterfaceUp
+(
+    const char              *ifNamePtr,
+        ///< [IN]
+        ///< Interface name
+    uint32_t                 timeoutMs
+        ///< [IN]
+        ///< Timeout in milliseconds
+);
+
+#endif // PA_WIFI_NL80211_H
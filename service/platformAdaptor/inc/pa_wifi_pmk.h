@@ -0,0 +1,152 @@
+// -------------------------------------------------------------------------------------------------
+/**
+ *  WiFi pairwise master key derivation
+ *
+ *  WPA/WPA2-Personal derive the 256-bit pre-shared key from the passphrase and the SSID with
+ *  PBKDF2-HMAC-SHA1 and 4096 iterations (IEEE 802.11i, annex H.4). Handing the derived key to
+ *  wpa_supplicant or hostapd instead of the passphrase saves this derivation on each connection.
+ *
+ *  Copyright (C) Sierra Wireless Inc.
+ *
+ */
+// -------------------------------------------------------------------------------------------------
+#ifndef PA_WIFI_PMK_H
+#define PA_WIFI_PMK_H
+
+#include "legato.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Size of a SHA-1 digest, and of a HMAC-SHA1.
+ */
+//--------------------------------------------------------------------------------------------------
+#define PA_WIFIPMK_SHA1_BYTES           20
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Size of a pairwise master key, and of its hexadecimal form including the null termination.
+ */
+//--------------------------------------------------------------------------------------------------
+#define PA_WIFIPMK_BYTES                32
+#define PA_WIFIPMK_HEX_BYTES            (2 * PA_WIFIPMK_BYTES + 1)
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of PBKDF2 iterations of the WPA passphrase to PSK mapping.
+ */
+//--------------------------------------------------------------------------------------------------
+#define PA_WIFIPMK_ITERATIONS           4096
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Compute the SHA-1 digest of a message.
+ */
+//--------------------------------------------------------------------------------------------------
+void pa_wifiPmk_Sha1
+(
+    const uint8_t *msgPtr,
+        ///< [IN]
+        ///< Message
+    size_t         msgLen,
+        ///< [IN]
+        ///< Length of the message
+    uint8_t        digest[PA_WIFIPMK_SHA1_BYTES]
+        ///< [OUT]
+        ///< Digest
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Compute the HMAC-SHA1 of a message (RFC 2104).
+ */
+//--------------------------------------------------------------------------------------------------
+void pa_wifiPmk_HmacSha1
+(
+    const uint8_t *keyPtr,
+        ///< [IN]
+        ///< Key
+    size_t         keyLen,
+        ///< [IN]
+        ///< Length of the key
+    const uint8_t *msgPtr,
+        ///< [IN]
+        ///< Message
+    size_t         msgLen,
+        ///< [IN]
+        ///< Length of the message
+    uint8_t        mac[PA_WIFIPMK_SHA1_BYTES]
+        ///< [OUT]
+        ///< Message authentication code
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Derive a key with PBKDF2-HMAC-SHA1 (RFC 8018).
+ */
+//--------------------------------------------------------------------------------------------------
+void pa_wifiPmk_Pbkdf2Sha1
+(
+    const uint8_t *passwordPtr,
+        ///< [IN]
+        ///< Password
+    size_t         passwordLen,
+        ///< [IN]
+        ///< Length of the password
+    const uint8_t *saltPtr,
+        ///< [IN]
+        ///< Salt
+    size_t         saltLen,
+        ///< [IN]
+        ///< Length of the salt
+    uint32_t       iterations,
+        ///< [IN]
+        ///< Number of iterations, at least 1
+    uint8_t       *keyPtr,
+        ///< [OUT]
+        ///< Derived key
+    size_t         keyLen
+        ///< [IN]
+        ///< Length of the derived key
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Derive the pairwise master key of a WPA/WPA2-Personal network from its passphrase and SSID.
+ *
+ * @return LE_BAD_PARAMETER  Invalid passphrase or SSID length.
+ * @return LE_OK             The function succeeded.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_wifiPmk_Derive
+(
+    const char    *passphrasePtr,
+        ///< [IN]
+        ///< Passphrase, 8 to 63 characters
+    const uint8_t *ssidPtr,
+        ///< [IN]
+        ///< SSID
+    size_t         ssidLen,
+        ///< [IN]
+        ///< Length of the SSID, 1 to 32 bytes
+    uint8_t        pmk[PA_WIFIPMK_BYTES]
+        ///< [OUT]
+        ///< Pairwise master key
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Format a pairwise master key as the 64 hexadecimal digits expected as PSK by wpa_supplicant and
+ * hostapd.
+ */
+//--------------------------------------------------------------------------------------------------
+void pa_wifiPmk_ToHex
+(
+    const uint8_t pmk[PA_WIFIPMK_BYTES],
+        ///< [IN]
+        ///< Pairwise master key
+    char          hex[PA_WIFIPMK_HEX_BYTES]
+        ///< [OUT]
+        ///< Null terminated hexadecimal digits
+);
+
+#endif // PA_WIFI_PMK_H
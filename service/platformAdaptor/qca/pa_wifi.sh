@@ -3,7 +3,8 @@
 #
 # ($1:) -d Debug logs
 # $1: Command (ex:  WIFI_START
-#                   WIFICLIENT_CONNECT
+#                   WIFI_START_FAILED
+#                   WIFICLIENT_SUPPLICANT_START
 # $2: wpa_supplicant.conf file directory
 
 if [ "$1" = "-d" ]; then
@@ -18,56 +19,24 @@ IFACE=wlan0
 HARDWAREABSENCE=50
 # QCA wifi module name
 QCAWIFIMOD=wlan
-# If wpa_supplicant is running already
-WPADUPLICATE=14
 # WiFi driver is not installed
 NODRIVER=100
-TIMEOUT=8
 SUCCESS=0
 ERROR=127
 # PATH
 export PATH=/legato/systems/current/bin:/usr/local/bin:/usr/bin:/bin:/usr/local/sbin:/usr/sbin:/sbin
 
-# Check the connection on the WiFi network interface.
-# Exit with 0 if connected otherwise exit with 8 (time out)
-CheckConnection()
-{
-    retries=10
-    echo "Checking connection..."
-    # Verify connection status
-    for i in $(seq 1 ${retries})
-    do
-        echo "loop=${i}"
-        (/usr/sbin/iw ${IFACE} link | grep "Connected to") && break
-        sleep 1
-    done
-    if [ "${i}" -eq "${retries}" ]; then
-        # Connection request time out.
-        exit ${TIMEOUT}
-    fi
-    # Connected.
-    exit ${SUCCESS}
-}
-
 echo "${CMD}"
 case ${CMD} in
     WIFI_START)
-        retries=10
         # Do clean up, even just after reboot
         /usr/bin/qca9377 wifi client stop > /dev/null 2>&1
-        sleep 1
-        # Run wifi start background
+        # Run wifi start background, the PA waits for the interface to come up and runs
+        # WIFI_START_FAILED if it does not
         /usr/bin/qca9377 wifi client init > /dev/null 2>&1 &
-        for i in $(seq 1 ${retries})
-        do
-            echo "loop=${i}"
-            sleep 1
-            [ -e /sys/class/net/${IFACE} ] && break
-        done
-        if [ "${i}" -ne "${retries}" ]; then
-            /sbin/ifconfig ${IFACE} up
-            exit ${SUCCESS}
-        fi
+        exit ${SUCCESS} ;;
+
+    WIFI_START_FAILED)
         moduleString=$(/sbin/lsmod | grep ${QCAWIFIMOD}) > /dev/null
         if [ -n "${moduleString}" ]; then
             ret=${HARDWAREABSENCE}
@@ -86,22 +55,6 @@ case ${CMD} in
     /usr/bin/qca9377 wifi client stop > /dev/null 2>&1 || exit ${ERROR}
     ;;
 
-  WIFI_SET_EVENT)
-    /usr/sbin/iw event || exit ${ERROR}
-    ;;
-
-  WIFI_UNSET_EVENT)
-    count=$(/usr/bin/pgrep -c iw)
-    [ "${count}" -eq 0 ] && exit ${SUCCESS}
-    for i in $(seq 1 "${count}")
-    do
-        pid=$(/usr/bin/pgrep -n iw)
-        /bin/kill -9 "${pid}"
-    done
-    count=$(/usr/bin/pgrep -c iw)
-    [ "${count}" -eq 0 ] || exit ${ERROR}
-    ;;
-
   WIFI_CHECK_HWSTATUS)
     #Client request disconnection if interface in up
     /sbin/ifconfig | grep ${IFACE} > /dev/null 2>&1
@@ -121,14 +74,15 @@ case ${CMD} in
     exit ${ERROR} ;;
 
   WIFIAP_HOSTAPD_STOP)
+    # Configuration left by older versions serving the clients with the shared dnsmasq
     rm -f /tmp/dnsmasq.wlan.conf
-    /usr/bin/unlink /etc/dnsmasq.d/dnsmasq.wlan.conf
-    /etc/init.d/dnsmasq stop
-    killall hostapd
-    sleep 1;
-    pidof hostapd && (kill -9 "$(pidof hostapd)" || exit ${ERROR})
-    pidof dnsmasq && (kill -9 "$(pidof dnsmasq)" || exit ${ERROR})
-    /etc/init.d/dnsmasq start || exit ${ERROR}
+    /usr/bin/unlink /etc/dnsmasq.d/dnsmasq.wlan.conf 2> /dev/null
+    # hostapd is normally terminated through its control interface already
+    if pidof hostapd; then
+        killall hostapd
+        sleep 1;
+        pidof hostapd && (kill -9 "$(pidof hostapd)" || exit ${ERROR})
+    fi
     ;;
 
   WIFIAP_WLAN_UP)
@@ -137,28 +91,19 @@ case ${CMD} in
     /sbin/ifconfig ${IFACE} "${AP_IP}" up || exit ${ERROR}
     ;;
 
-  DNSMASQ_RESTART)
-    echo "interface=${IFACE}" >> /tmp/dnsmasq.wlan.conf
-    /etc/init.d/dnsmasq stop
-    pidof dnsmasq && (kill -9 `pidof dnsmasq` || exit 127)
-    /etc/init.d/dnsmasq start || exit ${ERROR}
-    ;;
-
   WIFICLIENT_START_SCAN)
-    (/usr/sbin/iw dev ${IFACE} scan | grep 'BSS\|SSID\|signal') || exit ${ERROR}
+    # Optional arguments: freq <MHz>... to limit the scan to some channels, or dump to read the
+    # results cached by the kernel without scanning
+    shift
+    (/usr/sbin/iw dev ${IFACE} scan "$@" | grep 'BSS\|SSID\|signal\|freq:\|capability:\|last seen:') || exit ${ERROR}
     ;;
 
-  WIFICLIENT_CONNECT)
+  WIFICLIENT_SUPPLICANT_START)
     WPA_CFG=$2
     [ -f "${WPA_CFG}" ] || exit ${ERROR}
-    # wpa_supplicant is running, return duplicated request
-    /bin/ps -A | grep wpa_supplicant && exit ${WPADUPLICATE}
+    # wpa_supplicant is kept running, only start it once
+    (/bin/ps -ax | grep wpa_supplicant | grep ${IFACE} >/dev/null 2>&1) && exit ${SUCCESS}
     /sbin/wpa_supplicant -d -Dnl80211 -c "${WPA_CFG}" -i${IFACE} -B || exit ${ERROR}
-    CheckConnection ;;
-
-  WIFICLIENT_DISCONNECT)
-    /sbin/wpa_cli -i${IFACE} terminate || exit ${ERROR}
-    echo "WiFi client disconnected."
     ;;
 
   IPTABLE_DHCP_INSERT)
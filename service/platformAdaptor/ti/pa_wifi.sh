@@ -3,7 +3,8 @@
 #
 # ($1:) -d Debug logs
 # $1: Command (ex:  WIFI_START
-#                   WIFICLIENT_CONNECT
+#                   WIFI_START_FAILED
+#                   WIFICLIENT_SUPPLICANT_START
 # $2: wpa_supplicant.conf file directory
 
 if [ "$1" = "-d" ]; then
@@ -21,7 +22,6 @@ FIRMWAREFAILURE=100
 HARDWAREABSENCE=50
 # WiFi driver is not installed
 NODRIVER=100
-TIMEOUT=8
 # PATH
 export PATH=/legato/systems/current/bin:/usr/local/bin:/usr/bin:/bin:/usr/local/sbin:/usr/sbin:/sbin
 
@@ -318,27 +318,6 @@ tiwifi_int()
 
 ################################
 
-# Check the connection on the WiFi network interface.
-# Exit with 0 if connected otherwise exit with 8 (time out)
-CheckConnection()
-{
-    local retries=10
-    echo "Checking connection..."
-    # Verify connection status
-    for i in $(seq 1 ${retries})
-    do
-        echo "loop=${i}"
-        (/usr/sbin/iw $1 link | grep "Connected to") && break
-        sleep 1
-    done
-    if [ "${i}" -eq "${retries}" ]; then
-        # Connection request time out.
-        exit ${TIMEOUT}
-    fi
-    # Connected.
-    exit 0
-}
-
 WiFiReset()
 {
     local retries=3
@@ -377,6 +356,16 @@ case ${CMD} in
     ${TI_WIFI_SH} stop
     exit ${FAILUREREASON} ;;
 
+  WIFI_START_FAILED)
+    echo "WIFI_START_FAILED"
+    # The interface did not come up in time after WIFI_START
+    /sbin/lsmod | grep wlcore >/dev/null
+    FAILUREREASON=$?
+    ${TI_WIFI_SH} stop
+    # Driver loaded, hardware absent
+    [ ${FAILUREREASON} -eq 0 ] && exit ${HARDWAREABSENCE}
+    exit 127 ;;
+
   WIFI_STOP)
     echo "WIFI_STOP"
     # If wpa_supplicant is still running, terminate it
@@ -391,24 +380,6 @@ case ${CMD} in
     /usr/sbin/iw ${IFACE} link || exit 127
     exit 0 ;;
 
-  WIFI_SET_EVENT)
-    echo "WIFI_SET_EVENT"
-    /usr/sbin/iw event || exit 127
-    exit 0 ;;
-
-  WIFI_UNSET_EVENT)
-    echo "WIFI_UNSET_EVENT"
-    count=$(/usr/bin/pgrep -c iw)
-    [ "${count}" -eq 0 ] && exit 0
-    for i in $(seq 1 ${count})
-    do
-        pid=$(/usr/bin/pgrep -n iw)
-        /bin/kill -9 ${pid}
-    done
-    count=$(/usr/bin/pgrep -c iw)
-    [ "${count}" -eq 0 ] || exit 127
-    exit 0 ;;
-
   WIFI_CHECK_HWSTATUS)
     echo "WIFI_CHECK_HWSTATUS"
     #Client request disconnection if interface in up
@@ -431,14 +402,15 @@ case ${CMD} in
 
   WIFIAP_HOSTAPD_STOP)
     echo "WIFIAP_HOSTAPD_STOP"
+    # Configuration left by older versions serving the clients with the shared dnsmasq
     rm -f /tmp/dnsmasq.wlan.conf
-    /usr/bin/unlink /etc/dnsmasq.d/dnsmasq.wlan.conf
-    /etc/init.d/dnsmasq stop
-    killall hostapd
-    sleep 1;
-    pidof hostapd && (kill -9 `pidof hostapd` || exit 127)
-    pidof dnsmasq && (kill -9 `pidof dnsmasq` || exit 127)
-    /etc/init.d/dnsmasq start || exit 127
+    /usr/bin/unlink /etc/dnsmasq.d/dnsmasq.wlan.conf 2> /dev/null
+    # hostapd is normally terminated through its control interface already
+    if pidof hostapd; then
+        killall hostapd
+        sleep 1;
+        pidof hostapd && (kill -9 `pidof hostapd` || exit 127)
+    fi
     exit 0 ;;
 
   WIFIAP_WLAN_UP)
@@ -448,31 +420,21 @@ case ${CMD} in
     /sbin/ifconfig ${IFACE} ${AP_IP} up || exit 127
     exit 0 ;;
 
-  DNSMASQ_RESTART)
-    echo "interface=${IFACE}" >> /tmp/dnsmasq.wlan.conf
-    /etc/init.d/dnsmasq stop
-    pidof dnsmasq && (kill -9 `pidof dnsmasq` || exit 127)
-    /etc/init.d/dnsmasq start || exit 127
-    exit 0 ;;
-
   WIFICLIENT_START_SCAN)
     echo "WIFICLIENT_START_SCAN"
-    (/usr/sbin/iw dev ${IFACE} scan | grep 'BSS\|SSID\|signal') || exit 127
+    # Optional arguments: freq <MHz>... to limit the scan to some channels, or dump to read the
+    # results cached by the kernel without scanning
+    shift
+    (/usr/sbin/iw dev ${IFACE} scan "$@" | grep 'BSS\|SSID\|signal\|freq:\|capability:\|last seen:') || exit 127
     exit 0 ;;
 
-  WIFICLIENT_CONNECT)
-    echo "WIFICLIENT_CONNECT"
+  WIFICLIENT_SUPPLICANT_START)
+    echo "WIFICLIENT_SUPPLICANT_START"
     WPA_CFG=$2
     [ -f ${WPA_CFG} ] || exit 127
-    # wpa_supplicant is running, return duplicated request
-    /bin/ps -A | grep wpa_supplicant && exit 14
+    # wpa_supplicant is kept running, only start it once
+    (/bin/ps -ax | grep wpa_supplicant | grep ${IFACE} >/dev/null 2>&1) && exit 0
     /sbin/wpa_supplicant -d -Dnl80211 -c ${WPA_CFG} -i${IFACE} -B || exit 127
-    CheckConnection ${IFACE} ;;
-
-  WIFICLIENT_DISCONNECT)
-    echo "WIFICLIENT_DISCONNECT"
-    /sbin/wpa_cli -i${IFACE} terminate || exit 127
-    echo "WiFi client disconnected."
     exit 0 ;;
 
   IPTABLE_DHCP_INSERT)